@@ -20,6 +20,8 @@
  *
  */
 
+#include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -29,6 +31,13 @@
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
+#if defined(__GNUC__)
+#define MIXER_MEMORY_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define MIXER_MEMORY_BARRIER() _ReadWriteBarrier()
+#endif
+
 
 namespace Audio {
 
@@ -57,9 +66,11 @@ public:
 	int mix(int16 *data, uint len);
 
 	/**
-	 * Queries whether the channel is still playing or not.
+	 * Queries whether the channel is still playing or not. After the end of
+	 * the stream, the rate converter may still have to write the samples
+	 * it holds back.
 	 */
-	bool isFinished() const { return _stream->endOfStream(); }
+	bool isFinished() const { return _stream->endOfStream() && _drained; }
 
 	/**
 	 * Queries whether the channel is a permanent channel.
@@ -142,6 +153,11 @@ public:
 	 */
 	SoundHandle getHandle() const { return _handle; }
 
+	/**
+	 * Fills in the statistics about this channel.
+	 */
+	void getStats(Mixer::ChannelStats &stats) const;
+
 private:
 	const Mixer::SoundType _type;
 	SoundHandle _handle;
@@ -162,8 +178,10 @@ private:
 	uint32 _mixerTimeStamp;
 	uint32 _pauseStartTime;
 	uint32 _pauseTime;
+	uint32 _mixTime;
 
 	RateConverter *_converter;
+	bool _drained;
 	Common::DisposablePtr<AudioStream> _stream;
 };
 
@@ -173,10 +191,13 @@ private:
 
 
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _commandRead(0), _commandWrite(0), _commandMutex(), _lastCallbackTime(0), _samplesSinceLog(0) {
 
 	assert(sampleRate > 0);
 
+	resetStats();
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		_channels[i] = 0;
 }
@@ -194,6 +215,36 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
+bool MixerImpl::getStats(Stats &stats) {
+	Common::StackLock lock(_mutex);
+
+	stats = _stats;
+	stats.channels.clear();
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		if (_channels[i]) {
+			ChannelStats channelStats;
+			channelStats.slot = i;
+			_channels[i]->getStats(channelStats);
+			stats.channels.push_back(channelStats);
+		}
+	}
+
+	return true;
+}
+
+void MixerImpl::resetStats() {
+	Common::StackLock lock(_mutex);
+
+	_stats.callbacks = 0;
+	_stats.samplesMixed = 0;
+	_stats.mixTime = 0;
+	_stats.maxMixTime = 0;
+	_stats.bufferPeriod = 0;
+	_stats.underruns = 0;
+	_stats.overruns = 0;
+}
+
 void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
@@ -219,6 +270,72 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		*handle = chanHandle;
 }
 
+void MixerImpl::postCommand(ChannelCommand::Type type, SoundHandle handle, int value) {
+	ChannelCommand cmd;
+	cmd.type = type;
+	cmd.handle = handle;
+	cmd.value = value;
+
+#ifdef MIXER_MEMORY_BARRIER
+	{
+		Common::StackLock lock(_commandMutex);
+
+		const uint32 write = _commandWrite;
+		if (write - _commandRead < COMMAND_QUEUE_SIZE) {
+			_commands[write % COMMAND_QUEUE_SIZE] = cmd;
+			// Publish the command only after it has been completely written
+			MIXER_MEMORY_BARRIER();
+			_commandWrite = write + 1;
+			return;
+		}
+	}
+#endif
+
+	// The mixer callback did not keep up (or we can not queue without
+	// locking at all), so apply the command directly.
+	Common::StackLock lock(_mutex);
+	processCommands();
+	applyCommand(cmd);
+}
+
+void MixerImpl::processCommands() {
+	const uint32 write = _commandWrite;
+	uint32 read = _commandRead;
+
+	if (read == write)
+		return;
+
+#ifdef MIXER_MEMORY_BARRIER
+	// Make sure we see the commands published together with _commandWrite
+	MIXER_MEMORY_BARRIER();
+#endif
+
+	for (; read != write; ++read)
+		applyCommand(_commands[read % COMMAND_QUEUE_SIZE]);
+
+#ifdef MIXER_MEMORY_BARRIER
+	// Only hand the slots back to the producers after we are done with them
+	MIXER_MEMORY_BARRIER();
+#endif
+	_commandRead = read;
+}
+
+void MixerImpl::applyCommand(const ChannelCommand &cmd) {
+	// Commands for sounds which terminated meanwhile are silently dropped
+	const int index = cmd.handle._val % NUM_CHANNELS;
+	if (!_channels[index] || _channels[index]->getHandle()._val != cmd.handle._val)
+		return;
+
+	switch (cmd.type) {
+	case ChannelCommand::kSetVolume:
+		_channels[index]->setVolume(cmd.value);
+		break;
+	case ChannelCommand::kSetBalance:
+		_channels[index]->setBalance(cmd.value);
+		break;
+	}
+}
+
 void MixerImpl::playStream(
 			SoundType type,
 			SoundHandle *handle,
@@ -277,6 +394,18 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	// Since the mixer callback has been called, the mixer must be ready...
 	_mixerReady = true;
 
+	const uint32 startTime = g_system->getMillis();
+	const uint32 bufferPeriod = len * 1000 / _sampleRate;
+
+	// A callback arriving much later than one buffer after the previous one
+	// means the backend most likely ran out of data to play.
+	if (_stats.callbacks > 0 && (startTime - _lastCallbackTime) * 2 > bufferPeriod * 3)
+		_stats.underruns++;
+	_lastCallbackTime = startTime;
+
+	// Apply the channel settings changed since the last buffer
+	processCommands();
+
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
@@ -295,6 +424,32 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 			}
 		}
 
+	const uint32 mixTime = g_system->getMillis() - startTime;
+
+	_stats.callbacks++;
+	_stats.samplesMixed += len;
+	_stats.mixTime += mixTime;
+	_stats.maxMixTime = MAX(_stats.maxMixTime, mixTime);
+	_stats.bufferPeriod = bufferPeriod;
+	if (mixTime > bufferPeriod)
+		_stats.overruns++;
+
+	// Periodically report the mixer load when debugging
+	_samplesSinceLog += len;
+	if (_samplesSinceLog >= _sampleRate * 10) {
+		_samplesSinceLog = 0;
+
+		uint active = 0;
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			if (_channels[i])
+				active++;
+
+		debug(5, "Mixer: %u channels, %u buffers, load %.1f%%, max %u/%u ms, %u underruns, %u overruns",
+		      active, _stats.callbacks,
+		      100.0 * _stats.mixTime * _sampleRate / (1000.0 * _stats.samplesMixed),
+		      _stats.maxMixTime, bufferPeriod, _stats.underruns, _stats.overruns);
+	}
+
 	return res;
 }
 
@@ -346,16 +501,13 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-
-	_channels[index]->setVolume(volume);
+	postCommand(ChannelCommand::kSetVolume, handle, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
+	Common::StackLock lock(_mutex);
+	processCommands();
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -364,16 +516,13 @@ byte MixerImpl::getChannelVolume(SoundHandle handle) {
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
-
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
-
-	_channels[index]->setBalance(balance);
+	postCommand(ChannelCommand::kSetBalance, handle, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
+	Common::StackLock lock(_mutex);
+	processCommands();
+
 	const int index = handle._val % NUM_CHANNELS;
 	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
 		return 0;
@@ -487,17 +636,30 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark --- Channel implementations ---
 #pragma mark -
 
+/**
+ * Determine the rate converter quality selected by the user.
+ */
+static RateConverterQuality getRateConverterQuality() {
+	const Common::String quality = ConfMan.get("resampler_quality");
+
+	if (quality.equalsIgnoreCase("best"))
+		return kRateQualityBest;
+	else if (quality.equalsIgnoreCase("high"))
+		return kRateQualityHigh;
+	return kRateQualityFast;
+}
+
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
                  DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
     : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
       _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0),
-      _stream(stream, autofreeStream) {
+      _pauseStartTime(0), _pauseTime(0), _mixTime(0), _converter(0),
+      _drained(false), _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo, getRateConverterQuality());
 }
 
 Channel::~Channel() {
@@ -600,18 +762,33 @@ int Channel::mix(int16 *data, uint len) {
 
 	int res = 0;
 
-	if (_stream->endOfData()) {
-		// TODO: call drain method
-	} else {
-		assert(_converter);
+	assert(_converter);
+	if (!_stream->endOfData()) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis();
 		_pauseTime = 0;
 		res = _converter->flow(*_stream, data, len, _volL, _volR);
 		_samplesDecoded += res;
+		_mixTime += g_system->getMillis() - _mixerTimeStamp;
+	}
+
+	if (_stream->endOfStream() && !_drained && (uint)res < len) {
+		const int drained = _converter->drain(data + res * 2, len - res, _volL, _volR);
+		_drained = ((uint)drained < len - res);
+		res += drained;
 	}
 
 	return res;
 }
 
+void Channel::getStats(Mixer::ChannelStats &stats) const {
+	stats.id = _id;
+	stats.type = _type;
+	stats.rate = _stream->getRate();
+	stats.stereo = _stream->isStereo();
+	stats.paused = isPaused();
+	stats.samplesMixed = _samplesDecoded;
+	stats.mixTime = _mixTime;
+}
+
 } // End of namespace Audio
@@ -24,6 +24,7 @@
 #define AUDIO_MIXER_H
 
 #include "common/types.h"
+#include "common/array.h"
 #include "common/noncopyable.h"
 
 namespace Audio {
@@ -65,6 +66,41 @@ public:
 		kMaxMixerVolume = 256
 	};
 
+	/**
+	 * Statistics about one of the currently playing sounds.
+	 * @see getStats()
+	 */
+	struct ChannelStats {
+		int slot;               ///< index of the mixer slot the sound plays in
+		int id;                 ///< the sound id passed to playStream()
+		SoundType type;
+		uint rate;              ///< sample rate of the audio stream
+		bool stereo;
+		bool paused;
+		uint32 samplesMixed;    ///< number of sample pairs produced so far
+		uint32 mixTime;         ///< time spent decoding and converting, in ms
+	};
+
+	/**
+	 * Statistics about the work done by the mixer callback.
+	 *
+	 * All times are measured with OSystem::getMillis(). Since the tick
+	 * boundaries fall at random points of the measured intervals, the sums
+	 * are unbiased estimates even for work much shorter than a millisecond.
+	 *
+	 * @see getStats()
+	 */
+	struct Stats {
+		uint32 callbacks;       ///< number of buffers mixed
+		uint32 samplesMixed;    ///< number of sample pairs requested by the backend
+		uint32 mixTime;         ///< total time spent in the mixer callback, in ms
+		uint32 maxMixTime;      ///< longest single mixer callback, in ms
+		uint32 bufferPeriod;    ///< playback duration of the last buffer, in ms
+		uint32 underruns;       ///< callbacks arriving more than 1.5 buffer periods after the previous one
+		uint32 overruns;        ///< callbacks taking longer than the buffer period to mix
+		Common::Array<ChannelStats> channels;
+	};
+
 public:
 	Mixer() {}
 	virtual ~Mixer() {}
@@ -277,6 +313,20 @@ public:
 	 * @return the output sample rate in Hz
 	 */
 	virtual uint getOutputRate() const = 0;
+
+	/**
+	 * Query statistics about the mixer's CPU usage and timing.
+	 *
+	 * @param stats the structure to fill in
+	 * @return true if the mixer implementation gathers statistics
+	 */
+	virtual bool getStats(Stats &stats) { return false; }
+
+	/**
+	 * Reset the statistics gathered by the mixer, except for the ones
+	 * of the currently playing sounds.
+	 */
+	virtual void resetStats() {}
 };
 
 
@@ -71,6 +71,58 @@ private:
 	SoundTypeSettings _soundTypeSettings[4];
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * A channel control operation, which is queued by the engine side and
+	 * applied by the mixer callback at the start of the next buffer.
+	 */
+	struct ChannelCommand {
+		enum Type {
+			kSetVolume,
+			kSetBalance
+		};
+
+		Type type;
+		SoundHandle handle;
+		int value;
+	};
+
+	enum {
+		COMMAND_QUEUE_SIZE = 256
+	};
+
+	/**
+	 * Single producer/single consumer ring buffer of channel commands.
+	 * Producers are serialized by _commandMutex, which the mixer callback
+	 * never takes. The consumer always holds _mutex instead.
+	 */
+	ChannelCommand _commands[COMMAND_QUEUE_SIZE];
+	volatile uint32 _commandRead;
+	volatile uint32 _commandWrite;
+	Common::Mutex _commandMutex;
+
+	/**
+	 * Queue a channel command without waiting for the mixer callback.
+	 * If the queue is full or lock-free operation is not supported on
+	 * this platform, the command is applied directly instead.
+	 */
+	void postCommand(ChannelCommand::Type type, SoundHandle handle, int value);
+
+	/**
+	 * Apply all queued channel commands. Must be called with _mutex held.
+	 */
+	void processCommands();
+
+	void applyCommand(const ChannelCommand &cmd);
+
+	/** Statistics about the mixer callback, the channel data is not used. */
+	Stats _stats;
+
+	/** Time at which the mixer callback was last invoked */
+	uint32 _lastCallbackTime;
+
+	/** Number of sample pairs mixed since the last statistics log line */
+	uint32 _samplesSinceLog;
+
 
 public:
 
@@ -119,6 +171,9 @@ public:
 
 	virtual uint getOutputRate() const;
 
+	virtual bool getStats(Stats &stats);
+	virtual void resetStats();
+
 protected:
 	void insertChannel(SoundHandle *handle, Channel *chan);
 
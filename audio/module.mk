@@ -12,6 +12,7 @@ MODULE_OBJS := \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	rate_mix.o \
 	timestamp.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
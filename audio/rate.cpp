@@ -32,9 +32,12 @@
 #include "audio/rate.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
+#include "common/math.h"
 #include "common/textconsole.h"
 #include "common/util.h"
 
+#include <math.h>
+
 namespace Audio {
 
 
@@ -67,10 +70,15 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	/** resampled frames waiting to be mixed into the output */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	st_size_t resample(AudioStream &input, st_sample_t *buf, st_size_t frames);
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -98,17 +106,18 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 }
 
 /*
- * Processed signed long samples from ibuf to obuf.
- * Return number of sample pairs processed.
+ * Resample up to 'frames' sample frames from the input stream into buf.
+ * Return number of sample frames written, which is less than requested
+ * only when the input stream ran out of data.
  */
 template<bool stereo, bool reverseStereo>
-int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
+st_size_t SimpleRateConverter<stereo, reverseStereo>::resample(AudioStream &input, st_sample_t *buf, st_size_t frames) {
+	st_sample_t *bstart, *bend;
 
-	ostart = obuf;
-	oend = obuf + osamp * 2;
+	bstart = buf;
+	bend = buf + frames * (stereo ? 2 : 1);
 
-	while (obuf < oend) {
+	while (buf < bend) {
 
 		// read enough input samples so that opos >= 0
 		do {
@@ -117,7 +126,7 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return (buf - bstart) / (stereo ? 2 : 1);
 			}
 			inLen -= (stereo ? 2 : 1);
 			opos--;
@@ -126,22 +135,35 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			}
 		} while (opos >= 0);
 
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
+		*buf++ = *inPtr++;
+		if (stereo)
+			*buf++ = *inPtr++;
 
 		// Increment output position
 		opos += opos_inc;
+	}
+	return frames;
+}
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_size_t done = 0;
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+	while (done < osamp) {
+		const st_size_t wanted = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		const st_size_t produced = resample(input, outBuf, wanted);
 
-		obuf += 2;
+		mixBuffer(obuf + done * 2, outBuf, produced, stereo, reverseStereo, vol_l, vol_r);
+		done += produced;
+
+		if (produced < wanted)
+			break;
 	}
-	return (obuf - ostart) / 2;
+	return done;
 }
 
 /**
@@ -173,10 +195,15 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	/** interpolated frames waiting to be mixed into the output */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	st_size_t resample(AudioStream &input, st_sample_t *buf, st_size_t frames);
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
-	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -207,17 +234,18 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 }
 
 /*
- * Processed signed long samples from ibuf to obuf.
- * Return number of sample pairs processed.
+ * Interpolate up to 'frames' sample frames from the input stream into buf.
+ * Return number of sample frames written, which is less than requested
+ * only when the input stream ran out of data.
  */
 template<bool stereo, bool reverseStereo>
-int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
+st_size_t LinearRateConverter<stereo, reverseStereo>::resample(AudioStream &input, st_sample_t *buf, st_size_t frames) {
+	st_sample_t *bstart, *bend;
 
-	ostart = obuf;
-	oend = obuf + osamp * 2;
+	bstart = buf;
+	bend = buf + frames * (stereo ? 2 : 1);
 
-	while (obuf < oend) {
+	while (buf < bend) {
 
 		// read enough input samples so that opos < 0
 		while ((frac_t)FRAC_ONE <= opos) {
@@ -226,7 +254,7 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return (buf - bstart) / (stereo ? 2 : 1);
 			}
 			inLen -= (stereo ? 2 : 1);
 			ilast0 = icur0;
@@ -240,27 +268,284 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 
 		// Loop as long as the outpos trails behind, and as long as there is
 		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
+		while (opos < (frac_t)FRAC_ONE && buf < bend) {
 			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
+			*buf++ = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
+			if (stereo)
+				*buf++ = (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS));
+
+			// Increment output position
+			opos += opos_inc;
+		}
+	}
+	return frames;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		const st_size_t wanted = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		const st_size_t produced = resample(input, outBuf, wanted);
+
+		mixBuffer(obuf + done * 2, outBuf, produced, stereo, reverseStereo, vol_l, vol_r);
+		done += produced;
+
+		if (produced < wanted)
+			break;
+	}
+	return done;
+}
+
+
+#pragma mark -
+
+
+/**
+ * Zeroth order modified Bessel function of the first kind, needed for the
+ * Kaiser window. The power series converges quickly for the arguments used.
+ */
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	const double x2 = x * x / 4.0;
+
+	for (int k = 1; k < 32; k++) {
+		term *= x2 / (k * k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * Audio rate converter based on band-limited interpolation with a
+ * polyphase windowed sinc filter.
+ *
+ * The filter bank is computed once when the converter is created. Each of
+ * its phases holds 'taps' fixed-point coefficients for one fractional
+ * position between two input samples, so the inner loop is a plain integer
+ * dot product over the most recent input samples.
+ *
+ * Limited to sampling frequency <= 65535 Hz.
+ */
+template<bool stereo, bool reverseStereo, int taps>
+class PolyphaseRateConverter : public RateConverter {
+protected:
+	enum {
+		/** precision of the filter coefficients */
+		COEFF_BITS = 15
+	};
+
+	st_sample_t inBuf[INTERMEDIATE_BUFFER_SIZE];
+	const st_sample_t *inPtr;
+	int inLen;
+
+	/** fractional position of the output stream in input stream unit */
+	frac_t opos;
+
+	/** fractional position increment in the output stream */
+	frac_t opos_inc;
+
+	/** filter bank, 'taps' coefficients for each of the phases */
+	int16 *_filter;
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	/** shift converting opos into a phase of the filter bank */
+	int _phaseShift;
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+	/**
+	 * Most recent input samples (left/right channel). Each sample is stored
+	 * twice, so that the last 'taps' samples always are contiguous.
+	 */
+	st_sample_t hist0[2 * taps], hist1[2 * taps];
+	int histPos;
 
-			obuf += 2;
+	/** silent samples still to be fed in after the end of the input */
+	int tailLeft;
+
+	/** filtered frames waiting to be mixed into the output */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	st_size_t resample(AudioStream *input, st_sample_t *buf, st_size_t frames);
+	int process(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+	inline st_sample_t filter(const st_sample_t *hist, const int16 *coeffs) const {
+		int sum = 1 << (COEFF_BITS - 1);
+		for (int i = 0; i < taps; i++)
+			sum += hist[i] * coeffs[i];
+		sum >>= COEFF_BITS;
+
+		if (sum > ST_SAMPLE_MAX)
+			return ST_SAMPLE_MAX;
+		else if (sum < ST_SAMPLE_MIN)
+			return ST_SAMPLE_MIN;
+		return (st_sample_t)sum;
+	}
+
+public:
+	PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, int phaseBits);
+	~PolyphaseRateConverter() {
+		delete[] _filter;
+	}
+
+	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return process(&input, obuf, osamp, vol_l, vol_r);
+	}
+	int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+		return process(0, obuf, osamp, vol_l, vol_r);
+	}
+};
+
+
+/*
+ * Prepare processing.
+ */
+template<bool stereo, bool reverseStereo, int taps>
+PolyphaseRateConverter<stereo, reverseStereo, taps>::PolyphaseRateConverter(st_rate_t inrate, st_rate_t outrate, int phaseBits) {
+	if (inrate >= 65536 || outrate >= 65536) {
+		error("rate effect can only handle rates < 65536");
+	}
+
+	const int phases = 1 << phaseBits;
+	_phaseShift = FRAC_BITS - phaseBits;
+
+	// When downsampling, the cutoff has to be lowered to the output Nyquist
+	// frequency. The longer filter gets away with a narrower transition band.
+	const double cutoff = MIN<double>(1.0, (double)outrate / inrate) * (taps >= 32 ? 0.95 : 0.90);
+	const double beta = (taps >= 32 ? 8.0 : 6.0);
+	const double i0Beta = besselI0(beta);
+
+	_filter = new int16[phases * taps];
+
+	for (int phase = 0; phase < phases; phase++) {
+		double h[taps];
+		double total = 0.0;
+
+		// The output sample lies between the input samples at taps/2 - 1 and
+		// taps/2, at the fractional offset described by the phase.
+		for (int i = 0; i < taps; i++) {
+			const double x = i - (taps / 2 - 1) - (double)phase / phases;
+			const double t = x / (taps / 2);
+			const double window = besselI0(beta * sqrt(MAX<double>(0.0, 1.0 - t * t))) / i0Beta;
+			const double sinc = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+
+			h[i] = cutoff * sinc * window;
+			total += h[i];
+		}
+
+		// Normalize each phase to unity gain, and put the rounding error
+		// into the center tap so that DC passes through unchanged.
+		int16 *coeffs = _filter + phase * taps;
+		int sum = 0;
+		for (int i = 0; i < taps; i++) {
+			coeffs[i] = (int16)floor(h[i] / total * (1 << COEFF_BITS) + 0.5);
+			sum += coeffs[i];
+		}
+		coeffs[taps / 2 - 1] += (1 << COEFF_BITS) - sum;
+	}
+
+	// At phase 0, the filter is centered on the history sample at
+	// taps/2 - 1, counted from the oldest one. So after reading taps/2 + 1
+	// input samples, the first output sample is centered on the start of
+	// the input stream. Likewise, taps/2 silent samples at the end of the
+	// stream write out the last input sample.
+	opos = (taps / 2 + 1) << FRAC_BITS;
+	opos_inc = (inrate << FRAC_BITS) / outrate;
+
+	memset(hist0, 0, sizeof(hist0));
+	memset(hist1, 0, sizeof(hist1));
+	histPos = 0;
+	tailLeft = taps / 2;
+
+	inLen = 0;
+}
+
+/*
+ * Filter up to 'frames' sample frames from the input stream into buf. Once
+ * the input stream is gone, silence is fed in instead, so that the samples
+ * still in the history are written out.
+ * Return number of sample frames written, which is less than requested
+ * only when the input stream ran out of data.
+ */
+template<bool stereo, bool reverseStereo, int taps>
+st_size_t PolyphaseRateConverter<stereo, reverseStereo, taps>::resample(AudioStream *input, st_sample_t *buf, st_size_t frames) {
+	st_sample_t *bstart, *bend;
+
+	bstart = buf;
+	bend = buf + frames * (stereo ? 2 : 1);
+
+	while (buf < bend) {
+
+		// read enough input samples so that opos < 0
+		while ((frac_t)FRAC_ONE <= opos) {
+			if (input) {
+				// Check if we have to refill the buffer
+				if (inLen == 0) {
+					inPtr = inBuf;
+					inLen = input->readBuffer(inBuf, ARRAYSIZE(inBuf));
+					if (inLen <= 0) {
+						inLen = 0;
+						return (buf - bstart) / (stereo ? 2 : 1);
+					}
+				}
+				inLen -= (stereo ? 2 : 1);
+				hist0[histPos] = hist0[histPos + taps] = *inPtr++;
+				if (stereo)
+					hist1[histPos] = hist1[histPos + taps] = *inPtr++;
+			} else {
+				if (tailLeft == 0)
+					return (buf - bstart) / (stereo ? 2 : 1);
+				tailLeft--;
+				hist0[histPos] = hist0[histPos + taps] = 0;
+				if (stereo)
+					hist1[histPos] = hist1[histPos + taps] = 0;
+			}
+			if (++histPos == taps)
+				histPos = 0;
+			opos -= FRAC_ONE;
+		}
+
+		// Loop as long as the outpos trails behind, and as long as there is
+		// still space in the output buffer.
+		while (opos < (frac_t)FRAC_ONE && buf < bend) {
+			const int16 *coeffs = _filter + (opos >> _phaseShift) * taps;
+
+			*buf++ = filter(hist0 + histPos, coeffs);
+			if (stereo)
+				*buf++ = filter(hist1 + histPos, coeffs);
 
 			// Increment output position
 			opos += opos_inc;
 		}
 	}
-	return (obuf - ostart) / 2;
+	return frames;
+}
+
+/*
+ * Processed signed long samples from the input stream, or the remaining
+ * samples if it is 0, to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo, int taps>
+int PolyphaseRateConverter<stereo, reverseStereo, taps>::process(AudioStream *input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_size_t done = 0;
+
+	while (done < osamp) {
+		const st_size_t wanted = MIN<st_size_t>(osamp - done, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		const st_size_t produced = resample(input, outBuf, wanted);
+
+		mixBuffer(obuf + done * 2, outBuf, produced, stereo, reverseStereo, vol_l, vol_r);
+		done += produced;
+
+		if (produced < wanted)
+			break;
+	}
+	return done;
 }
 
 
@@ -283,11 +568,8 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
 		st_size_t len;
 
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -305,24 +587,12 @@ public:
 		len = input.readBuffer(_buffer, osamp);
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		len /= (stereo ? 2 : 1);
+		mixBuffer(obuf, _buffer, len, stereo, reverseStereo, vol_l, vol_r);
+		return len;
 	}
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		return ST_SUCCESS;
 	}
 };
@@ -331,9 +601,13 @@ public:
 #pragma mark -
 
 template<bool stereo, bool reverseStereo>
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, RateConverterQuality quality) {
 	if (inrate != outrate) {
-		if ((inrate % outrate) == 0) {
+		if (quality == kRateQualityHigh) {
+			return new PolyphaseRateConverter<stereo, reverseStereo, 16>(inrate, outrate, 8);
+		} else if (quality == kRateQualityBest) {
+			return new PolyphaseRateConverter<stereo, reverseStereo, 32>(inrate, outrate, 9);
+		} else if ((inrate % outrate) == 0) {
 			return new SimpleRateConverter<stereo, reverseStereo>(inrate, outrate);
 		} else {
 			return new LinearRateConverter<stereo, reverseStereo>(inrate, outrate);
@@ -346,14 +620,14 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate) {
 /**
  * Create and return a RateConverter object for the specified input and output rates.
  */
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo) {
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, RateConverterQuality quality) {
 	if (stereo) {
 		if (reverseStereo)
-			return makeRateConverter<true, true>(inrate, outrate);
+			return makeRateConverter<true, true>(inrate, outrate, quality);
 		else
-			return makeRateConverter<true, false>(inrate, outrate);
+			return makeRateConverter<true, false>(inrate, outrate, quality);
 	} else
-		return makeRateConverter<false, false>(inrate, outrate);
+		return makeRateConverter<false, false>(inrate, outrate, quality);
 }
 
 } // End of namespace Audio
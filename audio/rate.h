@@ -65,6 +65,29 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * Mix a block of sample frames into an interleaved stereo output buffer,
+ * scaling each channel by its volume and saturating the result.
+ *
+ * This is the inner loop shared by all rate converters. On hosts with SSE2
+ * it is vectorized; the result is always bit-identical to mixBufferScalar().
+ *
+ * @param obuf          output buffer of 'frames' stereo sample pairs
+ * @param ibuf          input buffer of 'frames' mono samples or stereo pairs
+ * @param frames        number of sample frames to process
+ * @param stereo        whether ibuf holds stereo sample pairs
+ * @param reverseStereo whether left and right channel should be swapped
+ * @param vol_l         volume of the left channel (0 - Mixer::kMaxMixerVolume)
+ * @param vol_r         volume of the right channel (0 - Mixer::kMaxMixerVolume)
+ */
+void mixBuffer(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, bool stereo, bool reverseStereo, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Plain C implementation of mixBuffer(). Serves as reference for the
+ * optimized variants and as fallback on hosts without SIMD support.
+ */
+void mixBufferScalar(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, bool stereo, bool reverseStereo, st_volume_t vol_l, st_volume_t vol_r);
+
 class RateConverter {
 public:
 	RateConverter() {}
@@ -75,10 +98,27 @@ public:
 	 */
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
 
-	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) = 0;
+	/**
+	 * Write the samples which are still buffered in the converter, after
+	 * the input stream has ended.
+	 *
+	 * @return Number of sample pairs written into the buffer, less than
+	 *         requested once the converter is empty.
+	 */
+	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) = 0;
+};
+
+/**
+ * Quality levels for the rate converters. Higher quality converters need
+ * considerably more CPU time per sample.
+ */
+enum RateConverterQuality {
+	kRateQualityFast,	///< Nearest neighbor or linear interpolation
+	kRateQualityHigh,	///< Band-limited interpolation with a 16 tap filter
+	kRateQualityBest	///< Band-limited interpolation with a 32 tap filter
 };
 
-RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false, RateConverterQuality quality = kRateQualityFast);
 
 } // End of namespace Audio
 
@@ -0,0 +1,123 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+
+#include "common/sse2.h"
+
+namespace Audio {
+
+void mixBufferScalar(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, bool stereo, bool reverseStereo, st_volume_t vol_l, st_volume_t vol_r) {
+	const int left = reverseStereo ? 1 : 0;
+	const int right = left ^ 1;
+
+	for (; frames > 0; --frames) {
+		st_sample_t out0, out1;
+		out0 = *ibuf++;
+		out1 = (stereo ? *ibuf++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[left ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[right], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+#ifdef USE_SSE2
+
+/**
+ * Scale eight samples by the matching volumes in 'vol' and add them with
+ * saturation to the eight output samples at 'obuf'.
+ *
+ * The products are computed in 32 bit and divided by kMaxMixerVolume with
+ * rounding towards zero, exactly like the scalar code does. Since both
+ * volumes are at most kMaxMixerVolume, the quotient always fits into 16 bit,
+ * so a saturating 16 bit addition yields the same result as clampedAdd().
+ */
+static inline void mixVector(st_sample_t *obuf, __m128i in, __m128i vol) {
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+
+	__m128i prod0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i prod1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Add kMaxMixerVolume - 1 to negative products, so that the arithmetic
+	// shift below truncates towards zero like a C division.
+	prod0 = _mm_add_epi32(prod0, _mm_srli_epi32(_mm_srai_epi32(prod0, 31), 24));
+	prod1 = _mm_add_epi32(prod1, _mm_srli_epi32(_mm_srai_epi32(prod1, 31), 24));
+	prod0 = _mm_srai_epi32(prod0, 8);
+	prod1 = _mm_srai_epi32(prod1, 8);
+
+	const __m128i out = _mm_loadu_si128((const __m128i *)obuf);
+	_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(out, _mm_packs_epi32(prod0, prod1)));
+}
+
+static void mixBufferSSE2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, bool stereo, bool reverseStereo, st_volume_t vol_l, st_volume_t vol_r) {
+	// Reversing the stereo channels is the same as swapping each input pair
+	// and mixing it with swapped volumes.
+	const __m128i vol = reverseStereo ? _mm_set_epi16(vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r)
+	                                  : _mm_set_epi16(vol_r, vol_l, vol_r, vol_l, vol_r, vol_l, vol_r, vol_l);
+
+	if (stereo) {
+		for (; frames >= 4; frames -= 4) {
+			__m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+			if (reverseStereo)
+				in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, 0xB1), 0xB1);
+
+			mixVector(obuf, in, vol);
+
+			ibuf += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; frames >= 8; frames -= 8) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+
+			mixVector(obuf, _mm_unpacklo_epi16(in, in), vol);
+			mixVector(obuf + 8, _mm_unpackhi_epi16(in, in), vol);
+
+			ibuf += 8;
+			obuf += 16;
+		}
+	}
+
+	mixBufferScalar(obuf, ibuf, frames, stereo, reverseStereo, vol_l, vol_r);
+}
+
+#endif
+
+void mixBuffer(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t frames, bool stereo, bool reverseStereo, st_volume_t vol_l, st_volume_t vol_r) {
+#if defined(USE_SSE2) && !defined(OUTPUT_UNSIGNED_AUDIO)
+	if (vol_l <= Audio::Mixer::kMaxMixerVolume && vol_r <= Audio::Mixer::kMaxMixerVolume) {
+		mixBufferSSE2(obuf, ibuf, frames, stereo, reverseStereo, vol_l, vol_r);
+		return;
+	}
+#endif
+
+	mixBufferScalar(obuf, ibuf, frames, stereo, reverseStereo, vol_l, vol_r);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,193 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#if defined(POSIX) || defined(PLAYSTATION3)
+
+// Re-enable some forbidden symbols to avoid clashes with stat.h and unistd.h.
+// Also with clock() in sys/time.h in some Mac OS X SDKs.
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+
+#include "backends/fs/posix/posix-fs-cache.h"
+#include "backends/fs/stdiostream.h"
+#include "common/algorithm.h"
+#include "common/debug.h"
+#include "common/ptr.h"
+
+#include <time.h>
+
+enum {
+	/** Version of the cache file format; files of other versions are ignored. */
+	kCacheVersion = 1,
+	/** Maximum number of directories kept in the cache file. */
+	kMaxCachedDirectories = 16384
+};
+
+#define CACHE_FILE_MAGIC MKTAG('S', 'D', 'I', 'R')
+
+static Common::String readCacheString(Common::ReadStream &stream) {
+	const uint16 size = stream.readUint16LE();
+
+	char buf[1024];
+	if (size <= sizeof(buf))
+		return Common::String(buf, stream.read(buf, size));
+
+	Common::String result;
+	for (uint16 i = 0; i < size && !stream.eos(); ++i)
+		result += (char)stream.readByte();
+	return result;
+}
+
+static void writeCacheString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint16LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+POSIXDirectoryCache::POSIXDirectoryCache(const Common::String &fileName)
+	: _fileName(fileName), _session(0), _dirty(false) {
+	load();
+
+	// Every run of ScummVM is a new session, used to find unused directories
+	++_session;
+}
+
+POSIXDirectoryCache::~POSIXDirectoryCache() {
+	if (_dirty)
+		save();
+}
+
+const POSIXDirectoryCache::EntryList *POSIXDirectoryCache::lookup(const Common::String &path, uint32 mtime) {
+	DirectoryMap::iterator i = _directories.find(path);
+	if (i == _directories.end() || i->_value.mtime != mtime)
+		return 0;
+
+	if (i->_value.lastUsed != _session) {
+		i->_value.lastUsed = _session;
+		_dirty = true;
+	}
+
+	return &i->_value.entries;
+}
+
+void POSIXDirectoryCache::store(const Common::String &path, uint32 mtime, const EntryList &entries) {
+	// Modification times only have a resolution of one second, so a change
+	// right after listing the directory would not update its mtime
+	if ((int32)((uint32)time(0) - mtime) < 2) {
+		_directories.erase(path);
+		return;
+	}
+
+	Directory &dir = _directories[path];
+	dir.mtime = mtime;
+	dir.lastUsed = _session;
+	dir.entries = entries;
+	_dirty = true;
+}
+
+void POSIXDirectoryCache::load() {
+	Common::ScopedPtr<StdioStream> stream(StdioStream::makeFromPath(_fileName, false));
+	if (!stream)
+		return;
+
+	if (stream->readUint32BE() != CACHE_FILE_MAGIC || stream->readUint32LE() != kCacheVersion) {
+		debug(1, "POSIXDirectoryCache: Ignoring invalid cache file '%s'", _fileName.c_str());
+		return;
+	}
+
+	_session = stream->readUint32LE();
+	const uint32 numDirectories = stream->readUint32LE();
+
+	for (uint32 i = 0; i < numDirectories && !stream->eos(); ++i) {
+		const Common::String path = readCacheString(*stream);
+		Directory &dir = _directories[path];
+		dir.mtime = stream->readUint32LE();
+		dir.lastUsed = stream->readUint32LE();
+
+		const uint32 numEntries = stream->readUint32LE();
+		for (uint32 j = 0; j < numEntries && !stream->eos(); ++j) {
+			Entry entry;
+			entry.isDirectory = (stream->readByte() != 0);
+			entry.name = readCacheString(*stream);
+			dir.entries.push_back(entry);
+		}
+	}
+
+	if (stream->eos() || stream->err()) {
+		debug(1, "POSIXDirectoryCache: Cache file '%s' is truncated", _fileName.c_str());
+		_directories.clear();
+	}
+}
+
+bool POSIXDirectoryCache::save() {
+	pruneOldDirectories();
+
+	Common::ScopedPtr<StdioStream> stream(StdioStream::makeFromPath(_fileName, true));
+	if (!stream) {
+		warning("POSIXDirectoryCache: Could not write cache file '%s'", _fileName.c_str());
+		return false;
+	}
+
+	stream->writeUint32BE(CACHE_FILE_MAGIC);
+	stream->writeUint32LE(kCacheVersion);
+	stream->writeUint32LE(_session);
+	stream->writeUint32LE(_directories.size());
+
+	for (DirectoryMap::const_iterator i = _directories.begin(); i != _directories.end(); ++i) {
+		const Directory &dir = i->_value;
+		writeCacheString(*stream, i->_key);
+		stream->writeUint32LE(dir.mtime);
+		stream->writeUint32LE(dir.lastUsed);
+
+		stream->writeUint32LE(dir.entries.size());
+		for (EntryList::const_iterator entry = dir.entries.begin(); entry != dir.entries.end(); ++entry) {
+			stream->writeByte(entry->isDirectory ? 1 : 0);
+			writeCacheString(*stream, entry->name);
+		}
+	}
+
+	if (!stream->flush() || stream->err()) {
+		warning("POSIXDirectoryCache: Could not write cache file '%s'", _fileName.c_str());
+		return false;
+	}
+
+	_dirty = false;
+	return true;
+}
+
+void POSIXDirectoryCache::pruneOldDirectories() {
+	if (_directories.size() <= kMaxCachedDirectories)
+		return;
+
+	// Find the session which separates the most recently used directories
+	// from the rest, and drop everything used before it
+	Common::Array<uint32> lastUsed;
+	for (DirectoryMap::const_iterator i = _directories.begin(); i != _directories.end(); ++i)
+		lastUsed.push_back(i->_value.lastUsed);
+	Common::sort(lastUsed.begin(), lastUsed.end(), Common::Greater<uint32>());
+	const uint32 oldest = lastUsed[kMaxCachedDirectories - 1];
+
+	for (DirectoryMap::iterator i = _directories.begin(); i != _directories.end(); ++i) {
+		if (i->_value.lastUsed < oldest)
+			_directories.erase(i);
+	}
+}
+
+#endif
@@ -0,0 +1,103 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef POSIX_FILESYSTEM_CACHE_H
+#define POSIX_FILESYSTEM_CACHE_H
+
+#include "common/array.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+/**
+ * Persistent cache of directory listings, used by POSIXFilesystemNode.
+ *
+ * Listing big directory trees is slow on network file systems, mostly
+ * because every entry may require its own stat() call. This cache stores
+ * the entries of each listed directory along with the modification time
+ * of the directory. As long as no entry is added, removed or renamed, the
+ * directory keeps its modification time and a later listing only costs a
+ * single stat() of the directory itself.
+ *
+ * The cache is loaded from a file on creation and written back when it
+ * is destroyed, so it survives restarts.
+ */
+class POSIXDirectoryCache {
+public:
+	struct Entry {
+		Common::String name;
+		bool isDirectory;
+	};
+
+	typedef Common::Array<Entry> EntryList;
+
+	/**
+	 * Create a cache backed by the given file, and load its contents.
+	 */
+	explicit POSIXDirectoryCache(const Common::String &fileName);
+
+	/**
+	 * Save the cache, if it was modified.
+	 */
+	~POSIXDirectoryCache();
+
+	/**
+	 * Look up the cached listing of a directory.
+	 *
+	 * @param path   the path of the directory
+	 * @param mtime  the current modification time of the directory
+	 * @return the cached entries, or 0 if the directory is not cached or
+	 *         the cached listing is outdated
+	 */
+	const EntryList *lookup(const Common::String &path, uint32 mtime);
+
+	/**
+	 * Store the listing of a directory. Directories which were modified
+	 * just now are not stored, since further modifications within the
+	 * same second would go unnoticed.
+	 */
+	void store(const Common::String &path, uint32 mtime, const EntryList &entries);
+
+	/**
+	 * Write the cache to its file.
+	 */
+	bool save();
+
+private:
+	struct Directory {
+		uint32 mtime;
+		uint32 lastUsed;	///< the session in which the directory was last listed
+		EntryList entries;
+	};
+
+	typedef Common::HashMap<Common::String, Directory> DirectoryMap;
+
+	Common::String _fileName;
+	DirectoryMap _directories;
+	uint32 _session;
+	bool _dirty;
+
+	void load();
+	void pruneOldDirectories();
+};
+
+#endif
@@ -31,6 +31,22 @@
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
 
+POSIXFilesystemFactory::POSIXFilesystemFactory() : _directoryCache(0) {
+}
+
+POSIXFilesystemFactory::~POSIXFilesystemFactory() {
+	POSIXFilesystemNode::setDirectoryCache(0);
+	delete _directoryCache;
+}
+
+void POSIXFilesystemFactory::enableDirectoryCache(const Common::String &fileName) {
+	POSIXFilesystemNode::setDirectoryCache(0);
+	delete _directoryCache;
+
+	_directoryCache = new POSIXDirectoryCache(fileName);
+	POSIXFilesystemNode::setDirectoryCache(_directoryCache);
+}
+
 AbstractFSNode *POSIXFilesystemFactory::makeRootFileNode() const {
 	return new POSIXFilesystemNode("/");
 }
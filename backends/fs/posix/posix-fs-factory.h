@@ -24,13 +24,27 @@
 
 #include "backends/fs/fs-factory.h"
 
+class POSIXDirectoryCache;
+
 /**
  * Creates POSIXFilesystemNode objects.
  *
  * Parts of this class are documented in the base interface class, FilesystemFactory.
  */
 class POSIXFilesystemFactory : public FilesystemFactory {
+public:
+	POSIXFilesystemFactory();
+	virtual ~POSIXFilesystemFactory();
+
+	/**
+	 * Enable the persistent cache for directory listings, stored in the
+	 * given file. See POSIXDirectoryCache.
+	 */
+	void enableDirectoryCache(const Common::String &fileName);
+
 protected:
+	POSIXDirectoryCache *_directoryCache;
+
 	virtual AbstractFSNode *makeRootFileNode() const;
 	virtual AbstractFSNode *makeCurrentDirectoryFileNode() const;
 	virtual AbstractFSNode *makeFileNodePath(const Common::String &path) const;
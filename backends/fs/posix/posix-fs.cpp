@@ -44,6 +44,8 @@
 #endif
 
 
+POSIXDirectoryCache *POSIXFilesystemNode::_directoryCache = 0;
+
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -145,18 +147,55 @@ bool POSIXFilesystemNode::getChildren(AbstractFSList &myList, ListMode mode, boo
 	}
 #endif
 
+	POSIXDirectoryCache::EntryList buffer;
+	const POSIXDirectoryCache::EntryList *entries = readDirectory(buffer);
+	if (!entries)
+		return false;
+
+	for (POSIXDirectoryCache::EntryList::const_iterator i = entries->begin(); i != entries->end(); ++i) {
+		// Skip 'invisible' files if necessary
+		if (i->name[0] == '.' && !hidden)
+			continue;
+
+		// Honor the chosen mode
+		if ((mode == Common::FSNode::kListFilesOnly && i->isDirectory) ||
+			(mode == Common::FSNode::kListDirectoriesOnly && !i->isDirectory))
+			continue;
+
+		// Start with a clone of this node, with the correct path set
+		POSIXFilesystemNode *entry = new POSIXFilesystemNode(*this);
+		entry->_displayName = i->name;
+		if (_path.lastChar() != '/')
+			entry->_path += '/';
+		entry->_path += entry->_displayName;
+		entry->_isDirectory = i->isDirectory;
+		entry->_isValid = true;
+
+		myList.push_back(entry);
+	}
+
+	return true;
+}
+
+const POSIXDirectoryCache::EntryList *POSIXFilesystemNode::readDirectory(POSIXDirectoryCache::EntryList &buffer) const {
+	// A directory gets a new modification time whenever an entry is added,
+	// removed or renamed, so a cached listing with the same time is valid
+	struct stat dirStat;
+	const bool useCache = _directoryCache && stat(_path.c_str(), &dirStat) == 0;
+	if (useCache) {
+		const POSIXDirectoryCache::EntryList *cached = _directoryCache->lookup(_path, dirStat.st_mtime);
+		if (cached)
+			return cached;
+	}
+
 	DIR *dirp = opendir(_path.c_str());
 	struct dirent *dp;
 
 	if (dirp == NULL)
-		return false;
+		return 0;
 
 	// loop over dir entries using readdir
 	while ((dp = readdir(dirp)) != NULL) {
-		// Skip 'invisible' files if necessary
-		if (dp->d_name[0] == '.' && !hidden) {
-			continue;
-		}
 		// Skip '.' and '..' to avoid cycles
 		if ((dp->d_name[0] == '.' && dp->d_name[1] == 0) || (dp->d_name[0] == '.' && dp->d_name[1] == '.')) {
 			continue;
@@ -201,16 +240,17 @@ bool POSIXFilesystemNode::getChildren(AbstractFSList &myList, ListMode mode, boo
 		if (!entry._isValid)
 			continue;
 
-		// Honor the chosen mode
-		if ((mode == Common::FSNode::kListFilesOnly && entry._isDirectory) ||
-			(mode == Common::FSNode::kListDirectoriesOnly && !entry._isDirectory))
-			continue;
-
-		myList.push_back(new POSIXFilesystemNode(entry));
+		POSIXDirectoryCache::Entry cacheEntry;
+		cacheEntry.name = entry._displayName;
+		cacheEntry.isDirectory = entry._isDirectory;
+		buffer.push_back(cacheEntry);
 	}
 	closedir(dirp);
 
-	return true;
+	if (useCache)
+		_directoryCache->store(_path, dirStat.st_mtime, buffer);
+
+	return &buffer;
 }
 
 AbstractFSNode *POSIXFilesystemNode::getParent() const {
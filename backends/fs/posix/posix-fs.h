@@ -23,6 +23,7 @@
 #define POSIX_FILESYSTEM_H
 
 #include "backends/fs/abstract-fs.h"
+#include "backends/fs/posix/posix-fs-cache.h"
 
 #ifdef MACOSX
 #include <sys/types.h>
@@ -41,6 +42,9 @@ protected:
 	bool _isDirectory;
 	bool _isValid;
 
+	/** Cache for directory listings, or 0 if disabled. */
+	static POSIXDirectoryCache *_directoryCache;
+
 	virtual AbstractFSNode *makeNode(const Common::String &path) const {
 		return new POSIXFilesystemNode(path);
 	}
@@ -73,7 +77,20 @@ public:
 	virtual Common::SeekableReadStream *createReadStream();
 	virtual Common::WriteStream *createWriteStream();
 
+	/**
+	 * Set the cache used for directory listings. The caller keeps the
+	 * ownership of the cache. Pass 0 to disable caching.
+	 */
+	static void setDirectoryCache(POSIXDirectoryCache *cache) { _directoryCache = cache; }
+
 private:
+	/**
+	 * Read all entries of this directory, using the directory cache if
+	 * possible. Returns either the cached entries or buffer, filled with
+	 * the entries, or 0 if the directory could not be read.
+	 */
+	const POSIXDirectoryCache::EntryList *readDirectory(POSIXDirectoryCache::EntryList &buffer) const;
+
 	/**
 	 * Tests and sets the _isValid and _isDirectory flags, using the stat() function.
 	 */
@@ -85,7 +85,8 @@ GLTexture::GLTexture(byte bpp, GLenum internalFormat, GLenum format, GLenum type
 	_realWidth(0),
 	_realHeight(0),
 	_refresh(false),
-	_filter(GL_NEAREST) {
+	_filter(GL_NEAREST),
+	_bytesUploaded(0) {
 
 	// Generate the texture ID
 	glGenTextures(1, &_textureName); CHECK_GL_ERROR();
@@ -145,10 +146,26 @@ void GLTexture::updateBuffer(const void *buf, int pitch, GLuint x, GLuint y, GLu
 	// Select this OpenGL texture
 	glBindTexture(GL_TEXTURE_2D, _textureName); CHECK_GL_ERROR();
 
+	// Orphan the old contents when all of them are replaced
+	if (x == 0 && y == 0 && w == _realWidth && h == _realHeight) {
+		glTexImage2D(GL_TEXTURE_2D, 0, _internalFormat,
+			_textureWidth, _textureHeight, 0, _glFormat, _glType, NULL); CHECK_GL_ERROR();
+	}
+
+	_bytesUploaded += w * h * _bytesPerPixel;
+
 	// Check if the buffer has its data contiguously
 	if (static_cast<int>(w) * _bytesPerPixel == pitch) {
 		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h,
 						_glFormat, _glType, buf); CHECK_GL_ERROR();
+#ifdef GL_UNPACK_ROW_LENGTH
+	} else if (pitch % _bytesPerPixel == 0) {
+		// Let OpenGL skip the rest of each row (not available in GLES)
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / _bytesPerPixel); CHECK_GL_ERROR();
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h,
+						_glFormat, _glType, buf); CHECK_GL_ERROR();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0); CHECK_GL_ERROR();
+#endif
 	} else {
 		// Update the texture row by row
 		const byte *src = static_cast<const byte *>(buf);
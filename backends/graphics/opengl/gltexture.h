@@ -83,6 +83,10 @@ public:
 
 	/**
 	 * Updates the texture pixels.
+	 *
+	 * When the whole texture is updated, its storage is specified anew, so
+	 * the driver can hand out fresh memory instead of waiting until the
+	 * previous contents are not used for drawing anymore.
 	 */
 	virtual void updateBuffer(const void *buf, int pitch, GLuint x, GLuint y,
 		GLuint w, GLuint h);
@@ -107,6 +111,13 @@ public:
 	 */
 	uint getBytesPerPixel() const { return _bytesPerPixel; }
 
+	/**
+	 * Get the number of bytes uploaded since the last resetBytesUploaded().
+	 */
+	uint32 getBytesUploaded() const { return _bytesUploaded; }
+
+	void resetBytesUploaded() { _bytesUploaded = 0; }
+
 	/**
 	 * Set the texture filter.
 	 * @filter the filter type, GL_NEAREST or GL_LINEAR
@@ -126,6 +137,7 @@ protected:
 	GLuint _textureHeight;
 	GLint _filter;
 	bool _refresh;
+	uint32 _bytesUploaded;
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include "backends/graphics/opengl/opengl-graphics.h"
 #include "backends/graphics/opengl/glerrorcheck.h"
 #include "common/config-manager.h"
+#include "common/debug.h"
 #include "common/file.h"
 #include "common/mutex.h"
 #include "common/textconsole.h"
@@ -34,6 +35,7 @@
 #ifdef USE_OSD
 #include "common/tokenizer.h"
 #endif
+#include "graphics/conversion.h"
 #include "graphics/font.h"
 #include "graphics/fontman.h"
 
@@ -44,8 +46,10 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 #endif
 	_gameTexture(0), _overlayTexture(0), _cursorTexture(0),
 	_screenChangeCount(1 << (sizeof(int) * 8 - 2)), _screenNeedsRedraw(false),
+	_screenDirtyRects(kMaxDirtyRects, 1, kUploadRectCost),
 	_shakePos(0),
 	_overlayVisible(false), _overlayNeedsRedraw(false),
+	_overlayDirtyRects(kMaxDirtyRects, 1, kUploadRectCost),
 	_transactionMode(kTransactionNone),
 	_cursorNeedsRedraw(false), _cursorPaletteDisabled(true),
 	_cursorVisible(false), _cursorKeyColor(0),
@@ -56,6 +60,7 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 	memset(&_oldVideoMode, 0, sizeof(_oldVideoMode));
 	memset(&_videoMode, 0, sizeof(_videoMode));
 	memset(&_transactionDetails, 0, sizeof(_transactionDetails));
+	memset(&_uploadStats, 0, sizeof(_uploadStats));
 
 	_videoMode.mode = OpenGL::GFX_NORMAL;
 	_videoMode.scaleFactor = 2;
@@ -63,6 +68,7 @@ OpenGLGraphicsManager::OpenGLGraphicsManager()
 	_videoMode.antialiasing = false;
 
 	_gamePalette = (byte *)calloc(sizeof(byte) * 3, 256);
+	memset(_gamePaletteMap, 0, sizeof(_gamePaletteMap));
 	_cursorPalette = (byte *)calloc(sizeof(byte) * 3, 256);
 }
 
@@ -324,9 +330,23 @@ void OpenGLGraphicsManager::setPalette(const byte *colors, uint start, uint num)
 	assert(_screenFormat.bytesPerPixel == 1);
 #endif
 
+	// Nothing has to be converted again if the colors did not change
+	if (!memcmp(_gamePalette + start * 3, colors, num * 3))
+		return;
+
 	// Save the screen palette
 	memcpy(_gamePalette + start * 3, colors, num * 3);
 
+	// The texture takes R, G and B bytes, and crossBlitMap() writes the
+	// low three bytes of the colors in memory order
+	for (uint i = start; i < start + num; i++, colors += 3) {
+#ifdef SCUMM_BIG_ENDIAN
+		_gamePaletteMap[i] = (colors[0] << 16) | (colors[1] << 8) | colors[2];
+#else
+		_gamePaletteMap[i] = (colors[2] << 16) | (colors[1] << 8) | colors[0];
+#endif
+	}
+
 	_screenNeedsRedraw = true;
 
 	if (_cursorPaletteDisabled)
@@ -359,11 +379,9 @@ void OpenGLGraphicsManager::copyRectToScreen(const byte *buf, int pitch, int x,
 		dst += _screenData.pitch;
 	}
 
-	// Extend dirty area if not full screen redraw is flagged
-	if (!_screenNeedsRedraw) {
-		const Common::Rect dirtyRect(x, y, x + w, y + h);
-		_screenDirtyRect.extend(dirtyRect);
-	}
+	// Add the dirty area if not full screen redraw is flagged
+	if (!_screenNeedsRedraw)
+		_screenDirtyRects.add(Common::Rect(x, y, x + w, y + h));
 }
 
 Graphics::Surface *OpenGLGraphicsManager::lockScreen() {
@@ -522,11 +540,9 @@ void OpenGLGraphicsManager::copyRectToOverlay(const OverlayColor *buf, int pitch
 		}
 	}
 
-	// Extend dirty area if not full screen redraw is flagged
-	if (!_overlayNeedsRedraw) {
-		const Common::Rect dirtyRect(x, y, x + w, y + h);
-		_overlayDirtyRect.extend(dirtyRect);
-	}
+	// Add the dirty area if not full screen redraw is flagged
+	if (!_overlayNeedsRedraw)
+		_overlayDirtyRects.add(Common::Rect(x, y, x + w, y + h));
 }
 
 int16 OpenGLGraphicsManager::getOverlayHeight() {
@@ -683,87 +699,63 @@ void OpenGLGraphicsManager::setFullscreenMode(bool enable) {
 }
 
 void OpenGLGraphicsManager::refreshGameScreen() {
-	if (_screenNeedsRedraw)
-		_screenDirtyRect = Common::Rect(0, 0, _screenData.w, _screenData.h);
-
-	int x = _screenDirtyRect.left;
-	int y = _screenDirtyRect.top;
-	int w = _screenDirtyRect.width();
-	int h = _screenDirtyRect.height();
-
-	if (_screenData.format.bytesPerPixel == 1) {
-		// Create a temporary RGB888 surface
-		byte *surface = new byte[w * h * 3];
-
-		// Convert the paletted buffer to RGB888
-		const byte *src = (byte *)_screenData.pixels + y * _screenData.pitch;
-		src += x * _screenData.format.bytesPerPixel;
-		byte *dst = surface;
-		for (int i = 0; i < h; i++) {
-			for (int j = 0; j < w; j++) {
-				dst[0] = _gamePalette[src[j] * 3];
-				dst[1] = _gamePalette[src[j] * 3 + 1];
-				dst[2] = _gamePalette[src[j] * 3 + 2];
-				dst += 3;
-			}
-			src += _screenData.pitch;
-		}
+	uploadDirtyRects(_gameTexture, _screenData, _screenNeedsRedraw, _screenDirtyRects);
+	_screenNeedsRedraw = false;
+}
 
-		// Update the texture
-		_gameTexture->updateBuffer(surface, w * 3, x, y, w, h);
+void OpenGLGraphicsManager::refreshOverlay() {
+	uploadDirtyRects(_overlayTexture, _overlayData, _overlayNeedsRedraw, _overlayDirtyRects);
+	_overlayNeedsRedraw = false;
+}
 
-		// Free the temp surface
-		delete[] surface;
-	} else {
-		// Update the texture
-		_gameTexture->updateBuffer((byte *)_screenData.pixels + y * _screenData.pitch +
-			x * _screenData.format.bytesPerPixel, _screenData.pitch, x, y, w, h);
+void OpenGLGraphicsManager::uploadDirtyRects(GLTexture *texture, const Graphics::Surface &surface,
+		bool fullRedraw, Graphics::DirtyRectSet &dirtyRects) {
+	if (fullRedraw) {
+		dirtyRects.clear();
+		dirtyRects.add(Common::Rect(0, 0, surface.w, surface.h));
+	} else if (dirtyRects.isBoundingBoxCheaper()) {
+		const Common::Rect box = dirtyRects.getBoundingBox();
+		dirtyRects.clear();
+		dirtyRects.add(box);
 	}
 
-	_screenNeedsRedraw = false;
-	_screenDirtyRect = Common::Rect();
-}
+	for (Graphics::DirtyRectSet::const_iterator r = dirtyRects.begin(); r != dirtyRects.end(); ++r) {
+		const int w = r->width();
+		const int h = r->height();
+		const byte *src = (const byte *)surface.pixels + r->top * surface.pitch;
+		src += r->left * surface.format.bytesPerPixel;
 
-void OpenGLGraphicsManager::refreshOverlay() {
-	if (_overlayNeedsRedraw)
-		_overlayDirtyRect = Common::Rect(0, 0, _overlayData.w, _overlayData.h);
-
-	int x = _overlayDirtyRect.left;
-	int y = _overlayDirtyRect.top;
-	int w = _overlayDirtyRect.width();
-	int h = _overlayDirtyRect.height();
-
-	if (_overlayData.format.bytesPerPixel == 1) {
-		// Create a temporary RGB888 surface
-		byte *surface = new byte[w * h * 3];
-
-		// Convert the paletted buffer to RGB888
-		const byte *src = (byte *)_overlayData.pixels + y * _overlayData.pitch;
-		src += x * _overlayData.format.bytesPerPixel;
-		byte *dst = surface;
-		for (int i = 0; i < h; i++) {
-			for (int j = 0; j < w; j++) {
-				dst[0] = _gamePalette[src[j] * 3];
-				dst[1] = _gamePalette[src[j] * 3 + 1];
-				dst[2] = _gamePalette[src[j] * 3 + 2];
-				dst += 3;
-			}
-			src += _screenData.pitch;
-		}
+		if (surface.format.bytesPerPixel == 1) {
+			if (_conversionBuffer.size() < (uint)(w * h * 3))
+				_conversionBuffer.resize(w * h * 3);
 
-		// Update the texture
-		_overlayTexture->updateBuffer(surface, w * 3, x, y, w, h);
+			// Convert the paletted buffer to RGB888
+			Graphics::crossBlitMap(_conversionBuffer.begin(), src, w * 3, surface.pitch, w, h, 3, _gamePaletteMap);
 
-		// Free the temp surface
-		delete[] surface;
-	} else {
-		// Update the texture
-		_overlayTexture->updateBuffer((byte *)_overlayData.pixels + y * _overlayData.pitch +
-			x * _overlayData.format.bytesPerPixel, _overlayData.pitch, x, y, w, h);
+			texture->updateBuffer(_conversionBuffer.begin(), w * 3, r->left, r->top, w, h);
+		} else {
+			texture->updateBuffer(src, surface.pitch, r->left, r->top, w, h);
+		}
 	}
 
-	_overlayNeedsRedraw = false;
-	_overlayDirtyRect = Common::Rect();
+	dirtyRects.clear();
+}
+
+void OpenGLGraphicsManager::updateUploadStats() {
+	_uploadStats.frames++;
+	_uploadStats.bytes += _gameTexture->getBytesUploaded() + _overlayTexture->getBytesUploaded() + _cursorTexture->getBytesUploaded();
+	_gameTexture->resetBytesUploaded();
+	_overlayTexture->resetBytesUploaded();
+	_cursorTexture->resetBytesUploaded();
+#ifdef USE_OSD
+	_uploadStats.bytes += _osdTexture->getBytesUploaded();
+	_osdTexture->resetBytesUploaded();
+#endif
+
+	if (_uploadStats.frames == 300) {
+		debug(2, "OpenGLGraphicsManager: %u bytes uploaded per frame", _uploadStats.bytes / _uploadStats.frames);
+		memset(&_uploadStats, 0, sizeof(_uploadStats));
+	}
 }
 
 void OpenGLGraphicsManager::refreshCursor() {
@@ -1005,7 +997,7 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 	// Clear the screen buffer
 	glClear(GL_COLOR_BUFFER_BIT); CHECK_GL_ERROR();
 
-	if (_screenNeedsRedraw || !_screenDirtyRect.isEmpty())
+	if (_screenNeedsRedraw || !_screenDirtyRects.empty())
 		// Refresh texture if dirty
 		refreshGameScreen();
 
@@ -1022,7 +1014,7 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 	glPopMatrix();
 
 	if (_overlayVisible) {
-		if (_overlayNeedsRedraw || !_overlayDirtyRect.isEmpty())
+		if (_overlayNeedsRedraw || !_overlayDirtyRects.empty())
 			// Refresh texture if dirty
 			refreshOverlay();
 
@@ -1079,6 +1071,8 @@ void OpenGLGraphicsManager::internUpdateScreen() {
 		glColor4f(1.0f, 1.0f, 1.0f, 1.0f); CHECK_GL_ERROR();
 	}
 #endif
+
+	updateUploadStats();
 }
 
 void OpenGLGraphicsManager::initGL() {
@@ -1158,6 +1152,11 @@ void OpenGLGraphicsManager::loadTextures() {
 	else
 		_cursorTexture->refresh();
 
+	// Uploading many small rects is cheaper than one big one only when it
+	// saves a few kilobytes
+	_screenDirtyRects.setCosts(_gameTexture->getBytesPerPixel(), kUploadRectCost);
+	_overlayDirtyRects.setCosts(_overlayTexture->getBytesPerPixel(), kUploadRectCost);
+
 	GLint filter = _videoMode.antialiasing ? GL_LINEAR : GL_NEAREST;
 	_gameTexture->setFilter(filter);
 	_overlayTexture->setFilter(filter);
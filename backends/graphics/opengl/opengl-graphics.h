@@ -27,6 +27,7 @@
 #include "backends/graphics/graphics.h"
 #include "common/array.h"
 #include "common/rect.h"
+#include "graphics/dirtyrects.h"
 #include "graphics/font.h"
 #include "graphics/pixelformat.h"
 
@@ -226,12 +227,14 @@ protected:
 	Graphics::Surface _screenData;
 	int _screenChangeCount;
 	bool _screenNeedsRedraw;
-	Common::Rect _screenDirtyRect;
+	Graphics::DirtyRectSet _screenDirtyRects;
 
 #ifdef USE_RGB_COLOR
 	Graphics::PixelFormat _screenFormat;
 #endif
 	byte *_gamePalette;
+	/** The game palette as RGB888 texture pixels, for crossBlitMap() */
+	uint32 _gamePaletteMap[256];
 
 	virtual void refreshGameScreen();
 
@@ -246,10 +249,38 @@ protected:
 	Graphics::PixelFormat _overlayFormat;
 	bool _overlayVisible;
 	bool _overlayNeedsRedraw;
-	Common::Rect _overlayDirtyRect;
+	Graphics::DirtyRectSet _overlayDirtyRects;
 
 	virtual void refreshOverlay();
 
+	//
+	// Texture uploads
+	//
+	enum {
+		kMaxDirtyRects = 16,
+		/** Overhead of uploading a rect, in uploaded bytes */
+		kUploadRectCost = 4096
+	};
+
+	/** Buffer for converting paletted pixels, kept to avoid reallocations */
+	Common::Array<byte> _conversionBuffer;
+
+	/**
+	 * Upload the dirty rects of a surface to its texture, converting
+	 * paletted pixels to RGB888 with the game palette.
+	 */
+	void uploadDirtyRects(GLTexture *texture, const Graphics::Surface &surface,
+		bool fullRedraw, Graphics::DirtyRectSet &dirtyRects);
+
+	struct UploadStats {
+		uint frames;
+		uint32 bytes;
+	};
+	UploadStats _uploadStats;
+
+	/** Count the bytes uploaded for this frame, and show the average with debug level 2. */
+	void updateUploadStats();
+
 	//
 	// Mouse
 	//
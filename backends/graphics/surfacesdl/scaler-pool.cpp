@@ -0,0 +1,233 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#if defined(SDL_BACKEND)
+
+#include "backends/graphics/surfacesdl/scaler-pool.h"
+#include "common/debug.h"
+#include "common/textconsole.h"
+
+enum {
+	kMaxThreads = 8
+};
+
+ScalerPool::ScalerPool()
+	: _numJobs(0), _nextJob(0), _jobsDone(0), _generation(0), _quit(false),
+	  _mutex(0), _workCond(0), _doneCond(0),
+	  _statsFrames(0), _statsPixels(0), _statsFrameTicks(0), _statsTicks(0), _statsMaxTicks(0) {
+}
+
+ScalerPool::~ScalerPool() {
+	stop();
+}
+
+void ScalerPool::start(uint numThreads) {
+	stop();
+
+	numThreads = MIN<uint>(numThreads, kMaxThreads);
+	if (!numThreads)
+		return;
+
+	_mutex = SDL_CreateMutex();
+	_workCond = SDL_CreateCond();
+	_doneCond = SDL_CreateCond();
+	_quit = false;
+
+	for (uint i = 0; i < numThreads; i++) {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, "ScummVM Scaler", this);
+#else
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, this);
+#endif
+		if (!thread) {
+			warning("Could not create scaler thread: %s", SDL_GetError());
+			break;
+		}
+		_threads.push_back(thread);
+	}
+
+	debug(1, "Scaling with %d worker threads", _threads.size());
+}
+
+void ScalerPool::stop() {
+	if (!_mutex)
+		return;
+
+	// Signal the workers to end, and wait for them to actually finish
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_workCond);
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _threads.size(); i++)
+		SDL_WaitThread(_threads[i], NULL);
+	_threads.clear();
+
+	SDL_DestroyCond(_doneCond);
+	SDL_DestroyCond(_workCond);
+	SDL_DestroyMutex(_mutex);
+	_doneCond = 0;
+	_workCond = 0;
+	_mutex = 0;
+}
+
+void ScalerPool::add(ScalerProc *scaler, int scale, const uint8 *src, uint32 srcPitch,
+                     uint8 *dst, uint32 dstPitch, int width, int height, const Common::Rect &dstRect) {
+	if (!_threads.empty() && height > 0) {
+		for (uint i = 0; i < _dstRects.size(); i++) {
+			if (_dstRects[i].intersects(dstRect)) {
+				run();
+				break;
+			}
+		}
+		_dstRects.push_back(dstRect);
+	}
+
+	Job job;
+	job.scaler = scaler;
+	job.src = src;
+	job.srcPitch = srcPitch;
+	job.dst = dst;
+	job.dstPitch = dstPitch;
+	job.width = width;
+	job.height = height;
+
+	_statsPixels += width * height;
+
+	int bandHeight = height;
+	if (!_threads.empty()) {
+		// One band for each thread, including the main one
+		const int numBands = _threads.size() + 1;
+		bandHeight = MAX<int>((height + numBands - 1) / numBands, kMinBandHeight);
+		bandHeight = (bandHeight + 3) & ~3;
+	}
+
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+	// The assembly versions of the HQ scalers keep their state in globals
+	if (scaler == HQ2x || scaler == HQ3x)
+		bandHeight = height;
+#endif
+
+	while (height > bandHeight) {
+		job.height = bandHeight;
+		_jobs.push_back(job);
+
+		job.src += bandHeight * srcPitch;
+		job.dst += bandHeight * scale * dstPitch;
+		height -= bandHeight;
+	}
+
+	job.height = height;
+	if (height > 0)
+		_jobs.push_back(job);
+}
+
+void ScalerPool::run() {
+	if (_jobs.empty())
+		return;
+
+	const uint32 start = SDL_GetTicks();
+
+	if (_threads.empty()) {
+		for (JobList::const_iterator job = _jobs.begin(); job != _jobs.end(); ++job)
+			job->scaler(job->src, job->srcPitch, job->dst, job->dstPitch, job->width, job->height);
+	} else {
+		SDL_LockMutex(_mutex);
+		_numJobs = _jobs.size();
+		_nextJob = 0;
+		_jobsDone = 0;
+		_generation++;
+		SDL_CondBroadcast(_workCond);
+
+		processJobs();
+
+		while (_jobsDone < _numJobs)
+			SDL_CondWait(_doneCond, _mutex);
+
+		_numJobs = 0;
+		_nextJob = 0;
+		SDL_UnlockMutex(_mutex);
+	}
+
+	// Keep the storage for the next frame
+	_jobs.resize(0);
+	_dstRects.resize(0);
+
+	const uint32 ticks = SDL_GetTicks() - start;
+	_statsFrameTicks += ticks;
+}
+
+void ScalerPool::endFrame() {
+	_statsTicks += _statsFrameTicks;
+	_statsMaxTicks = MAX(_statsMaxTicks, _statsFrameTicks);
+	_statsFrameTicks = 0;
+
+	if (++_statsFrames == kStatsInterval) {
+		debug(2, "Scaler: %d threads, %.2f ms and %d pixels per frame on average, at most %d ms",
+		      _threads.size(), (double)_statsTicks / _statsFrames, _statsPixels / _statsFrames, _statsMaxTicks);
+
+		_statsFrames = 0;
+		_statsPixels = 0;
+		_statsTicks = 0;
+		_statsMaxTicks = 0;
+	}
+}
+
+void ScalerPool::processJobs() {
+	while (_nextJob < _numJobs) {
+		const Job job = _jobs[_nextJob++];
+
+		SDL_UnlockMutex(_mutex);
+		job.scaler(job.src, job.srcPitch, job.dst, job.dstPitch, job.width, job.height);
+		SDL_LockMutex(_mutex);
+
+		if (++_jobsDone == _numJobs)
+			SDL_CondSignal(_doneCond);
+	}
+}
+
+void ScalerPool::workerThread() {
+	uint32 generation = 0;
+
+	SDL_LockMutex(_mutex);
+	while (true) {
+		// Wait for the jobs of the next frame
+		while (!_quit && _generation == generation)
+			SDL_CondWait(_workCond, _mutex);
+
+		if (_quit)
+			break;
+
+		generation = _generation;
+		processJobs();
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+int SDLCALL ScalerPool::workerThreadEntry(void *arg) {
+	ScalerPool *pool = (ScalerPool *)arg;
+	assert(pool);
+	pool->workerThread();
+	return 0;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_GRAPHICS_SURFACESDL_SCALER_POOL_H
+#define BACKENDS_GRAPHICS_SURFACESDL_SCALER_POOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+#include "graphics/scaler.h"
+#include "common/array.h"
+#include "common/rect.h"
+
+/**
+ * Runs the scaler over the dirty rects of a frame on a pool of worker
+ * threads.
+ *
+ * Each rect is cut into horizontal bands, which are scaled independently.
+ * The scalers only read the pixels around the rect from the source, which
+ * has a border of one pixel for this, so the bands of a rect produce
+ * exactly the same output as scaling it in one go. The main thread works
+ * on the bands too, and run() returns once all of them are done.
+ *
+ * Rects whose destinations intersect are never scaled at the same time,
+ * since the scalers would write to the same pixels.
+ *
+ * Without worker threads, the bands are not split and everything is
+ * scaled on the main thread, like before.
+ */
+class ScalerPool {
+public:
+	ScalerPool();
+	~ScalerPool();
+
+	/**
+	 * Start the given number of worker threads, after stopping the
+	 * current ones. Zero scales everything on the calling thread.
+	 */
+	void start(uint numThreads);
+
+	/** Stop all worker threads. */
+	void stop();
+
+	uint getThreadCount() const { return _threads.size(); }
+
+	/**
+	 * Queue the scaling of a rect, with the same parameters as the
+	 * ScalerProc takes. dstRect is the area of the destination which the
+	 * scaler writes to. If it intersects the one of a queued rect, the
+	 * queued rects are scaled first.
+	 */
+	void add(ScalerProc *scaler, int scale, const uint8 *src, uint32 srcPitch,
+	         uint8 *dst, uint32 dstPitch, int width, int height, const Common::Rect &dstRect);
+
+	/** Scale all queued rects, and wait until they are done. */
+	void run();
+
+	/** Count a frame for the timings, which are printed at debug level 2. */
+	void endFrame();
+
+private:
+	enum {
+		/** Bands are never smaller than this, and a multiple of 4 rows for DotMatrix. */
+		kMinBandHeight = 16,
+		/** Print the timings after this many frames. */
+		kStatsInterval = 300
+	};
+
+	struct Job {
+		ScalerProc *scaler;
+		const uint8 *src;
+		uint32 srcPitch;
+		uint8 *dst;
+		uint32 dstPitch;
+		int width;
+		int height;
+	};
+
+	typedef Common::Array<Job> JobList;
+
+	/**
+	 * The queued jobs. add() changes the list without locking, the workers
+	 * only look at the first _numJobs, which is zero outside of run().
+	 */
+	JobList _jobs;
+
+	/** The destination areas of the queued rects. */
+	Common::Array<Common::Rect> _dstRects;
+
+	// Progress of the frame being scaled, protected by _mutex
+	uint _numJobs;
+	uint _nextJob;
+	uint _jobsDone;
+
+	/** Incremented for every frame, so that the workers notice new jobs. */
+	uint32 _generation;
+	bool _quit;
+
+	SDL_mutex *_mutex;
+	SDL_cond *_workCond;
+	SDL_cond *_doneCond;
+	Common::Array<SDL_Thread *> _threads;
+
+	// Timings
+	uint32 _statsFrames;
+	uint32 _statsPixels;
+	uint32 _statsFrameTicks;
+	uint32 _statsTicks;
+	uint32 _statsMaxTicks;
+
+	/** Run jobs until there are none left. Called with _mutex locked. */
+	void processJobs();
+
+	void workerThread();
+	static int SDLCALL workerThreadEntry(void *arg);
+};
+
+#endif
@@ -139,9 +139,13 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_currentShakePos(0), _newShakePos(0),
 	_paletteDirtyStart(0), _paletteDirtyEnd(0),
 	_screenIsLocked(false),
+	_dirtyRects(NUM_DIRTY_RECT), _numDirtyRects(0),
 	_graphicsMutex(0),
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
+#endif
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+	_showDirtyRectStats(false),
 #endif
 	_transactionMode(kTransactionNone) {
 
@@ -168,6 +172,12 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 		_enableFocusRectDebugCode = ConfMan.getBool("use_sdl_debug_focusrect");
 #endif
 
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+	if (ConfMan.hasKey("show_dirty_rects"))
+		_showDirtyRectStats = ConfMan.getBool("show_dirty_rects");
+	memset(&_dirtyRectStats, 0, sizeof(_dirtyRectStats));
+#endif
+
 	SDL_ShowCursor(SDL_DISABLE);
 
 	memset(&_oldVideoMode, 0, sizeof(_oldVideoMode));
@@ -188,6 +198,10 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 #endif
 	_scalerType = 0;
 
+	// Scaling on worker threads is opt-in for now
+	if (ConfMan.hasKey("scaler_threads"))
+		_scalerPool.start(MAX(ConfMan.getInt("scaler_threads"), 0));
+
 #if !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
 	_videoMode.fullscreen = ConfMan.getBool("fullscreen");
 #else
@@ -563,6 +577,9 @@ bool SurfaceSdlGraphicsManager::setGraphicsMode(int mode) {
 void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 	Common::StackLock lock(_graphicsMutex);
 	ScalerProc *newScalerProc = 0;
+	// Rough cost of scaling one pixel, relative to copying one pixel,
+	// which decides how eagerly dirty rects are merged
+	uint pixelCost = 1;
 
 	switch (_videoMode.mode) {
 	case GFX_NORMAL:
@@ -571,39 +588,50 @@ void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 #ifdef USE_SCALERS
 	case GFX_DOUBLESIZE:
 		newScalerProc = Normal2x;
+		pixelCost = 4;
 		break;
 	case GFX_TRIPLESIZE:
 		newScalerProc = Normal3x;
+		pixelCost = 9;
 		break;
 
 	case GFX_2XSAI:
 		newScalerProc = _2xSaI;
+		pixelCost = 16;
 		break;
 	case GFX_SUPER2XSAI:
 		newScalerProc = Super2xSaI;
+		pixelCost = 16;
 		break;
 	case GFX_SUPEREAGLE:
 		newScalerProc = SuperEagle;
+		pixelCost = 16;
 		break;
 	case GFX_ADVMAME2X:
 		newScalerProc = AdvMame2x;
+		pixelCost = 6;
 		break;
 	case GFX_ADVMAME3X:
 		newScalerProc = AdvMame3x;
+		pixelCost = 12;
 		break;
 #ifdef USE_HQ_SCALERS
 	case GFX_HQ2X:
 		newScalerProc = HQ2x;
+		pixelCost = 24;
 		break;
 	case GFX_HQ3X:
 		newScalerProc = HQ3x;
+		pixelCost = 32;
 		break;
 #endif
 	case GFX_TV2X:
 		newScalerProc = TV2x;
+		pixelCost = 6;
 		break;
 	case GFX_DOTMATRIX:
 		newScalerProc = DotMatrix;
+		pixelCost = 6;
 		break;
 #endif // USE_SCALERS
 
@@ -612,6 +640,7 @@ void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 	}
 
 	_scalerProc = newScalerProc;
+	_dirtyRects.setCosts(pixelCost, DIRTY_RECT_COST);
 
 	if (_videoMode.mode != GFX_NORMAL) {
 		for (int i = 0; i < ARRAYSIZE(s_gfxModeSwitchTable); i++) {
@@ -1048,6 +1077,20 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		_dirtyRectList[0].h = height;
 	}
 
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+	if (_showDirtyRectStats) {
+		updateDirtyRectStats();
+
+		// The statistics are drawn on top of the scaled screen, so their
+		// area has to be redrawn each time. This is not counted.
+		if (!_dirtyRectStatsText.empty()) {
+			const Graphics::Font *font = FontMan.getFontByUsage(Graphics::FontManager::kConsoleFont);
+			addDirtyRect(0, 0, (font->getStringWidth(_dirtyRectStatsText) + 4) / scale1 + 1,
+				(font->getFontHeight() + 4) / scale1 + 1);
+		}
+	}
+#endif
+
 	// Only draw anything if necessary
 	if (_numDirtyRects > 0 || _mouseNeedsRedraw) {
 		SDL_Rect *r;
@@ -1088,8 +1131,9 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				_scalerPool.add(scalerProc, scale1, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h,
+					Common::Rect(rx1, dst_y, rx1 + r->w * scale1, dst_y + dst_h * scale1));
 			}
 
 			r->x = rx1;
@@ -1098,10 +1142,18 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 			r->h = dst_h * scale1;
 
 #ifdef USE_SCALERS
-			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible)
+			if (_videoMode.aspectRatioCorrection && orig_dst_y < height && !_overlayVisible) {
+				// The stretching works in place, so the rect has to be
+				// scaled first
+				_scalerPool.run();
 				r->h = stretch200To240((uint8 *) _hwscreen->pixels, dstPitch, r->w, r->h, r->x, r->y, orig_dst_y * scale1);
+			}
 #endif
 		}
+
+		// Scale all rects at once, if they were not done one by one
+		_scalerPool.run();
+		_scalerPool.endFrame();
 		SDL_UnlockSurface(srcSurf);
 		SDL_UnlockSurface(_hwscreen);
 
@@ -1120,6 +1172,11 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		}
 #endif
 
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+		if (_showDirtyRectStats)
+			drawDirtyRectStats();
+#endif
+
 #ifdef USE_SDL_DEBUG_FOCUSRECT
 		// We draw the focus rectangle on top of everything, to assure it's easily visible.
 		// Of course when the overlay is visible we do not show it, since it is only for game
@@ -1196,11 +1253,68 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 		SDL_UpdateRects(_hwscreen, _numDirtyRects, _dirtyRectList);
 	}
 
-	_numDirtyRects = 0;
+	clearDirtyRects();
 	_forceFull = false;
 	_mouseNeedsRedraw = false;
 }
 
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+void SurfaceSdlGraphicsManager::updateDirtyRectStats() {
+	_dirtyRectStats.frames++;
+	_dirtyRectStats.rects += _numDirtyRects;
+	for (int i = 0; i < _numDirtyRects; i++)
+		_dirtyRectStats.pixels += _dirtyRectList[i].w * _dirtyRectList[i].h;
+
+	// Show the averages of the last second
+	const uint32 now = SDL_GetTicks();
+	if (now - _dirtyRectStats.startTime < 1000)
+		return;
+
+	if (_dirtyRectStats.startTime) {
+		_dirtyRectStatsText = Common::String::format("%u updates/s, %u rects, %u pixels scaled per update",
+			_dirtyRectStats.frames,
+			_dirtyRectStats.rects / _dirtyRectStats.frames,
+			_dirtyRectStats.pixels / _dirtyRectStats.frames);
+	}
+
+	memset(&_dirtyRectStats, 0, sizeof(_dirtyRectStats));
+	_dirtyRectStats.startTime = now;
+}
+
+void SurfaceSdlGraphicsManager::drawDirtyRectStats() {
+	if (_dirtyRectStatsText.empty())
+		return;
+
+	const Graphics::Font *font = FontMan.getFontByUsage(Graphics::FontManager::kConsoleFont);
+
+	SDL_Rect box;
+	box.x = 0;
+	box.y = 0;
+	box.w = MIN<int>(font->getStringWidth(_dirtyRectStatsText) + 4, _hwscreen->w);
+	box.h = MIN<int>(font->getFontHeight() + 4, _hwscreen->h);
+	SDL_FillRect(_hwscreen, &box, SDL_MapRGB(_hwscreen->format, 0, 0, 0));
+
+	if (SDL_LockSurface(_hwscreen))
+		error("drawDirtyRectStats: SDL_LockSurface failed: %s", SDL_GetError());
+
+	Graphics::Surface dst;
+	dst.pixels = _hwscreen->pixels;
+	dst.w = _hwscreen->w;
+	dst.h = _hwscreen->h;
+	dst.pitch = _hwscreen->pitch;
+	dst.format = Graphics::PixelFormat(_hwscreen->format->BytesPerPixel,
+	                                   8 - _hwscreen->format->Rloss, 8 - _hwscreen->format->Gloss,
+	                                   8 - _hwscreen->format->Bloss, 8 - _hwscreen->format->Aloss,
+	                                   _hwscreen->format->Rshift, _hwscreen->format->Gshift,
+	                                   _hwscreen->format->Bshift, _hwscreen->format->Ashift);
+
+	font->drawString(&dst, _dirtyRectStatsText, 2, 2, box.w - 4,
+	                 SDL_MapRGB(_hwscreen->format, 255, 255, 0));
+
+	SDL_UnlockSurface(_hwscreen);
+}
+#endif
+
 bool SurfaceSdlGraphicsManager::saveScreenshot(const char *filename) {
 	assert(_hwscreen != NULL);
 
@@ -1337,11 +1451,6 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 	if (_forceFull)
 		return;
 
-	if (_numDirtyRects == NUM_DIRTY_RECT) {
-		_forceFull = true;
-		return;
-	}
-
 	int height, width;
 
 	if (!_overlayVisible && !realCoordinates) {
@@ -1391,14 +1500,57 @@ void SurfaceSdlGraphicsManager::addDirtyRect(int x, int y, int w, int h, bool re
 		return;
 	}
 
-	if (w > 0 && h > 0) {
-		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
+	if (w <= 0 || h <= 0)
+		return;
 
+	// Rects in real coordinates, like the one of the mouse cursor, are
+	// added after the rect list was converted to screen coordinates. So
+	// they are appended as they are, instead of being merged with the
+	// rects of the game screen.
+	if (realCoordinates) {
+		if (_numDirtyRects == NUM_DIRTY_RECT) {
+			_forceFull = true;
+			return;
+		}
+
+		SDL_Rect *r = &_dirtyRectList[_numDirtyRects++];
 		r->x = x;
 		r->y = y;
 		r->w = w;
 		r->h = h;
+		return;
+	}
+
+	_dirtyRects.add(Common::Rect(x, y, x + w, y + h));
+	updateDirtyRectList();
+}
+
+void SurfaceSdlGraphicsManager::updateDirtyRectList() {
+	if (_dirtyRects.isBoundingBoxCheaper()) {
+		const Common::Rect box = _dirtyRects.getBoundingBox();
+
+		_dirtyRectList[0].x = box.left;
+		_dirtyRectList[0].y = box.top;
+		_dirtyRectList[0].w = box.width();
+		_dirtyRectList[0].h = box.height();
+		_numDirtyRects = 1;
+		return;
+	}
+
+	SDL_Rect *r = _dirtyRectList;
+	for (Graphics::DirtyRectSet::const_iterator i = _dirtyRects.begin(); i != _dirtyRects.end(); ++i, ++r) {
+		r->x = i->left;
+		r->y = i->top;
+		r->w = i->width();
+		r->h = i->height();
 	}
+
+	_numDirtyRects = _dirtyRects.size();
+}
+
+void SurfaceSdlGraphicsManager::clearDirtyRects() {
+	_dirtyRects.clear();
+	_numDirtyRects = 0;
 }
 
 int16 SurfaceSdlGraphicsManager::getHeight() {
@@ -25,9 +25,12 @@
 
 #include "backends/graphics/graphics.h"
 #include "backends/graphics/sdl/sdl-graphics.h"
+#include "backends/graphics/surfacesdl/scaler-pool.h"
+#include "graphics/dirtyrects.h"
 #include "graphics/pixelformat.h"
 #include "graphics/scaler.h"
 #include "common/events.h"
+#include "common/str.h"
 #include "common/system.h"
 
 #include "backends/events/sdl/sdl-events.h"
@@ -37,6 +40,8 @@
 #ifndef RELEASE_BUILD
 // Define this to allow for focus rectangle debugging
 #define USE_SDL_DEBUG_FOCUSRECT
+// Define this to allow showing statistics about the dirty rects
+#define USE_SDL_DEBUG_DIRTYRECTS
 #endif
 
 #if !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
@@ -230,6 +235,9 @@ protected:
 
 	ScalerProc *_scalerProc;
 	int _scalerType;
+
+	/** Scales the dirty rects on multiple threads */
+	ScalerPool _scalerPool;
 	int _transactionMode;
 
 	bool _screenIsLocked;
@@ -239,10 +247,15 @@ protected:
 
 	enum {
 		NUM_DIRTY_RECT = 100,
-		MAX_SCALING = 3
+		MAX_SCALING = 3,
+		/** Overhead of scaling a dirty rect, in copied pixels */
+		DIRTY_RECT_COST = 1024
 	};
 
-	// Dirty rect management
+	// Dirty rect management. The rects are collected in _dirtyRects, which
+	// merges them, and _dirtyRectList holds the rects to redraw. Rects in
+	// real coordinates bypass _dirtyRects and are appended to the list.
+	Graphics::DirtyRectSet _dirtyRects;
 	SDL_Rect _dirtyRectList[NUM_DIRTY_RECT];
 	int _numDirtyRects;
 
@@ -312,7 +325,27 @@ protected:
 	Common::Rect _focusRect;
 #endif
 
+#ifdef USE_SDL_DEBUG_DIRTYRECTS
+	struct DirtyRectStats {
+		uint32 startTime;
+		uint frames;
+		uint rects;
+		uint pixels;
+	};
+
+	bool _showDirtyRectStats;
+	DirtyRectStats _dirtyRectStats;
+	Common::String _dirtyRectStatsText;
+
+	/** Count the rects and pixels which are going to be scaled. */
+	void updateDirtyRectStats();
+	/** Draw the dirty rect statistics at the top left of the screen. */
+	void drawDirtyRectStats();
+#endif
+
 	virtual void addDirtyRect(int x, int y, int w, int h, bool realCoordinates = false);
+	void updateDirtyRectList();
+	void clearDirtyRects();
 
 	virtual void drawMouse();
 	virtual void undrawMouse();
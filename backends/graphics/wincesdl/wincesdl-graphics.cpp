@@ -701,7 +701,7 @@ void WINCESdlGraphicsManager::internUpdateScreen() {
 	if (numRectsOut > 0)
 		SDL_UpdateRects(_hwscreen, numRectsOut, _dirtyRectOut);
 
-	_numDirtyRects = 0;
+	clearDirtyRects();
 	_forceFull = false;
 }
 
@@ -62,6 +62,7 @@ ifdef SDL_BACKEND
 MODULE_OBJS += \
 	events/sdl/sdl-events.o \
 	graphics/sdl/sdl-graphics.o \
+	graphics/surfacesdl/scaler-pool.o \
 	graphics/surfacesdl/surfacesdl-graphics.o \
 	mixer/doublebuffersdl/doublebuffersdl-mixer.o \
 	mixer/sdl/sdl-mixer.o \
@@ -79,6 +80,7 @@ endif
 ifdef POSIX
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
+	fs/posix/posix-fs-cache.o \
 	fs/posix/posix-fs-factory.o \
 	plugins/posix/posix-provider.o \
 	saves/posix/posix-saves.o \
@@ -111,6 +113,7 @@ endif
 ifdef PLAYSTATION3
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
+	fs/posix/posix-fs-cache.o \
 	fs/posix/posix-fs-factory.o \
 	fs/ps3/ps3-fs-factory.o \
 	events/ps3sdl/ps3sdl-events.o \
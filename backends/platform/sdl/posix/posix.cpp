@@ -27,6 +27,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_time_h	//On IRIX, sys/stat.h includes sys/time.h
 
 #include "common/scummsys.h"
+#include "common/config-manager.h"
 
 #ifdef POSIX
 
@@ -67,6 +68,19 @@ void OSystem_POSIX::initBackend() {
 	// Invoke parent implementation of this method
 	OSystem_SDL::initBackend();
 
+	// The config file is loaded by now, so the directory cache can be set up
+	if (ConfMan.getBool("fs_cache")) {
+		Common::String cacheFile = ConfMan.get("fs_cache_path");
+		if (cacheFile.empty()) {
+			const char *home = getenv("HOME");
+			if (home != NULL)
+				cacheFile = Common::String(home) + "/.scummvm-fscache";
+		}
+
+		if (!cacheFile.empty())
+			((POSIXFilesystemFactory *)_fsFactory)->enableDirectoryCache(cacheFile);
+	}
+
 #if defined(USE_TASKBAR) && defined(USE_TASKBAR_UNITY)
 	// Register the taskbar manager as an event source (this is necessary for the glib event loop to be run)
 	_eventManager->getEventDispatcher()->registerSource((UnityTaskbarManager *)_taskbarManager, false);
@@ -26,8 +26,10 @@
 #define COMMON_BITSTREAM_H
 
 #include "common/scummsys.h"
+#include "common/types.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/endian.h"
 
 namespace Common {
 
@@ -67,29 +69,160 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits of each value handed out starting with the MSB? */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
 };
 
 /**
- * A template implementing a bit stream for different data memory layouts.
+ * A cut-down version of MemoryReadStream, for use with the bit stream
+ * readers below.
+ *
+ * None of its methods are virtual, so a BitStreamReader reading from it
+ * can be fully inlined into its users.
+ */
+class BitStreamMemoryStream {
+private:
+	const byte * const _ptrOrig;
+	const byte *_ptr;
+	const uint32 _size;
+	bool _eos;
+	DisposeAfterUse::Flag _disposeMemory;
+
+	/** Do we have the given number of bytes left? Otherwise, go to the end and flag it. */
+	inline bool available(uint32 n) {
+		if ((uint32)(_ptr - _ptrOrig) + n <= _size)
+			return true;
+
+		_ptr = _ptrOrig + _size;
+		_eos = true;
+		return false;
+	}
+
+public:
+	BitStreamMemoryStream(const byte *dataPtr, uint32 dataSize, DisposeAfterUse::Flag disposeMemory = DisposeAfterUse::NO) :
+		_ptrOrig(dataPtr), _ptr(dataPtr), _size(dataSize), _eos(false), _disposeMemory(disposeMemory) {
+	}
+
+	~BitStreamMemoryStream() {
+		if (_disposeMemory)
+			free(const_cast<byte *>(_ptrOrig));
+	}
+
+	bool eos() const {
+		return _eos;
+	}
+
+	bool err() const {
+		return false;
+	}
+
+	int32 pos() const {
+		return _ptr - _ptrOrig;
+	}
+
+	int32 size() const {
+		return _size;
+	}
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		switch (whence) {
+		case SEEK_END:
+			offset = _size + offset;
+			// Fall through
+		case SEEK_SET:
+			_ptr = _ptrOrig + offset;
+			break;
+
+		case SEEK_CUR:
+			_ptr += offset;
+			break;
+		}
+
+		assert((uint32)(_ptr - _ptrOrig) <= _size);
+
+		// Reset end-of-stream flag on a successful seek
+		_eos = false;
+		return true;
+	}
+
+	byte readByte() {
+		if (!available(1))
+			return 0;
+
+		return *_ptr++;
+	}
+
+	uint16 readUint16LE() {
+		if (!available(2))
+			return 0;
+
+		uint16 val = READ_LE_UINT16(_ptr);
+		_ptr += 2;
+		return val;
+	}
+
+	uint16 readUint16BE() {
+		if (!available(2))
+			return 0;
+
+		uint16 val = READ_BE_UINT16(_ptr);
+		_ptr += 2;
+		return val;
+	}
+
+	uint32 readUint32LE() {
+		if (!available(4))
+			return 0;
+
+		uint32 val = READ_LE_UINT32(_ptr);
+		_ptr += 4;
+		return val;
+	}
+
+	uint32 readUint32BE() {
+		if (!available(4))
+			return 0;
+
+		uint32 val = READ_BE_UINT32(_ptr);
+		_ptr += 4;
+		return val;
+	}
+};
+
+/**
+ * A template implementing a bit stream reader for different data memory
+ * layouts, on top of any stream type providing the reading methods of
+ * SeekableReadStream.
  *
  * Such a bit stream reads valueBits-wide values from the data stream and
- * gives access to their bits, one at a time.
+ * gives access to their bits.
  *
  * For example, a bit stream with the layout parameters 32, true, false
  * for valueBits, isLE and isMSB2LSB, reads 32bit little-endian values
  * from the data stream and hands out the bits in the order of LSB to MSB.
+ *
+ * The reader is not derived from BitStream and none of its methods are
+ * virtual. The bits are buffered in a 32-bit cache, which is refilled
+ * with as many whole values as fit into it, so reading, peeking at and
+ * skipping multiple bits doesn't have to loop over the single bits.
  */
-template<int valueBits, bool isLE, bool isMSB2LSB>
-class BitStreamImpl : public BitStream {
+template<class STREAM, int valueBits, bool isLE, bool isMSB2LSB>
+class BitStreamReader {
 private:
-	SeekableReadStream *_stream; ///< The input stream.
-	bool _disposeAfterUse;       ///< Should we delete the stream on destruction?
+	STREAM *_stream;                       ///< The input stream.
+	DisposeAfterUse::Flag _disposeAfterUse; ///< Should we delete the stream on destruction?
 
-	uint32 _value;   ///< Current value.
-	uint8  _inValue; ///< Position within the current value.
+	/**
+	 * The bits read from the stream but not handed out yet. Reading MSB
+	 * first, they are in the upper bits, otherwise in the lower bits.
+	 * The remaining bits are always zero.
+	 */
+	uint32 _cache;
+	uint8  _cacheBits; ///< Number of bits in the cache.
 
 	/** Read a data value. */
 	inline uint32 readData() {
@@ -113,65 +246,87 @@ private:
 		return 0;
 	}
 
-	/** Read the next data value. */
-	inline void readValue() {
-		if ((size() - pos()) < valueBits)
-			error("BitStreamImpl::readValue(): End of bit stream reached");
+	/** Fill the empty cache with as many whole values as fit into it and are left. */
+	inline void fillCache() {
+		const uint32 bytesLeft = _stream->size() - _stream->pos();
+
+		uint32 values = 32 / valueBits;
+		if (values > bytesLeft / (valueBits >> 3))
+			values = bytesLeft / (valueBits >> 3);
+
+		_cache = 0;
+		_cacheBits = 0;
+
+		for (uint32 i = 0; i < values; i++) {
+			const uint32 value = readData();
+
+			if (isMSB2LSB)
+				_cache |= (value << (32 - valueBits)) >> _cacheBits;
+			else
+				_cache |= value << _cacheBits;
+
+			_cacheBits += valueBits;
+		}
 
-		_value = readData();
 		if (_stream->err() || _stream->eos())
-			error("BitStreamImpl::readValue(): Read error");
+			error("BitStreamReader::fillCache(): Read error");
+	}
 
-		// If we're reading the bits MSB first, we need to shift the value to that position
+	/** Return the first n bits in the cache, 0 < n <= 32. */
+	inline uint32 cacheBits(uint32 cache, uint8 n) const {
 		if (isMSB2LSB)
-			_value <<= 32 - valueBits;
-		}
+			return cache >> (32 - n);
+
+		return (n < 32) ? (cache & ((1U << n) - 1)) : cache;
+	}
+
+	/** Hand out n bits from the cache, 0 < n <= _cacheBits. */
+	inline uint32 takeBits(uint8 n) {
+		const uint32 v = cacheBits(_cache, n);
+
+		if (n == 32)
+			_cache = 0;
+		else if (isMSB2LSB)
+			_cache <<= n;
+		else
+			_cache >>= n;
+
+		_cacheBits -= n;
+		return v;
+	}
 
 public:
 	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
-	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
-		_stream(stream), _disposeAfterUse(disposeAfterUse), _value(0), _inValue(0) {
+	BitStreamReader(STREAM *stream, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::NO) :
+		_stream(stream), _disposeAfterUse(disposeAfterUse), _cache(0), _cacheBits(0) {
 
 		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+			error("BitStreamReader: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
 	}
 
 	/** Create a bit stream using this input data stream. */
-	BitStreamImpl(SeekableReadStream &stream) :
-		_stream(&stream), _disposeAfterUse(false), _value(0), _inValue(0) {
+	BitStreamReader(STREAM &stream) :
+		_stream(&stream), _disposeAfterUse(DisposeAfterUse::NO), _cache(0), _cacheBits(0) {
 
 		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+			error("BitStreamReader: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
 	}
 
-	~BitStreamImpl() {
+	~BitStreamReader() {
 		if (_disposeAfterUse)
 			delete _stream;
 	}
 
 	/** Read a bit from the bit stream. */
-	uint32 getBit() {
-		// Check if we need the next value
-		if (_inValue == 0)
-			readValue();
-
-		// Get the current bit
-		int b = 0;
-		if (isMSB2LSB)
-			b = ((_value & 0x80000000) == 0) ? 0 : 1;
-		else
-			b = ((_value & 1) == 0) ? 0 : 1;
-
-		// Shift to the next bit
-		if (isMSB2LSB)
-			_value <<= 1;
-		else
-			_value >>= 1;
+	inline uint32 getBit() {
+		if (_cacheBits == 0) {
+			fillCache();
 
-		// Increase the position within the current value
-		_inValue = (_inValue + 1) % valueBits;
+			if (_cacheBits == 0)
+				error("BitStreamReader::getBit(): End of bit stream reached");
+		}
 
-		return b;
+		return takeBits(1);
 	}
 
 	/**
@@ -184,42 +339,41 @@ public:
 	 * If the bitstream is MSB2LSB, the 4-bit value would be 0101.
 	 * If the bitstream is LSB2MSB, the 4-bit value would be 0011.
 	 */
-	uint32 getBits(uint8 n) {
+	inline uint32 getBits(uint8 n) {
 		if (n == 0)
 			return 0;
 
 		if (n > 32)
-			error("BitStreamImpl::getBits(): Too many bits requested to be read");
+			error("BitStreamReader::getBits(): Too many bits requested to be read");
 
-		// Read the number of bits
-		uint32 v = 0;
+		if (n <= _cacheBits)
+			return takeBits(n);
 
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
+		// Take what's left in the cache, and the rest from the next values
+		const uint8 have = _cacheBits;
+		const uint32 first = (have == 0) ? 0 : takeBits(have);
 
-			v >>= (32 - n);
-		}
+		fillCache();
+		if (_cacheBits < n - have)
+			error("BitStreamReader::getBits(): End of bit stream reached");
 
-		return v;
-	}
+		const uint32 second = takeBits(n - have);
 
-	/** Read a bit from the bit stream, without changing the stream's position. */
-	uint32 peekBit() {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (have == 0)
+			return second;
 
-		uint32 v = getBit();
+		if (isMSB2LSB)
+			return (first << (n - have)) | second;
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		return first | (second << have);
+	}
 
-		return v;
+	/** Read a bit from the bit stream, without changing the stream's position. */
+	inline uint32 peekBit() {
+		if (_cacheBits != 0)
+			return cacheBits(_cache, 1);
+
+		return peekBits(1);
 	}
 
 	/**
@@ -227,18 +381,39 @@ public:
 	 *
 	 * The bit order is the same as in getBits().
 	 */
-	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+	inline uint32 peekBits(uint8 n) {
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamReader::peekBits(): Too many bits requested to be read");
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		if (n <= _cacheBits)
+			return cacheBits(_cache, n);
 
-		return v;
+		// Add the following values, and seek back afterwards
+		if ((size() - pos()) < n)
+			error("BitStreamReader::peekBits(): End of bit stream reached");
+
+		uint32 v = _cache;
+		uint32 have = _cacheBits;
+		uint32 values = 0;
+
+		for (; have < n; have += valueBits, values++) {
+			const uint32 next = readData();
+
+			if (isMSB2LSB)
+				v |= (next << (32 - valueBits)) >> have;
+			else
+				v |= next << have;
+		}
+
+		if (_stream->err() || _stream->eos())
+			error("BitStreamReader::peekBits(): Read error");
+
+		_stream->seek(-(int32)(values * (valueBits >> 3)), SEEK_CUR);
+
+		return cacheBits(v, n);
 	}
 
 	/**
@@ -252,9 +427,9 @@ public:
 	 * If the stream's bitorder is MSB2LSB, the resulting value is 0001100y.
 	 * If the stream's bitorder is LSB2MSB, the resulting value is 000y1100.
 	 */
-	void addBit(uint32 &x, uint32 n) {
+	inline void addBit(uint32 &x, uint32 n) {
 		if (n >= 32)
-			error("BitStreamImpl::addBit(): Too many bits requested to be read");
+			error("BitStreamReader::addBit(): Too many bits requested to be read");
 
 		if (isMSB2LSB)
 			x = (x << 1) | getBit();
@@ -266,35 +441,134 @@ public:
 	void rewind() {
 		_stream->seek(0);
 
-		_value   = 0;
-		_inValue = 0;
+		_cache     = 0;
+		_cacheBits = 0;
 	}
 
 	/** Skip the specified amount of bits. */
-	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+	inline void skip(uint32 n) {
+		if (n <= _cacheBits) {
+			// Stay within the cache
+			if (n > 0)
+				takeBits(n);
+			return;
+		}
+
+		// Drop the rest of the cache
+		n -= _cacheBits;
+		_cache     = 0;
+		_cacheBits = 0;
+
+		// Seek over whole values
+		if (n >= valueBits) {
+			const uint32 values = n / valueBits;
+			if ((size() - pos()) < values * valueBits)
+				error("BitStreamReader::skip(): End of bit stream reached");
+
+			_stream->seek(values * (valueBits >> 3), SEEK_CUR);
+			n -= values * valueBits;
+		}
+
+		if (n > 0) {
+			fillCache();
+			if (_cacheBits < n)
+				error("BitStreamReader::skip(): End of bit stream reached");
+
+			takeBits(n);
+		}
 	}
 
-	/** Return the stream position in bits. */
-	uint32 pos() const {
-		if (_stream->pos() == 0)
-			return 0;
+	/** Are the bits of each value handed out starting with the MSB? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
 
-		uint32 p = (_inValue == 0) ? _stream->pos() : ((_stream->pos() - 1) & ~((uint32) ((valueBits >> 3) - 1)));
-		return p * 8 + _inValue;
+	/** Return the stream position in bits. */
+	inline uint32 pos() const {
+		return _stream->pos() * 8 - _cacheBits;
 	}
 
 	/** Return the stream size in bits. */
-	uint32 size() const {
+	inline uint32 size() const {
 		return (_stream->size() & ~((uint32) ((valueBits >> 3) - 1))) * 8;
 	}
 
+	/** Has the end of the stream been reached? */
 	bool eos() const {
 		return _stream->eos() || (pos() >= size());
 	}
 };
 
+/**
+ * A template implementing the BitStream interface for different data
+ * memory layouts, by wrapping a BitStreamReader on a SeekableReadStream.
+ *
+ * Code that doesn't need to hide the layout behind the interface should
+ * use a BitStreamReader directly, to avoid the virtual calls.
+ */
+template<int valueBits, bool isLE, bool isMSB2LSB>
+class BitStreamImpl : public BitStream {
+private:
+	BitStreamReader<SeekableReadStream, valueBits, isLE, isMSB2LSB> _reader;
+
+public:
+	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
+	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
+		_reader(stream, disposeAfterUse ? DisposeAfterUse::YES : DisposeAfterUse::NO) {
+	}
+
+	/** Create a bit stream using this input data stream. */
+	BitStreamImpl(SeekableReadStream &stream) : _reader(stream) {
+	}
+
+	~BitStreamImpl() {
+	}
+
+	uint32 getBit() {
+		return _reader.getBit();
+	}
+
+	uint32 getBits(uint8 n) {
+		return _reader.getBits(n);
+	}
+
+	uint32 peekBit() {
+		return _reader.peekBit();
+	}
+
+	uint32 peekBits(uint8 n) {
+		return _reader.peekBits(n);
+	}
+
+	void addBit(uint32 &x, uint32 n) {
+		_reader.addBit(x, n);
+	}
+
+	void rewind() {
+		_reader.rewind();
+	}
+
+	void skip(uint32 n) {
+		_reader.skip(n);
+	}
+
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
+	uint32 pos() const {
+		return _reader.pos();
+	}
+
+	uint32 size() const {
+		return _reader.size();
+	}
+
+	bool eos() const {
+		return _reader.eos();
+	}
+};
+
 // typedefs for various memory layouts.
 
 /** 8-bit data, MSB to LSB. */
@@ -320,6 +594,31 @@ typedef BitStreamImpl<32, false, true > BitStream32BEMSB;
 /** 32-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<32, false, false> BitStream32BELSB;
 
+// typedefs for various memory layouts of in-memory data, read without virtual calls.
+
+/** 8-bit data, MSB to LSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 8, false, true > BitStreamMemory8MSB;
+/** 8-bit data, LSB to MSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 8, false, false> BitStreamMemory8LSB;
+
+/** 16-bit little-endian data, MSB to LSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 16, true , true > BitStreamMemory16LEMSB;
+/** 16-bit little-endian data, LSB to MSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 16, true , false> BitStreamMemory16LELSB;
+/** 16-bit big-endian data, MSB to LSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 16, false, true > BitStreamMemory16BEMSB;
+/** 16-bit big-endian data, LSB to MSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 16, false, false> BitStreamMemory16BELSB;
+
+/** 32-bit little-endian data, MSB to LSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 32, true , true > BitStreamMemory32LEMSB;
+/** 32-bit little-endian data, LSB to MSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 32, true , false> BitStreamMemory32LELSB;
+/** 32-bit big-endian data, MSB to LSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 32, false, true > BitStreamMemory32BEMSB;
+/** 32-bit big-endian data, LSB to MSB. */
+typedef BitStreamReader<BitStreamMemoryStream, 32, false, false> BitStreamMemory32BELSB;
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
@@ -0,0 +1,457 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/scummsys.h"
+#include "common/func.h"
+#include "common/textconsole.h"	// For error()
+
+namespace Common {
+
+/**
+ * FlatHashMap<Key,Val> is an alternative to HashMap<Key,Val>, which stores
+ * its keys and values inline in one array instead of allocating a node for
+ * each entry.
+ *
+ * It uses open addressing with linear probing. A separate array holds one
+ * control byte per slot, which is either a marker for an empty or erased
+ * slot, or seven bits of the key's hash. Lookups scan the densely packed
+ * control bytes and only compare keys whose hash bits match, so they touch
+ * very few cache lines, and iteration walks through contiguous memory.
+ *
+ * It supports the commonly used subset of the HashMap interface and has
+ * the same requirements on the hash and equality functors.
+ *
+ * @note Unlike with HashMap, adding entries may move the existing entries
+ *       in memory. Hence any references or pointers to values, as well as
+ *       iterators, are invalidated when a new key is inserted. Erasing
+ *       entries does not move anything.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> HM_t;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+		Node(const Node &node) : _key(node._key), _value(node._value) {}
+	private:
+		Node &operator=(const Node &);
+	};
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The quotient of the next two constants controls how much the
+		// internal storage of the hashmap may fill up (counting erased
+		// entries) before being resized automatically.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 3,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 4
+	};
+
+	enum {
+		kCtrlEmpty = 0x80,		///< slot was never used
+		kCtrlErased = 0xFF		///< slot held an entry which got erased
+		// Any value < 0x80 marks a used slot and holds seven bits of the hash
+	};
+
+	byte *_ctrl;		///< control bytes, one per slot
+	Node *_nodes;		///< uninitialized storage for the entries, one per slot
+	uint _mask;		///< Capacity of the map minus one; the capacity must be a power of two
+	uint _size;
+	uint _erased;		///< Number of erased slots
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	/**
+	 * Scramble the result of the hash functor. Many hash functors, e.g. the
+	 * ones for integers, return their argument unmodified, which linear
+	 * probing does not cope well with.
+	 */
+	static uint32 mixHash(uint32 hash) {
+		hash *= 0x9E3779B1;
+		return hash ^ (hash >> 16);
+	}
+
+	static byte hashCtrl(uint32 hash) {
+		return (byte)(hash >> 25);
+	}
+
+	static bool isUsed(byte ctrl) {
+		return (ctrl & 0x80) == 0;
+	}
+
+	void allocStorage(uint capacity) {
+		_mask = capacity - 1;
+		_ctrl = (byte *)malloc(capacity);
+		_nodes = (Node *)malloc(capacity * sizeof(Node));
+		if (!_ctrl || !_nodes)
+			error("FlatHashMap: Failure to allocate %u slots", capacity);
+		memset(_ctrl, kCtrlEmpty, capacity);
+		_size = 0;
+		_erased = 0;
+	}
+
+	void freeStorage() {
+		for (uint ctr = 0; ctr <= _mask; ++ctr) {
+			if (isUsed(_ctrl[ctr]))
+				_nodes[ctr].~Node();
+		}
+		free(_ctrl);
+		free(_nodes);
+	}
+
+	void assign(const HM_t &map);
+	uint lookup(const Key &key) const;
+	uint lookupAndCreateIfMissing(const Key &key);
+	void resizeStorage(uint newCapacity);
+
+	template<class T> friend class IteratorImpl;
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		uint _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(uint idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(isUsed(_hashmap->_ctrl[_idx]));
+			return &_hashmap->_nodes[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			_idx = _hashmap->nextUsed(_idx + 1);
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+	/** Return the index of the first used slot at or after idx, or (uint)-1. */
+	uint nextUsed(uint idx) const {
+		for (; idx <= _mask; ++idx) {
+			if (isUsed(_ctrl[idx]))
+				return idx;
+		}
+		return (uint)-1;
+	}
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap() : _defaultVal() {
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+	}
+
+	FlatHashMap(const HM_t &map) : _defaultVal() {
+		assign(map);
+	}
+
+	~FlatHashMap() {
+		freeStorage();
+	}
+
+	HM_t &operator=(const HM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const {
+		return lookup(key) <= _mask;
+	}
+
+	Val &operator[](const Key &key) { return getVal(key); }
+	const Val &operator[](const Key &key) const { return getVal(key); }
+
+	Val &getVal(const Key &key) {
+		// Inserting may reallocate _nodes, so look up the slot first
+		const uint ctr = lookupAndCreateIfMissing(key);
+		return _nodes[ctr]._value;
+	}
+
+	const Val &getVal(const Key &key) const {
+		return getVal(key, _defaultVal);
+	}
+
+	const Val &getVal(const Key &key, const Val &defaultVal) const {
+		const uint ctr = lookup(key);
+		if (ctr <= _mask)
+			return _nodes[ctr]._value;
+		else
+			return defaultVal;
+	}
+
+	void setVal(const Key &key, const Val &val) {
+		const uint ctr = lookupAndCreateIfMissing(key);
+		_nodes[ctr]._value = val;
+	}
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	uint size() const { return _size; }
+
+	bool empty() const {
+		return (_size == 0);
+	}
+
+	iterator begin() {
+		return iterator(nextUsed(0), this);
+	}
+	iterator end() {
+		return iterator((uint)-1, this);
+	}
+
+	const_iterator begin() const {
+		return const_iterator(nextUsed(0), this);
+	}
+	const_iterator end() const {
+		return const_iterator((uint)-1, this);
+	}
+
+	iterator find(const Key &key) {
+		const uint ctr = lookup(key);
+		return iterator(ctr <= _mask ? ctr : (uint)-1, this);
+	}
+
+	const_iterator find(const Key &key) const {
+		const uint ctr = lookup(key);
+		return const_iterator(ctr <= _mask ? ctr : (uint)-1, this);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const HM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// The slots stay the same, so the control bytes can be copied as is.
+	memcpy(_ctrl, map._ctrl, _mask + 1);
+	for (uint ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(_ctrl[ctr]))
+			new ((void *)&_nodes[ctr]) Node(map._nodes[ctr]);
+	}
+
+	_size = map._size;
+	_erased = map._erased;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray && _mask >= FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+		return;
+	}
+
+	for (uint ctr = 0; ctr <= _mask; ++ctr) {
+		if (isUsed(_ctrl[ctr]))
+			_nodes[ctr].~Node();
+	}
+	memset(_ctrl, kCtrlEmpty, _mask + 1);
+
+	_size = 0;
+	_erased = 0;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::resizeStorage(uint newCapacity) {
+	const uint oldMask = _mask;
+	byte *oldCtrl = _ctrl;
+	Node *oldNodes = _nodes;
+#ifndef NDEBUG
+	const uint oldSize = _size;
+#endif
+
+	allocStorage(newCapacity);
+
+	// Move all the entries over. Since we know that no key exists twice in
+	// the old table, there is no need to call _equal().
+	for (uint ctr = 0; ctr <= oldMask; ++ctr) {
+		if (!isUsed(oldCtrl[ctr]))
+			continue;
+
+		const uint32 hash = mixHash(_hash(oldNodes[ctr]._key));
+		uint idx = hash & _mask;
+		while (_ctrl[idx] != kCtrlEmpty)
+			idx = (idx + 1) & _mask;
+
+		_ctrl[idx] = oldCtrl[ctr];
+		new ((void *)&_nodes[idx]) Node(oldNodes[ctr]);
+		oldNodes[ctr].~Node();
+		_size++;
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == oldSize);
+
+	free(oldCtrl);
+	free(oldNodes);
+}
+
+/**
+ * Find the slot holding the given key.
+ *
+ * @return the slot index, or a value greater than _mask if the key is
+ *         not contained in the map
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+uint FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 hash = mixHash(_hash(key));
+	const byte ctrl = hashCtrl(hash);
+
+	// This terminates since the load factor guarantees empty slots.
+	for (uint ctr = hash & _mask; ; ctr = (ctr + 1) & _mask) {
+		if (_ctrl[ctr] == ctrl && _equal(_nodes[ctr]._key, key))
+			return ctr;
+		if (_ctrl[ctr] == kCtrlEmpty)
+			return _mask + 1;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+uint FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	const uint32 hash = mixHash(_hash(key));
+	const byte ctrl = hashCtrl(hash);
+	const uint NONE_FOUND = _mask + 1;
+	uint firstErased = NONE_FOUND;
+	uint ctr;
+
+	for (ctr = hash & _mask; _ctrl[ctr] != kCtrlEmpty; ctr = (ctr + 1) & _mask) {
+		if (_ctrl[ctr] == ctrl && _equal(_nodes[ctr]._key, key))
+			return ctr;
+		if (_ctrl[ctr] == kCtrlErased && firstErased == NONE_FOUND)
+			firstErased = ctr;
+	}
+
+	// Reuse an erased slot, which does not change the load of the map.
+	if (firstErased != NONE_FOUND) {
+		ctr = firstErased;
+		_erased--;
+	} else if ((_size + _erased + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR >
+	           (_mask + 1) * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		// Keep the load factor below a certain threshold. If the map is
+		// mostly filled with erased slots, rehashing at the same size
+		// suffices to get rid of them.
+		uint capacity = _mask + 1;
+		while ((_size + 1) * 2 * FLATHASHMAP_LOADFACTOR_DENOMINATOR >
+		       capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity *= 2;
+		resizeStorage(capacity);
+
+		for (ctr = hash & _mask; _ctrl[ctr] != kCtrlEmpty; ctr = (ctr + 1) & _mask)
+			;
+	}
+
+	_ctrl[ctr] = ctrl;
+	new ((void *)&_nodes[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	const uint ctr = entry._idx;
+	assert(ctr <= _mask);
+	assert(isUsed(_ctrl[ctr]));
+
+	// Mark the slot as erased, so that lookups keep probing past it.
+	_nodes[ctr].~Node();
+	_ctrl[ctr] = kCtrlErased;
+	_size--;
+	_erased++;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	const uint ctr = lookup(key);
+	if (ctr > _mask)
+		return;
+
+	_nodes[ctr].~Node();
+	_ctrl[ctr] = kCtrlErased;
+	_size--;
+	_erased++;
+}
+
+}	// End of namespace Common
+
+#endif
@@ -38,7 +38,8 @@
  * @def USE_HASHMAP_MEMORY_POOL
  * Enable the following define to let HashMaps use a memory pool for the
  nodes they contain. * This increases memory usage, but also can improve
- speed quite a bit.
+ speed quite a bit. Without it, the nodes come from the shared small
+ object allocator.
  */
 #define USE_HASHMAP_MEMORY_POOL
 
@@ -49,9 +50,7 @@
 #include "common/debug.h"
 #endif
 
-#ifdef USE_HASHMAP_MEMORY_POOL
 #include "common/memorypool.h"
-#endif
 
 
 
@@ -108,6 +107,8 @@ private:
 
 #ifdef USE_HASHMAP_MEMORY_POOL
 	ObjectPool<Node, HASHMAP_MEMORYPOOL_SIZE> _nodePool;
+#else
+	SmallObjectPool<Node> _nodePool;
 #endif
 
 	Node **_storage;	///< hashtable of size arrsize.
@@ -129,20 +130,12 @@ private:
 #endif
 
 	Node *allocNode(const Key &key) {
-#ifdef USE_HASHMAP_MEMORY_POOL
 		return new (_nodePool) Node(key);
-#else
-		return new Node(key);
-#endif
 	}
 
 	void freeNode(Node *node) {
 		if (node && node != HASHMAP_DUMMY_NODE)
-#ifdef USE_HASHMAP_MEMORY_POOL
 			_nodePool.deleteChunk(node);
-#else
-			delete node;
-#endif
 	}
 
 	void assign(const HM_t &map);
@@ -396,9 +389,7 @@ void HashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
 		_storage[ctr] = NULL;
 	}
 
-#ifdef USE_HASHMAP_MEMORY_POOL
 	_nodePool.freeUnusedPages();
-#endif
 
 	if (shrinkArray && _mask >= HASHMAP_MIN_CAPACITY) {
 		delete[] _storage;
@@ -25,10 +25,31 @@
 #include "common/huffman.h"
 #include "common/util.h"
 #include "common/textconsole.h"
-#include "common/bitstream.h"
 
 namespace Common {
 
+enum {
+	/** Maximum number of bits indexing a lookup table. */
+	kHuffmanTableBits = 9
+};
+
+/** Reverse the order of the lowest n bits of v. */
+static uint32 reverseBits(uint32 v, uint8 n) {
+	uint32 result = 0;
+
+	for (uint8 i = 0; i < n; i++) {
+		result = (result << 1) | (v & 1);
+		v >>= 1;
+	}
+
+	return result;
+}
+
+/** Mask of the lowest n bits. */
+static inline uint32 lowBits(uint8 n) {
+	return (n >= 32) ? 0xFFFFFFFF : ((1U << n) - 1);
+}
+
 Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
 }
 
@@ -45,6 +66,9 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 	assert(maxLength <= 32);
 
+	_maxLength = maxLength;
+	_tableBits = MIN<uint8>(maxLength, kHuffmanTableBits);
+
 	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
 
@@ -58,6 +82,8 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	buildTables();
 }
 
 Huffman::~Huffman() {
@@ -66,21 +92,106 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	buildTables();
 }
 
-uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+void Huffman::buildTables() {
+	PathCodes codesMSB, codesLSB;
 
+	// Going by code length, so that shorter codes take precedence, as in
+	// the bitwise search
 	for (uint32 i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			PathCode code;
+			code.length = i + 1;
+			code.symbol = cCode->symbol;
+
+			// Streams handing out the LSB first read the code's LSB first
+			code.path = cCode->code;
+			codesMSB.push_back(code);
+
+			code.path = reverseBits(cCode->code, code.length);
+			codesLSB.push_back(code);
+		}
+	}
+
+	_tableMSB.clear();
+	_tableLSB.clear();
+	_tableMSB.resize(1 << _tableBits);
+	_tableLSB.resize(1 << _tableBits);
+
+	buildTable(_tableMSB, 0, _tableBits, 0, codesMSB, true);
+	buildTable(_tableLSB, 0, _tableBits, 0, codesLSB, false);
+}
+
+void Huffman::buildTable(Table &table, uint32 offset, uint8 bits, uint8 consumed, const PathCodes &codes, bool msbFirst) {
+	PathCodes longCodes;
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+	// Fill in the codes ending within this table. A code takes all
+	// entries starting with its remaining bits.
+	for (uint32 i = 0; i < codes.size(); i++) {
+		const PathCode &code = codes[i];
+		const uint8 length = code.length - consumed;
+		const uint32 remaining = code.path & lowBits(length);
+
+		if (length > bits) {
+			longCodes.push_back(code);
+			continue;
+		}
+
+		const uint8 fill = bits - length;
+
+		for (uint32 j = 0; j < (1U << fill); j++) {
+			uint32 index = (remaining << fill) | j;
+			if (!msbFirst)
+				index = reverseBits(index, bits);
+
+			TableEntry &entry = table[offset + index];
+			if (entry.length)
+				continue;
+
+			entry.value = code.symbol;
+			entry.length = length;
+			entry.subBits = 0;
+		}
 	}
 
-	error("Unknown Huffman code");
-	return 0;
+	// Longer codes go into secondary tables, one for each prefix
+	for (uint32 i = 0; i < longCodes.size(); i++) {
+		const uint8 length = longCodes[i].length - consumed;
+		const uint32 prefix = (longCodes[i].path & lowBits(length)) >> (length - bits);
+
+		uint32 index = msbFirst ? prefix : reverseBits(prefix, bits);
+
+		// Skip prefixes that are already handled, or taken by a shorter code
+		if (table[offset + index].length || table[offset + index].subBits)
+			continue;
+
+		PathCodes subCodes;
+		uint8 subBits = 0;
+
+		for (uint32 j = i; j < longCodes.size(); j++) {
+			const uint8 subLength = longCodes[j].length - consumed;
+
+			if (((longCodes[j].path & lowBits(subLength)) >> (subLength - bits)) != prefix)
+				continue;
+
+			subCodes.push_back(longCodes[j]);
+			subBits = MAX<uint8>(subBits, subLength - bits);
+		}
+
+		subBits = MIN<uint8>(subBits, kHuffmanTableBits);
+
+		const uint32 subOffset = table.size();
+		table.resize(subOffset + (1 << subBits));
+
+		table[offset + index].value = subOffset;
+		table[offset + index].length = 0;
+		table[offset + index].subBits = subBits;
+
+		buildTable(table, subOffset, subBits, consumed + bits, subCodes, msbFirst);
+	}
 }
 
 } // End of namespace Common
@@ -28,14 +28,18 @@
 #include "common/array.h"
 #include "common/list.h"
 #include "common/types.h"
+#include "common/textconsole.h"
 
 namespace Common {
 
-class BitStream;
-
 /**
  * Huffman bitstream decoding
  *
+ * Symbols are decoded with lookup tables: the next few bits of the stream
+ * index a table, which gives the symbol of all short codes in a single step.
+ * Entries for longer codes refer to secondary tables, indexed by the
+ * following bits.
+ *
  * Used in engines:
  *  - scumm
  */
@@ -55,8 +59,41 @@ public:
 	/** Modify the codes' symbols. */
 	void setSymbols(const uint32 *symbols = 0);
 
-	/** Return the next symbol in the bitstream. */
-	uint32 getSymbol(BitStream &bits) const;
+	/**
+	 * Return the next symbol in the bitstream.
+	 *
+	 * Works with any bit stream providing the BitStream methods, virtual
+	 * or not, so a BitStreamReader can be decoded from without virtual calls.
+	 */
+	template<class BITSTREAM>
+	uint32 getSymbol(BITSTREAM &bits) const {
+		// Near the end of the stream, there might not be enough bits to peek at
+		if (bits.size() - bits.pos() < _maxLength)
+			return getSymbolBitwise(bits);
+
+		const Table &table = bits.isMSBFirst() ? _tableMSB : _tableLSB;
+		uint32 offset = 0;
+		uint8 tableBits = _tableBits;
+
+		for (;;) {
+			const TableEntry &entry = table[offset + bits.peekBits(tableBits)];
+
+			if (entry.length) {
+				bits.skip(entry.length);
+				return entry.value;
+			}
+
+			if (!entry.subBits)
+				break;
+
+			bits.skip(tableBits);
+			offset = entry.value;
+			tableBits = entry.subBits;
+		}
+
+		error("Unknown Huffman code");
+		return 0;
+	}
 
 private:
 	struct Symbol {
@@ -75,6 +112,58 @@ private:
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/**
+	 * A lookup table entry. It either holds a symbol and the number of
+	 * code bits it takes within the table, or links to a secondary table.
+	 * Entries with neither are not part of any code.
+	 */
+	struct TableEntry {
+		uint32 value;  ///< The symbol, or the offset of the secondary table.
+		uint8 length;  ///< Number of code bits in this table, 0 for links.
+		uint8 subBits; ///< Number of bits indexing the secondary table.
+	};
+
+	typedef Array<TableEntry> Table;
+
+	/** A code with its bits in reading order, the first bit being the MSB. */
+	struct PathCode {
+		uint32 path;
+		uint8 length;
+		uint32 symbol;
+	};
+
+	typedef Array<PathCode> PathCodes;
+
+	/** Lookup tables for streams handing out the MSB or LSB first. */
+	Table _tableMSB;
+	Table _tableLSB;
+
+	/** Number of bits indexing the primary tables. */
+	uint8 _tableBits;
+
+	/** Maximal code length. */
+	uint8 _maxLength;
+
+	void buildTables();
+	void buildTable(Table &table, uint32 offset, uint8 bits, uint8 consumed, const PathCodes &codes, bool msbFirst);
+
+	/** Decode a symbol bit by bit, for when there are too few bits left to peek at. */
+	template<class BITSTREAM>
+	uint32 getSymbolBitwise(BITSTREAM &bits) const {
+		uint32 code = 0;
+
+		for (uint32 i = 0; i < _codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
+				if (code == cCode->code)
+					return cCode->symbol;
+		}
+
+		error("Unknown Huffman code");
+		return 0;
+	}
 };
 
 } // End of namespace Common
@@ -23,6 +23,7 @@
 #define COMMON_LIST_H
 
 #include "common/list_intern.h"
+#include "common/memorypool.h"
 
 namespace Common {
 
@@ -38,6 +39,13 @@ protected:
 
 	NodeBase _anchor;
 
+	/** Nodes come from the shared small object allocator. */
+	static SmallObjectPool<Node> _nodePool;
+
+	static void freeNode(Node *node) {
+		_nodePool.deleteChunk(node);
+	}
+
 public:
 	typedef ListInternal::Iterator<t_T>		iterator;
 	typedef ListInternal::ConstIterator<t_T>	const_iterator;
@@ -193,7 +201,7 @@ public:
 		while (pos != &_anchor) {
 			Node *node = static_cast<Node *>(pos);
 			pos = pos->_next;
-			delete node;
+			freeNode(node);
 		}
 
 		_anchor._prev = &_anchor;
@@ -235,7 +243,7 @@ protected:
 		Node *node = static_cast<Node *>(pos);
 		n._prev->_next = n._next;
 		n._next->_prev = n._prev;
-		delete node;
+		freeNode(node);
 		return n;
 	}
 
@@ -243,8 +251,7 @@ protected:
 	 * Inserts element before pos.
 	 */
 	void insert(NodeBase *pos, const t_T &element) {
-		ListInternal::NodeBase *newNode = new Node(element);
-		assert(newNode);
+		ListInternal::NodeBase *newNode = new (_nodePool) Node(element);
 
 		newNode->_next = pos;
 		newNode->_prev = pos->_prev;
@@ -253,6 +260,9 @@ protected:
 	}
 };
 
+template<typename t_T>
+SmallObjectPool<ListInternal::Node<t_T> > List<t_T>::_nodePool;
+
 } // End of namespace Common
 
 #endif
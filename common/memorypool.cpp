@@ -20,6 +20,23 @@
  *
  */
 
+// Thread-local storage lets every thread keep its own free lists. A
+// pthread key returns them to the shared pool when the thread exits.
+#if defined(__GNUC__) && defined(__linux__) && !defined(__ANDROID__)
+#include <pthread.h>
+#define SMALLOBJ_THREAD_LOCAL __thread
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Without atomic operations for the spin lock, the small object allocator
+// passes all requests on to malloc()
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define SMALLOBJ_USE_POOL
+#endif
+
 #include "common/memorypool.h"
 #include "common/util.h"
 
@@ -179,4 +196,299 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+#pragma mark -
+#pragma mark --- Small object allocator ---
+#pragma mark -
+
+namespace {
+
+enum {
+	/** Number of chunks exchanged between a thread cache and the shared pool at once. */
+	kSmallObjectBatchSize = 32,
+	/** Size of the pages the shared pool allocates its chunks from. */
+	kSmallObjectPageSize = 16384
+};
+
+const uint16 kSmallObjectClassSizes[kSmallObjectNumClasses] = {
+	8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256
+};
+
+// Maps (size + 7) / 8 to the smallest size class that can hold size bytes
+const byte kSmallObjectClassIndex[kSmallObjectMaxSize / 8 + 1] = {
+	0,
+	0, 1, 2, 3, 4, 5, 6, 7,
+	8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 12, 12, 13, 13, 13, 13, 14, 14, 14, 14, 15, 15, 15, 15
+};
+
+struct SharedSizeClass {
+	void *freeList;
+	uint32 freeCount;
+	uint32 allocations;
+	uint32 frees;
+	size_t reservedBytes;
+};
+
+struct ThreadCache {
+	void *freeList[kSmallObjectNumClasses];
+	uint32 freeCount[kSmallObjectNumClasses];
+	// Counters not yet added to the shared statistics
+	uint32 allocations[kSmallObjectNumClasses];
+	uint32 frees[kSmallObjectNumClasses];
+	// Whether the cache is returned to the shared pool at thread exit
+	bool registered;
+};
+
+// All of these are zero initialized before any constructor runs, so the
+// allocator can be used during static initialization.
+SharedSizeClass g_sharedClasses[kSmallObjectNumClasses];
+long g_liveBytes;
+size_t g_peakBytes;
+size_t g_reservedBytes;
+volatile long g_sharedLock;
+
+#ifdef SMALLOBJ_THREAD_LOCAL
+SMALLOBJ_THREAD_LOCAL ThreadCache g_threadCache;
+// Only exchanges with the shared pool need locking
+const bool kLockThreadCache = false;
+
+pthread_key_t g_threadExitKey;
+pthread_once_t g_threadExitKeyOnce = PTHREAD_ONCE_INIT;
+#else
+// All threads use the same cache, protected by the shared lock
+ThreadCache g_threadCache;
+const bool kLockThreadCache = true;
+#endif
+
+#ifdef SMALLOBJ_USE_POOL
+const bool kUsePool = true;
+#else
+const bool kUsePool = false;
+#endif
+
+/**
+ * Spin lock protecting the shared pool. It is only held for very short
+ * times, so spinning is cheaper than a full mutex, and unlike a mutex it
+ * does not depend on g_system being available. On other compilers than
+ * the ones below, the pool is not used at all.
+ */
+class SharedPoolLock {
+	const bool _enabled;
+
+public:
+	explicit SharedPoolLock(bool enabled = true) : _enabled(enabled) {
+		if (!_enabled)
+			return;
+#if defined(__GNUC__)
+		while (__sync_lock_test_and_set(&g_sharedLock, 1)) {
+			while (g_sharedLock) {}
+		}
+#elif defined(_MSC_VER)
+		while (_InterlockedExchange(&g_sharedLock, 1)) {
+			while (g_sharedLock) {}
+		}
+#endif
+	}
+
+	~SharedPoolLock() {
+		if (!_enabled)
+			return;
+#if defined(__GNUC__)
+		__sync_lock_release(&g_sharedLock);
+#elif defined(_MSC_VER)
+		_InterlockedExchange(&g_sharedLock, 0);
+#endif
+	}
+};
+
+inline uint getSizeClass(size_t size) {
+	return kSmallObjectClassIndex[(size + 7) >> 3];
+}
+
+/** Add the pending counters of the given cache to the shared statistics. */
+void foldCounters(ThreadCache &cache) {
+	for (uint i = 0; i < kSmallObjectNumClasses; ++i) {
+		SharedSizeClass &shared = g_sharedClasses[i];
+		shared.allocations += cache.allocations[i];
+		shared.frees += cache.frees[i];
+		g_liveBytes += ((long)cache.allocations[i] - (long)cache.frees[i]) * kSmallObjectClassSizes[i];
+		cache.allocations[i] = cache.frees[i] = 0;
+	}
+
+	if (g_liveBytes > 0 && (size_t)g_liveBytes > g_peakBytes)
+		g_peakBytes = g_liveBytes;
+}
+
+void allocPage(uint sizeClass) {
+	SharedSizeClass &shared = g_sharedClasses[sizeClass];
+	const size_t chunkSize = kSmallObjectClassSizes[sizeClass];
+	const size_t numChunks = kSmallObjectPageSize / chunkSize;
+
+	byte *page = (byte *)::malloc(numChunks * chunkSize);
+	assert(page);
+
+	for (size_t i = 0; i < numChunks; ++i) {
+		void *chunk = page + i * chunkSize;
+		*(void **)chunk = shared.freeList;
+		shared.freeList = chunk;
+	}
+
+	shared.freeCount += numChunks;
+	shared.reservedBytes += numChunks * chunkSize;
+	g_reservedBytes += numChunks * chunkSize;
+}
+
+/** Move a batch of chunks from the shared pool into the empty cache list. */
+void refillCache(ThreadCache &cache, uint sizeClass) {
+	SharedSizeClass &shared = g_sharedClasses[sizeClass];
+	if (shared.freeCount < kSmallObjectBatchSize)
+		allocPage(sizeClass);
+
+	void *tail = shared.freeList;
+	for (uint i = 1; i < kSmallObjectBatchSize; ++i)
+		tail = *(void **)tail;
+
+	cache.freeList[sizeClass] = shared.freeList;
+	shared.freeList = *(void **)tail;
+	*(void **)tail = 0;
+
+	cache.freeCount[sizeClass] = kSmallObjectBatchSize;
+	shared.freeCount -= kSmallObjectBatchSize;
+}
+
+/** Move up to count chunks from the cache list back to the shared pool. */
+void drainCache(ThreadCache &cache, uint sizeClass, uint32 count) {
+	SharedSizeClass &shared = g_sharedClasses[sizeClass];
+	count = MIN(count, cache.freeCount[sizeClass]);
+	if (!count)
+		return;
+
+	void *head = cache.freeList[sizeClass];
+	void *tail = head;
+	for (uint32 i = 1; i < count; ++i)
+		tail = *(void **)tail;
+
+	cache.freeList[sizeClass] = *(void **)tail;
+	*(void **)tail = shared.freeList;
+	shared.freeList = head;
+
+	cache.freeCount[sizeClass] -= count;
+	shared.freeCount += count;
+}
+
+/** Return all chunks of the cache to the shared pool. The lock must be held. */
+void flushCache(ThreadCache &cache) {
+	foldCounters(cache);
+	for (uint i = 0; i < kSmallObjectNumClasses; ++i)
+		drainCache(cache, i, cache.freeCount[i]);
+}
+
+#ifdef SMALLOBJ_THREAD_LOCAL
+
+void flushExitingThreadCache(void *cache) {
+	SharedPoolLock lock;
+	flushCache(*(ThreadCache *)cache);
+
+	// The thread may still allocate in other destructors of thread
+	// specific data, which registers the cache again
+	((ThreadCache *)cache)->registered = false;
+}
+
+void createThreadExitKey() {
+	pthread_key_create(&g_threadExitKey, flushExitingThreadCache);
+}
+
+#endif
+
+/** Make sure that the cache is flushed when the calling thread exits. */
+void registerCache(ThreadCache &cache) {
+#ifdef SMALLOBJ_THREAD_LOCAL
+	pthread_once(&g_threadExitKeyOnce, createThreadExitKey);
+	pthread_setspecific(g_threadExitKey, &cache);
+#endif
+	cache.registered = true;
+}
+
+} // End of anonymous namespace
+
+void *allocSmallObject(size_t size) {
+	if (!kUsePool || size > kSmallObjectMaxSize)
+		return ::malloc(size);
+
+	const uint sizeClass = getSizeClass(size);
+	SharedPoolLock cacheLock(kLockThreadCache);
+	ThreadCache &cache = g_threadCache;
+
+	if (!cache.freeList[sizeClass]) {
+		if (!cache.registered)
+			registerCache(cache);
+
+		SharedPoolLock sharedLock(!kLockThreadCache);
+		foldCounters(cache);
+		refillCache(cache, sizeClass);
+	}
+
+	void *result = cache.freeList[sizeClass];
+	cache.freeList[sizeClass] = *(void **)result;
+	--cache.freeCount[sizeClass];
+	++cache.allocations[sizeClass];
+
+	return result;
+}
+
+void freeSmallObject(void *ptr, size_t size) {
+	if (!ptr)
+		return;
+
+	if (!kUsePool || size > kSmallObjectMaxSize) {
+		::free(ptr);
+		return;
+	}
+
+	const uint sizeClass = getSizeClass(size);
+	SharedPoolLock cacheLock(kLockThreadCache);
+	ThreadCache &cache = g_threadCache;
+
+	*(void **)ptr = cache.freeList[sizeClass];
+	cache.freeList[sizeClass] = ptr;
+	++cache.freeCount[sizeClass];
+	++cache.frees[sizeClass];
+
+	// Keep one batch around, so that alternating allocations and frees do
+	// not have to go to the shared pool every time
+	if (cache.freeCount[sizeClass] >= 2 * kSmallObjectBatchSize) {
+		SharedPoolLock sharedLock(!kLockThreadCache);
+		foldCounters(cache);
+		drainCache(cache, sizeClass, kSmallObjectBatchSize);
+	}
+}
+
+void flushSmallObjectCache() {
+	if (!kUsePool)
+		return;
+
+	SharedPoolLock lock;
+	flushCache(g_threadCache);
+}
+
+void getSmallObjectStats(SmallObjectStats &stats) {
+	SharedPoolLock lock(kUsePool);
+	foldCounters(g_threadCache);
+
+	stats.liveBytes = MAX<long>(g_liveBytes, 0);
+	stats.peakBytes = g_peakBytes;
+	stats.reservedBytes = g_reservedBytes;
+
+	for (uint i = 0; i < kSmallObjectNumClasses; ++i) {
+		const SharedSizeClass &shared = g_sharedClasses[i];
+		SmallObjectStats::SizeClass &sizeClass = stats.sizeClasses[i];
+
+		sizeClass.chunkSize = kSmallObjectClassSizes[i];
+		sizeClass.allocations = shared.allocations;
+		sizeClass.frees = shared.frees;
+		sizeClass.liveChunks = (shared.allocations >= shared.frees) ? shared.allocations - shared.frees : 0;
+		sizeClass.reservedBytes = shared.reservedBytes;
+	}
+}
+
 } // End of namespace Common
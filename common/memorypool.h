@@ -35,9 +35,9 @@ namespace Common {
  *
  * Using a memory pool may yield better performance and memory usage
  * when allocating and deallocating many memory blocks of equal size.
- * E.g. the Common::String class uses a memory pool for the refCount
- * variables (each the size of an int) it allocates for each string
- * instance.
+ *
+ * A MemoryPool is not thread-safe. Memory shared between threads should
+ * come from the small object allocator below instead.
  */
 class MemoryPool {
 protected:
@@ -141,6 +141,107 @@ public:
 	}
 };
 
+enum {
+	/** Largest allocation served by the small object allocator. */
+	kSmallObjectMaxSize = 256,
+	/** Number of size classes of the small object allocator. */
+	kSmallObjectNumClasses = 16
+};
+
+/**
+ * Allocate a block of the given size from the small object allocator.
+ *
+ * The allocator rounds each request up to one of a fixed set of size
+ * classes and serves it from a free list for that class. On platforms
+ * with thread-local storage every thread has its own cache of free
+ * chunks, which is refilled from and returned to a shared pool in
+ * batches, so most calls do not need any locking at all. Elsewhere the
+ * shared pool is protected by a spin lock. Compilers which provide no
+ * atomic operations for that lock get plain malloc() and free() instead.
+ *
+ * The allocator is safe to use from any thread, and also during static
+ * initialization. Memory it obtained once is kept for reuse and never
+ * returned to the system. Requests larger than kSmallObjectMaxSize are
+ * passed on to malloc().
+ */
+void *allocSmallObject(size_t size);
+
+/**
+ * Return a block to the small object allocator. The size must be the
+ * same as the one passed to allocSmallObject(). The block may be freed
+ * by a different thread than the one which allocated it.
+ */
+void freeSmallObject(void *ptr, size_t size);
+
+/**
+ * Return all chunks cached by the calling thread to the shared pool.
+ * This happens automatically when a thread exits.
+ */
+void flushSmallObjectCache();
+
+/**
+ * Statistics of the small object allocator.
+ *
+ * Allocations and frees are counted per thread. They are only added to
+ * these figures when a thread exchanges chunks with the shared pool or
+ * exits, or when the statistics are read by that thread. So the numbers
+ * for other threads than the calling one may lag behind a bit, and
+ * peakBytes may miss short peaks.
+ */
+struct SmallObjectStats {
+	struct SizeClass {
+		size_t chunkSize;     ///< size of the chunks in this class
+		uint32 allocations;   ///< total number of allocations
+		uint32 frees;         ///< total number of frees
+		uint32 liveChunks;    ///< number of chunks currently in use
+		size_t reservedBytes; ///< memory obtained from malloc() for this class
+	};
+
+	size_t liveBytes;     ///< bytes currently in use
+	size_t peakBytes;     ///< maximum of liveBytes so far
+	size_t reservedBytes; ///< memory obtained from malloc() in total
+
+	SizeClass sizeClasses[kSmallObjectNumClasses];
+};
+
+/**
+ * Retrieve the current statistics of the small object allocator.
+ */
+void getSmallObjectStats(SmallObjectStats &stats);
+
+/**
+ * A memory pool for C++ objects, which takes its memory from the shared
+ * small object allocator. It has the same interface as ObjectPool, but
+ * it is thread-safe and does not keep any memory of its own.
+ */
+template<class T>
+class SmallObjectPool {
+public:
+	void *allocChunk() {
+		return allocSmallObject(sizeof(T));
+	}
+
+	void freeChunk(void *ptr) {
+		freeSmallObject(ptr, sizeof(T));
+	}
+
+	/**
+	 * Return the memory chunk used as storage for the given object back
+	 * to the allocator, after calling its destructor.
+	 */
+	void deleteChunk(T *ptr) {
+		ptr->~T();
+		freeChunk(ptr);
+	}
+
+	/**
+	 * Does nothing; the memory is owned by the shared allocator.
+	 */
+	void freeUnusedPages() {}
+
+	size_t getChunkSize() const { return sizeof(T); }
+};
+
 }	// End of namespace Common
 
 /**
@@ -160,4 +261,15 @@ inline void operator delete(void *p, Common::MemoryPool &pool) {
 	pool.freeChunk(p);
 }
 
+template<class T>
+inline void *operator new(size_t nbytes, Common::SmallObjectPool<T> &pool) {
+	assert(nbytes <= pool.getChunkSize());
+	return pool.allocChunk();
+}
+
+template<class T>
+inline void operator delete(void *p, Common::SmallObjectPool<T> &pool) {
+	pool.freeChunk(p);
+}
+
 #endif
@@ -0,0 +1,42 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_SSE2_H
+#define COMMON_SSE2_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Defines USE_SSE2 and includes the SSE2 intrinsics when the compiler
+ * targets SSE2, as it always does for x86-64.
+ *
+ * The intrinsics header only pulls in C headers which common/scummsys.h
+ * has already included, so including it after the forbidden symbol checks
+ * are enabled is fine.
+ */
+#if defined(__SSE2__)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#endif
@@ -27,7 +27,6 @@
 
 namespace Common {
 
-MemoryPool *g_refCountPool = 0; // FIXME: This is never freed right now
 
 static uint32 computeCapacity(uint32 len) {
 	// By default, for the capacity we use the next multiple of 32
@@ -177,12 +176,9 @@ void String::ensureCapacity(uint32 new_size, bool keep_old) {
 void String::incRefCount() const {
 	assert(!isStorageIntern());
 	if (_extern._refCount == 0) {
-		if (g_refCountPool == 0) {
-			g_refCountPool = new MemoryPool(sizeof(int));
-			assert(g_refCountPool);
-		}
-
-		_extern._refCount = (int *)g_refCountPool->allocChunk();
+		// Strings are shared between threads, so the ref count has to come
+		// from the thread-safe small object allocator
+		_extern._refCount = (int *)allocSmallObject(sizeof(int));
 		*_extern._refCount = 2;
 	} else {
 		++(*_extern._refCount);
@@ -199,10 +195,8 @@ void String::decRefCount(int *oldRefCount) {
 	if (!oldRefCount || *oldRefCount <= 0) {
 		// The ref count reached zero, so we free the string storage
 		// and the ref count storage.
-		if (oldRefCount) {
-			assert(g_refCountPool);
-			g_refCountPool->freeChunk(oldRefCount);
-		}
+		if (oldRefCount)
+			freeSmallObject(oldRefCount, sizeof(int));
 		delete[] _str;
 
 		// Even though _str points to a freed memory block now,
@@ -105,9 +105,11 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/substream.h"
 
-#include "common/hashmap.h"
-#include "common/hash-str.h"
+#include "common/algorithm.h"
+#include "common/array.h"
+#include "common/ptr.h"
 
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -372,8 +374,27 @@ typedef struct {
 	unz_file_info_internal cur_file_info_internal;	/* private info about it*/
 } cached_file_in_zip;
 
-typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_Hash,
-	Common::IgnoreCase_EqualTo> ZipHash;
+/* Entry of the sorted index of all files in the zipfile */
+typedef struct {
+	uLong name_offset;				/* offset of the file name in the name table */
+	cached_file_in_zip info;		/* cached information about the file */
+} zip_index_entry;
+
+/* Orders the index case insensitively by name. Of several files with the
+   same name, the one stored last in the zipfile comes first, since that is
+   the one which would be extracted. */
+struct ZipIndexLess {
+	const char *_names;
+
+	ZipIndexLess(const char *names) : _names(names) {}
+
+	bool operator()(const zip_index_entry &a, const zip_index_entry &b) const {
+		int cmp = scumm_stricmp(_names + a.name_offset, _names + b.name_offset);
+		if (cmp != 0)
+			return cmp < 0;
+		return a.info.num_file > b.info.num_file;
+	}
+};
 
 /* unz_s contain internal information about the zipfile
 */
@@ -394,7 +415,8 @@ typedef struct {
 	unz_file_info_internal cur_file_info_internal;	/* private info about it*/
 	file_in_zip_read_info_s* pfile_in_zip_read;		/* structure about the current
 													file if we are decompressing it */
-	ZipHash _hash;
+	Common::Array<zip_index_entry> _index;	/* all files, sorted by name */
+	Common::Array<char> _names;				/* zero terminated names of all files */
 } unz_s;
 
 /* ===========================================================================
@@ -514,6 +536,8 @@ static uLong unzlocal_SearchCentralDir(Common::SeekableReadStream &fin) {
 	return uPosFound;
 }
 
+static int unzlocal_BuildIndex(unz_s *us);
+
 /*
   Open a Zip file. path contain the full pathname (by example,
      on a Windows NT computer "c:\\test\\zlib109.zip" or on an Unix computer
@@ -602,27 +626,13 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	us->central_pos = central_pos;
 	us->pfile_in_zip_read = NULL;
 
-	err = unzGoToFirstFile((unzFile)us);
-
-	while (err == UNZ_OK) {
-		// Get the file details
-		char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
-		unzGetCurrentFileInfo(us, NULL, szCurrentFileName, sizeof(szCurrentFileName) - 1,
-							NULL, 0, NULL, 0);
-
-		// Save details into the hash
-		cached_file_in_zip fe;
-		fe.num_file = us->num_file;
-		fe.pos_in_central_dir = us->pos_in_central_dir;
-		fe.current_file_ok = us->current_file_ok;
-		fe.cur_file_info = us->cur_file_info;
-		fe.cur_file_info_internal = us->cur_file_info_internal;
-
-		us->_hash[Common::String(szCurrentFileName)] = fe;
-
-		// Move to the next file
-		err = unzGoToNextFile((unzFile)us);
+	if (unzlocal_BuildIndex(us) != UNZ_OK) {
+		delete us->_stream;
+		delete us;
+		return NULL;
 	}
+
+	unzGoToFirstFile((unzFile)us);
 	return (unzFile)us;
 }
 
@@ -676,6 +686,101 @@ static void unzlocal_DosDateToTmuDate(uLong ulDosDate, tm_unz* ptm) {
 	ptm->tm_sec =  (uInt) (2*(ulDosDate&0x1f)) ;
 }
 
+/*
+  Build the sorted index of all files in the zipfile. The whole central
+  directory is read with a single call and parsed from memory, which is
+  a lot faster than reading it field by field through the stream.
+*/
+static int unzlocal_BuildIndex(unz_s *us) {
+	us->_index.clear();
+	us->_names.clear();
+
+	if (us->gi.number_entry == 0)
+		return UNZ_OK;
+
+	byte *dir = (byte *)malloc(us->size_central_dir);
+	if (dir == NULL)
+		return UNZ_INTERNALERROR;
+
+	us->_stream->seek(us->offset_central_dir + us->byte_before_the_zipfile, SEEK_SET);
+	if (us->_stream->err() || us->_stream->read(dir, us->size_central_dir) != us->size_central_dir) {
+		free(dir);
+		return UNZ_ERRNO;
+	}
+
+	// First pass: validate the entries and compute the size of the name table
+	uLong numFiles = 0, namesSize = 0, pos = 0;
+	while (numFiles < us->gi.number_entry) {
+		if (pos + SIZECENTRALDIRITEM > us->size_central_dir ||
+		    READ_LE_UINT32(dir + pos) != 0x02014b50)
+			break;
+
+		const byte *p = dir + pos;
+		const uLong entrySize = SIZECENTRALDIRITEM + READ_LE_UINT16(p + 28) +
+		                        READ_LE_UINT16(p + 30) + READ_LE_UINT16(p + 32);
+		if (pos + entrySize > us->size_central_dir)
+			break;
+
+		namesSize += MIN<uLong>(READ_LE_UINT16(p + 28), UNZ_MAXFILENAMEINZIP) + 1;
+		pos += entrySize;
+		++numFiles;
+	}
+
+	// Like the sequential scan this replaces, use all entries up to the
+	// first broken one, but refuse archives without a single valid entry
+	if (numFiles == 0) {
+		free(dir);
+		return UNZ_BADZIPFILE;
+	}
+
+	us->_index.resize(numFiles);
+	us->_names.resize(namesSize);
+
+	// Second pass: fill in the index
+	uLong namePos = 0;
+	pos = 0;
+	for (uLong i = 0; i < numFiles; ++i) {
+		const byte *p = dir + pos;
+		zip_index_entry &entry = us->_index[i];
+		unz_file_info &info = entry.info.cur_file_info;
+
+		info.version = READ_LE_UINT16(p + 4);
+		info.version_needed = READ_LE_UINT16(p + 6);
+		info.flag = READ_LE_UINT16(p + 8);
+		info.compression_method = READ_LE_UINT16(p + 10);
+		info.dosDate = READ_LE_UINT32(p + 12);
+		unzlocal_DosDateToTmuDate(info.dosDate, &info.tmu_date);
+		info.crc = READ_LE_UINT32(p + 16);
+		info.compressed_size = READ_LE_UINT32(p + 20);
+		info.uncompressed_size = READ_LE_UINT32(p + 24);
+		info.size_filename = READ_LE_UINT16(p + 28);
+		info.size_file_extra = READ_LE_UINT16(p + 30);
+		info.size_file_comment = READ_LE_UINT16(p + 32);
+		info.disk_num_start = READ_LE_UINT16(p + 34);
+		info.internal_fa = READ_LE_UINT16(p + 36);
+		info.external_fa = READ_LE_UINT32(p + 38);
+		entry.info.cur_file_info_internal.offset_curfile = READ_LE_UINT32(p + 42);
+
+		entry.info.num_file = i;
+		entry.info.pos_in_central_dir = us->offset_central_dir + pos;
+		entry.info.current_file_ok = 1;
+
+		const uLong nameLength = MIN<uLong>(info.size_filename, UNZ_MAXFILENAMEINZIP);
+		entry.name_offset = namePos;
+		memcpy(&us->_names[namePos], p + SIZECENTRALDIRITEM, nameLength);
+		us->_names[namePos + nameLength] = 0;
+		namePos += nameLength + 1;
+
+		pos += SIZECENTRALDIRITEM + info.size_filename + info.size_file_extra + info.size_file_comment;
+	}
+
+	free(dir);
+
+	us->gi.number_entry = numFiles;
+	Common::sort(us->_index.begin(), us->_index.end(), ZipIndexLess(&us->_names[0]));
+	return UNZ_OK;
+}
+
 /*
   Get Info about the current file in the zipfile, with internal only info
 */
@@ -924,13 +1029,22 @@ int unzLocateFile(unzFile file, const char *szFileName, int iCaseSensitivity) {
 	if (!s->current_file_ok)
 		return UNZ_END_OF_LIST_OF_FILE;
 
-	// Check to see if the entry exists
-	ZipHash::iterator i = s->_hash.find(Common::String(szFileName));
-	if (i == s->_hash.end())
+	// Binary search the index for the entry
+	const char *names = s->_names.begin();
+	uint first = 0, last = s->_index.size();
+	while (first < last) {
+		const uint middle = (first + last) / 2;
+		if (scumm_stricmp(names + s->_index[middle].name_offset, szFileName) < 0)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	if (first == s->_index.size() || scumm_stricmp(names + s->_index[first].name_offset, szFileName) != 0)
 		return UNZ_END_OF_LIST_OF_FILE;
 
 	// Found it, so reset the details in the main structure
-	cached_file_in_zip &fe = i->_value;
+	const cached_file_in_zip &fe = s->_index[first].info;
 	s->num_file = fe.num_file;
 	s->pos_in_central_dir = fe.pos_in_central_dir;
 	s->current_file_ok = fe.current_file_ok;
@@ -1416,12 +1530,156 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+enum {
+	/**
+	 * Members at least this large are read on demand from the archive,
+	 * smaller ones are extracted into memory at once.
+	 */
+	kZipStreamingThreshold = 128 * 1024
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Stream for a deflated member of a zip archive, which decompresses the
+ * data on demand instead of extracting the whole member at once. It reads
+ * from its own stream of the archive file, which it deletes when done.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+	enum {
+		BUFSIZE = UNZ_BUFSIZE
+	};
+
+	byte _buf[BUFSIZE];
+
+	ScopedPtr<SeekableReadStream> _parentStream;
+	uint32 _begin;
+	uint32 _compressedSize;
+	uint32 _compressedPos;
+	uint32 _size;
+	uint32 _pos;
+	uLong _crc;
+	uLong _expectedCrc;
+	z_stream _stream;
+	int _zlibErr;
+	bool _eos;
+
+	void reset() {
+		_parentStream->seek(_begin);
+		_compressedPos = 0;
+		_pos = 0;
+		_crc = crc32(0, Z_NULL, 0);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+	}
+
+public:
+	ZipInflateReadStream(SeekableReadStream *parentStream, uint32 begin,
+	                     uint32 compressedSize, uint32 size, uLong crc)
+		: _parentStream(parentStream), _begin(begin), _compressedSize(compressedSize),
+		  _size(size), _expectedCrc(crc), _stream(), _eos(false) {
+		// windowBits is passed < 0 to tell that there is no zlib header
+		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		reset();
+	}
+
+	~ZipInflateReadStream() {
+		inflateEnd(&_stream);
+	}
+
+	bool eos() const { return _eos; }
+	bool err() const { return (_zlibErr != Z_OK && _zlibErr != Z_STREAM_END) || _parentStream->err(); }
+	void clearErr() {
+		// only reset _eos; decompression errors are not recoverable
+		_eos = false;
+	}
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (dataSize > _size - _pos) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		_stream.next_out = (Bytef *)dataPtr;
+		_stream.avail_out = dataSize;
+
+		while (_zlibErr == Z_OK && _stream.avail_out) {
+			if (_stream.avail_in == 0) {
+				// Refill the input buffer from the archive stream
+				const uint32 readSize = MIN<uint32>(BUFSIZE, _compressedSize - _compressedPos);
+				if (!readSize || _parentStream->read(_buf, readSize) != readSize) {
+					_zlibErr = Z_DATA_ERROR;
+					break;
+				}
+
+				_compressedPos += readSize;
+				_stream.next_in = _buf;
+				_stream.avail_in = readSize;
+			}
+
+			_zlibErr = inflate(&_stream, Z_SYNC_FLUSH);
+		}
+
+		const uint32 bytesRead = dataSize - _stream.avail_out;
+		_crc = crc32(_crc, (const Bytef *)dataPtr, bytesRead);
+		_pos += bytesRead;
+
+		if (_pos == _size && _crc != _expectedCrc && !err()) {
+			warning("ZipInflateReadStream: CRC mismatch");
+			_zlibErr = Z_DATA_ERROR;
+		}
+
+		return bytesRead;
+	}
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		switch (whence) {
+		case SEEK_END:
+			offset = _size + offset;
+			break;
+		case SEEK_CUR:
+			offset = _pos + offset;
+			break;
+		}
+
+		if (offset < 0 || (uint32)offset > _size)
+			return false;
+
+		if ((uint32)offset < _pos) {
+			// Seeking backwards requires restarting the decompression
+			_zlibErr = inflateReset(&_stream);
+			if (_zlibErr != Z_OK)
+				return false;
+			reset();
+		}
+
+		// Skip forward by decompressing into a scratch buffer
+		byte tmpBuf[1024];
+		while (!err() && _pos < (uint32)offset)
+			read(tmpBuf, MIN<uint32>(sizeof(tmpBuf), offset - _pos));
+
+		_eos = false;
+		return !err();
+	}
+};
+
+#endif
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
 
+	/**
+	 * The zip file, if it can be opened again. Large members are streamed
+	 * from their own handle of it, so they stay independent of each other
+	 * and of the archive, even when read from other threads.
+	 */
+	ArchiveMemberPtr _source;
+
 public:
-	ZipArchive(unzFile zipFile);
+	ZipArchive(unzFile zipFile, const ArchiveMemberPtr &source = ArchiveMemberPtr());
 
 
 	~ZipArchive();
@@ -1450,7 +1708,7 @@ public:
 };
 */
 
-ZipArchive::ZipArchive(unzFile zipFile) : _zipFile(zipFile) {
+ZipArchive::ZipArchive(unzFile zipFile, const ArchiveMemberPtr &source) : _zipFile(zipFile), _source(source) {
 	assert(_zipFile);
 }
 
@@ -1463,19 +1721,17 @@ bool ZipArchive::hasFile(const String &name) const {
 }
 
 int ZipArchive::listMembers(ArchiveMemberList &list) const {
+	const unz_s *s = (const unz_s *)_zipFile;
 	int matches = 0;
-	int err = unzGoToFirstFile(_zipFile);
-
-	while (err == UNZ_OK) {
-		char szCurrentFileName[UNZ_MAXFILENAMEINZIP+1];
-		if (unzGetCurrentFileInfo(_zipFile, NULL,
-		                          szCurrentFileName, sizeof(szCurrentFileName)-1,
-		                          NULL, 0, NULL, 0) == UNZ_OK) {
-			list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(szCurrentFileName, this)));
-			matches++;
-		}
 
-		err = unzGoToNextFile(_zipFile);
+	for (uint i = 0; i < s->_index.size(); ++i) {
+		// Skip entries hidden by a later one with the same name
+		const char *name = &s->_names[s->_index[i].name_offset];
+		if (i > 0 && !scumm_stricmp(name, &s->_names[s->_index[i - 1].name_offset]))
+			continue;
+
+		list.push_back(ArchiveMemberList::value_type(new GenericArchiveMember(name, this)));
+		matches++;
 	}
 
 	return matches;
@@ -1492,6 +1748,34 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
+	unz_s *s = (unz_s *)_zipFile;
+	const unz_file_info &info = s->cur_file_info;
+
+	if (_source && info.uncompressed_size >= kZipStreamingThreshold) {
+		uInt sizeVar;
+		uLong offsetLocalExtraField;
+		uInt sizeLocalExtraField;
+		if (unzlocal_CheckCurrentFileCoherencyHeader(s, &sizeVar, &offsetLocalExtraField, &sizeLocalExtraField) != UNZ_OK)
+			return 0;
+
+		const uint32 begin = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER + sizeVar +
+		                     s->byte_before_the_zipfile;
+
+		SeekableReadStream *stream = _source->createReadStream();
+		if (!stream)
+			return 0;
+
+		if (info.compression_method == 0)
+			return new SeekableSubReadStream(stream, begin, begin + info.uncompressed_size, DisposeAfterUse::YES);
+#ifdef USE_ZLIB
+		if (info.compression_method == Z_DEFLATED)
+			return new ZipInflateReadStream(stream, begin, info.compressed_size,
+			                                info.uncompressed_size, info.crc);
+#endif
+		delete stream;
+		return 0;
+	}
+
 	unz_file_info fileInfo;
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
@@ -1513,22 +1797,9 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	}
 
 	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
 }
 
-Archive *makeZipArchive(const String &name) {
-	return makeZipArchive(SearchMan.createReadStreamForMember(name));
-}
-
-Archive *makeZipArchive(const FSNode &node) {
-	return makeZipArchive(node.createReadStream());
-}
-
-Archive *makeZipArchive(SeekableReadStream *stream) {
+static Archive *makeZipArchive(SeekableReadStream *stream, const ArchiveMemberPtr &source) {
 	if (!stream)
 		return 0;
 	unzFile zipFile = unzOpen(stream);
@@ -1537,7 +1808,23 @@ Archive *makeZipArchive(SeekableReadStream *stream) {
 		// goes wrong.
 		return 0;
 	}
-	return new ZipArchive(zipFile);
+	return new ZipArchive(zipFile, source);
+}
+
+Archive *makeZipArchive(const String &name) {
+	const ArchiveMemberPtr member = SearchMan.getMember(name);
+	if (!member)
+		return 0;
+	return makeZipArchive(member->createReadStream(), member);
+}
+
+Archive *makeZipArchive(const FSNode &node) {
+	return makeZipArchive(node.createReadStream(), ArchiveMemberPtr(new FSNode(node)));
+}
+
+Archive *makeZipArchive(SeekableReadStream *stream) {
+	// The stream can't be opened again, so all members are extracted
+	return makeZipArchive(stream, ArchiveMemberPtr());
 }
 
 }	// End of namespace Common
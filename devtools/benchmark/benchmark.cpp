@@ -0,0 +1,119 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(POSIX)
+#include <sys/time.h>
+#endif
+
+uint32 getMicros() {
+	// Wall clock time, so that time spent waiting for I/O is included
+#if defined(WIN32)
+	static LARGE_INTEGER frequency;
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint32)((counter.QuadPart / frequency.QuadPart) * 1000000 +
+	                (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#elif defined(POSIX) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#elif defined(POSIX)
+	// Not monotonic, but still wall clock time, unlike clock()
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint32)(tv.tv_sec * 1000000 + tv.tv_usec);
+#else
+	return (uint32)((double)clock() * 1000000.0 / CLOCKS_PER_SEC);
+#endif
+}
+
+void reportBenchmark(const char *name, uint32 micros, uint32 operations) {
+	printf("%-40s %10u ops %10.3f ms %10.2f ns/op\n", name, operations, micros / 1000.0,
+	       operations ? micros * 1000.0 / operations : 0.0);
+}
+
+static volatile uint32 g_sink;
+
+void consumeResult(uint32 value) {
+	g_sink += value;
+}
+
+struct BenchmarkSuite {
+	const char *name;
+	void (*run)();
+};
+
+static const BenchmarkSuite suites[] = {
+	{ "hashmap", runHashMapBenchmarks },
+	{ "fscache", runFSCacheBenchmarks },
+	{ "huffman", runHuffmanBenchmarks },
+	{ "bitstream", runBitStreamBenchmarks },
+	{ "bink", runBinkBenchmarks },
+	{ "conversion", runConversionBenchmarks },
+	{ "rate", runRateBenchmarks },
+	{ 0, 0 }
+};
+
+int main(int argc, char *argv[]) {
+	bool found = false;
+
+	for (const BenchmarkSuite *suite = suites; suite->name; ++suite) {
+		// Run all suites, or only those given on the command line
+		bool selected = (argc < 2);
+		for (int i = 1; i < argc; ++i) {
+			if (!strcmp(argv[i], suite->name))
+				selected = true;
+		}
+
+		if (!selected)
+			continue;
+
+		printf("=== %s ===\n", suite->name);
+		suite->run();
+		found = true;
+	}
+
+	if (!found) {
+		printf("Usage: %s [suite...]\nAvailable suites:", argv[0]);
+		for (const BenchmarkSuite *suite = suites; suite->name; ++suite)
+			printf(" %s", suite->name);
+		printf("\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef DEVTOOLS_BENCHMARK_H
+#define DEVTOOLS_BENCHMARK_H
+
+#include "common/scummsys.h"
+
+/**
+ * Return a monotonic wall clock time stamp in microseconds, for timing
+ * the benchmark runs. Only on systems which have neither a monotonic
+ * clock nor gettimeofday(), this falls back to the CPU time used.
+ */
+uint32 getMicros();
+
+/**
+ * Print the result of a single benchmark run.
+ *
+ * @param name       the name of the benchmark
+ * @param micros     the time spent, in microseconds
+ * @param operations the number of operations performed in that time
+ */
+void reportBenchmark(const char *name, uint32 micros, uint32 operations);
+
+/**
+ * Prevent the compiler from optimizing away a computed result.
+ */
+void consumeResult(uint32 value);
+
+// The benchmark suites
+void runHashMapBenchmarks();
+void runFSCacheBenchmarks();
+void runHuffmanBenchmarks();
+void runBitStreamBenchmarks();
+void runBinkBenchmarks();
+void runConversionBenchmarks();
+void runRateBenchmarks();
+
+#endif
@@ -0,0 +1,127 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include "video/bink_decoder.h"
+
+#include "test/common/random_helper.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+enum {
+	kNumBlocks = 1000000,
+	kNumFrames = 200,
+	kFrameWidth = 640,
+	kFrameHeight = 480
+};
+
+TestRandom g_random;
+
+#ifdef USE_BINK
+
+enum {
+	kNumSourceBlocks = 256
+};
+
+typedef void (*IDCTPutFunc)(byte *dest, int pitch, const int16 *block);
+
+void benchmarkIDCT(const char *name, IDCTPutFunc idct, const int16 *blocks) {
+	// Write all over a frame, like the decoder does
+	byte *frame = new byte[kFrameWidth * kFrameHeight];
+	memset(frame, 0, kFrameWidth * kFrameHeight);
+
+	const int blocksPerRow = kFrameWidth / 8;
+	const int blocksPerFrame = blocksPerRow * (kFrameHeight / 8);
+
+	const uint32 start = getMicros();
+	for (uint32 i = 0; i < kNumBlocks; i++) {
+		const int pos = i % blocksPerFrame;
+		byte *dest = frame + (pos / blocksPerRow) * 8 * kFrameWidth + (pos % blocksPerRow) * 8;
+		idct(dest, kFrameWidth, blocks + (i % kNumSourceBlocks) * 64);
+	}
+	reportBenchmark(name, getMicros() - start, kNumBlocks);
+
+	uint32 sum = 0;
+	for (int i = 0; i < kFrameWidth * kFrameHeight; i++)
+		sum += frame[i];
+	consumeResult(sum);
+
+	delete[] frame;
+}
+
+#endif
+
+} // End of anonymous namespace
+
+void runBinkBenchmarks() {
+#ifdef USE_BINK
+	// Sparse coefficients, like in real videos
+	int16 *blocks = new int16[kNumSourceBlocks * 64];
+	for (int i = 0; i < kNumSourceBlocks * 64; i++) {
+		const int coeff = i & 63;
+		const int range = (coeff == 0) ? 2048 : 512 / (1 + (coeff >> 3) + (coeff & 7));
+		blocks[i] = (g_random.getRandom() % 3 == 0) ? (int)(g_random.getRandom() % (2 * range + 1)) - range : 0;
+	}
+
+	benchmarkIDCT("IDCT put, C", Video::binkIDCTPutScalar, blocks);
+	benchmarkIDCT("IDCT put", Video::binkIDCTPut, blocks);
+	benchmarkIDCT("IDCT add, C", Video::binkIDCTAddScalar, blocks);
+	benchmarkIDCT("IDCT add", Video::binkIDCTAdd, blocks);
+
+	delete[] blocks;
+#else
+	printf("Bink support is disabled, skipping the IDCT benchmarks\n");
+#endif
+
+	// The conversion of the decoded planes, for a 640x480 video
+	byte *planes = new byte[kFrameWidth * kFrameHeight * 3 / 2];
+	for (int i = 0; i < kFrameWidth * kFrameHeight * 3 / 2; i++)
+		planes[i] = g_random.getRandom() & 0xFF;
+
+	const byte *y = planes;
+	const byte *u = y + kFrameWidth * kFrameHeight;
+	const byte *v = u + kFrameWidth * kFrameHeight / 4;
+
+	Graphics::Surface surface;
+	surface.create(kFrameWidth, kFrameHeight, Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0));
+
+	const uint32 start = getMicros();
+	for (int i = 0; i < kNumFrames; i++)
+		Graphics::convertYUV420ToRGB(&surface, y, u, v, kFrameWidth, kFrameHeight, kFrameWidth, kFrameWidth / 2);
+	const uint32 micros = getMicros() - start;
+	reportBenchmark("YUV 4:2:0 to RGB, 640x480 frames", micros, kNumFrames);
+	printf("%-40s %10.1f frames/s\n", "", micros ? kNumFrames * 1000000.0 / micros : 0.0);
+
+	consumeResult(*(const uint32 *)surface.pixels);
+	surface.free();
+	delete[] planes;
+}
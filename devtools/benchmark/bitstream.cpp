@@ -0,0 +1,136 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include "common/bitstream.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "test/common/random_helper.h"
+
+#include <stdio.h>
+
+namespace {
+
+enum {
+	kDataSize = 4 * 1024 * 1024
+};
+
+/** Read all bits one at a time. */
+template<class BITSTREAM>
+uint32 readBits(BITSTREAM &bits) {
+	uint32 sum = 0;
+
+	while (bits.size() - bits.pos() > 0)
+		sum += bits.getBit();
+
+	return sum;
+}
+
+/** Read values of 1 to 17 bits, like the fields of a video packet. */
+template<class BITSTREAM>
+uint32 readValues(BITSTREAM &bits) {
+	uint32 sum = 0;
+	uint8 n = 1;
+
+	while (bits.size() - bits.pos() >= n) {
+		sum += bits.getBits(n);
+		n = n % 17 + 1;
+	}
+
+	return sum;
+}
+
+/** Peek at 9 bits and skip a part of them, like a table based Huffman decoder. */
+template<class BITSTREAM>
+uint32 peekSkip(BITSTREAM &bits) {
+	uint32 sum = 0;
+
+	while (bits.size() - bits.pos() >= 9) {
+		const uint32 v = bits.peekBits(9);
+		sum += v;
+		bits.skip((v & 7) + 1);
+	}
+
+	return sum;
+}
+
+/** Run a test on both the virtual BitStream interface and the memory reader. */
+template<class VIRTUALSTREAM, class MEMORYSTREAM>
+void benchmarkReaders(const char *layout, const byte *buffer, const char *name, uint32 (*testVirtual)(Common::BitStream &), uint32 (*testMemory)(MEMORYSTREAM &)) {
+	Common::String label;
+	uint32 start, sumVirtual, sumMemory;
+
+	{
+		Common::MemoryReadStream data(buffer, kDataSize);
+		VIRTUALSTREAM bits(data);
+
+		start = getMicros();
+		sumVirtual = testVirtual(bits);
+		label = Common::String::format("%s %s: BitStream", layout, name);
+		reportBenchmark(label.c_str(), getMicros() - start, kDataSize * 8);
+	}
+
+	{
+		Common::BitStreamMemoryStream data(buffer, kDataSize);
+		MEMORYSTREAM bits(data);
+
+		start = getMicros();
+		sumMemory = testMemory(bits);
+		label = Common::String::format("%s %s: memory reader", layout, name);
+		reportBenchmark(label.c_str(), getMicros() - start, kDataSize * 8);
+	}
+
+	// Both readers have to agree
+	if (sumVirtual != sumMemory)
+		printf("%s %s: read bits differ\n", layout, name);
+
+	consumeResult(sumVirtual);
+}
+
+template<class VIRTUALSTREAM, class MEMORYSTREAM>
+void benchmarkLayout(const char *layout, const byte *buffer) {
+	benchmarkReaders<VIRTUALSTREAM, MEMORYSTREAM>(layout, buffer, "getBit", &readBits<Common::BitStream>, &readBits<MEMORYSTREAM>);
+	benchmarkReaders<VIRTUALSTREAM, MEMORYSTREAM>(layout, buffer, "getBits", &readValues<Common::BitStream>, &readValues<MEMORYSTREAM>);
+	benchmarkReaders<VIRTUALSTREAM, MEMORYSTREAM>(layout, buffer, "peekBits/skip", &peekSkip<Common::BitStream>, &peekSkip<MEMORYSTREAM>);
+}
+
+} // End of anonymous namespace
+
+void runBitStreamBenchmarks() {
+	byte *buffer = new byte[kDataSize];
+
+	TestRandom rnd;
+	for (uint32 i = 0; i < kDataSize; i++)
+		buffer[i] = rnd.getRandom();
+
+	// The layouts of Smacker and Bink
+	benchmarkLayout<Common::BitStream8LSB, Common::BitStreamMemory8LSB>("8LSB", buffer);
+	benchmarkLayout<Common::BitStream32LELSB, Common::BitStreamMemory32LELSB>("32LELSB", buffer);
+	benchmarkLayout<Common::BitStream16BEMSB, Common::BitStreamMemory16BEMSB>("16BEMSB", buffer);
+
+	delete[] buffer;
+}
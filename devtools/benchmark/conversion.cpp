@@ -0,0 +1,159 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+#include "test/common/random_helper.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+enum {
+	kNumPixels = 20000000
+};
+
+struct FrameSize {
+	const char *name;
+	int width, height;
+};
+
+const FrameSize frameSizes[] = {
+	{ "320x200", 320, 200 },
+	{ "640x480", 640, 480 }
+};
+
+TestRandom g_random;
+
+/**
+ * The conversion with PixelFormat, one pixel at a time, as crossBlit() did
+ * it for all formats before it got fast paths.
+ */
+template<typename SrcPixel, typename DstPixel>
+void convertGeneric(byte *dst, const byte *src, int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+	const SrcPixel *s = (const SrcPixel *)src;
+	DstPixel *d = (DstPixel *)dst;
+
+	uint8 a, r, g, b;
+	for (int i = 0; i < w * h; i++) {
+		srcFmt.colorToARGB(s[i], a, r, g, b);
+		d[i] = dstFmt.ARGBToColor(a, r, g, b);
+	}
+}
+
+void benchmarkConversion(const char *name, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+	for (uint i = 0; i < ARRAYSIZE(frameSizes); i++) {
+		const int w = frameSizes[i].width;
+		const int h = frameSizes[i].height;
+		const int frames = kNumPixels / (w * h);
+
+		byte *src = new byte[w * h * 4];
+		byte *dst = new byte[w * h * 4];
+		for (int j = 0; j < w * h * 4; j++)
+			src[j] = g_random.getRandom() & 0xFF;
+
+		char title[64];
+		snprintf(title, sizeof(title), "%s, %s, generic", name, frameSizes[i].name);
+
+		uint32 start = getMicros();
+		for (int j = 0; j < frames; j++) {
+			if (srcFmt.bytesPerPixel == 2 && dstFmt.bytesPerPixel == 2)
+				convertGeneric<uint16, uint16>(dst, src, w, h, dstFmt, srcFmt);
+			else if (srcFmt.bytesPerPixel == 2)
+				convertGeneric<uint16, uint32>(dst, src, w, h, dstFmt, srcFmt);
+			else if (dstFmt.bytesPerPixel == 2)
+				convertGeneric<uint32, uint16>(dst, src, w, h, dstFmt, srcFmt);
+			else
+				convertGeneric<uint32, uint32>(dst, src, w, h, dstFmt, srcFmt);
+		}
+		reportBenchmark(title, getMicros() - start, frames);
+		consumeResult(dst[0]);
+
+		snprintf(title, sizeof(title), "%s, %s", name, frameSizes[i].name);
+
+		start = getMicros();
+		for (int j = 0; j < frames; j++)
+			Graphics::crossBlit(dst, src, w * dstFmt.bytesPerPixel, w * srcFmt.bytesPerPixel, w, h, dstFmt, srcFmt);
+		reportBenchmark(title, getMicros() - start, frames);
+		consumeResult(dst[0]);
+
+		delete[] src;
+		delete[] dst;
+	}
+}
+
+void benchmarkPaletteConversion(const char *name, const Graphics::PixelFormat &dstFmt) {
+	uint32 map[256];
+	for (int i = 0; i < 256; i++)
+		map[i] = dstFmt.RGBToColor(g_random.getRandom() & 0xFF, g_random.getRandom() & 0xFF, g_random.getRandom() & 0xFF);
+
+	for (uint i = 0; i < ARRAYSIZE(frameSizes); i++) {
+		const int w = frameSizes[i].width;
+		const int h = frameSizes[i].height;
+		const int frames = kNumPixels / (w * h);
+
+		byte *src = new byte[w * h];
+		byte *dst = new byte[w * h * 4];
+		for (int j = 0; j < w * h; j++)
+			src[j] = g_random.getRandom() & 0xFF;
+
+		char title[64];
+		snprintf(title, sizeof(title), "%s, %s", name, frameSizes[i].name);
+
+		const uint32 start = getMicros();
+		for (int j = 0; j < frames; j++)
+			Graphics::crossBlitMap(dst, src, w * dstFmt.bytesPerPixel, w, w, h, dstFmt.bytesPerPixel, map);
+		reportBenchmark(title, getMicros() - start, frames);
+		consumeResult(dst[0]);
+
+		delete[] src;
+		delete[] dst;
+	}
+}
+
+} // End of anonymous namespace
+
+void runConversionBenchmarks() {
+	const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+	const Graphics::PixelFormat argb1555(2, 5, 5, 5, 1, 10, 5, 0, 15);
+	const Graphics::PixelFormat xrgb8888(4, 8, 8, 8, 0, 16, 8, 0, 0);
+	const Graphics::PixelFormat argb8888(4, 8, 8, 8, 8, 16, 8, 0, 24);
+	const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+	// Times are per frame
+	benchmarkConversion("RGB565 to XRGB8888", xrgb8888, rgb565);
+	benchmarkConversion("XRGB8888 to RGB565", rgb565, xrgb8888);
+	benchmarkConversion("ARGB1555 to RGB565", rgb565, argb1555);
+	benchmarkConversion("RGB565 to ARGB1555", argb1555, rgb565);
+	benchmarkConversion("RGBA8888 to ARGB8888", argb8888, rgba8888);
+	benchmarkConversion("ARGB8888 to RGBA8888", rgba8888, argb8888);
+
+	benchmarkPaletteConversion("CLUT8 to RGB565", rgb565);
+	benchmarkPaletteConversion("CLUT8 to XRGB8888", xrgb8888);
+}
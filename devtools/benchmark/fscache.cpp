@@ -0,0 +1,143 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#ifdef POSIX
+
+#include "backends/fs/posix/posix-fs.h"
+#include "backends/fs/posix/posix-fs-cache.h"
+#include "common/fs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <utime.h>
+
+namespace {
+
+enum {
+	kNumDirectories = 200,
+	kFilesPerDirectory = 50
+};
+
+// Give the test tree an old modification time, so the cache accepts it
+void backdate(const Common::String &path) {
+	struct utimbuf times;
+	times.actime = times.modtime = time(0) - 60;
+	utime(path.c_str(), &times);
+}
+
+void createTree(const Common::String &root) {
+	mkdir(root.c_str(), 0755);
+
+	for (int i = 0; i < kNumDirectories; ++i) {
+		const Common::String dir = Common::String::format("%s/dir%03d", root.c_str(), i);
+		mkdir(dir.c_str(), 0755);
+
+		for (int j = 0; j < kFilesPerDirectory; ++j) {
+			const Common::String file = Common::String::format("%s/file%03d.dat", dir.c_str(), j);
+			FILE *f = fopen(file.c_str(), "wb");
+			if (f)
+				fclose(f);
+		}
+
+		backdate(dir);
+	}
+
+	backdate(root);
+}
+
+void removeTree(const Common::String &root) {
+	for (int i = 0; i < kNumDirectories; ++i) {
+		const Common::String dir = Common::String::format("%s/dir%03d", root.c_str(), i);
+		for (int j = 0; j < kFilesPerDirectory; ++j)
+			remove(Common::String::format("%s/file%03d.dat", dir.c_str(), j).c_str());
+		rmdir(dir.c_str());
+	}
+	rmdir(root.c_str());
+}
+
+/** List the given directory recursively, like FSDirectory does. */
+uint32 scanTree(const AbstractFSNode &node) {
+	AbstractFSList children;
+	if (!node.getChildren(children, Common::FSNode::kListAll, false))
+		return 0;
+
+	uint32 count = children.size();
+	for (AbstractFSList::iterator i = children.begin(); i != children.end(); ++i) {
+		if ((*i)->isDirectory())
+			count += scanTree(**i);
+		delete *i;
+	}
+
+	return count;
+}
+
+void benchmarkScan(const char *name, const Common::String &root) {
+	const POSIXFilesystemNode node(root);
+
+	const uint32 start = getMicros();
+	const uint32 count = scanTree(node);
+	reportBenchmark(name, getMicros() - start, count);
+}
+
+} // End of anonymous namespace
+
+void runFSCacheBenchmarks() {
+	const char *tmp = getenv("TMPDIR");
+	const Common::String root = Common::String::format("%s/scummvm-fscache-bench-%d", tmp ? tmp : "/tmp", (int)getpid());
+	const Common::String cacheFile = root + ".cache";
+
+	createTree(root);
+
+	benchmarkScan("fscache: scan without cache", root);
+
+	POSIXDirectoryCache *cache = new POSIXDirectoryCache(cacheFile);
+	POSIXFilesystemNode::setDirectoryCache(cache);
+	benchmarkScan("fscache: scan, filling cache", root);
+	delete cache;
+
+	// Simulate the next start, with the cache loaded from disk
+	const uint32 start = getMicros();
+	cache = new POSIXDirectoryCache(cacheFile);
+	reportBenchmark("fscache: load cache file", getMicros() - start, 1);
+
+	POSIXFilesystemNode::setDirectoryCache(cache);
+	benchmarkScan("fscache: scan with cache", root);
+	POSIXFilesystemNode::setDirectoryCache(0);
+	delete cache;
+
+	remove(cacheFile.c_str());
+	removeTree(root);
+}
+
+#else
+
+void runFSCacheBenchmarks() {
+	reportBenchmark("fscache: not supported on this platform", 0, 0);
+}
+
+#endif
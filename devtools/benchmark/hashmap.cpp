@@ -0,0 +1,177 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "benchmark.h"
+
+#include "common/hashmap.h"
+#include "common/flathashmap.h"
+#include "common/fs.h"
+#include "common/str.h"
+#include "common/array.h"
+#include "common/hash-str.h"
+
+namespace {
+
+enum {
+	kNumKeys = 100000,
+	kNumRounds = 10
+};
+
+template<class Map>
+void benchmarkIntMap(const char *name) {
+	Common::String label;
+	uint32 start, sum = 0;
+
+	Map map;
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		map.clear();
+		for (int i = 0; i < kNumKeys; ++i)
+			map[i * 7919] = i;
+	}
+	label = Common::String::format("%s: int insert", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		for (int i = 0; i < kNumKeys; ++i)
+			sum += map.getVal(i * 7919);
+	}
+	label = Common::String::format("%s: int lookup hit", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		for (int i = 0; i < kNumKeys; ++i)
+			sum += map.contains(i * 7919 + 1);
+	}
+	label = Common::String::format("%s: int lookup miss", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		for (typename Map::const_iterator i = map.begin(); i != map.end(); ++i)
+			sum += i->_value;
+	}
+	label = Common::String::format("%s: int iterate", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	start = getMicros();
+	for (int i = 0; i < kNumKeys; ++i)
+		map.erase(i * 7919);
+	label = Common::String::format("%s: int erase", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys);
+
+	consumeResult(sum);
+}
+
+template<class Map>
+void benchmarkStringMap(const char *name) {
+	Common::String label;
+	uint32 start, sum = 0;
+
+	Common::Array<Common::String> keys;
+	keys.reserve(kNumKeys);
+	for (int i = 0; i < kNumKeys; ++i)
+		keys.push_back(Common::String::format("data/file%05d.dat", i));
+
+	Map map;
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		map.clear();
+		for (int i = 0; i < kNumKeys; ++i)
+			map[keys[i]] = i;
+	}
+	label = Common::String::format("%s: string insert", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	start = getMicros();
+	for (int round = 0; round < kNumRounds; ++round) {
+		for (int i = 0; i < kNumKeys; ++i)
+			sum += map.getVal(keys[i]);
+	}
+	label = Common::String::format("%s: string lookup hit", name);
+	reportBenchmark(label.c_str(), getMicros() - start, kNumKeys * kNumRounds);
+
+	consumeResult(sum);
+}
+
+/**
+ * The use of the node cache of FSDirectory: a directory tree is cached
+ * once, checking each name for clashes, and files are then looked up
+ * with contains() and operator[], often with other capitalization.
+ */
+template<class Map>
+void benchmarkNodeCache(const char *name, int numFiles) {
+	Common::String label;
+	uint32 start, sum = 0;
+
+	Common::Array<Common::String> keys, lookups;
+	for (int i = 0; i < numFiles; ++i) {
+		keys.push_back(Common::String::format("dir%02d/file%04d.dat", i / 100, i));
+		lookups.push_back(Common::String::format("DIR%02d/File%04d.DAT", i / 100, i));
+	}
+
+	const Common::FSNode node;
+	const int rounds = kNumKeys * kNumRounds / numFiles;
+	Map map;
+
+	start = getMicros();
+	for (int round = 0; round < rounds; ++round) {
+		map.clear();
+		for (int i = 0; i < numFiles; ++i) {
+			if (!map.contains(keys[i]))
+				map[keys[i]] = node;
+		}
+	}
+	label = Common::String::format("%s: node cache, %d files, build", name, numFiles);
+	reportBenchmark(label.c_str(), getMicros() - start, rounds * numFiles);
+
+	start = getMicros();
+	for (int round = 0; round < rounds; ++round) {
+		for (int i = 0; i < numFiles; ++i) {
+			if (map.contains(lookups[i]))
+				sum += map[lookups[i]].isDirectory();
+		}
+	}
+	label = Common::String::format("%s: node cache, %d files, lookup", name, numFiles);
+	reportBenchmark(label.c_str(), getMicros() - start, rounds * numFiles);
+
+	consumeResult(sum);
+}
+
+} // End of anonymous namespace
+
+void runHashMapBenchmarks() {
+	benchmarkIntMap<Common::HashMap<int, uint32> >("HashMap");
+	benchmarkIntMap<Common::FlatHashMap<int, uint32> >("FlatHashMap");
+	benchmarkStringMap<Common::HashMap<Common::String, uint32, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("HashMap");
+	benchmarkStringMap<Common::FlatHashMap<Common::String, uint32, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("FlatHashMap");
+
+	static const int nodeCacheSizes[] = { 100, 2000, 20000 };
+	for (int i = 0; i < ARRAYSIZE(nodeCacheSizes); ++i) {
+		benchmarkNodeCache<Common::HashMap<Common::String, Common::FSNode, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("HashMap", nodeCacheSizes[i]);
+		benchmarkNodeCache<Common::FlatHashMap<Common::String, Common::FSNode, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("FlatHashMap", nodeCacheSizes[i]);
+	}
+}
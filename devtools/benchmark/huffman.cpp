@@ -0,0 +1,161 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+#include "common/str.h"
+
+#include "test/common/random_helper.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+enum {
+	kNumSymbols = 1000000
+};
+
+TestRandom g_random;
+
+/** Assign canonical codes to the lengths, with the first bit as the LSB. */
+void makeCodes(const uint8 *lengths, uint32 count, uint32 *codes) {
+	uint32 code = 0;
+
+	for (uint8 length = 1; length <= 32; length++) {
+		for (uint32 i = 0; i < count; i++) {
+			if (lengths[i] != length)
+				continue;
+
+			// Reverse the code, as the stream hands out the LSB first
+			uint32 reversed = 0;
+			for (uint8 j = 0; j < length; j++)
+				reversed |= ((code >> j) & 1) << (length - 1 - j);
+
+			codes[i] = reversed;
+			code++;
+		}
+		code <<= 1;
+	}
+}
+
+/**
+ * The decoder Common::Huffman used before the lookup tables: add one bit
+ * at a time and compare against all codes of that length.
+ */
+uint32 getSymbolBitwise(Common::BitStream &bits, const uint8 *lengths, const uint32 *codes, uint32 count, uint8 maxLength) {
+	uint32 code = 0;
+
+	for (uint8 i = 0; i < maxLength; i++) {
+		bits.addBit(code, i);
+
+		for (uint32 j = 0; j < count; j++)
+			if (lengths[j] == i + 1 && codes[j] == code)
+				return j;
+	}
+
+	return 0;
+}
+
+void benchmarkCodes(const char *name, const uint8 *lengths, uint32 count) {
+	uint32 codes[64];
+	makeCodes(lengths, count, codes);
+
+	uint8 maxLength = 0;
+	for (uint32 i = 0; i < count; i++)
+		maxLength = MAX(maxLength, lengths[i]);
+
+	// Encode random symbols
+	byte *buffer = new byte[kNumSymbols * 4 + 4];
+	memset(buffer, 0, kNumSymbols * 4 + 4);
+
+	uint32 bitPos = 0;
+	for (uint32 i = 0; i < kNumSymbols; i++) {
+		const uint32 symbol = g_random.getRandom() % count;
+
+		for (uint8 j = 0; j < lengths[symbol]; j++, bitPos++)
+			buffer[bitPos >> 3] |= ((codes[symbol] >> j) & 1) << (bitPos & 7);
+	}
+
+	const uint32 dataSize = ((bitPos + 31) / 32) * 4;
+	Common::Huffman huffman(0, count, codes, lengths);
+	Common::String label;
+	uint32 start, sumBitwise = 0, sumTable = 0, sumMemory = 0;
+
+	{
+		Common::MemoryReadStream data(buffer, dataSize);
+		Common::BitStream32LELSB bits(data);
+
+		start = getMicros();
+		for (uint32 i = 0; i < kNumSymbols; i++)
+			sumBitwise += getSymbolBitwise(bits, lengths, codes, count, maxLength);
+		label = Common::String::format("%s: bitwise decode", name);
+		reportBenchmark(label.c_str(), getMicros() - start, kNumSymbols);
+	}
+
+	{
+		Common::MemoryReadStream data(buffer, dataSize);
+		Common::BitStream32LELSB bits(data);
+
+		start = getMicros();
+		for (uint32 i = 0; i < kNumSymbols; i++)
+			sumTable += huffman.getSymbol(bits);
+		label = Common::String::format("%s: table decode", name);
+		reportBenchmark(label.c_str(), getMicros() - start, kNumSymbols);
+	}
+
+	{
+		Common::BitStreamMemoryStream data(buffer, dataSize);
+		Common::BitStreamMemory32LELSB bits(data);
+
+		start = getMicros();
+		for (uint32 i = 0; i < kNumSymbols; i++)
+			sumMemory += huffman.getSymbol(bits);
+		label = Common::String::format("%s: table decode, memory reader", name);
+		reportBenchmark(label.c_str(), getMicros() - start, kNumSymbols);
+	}
+
+	// All decoders have to agree
+	if (sumTable != sumBitwise || sumMemory != sumBitwise)
+		printf("%s: decoded symbols differ\n", name);
+
+	consumeResult(sumBitwise);
+	delete[] buffer;
+}
+
+} // End of anonymous namespace
+
+void runHuffmanBenchmarks() {
+	// Like the Bink codebooks: 16 symbols, short codes
+	static const uint8 shortLengths[] = { 1, 2, 4, 4, 5, 5, 5, 6, 6, 7, 7, 7, 7, 7, 7, 7 };
+	benchmarkCodes("short codes", shortLengths, ARRAYSIZE(shortLengths));
+
+	// Codes up to 16 bits long, which need secondary tables
+	static const uint8 longLengths[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 16 };
+	benchmarkCodes("long codes", longLengths, ARRAYSIZE(longLengths));
+}
@@ -0,0 +1,32 @@
+MODULE := devtools/benchmark
+
+MODULE_OBJS := \
+	benchmark.o \
+	bink.o \
+	bitstream.o \
+	conversion.o \
+	fscache.o \
+	hashmap.o \
+	huffman.o \
+	rate.o
+
+# Set the name of the executable
+TOOL_EXECUTABLE := benchmark
+
+# Link against the code being benchmarked
+TOOL_DEPS :=
+ifdef POSIX
+TOOL_DEPS += \
+	backends/fs/abstract-fs.o \
+	backends/fs/stdiostream.o \
+	backends/fs/posix/posix-fs.o \
+	backends/fs/posix/posix-fs-cache.o
+endif
+TOOL_DEPS += \
+	video/libvideo.a \
+	audio/libaudio.a \
+	graphics/libgraphics.a \
+	common/libcommon.a
+
+# Include common rules
+include $(srcdir)/rules.mk
@@ -0,0 +1,124 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Standalone tool, allowed to use the standard C library
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "benchmark.h"
+
+#include "audio/audiostream.h"
+#include "audio/mixer.h"
+#include "audio/rate.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+enum {
+	kNumSeconds = 60,
+	kBufferFrames = 2048
+};
+
+/** An endless 440 Hz sine wave. */
+class SineStream : public Audio::AudioStream {
+public:
+	SineStream(int rate, bool stereo) : _rate(rate), _stereo(stereo), _pos(0) {
+		_period = rate / 440;
+		_table = new int16[_period];
+		for (int i = 0; i < _period; i++)
+			_table[i] = (int16)(sin(i * 2 * M_PI / _period) * 16384);
+	}
+
+	~SineStream() {
+		delete[] _table;
+	}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; i++) {
+			buffer[i] = _table[_pos];
+			if (!_stereo || (i & 1)) {
+				if (++_pos == _period)
+					_pos = 0;
+			}
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+
+private:
+	int _rate;
+	bool _stereo;
+	int16 *_table;
+	int _period;
+	int _pos;
+};
+
+void benchmarkRateConverter(const char *name, int inputRate, int outputRate, bool stereo, Audio::RateConverterQuality quality) {
+	SineStream stream(inputRate, stereo);
+	Audio::RateConverter *converter = Audio::makeRateConverter(inputRate, outputRate, stereo, false, quality);
+	int16 *buffer = new int16[kBufferFrames * 2];
+	const int numFrames = outputRate * kNumSeconds;
+
+	const uint32 start = getMicros();
+	for (int i = 0; i < numFrames; i += kBufferFrames) {
+		memset(buffer, 0, kBufferFrames * 2 * sizeof(int16));
+		converter->flow(stream, buffer, kBufferFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+	}
+	const uint32 micros = getMicros() - start;
+
+	char title[64];
+	snprintf(title, sizeof(title), "%s, %d Hz %s to %d Hz", name, inputRate, stereo ? "stereo" : "mono", outputRate);
+	reportBenchmark(title, micros, numFrames);
+
+	// The share of one CPU which is needed for real time playback
+	printf("%-40s %10.2f %% CPU\n", "", micros / (kNumSeconds * 10000.0));
+
+	consumeResult(buffer[0]);
+	delete[] buffer;
+	delete converter;
+}
+
+} // End of anonymous namespace
+
+void runRateBenchmarks() {
+	static const int inputRates[] = { 11025, 22050, 44100, 48000 };
+	// The usual mixer rates
+	static const int outputRates[] = { 44100, 48000 };
+
+	for (int o = 0; o < ARRAYSIZE(outputRates); o++) {
+		for (int i = 0; i < ARRAYSIZE(inputRates); i++) {
+			if (inputRates[i] == outputRates[o])
+				continue;
+
+			for (int stereo = 0; stereo < 2; stereo++) {
+				benchmarkRateConverter("Fast", inputRates[i], outputRates[o], stereo, Audio::kRateQualityFast);
+				benchmarkRateConverter("High", inputRates[i], outputRates[o], stereo, Audio::kRateQualityHigh);
+				benchmarkRateConverter("Best", inputRates[i], outputRates[o], stereo, Audio::kRateQualityBest);
+			}
+		}
+	}
+}
@@ -57,6 +57,7 @@
 #include "sci/video/robot_decoder.h"
 #endif
 
+#include "common/algorithm.h"
 #include "common/file.h"
 #include "common/savefile.h"
 
@@ -67,6 +68,9 @@ namespace Sci {
 int g_debug_sleeptime_factor = 1;
 int g_debug_simulated_key = 0;
 bool g_debug_track_mouse_clicks = false;
+bool g_debug_predecode_scripts = true;
+
+extern const char *opcodeNames[]; // from scriptdebug.cpp
 
 // Refer to the "addresses" command on how to pass address parameters
 static int parse_reg_t(EngineState *s, const char *str, reg_t *dest, bool mayBeValue);
@@ -80,8 +84,10 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	// Variables
 	DVar_Register("sleeptime_factor",	&g_debug_sleeptime_factor, DVAR_INT, 0);
 	DVar_Register("gc_interval",		&engine->_gamestate->scriptGCInterval, DVAR_INT, 0);
+	DVar_Register("gc_incremental",		&engine->_gamestate->incrementalGC, DVAR_BOOL, 0);
 	DVar_Register("simulated_key",		&g_debug_simulated_key, DVAR_INT, 0);
 	DVar_Register("track_mouse_clicks",	&g_debug_track_mouse_clicks, DVAR_BOOL, 0);
+	DVar_Register("predecode_scripts",	&g_debug_predecode_scripts, DVAR_BOOL, 0);
 	DVar_Register("script_abort_flag",	&_engine->_gamestate->abortScriptProcessing, DVAR_INT, 0);
 
 	// General
@@ -108,6 +114,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	DCmd_Register("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	DCmd_Register("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	DCmd_Register("resource_stats",		WRAP_METHOD(Console, cmdResourceStats));
 	DCmd_Register("list",				WRAP_METHOD(Console, cmdList));
 	DCmd_Register("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	DCmd_Register("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -140,12 +147,14 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("seginfo",			WRAP_METHOD(Console, cmdSegmentInfo));			// alias
 	DCmd_Register("segment_kill",		WRAP_METHOD(Console, cmdKillSegment));
 	DCmd_Register("segkill",			WRAP_METHOD(Console, cmdKillSegment));			// alias
+	DCmd_Register("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	// Garbage collection
 	DCmd_Register("gc",					WRAP_METHOD(Console, cmdGCInvoke));
 	DCmd_Register("gc_objects",			WRAP_METHOD(Console, cmdGCObjects));
 	DCmd_Register("gc_reachable",		WRAP_METHOD(Console, cmdGCShowReachable));
 	DCmd_Register("gc_freeable",		WRAP_METHOD(Console, cmdGCShowFreeable));
 	DCmd_Register("gc_normalize",		WRAP_METHOD(Console, cmdGCNormalize));
+	DCmd_Register("gc_stats",			WRAP_METHOD(Console, cmdGCStats));
 	// Music/SFX
 	DCmd_Register("songlib",			WRAP_METHOD(Console, cmdSongLib));
 	DCmd_Register("songinfo",			WRAP_METHOD(Console, cmdSongInfo));
@@ -201,6 +210,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	DCmd_Register("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	DCmd_Register("vm_profile",			WRAP_METHOD(Console, cmdVMProfile));
 	DCmd_Register("vm_varlist",			WRAP_METHOD(Console, cmdVMVarlist));
 	DCmd_Register("vmvarlist",			WRAP_METHOD(Console, cmdVMVarlist));				// alias
 	DCmd_Register("vl",					WRAP_METHOD(Console, cmdVMVarlist));				// alias
@@ -225,6 +235,8 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	_debugState.breakpointWasHit = false;
 	_debugState._breakpoints.clear(); // No breakpoints defined
 	_debugState._activeBreakpointTypes = 0;
+	_debugState.profiling = false;
+	memset(_debugState.opcodeCounts, 0, sizeof(_debugState.opcodeCounts));
 }
 
 Console::~Console() {
@@ -308,8 +320,10 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf("---------\n");
 	DebugPrintf("sleeptime_factor: Factor to multiply with wait times in kWait()\n");
 	DebugPrintf("gc_interval: Number of kernel calls in between garbage collections\n");
+	DebugPrintf("gc_incremental: Toggles spreading the marking of garbage collections over kernel calls\n");
 	DebugPrintf("simulated_key: Add a key with the specified scan code to the event list\n");
 	DebugPrintf("track_mouse_clicks: Toggles mouse click tracking to the console\n");
+	DebugPrintf("predecode_scripts: Toggles reusing the decoded instructions of scripts\n");
 	DebugPrintf("weak_validations: Turns some validation errors into warnings\n");
 	DebugPrintf("script_abort_flag: Set to 1 to abort script execution. Set to 2 to force a replay afterwards\n");
 	DebugPrintf("\n");
@@ -344,6 +358,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	DebugPrintf(" resource_info - Shows info about a resource\n");
 	DebugPrintf(" resource_types - Shows the valid resource types\n");
+	DebugPrintf(" resource_stats - Shows statistics of the resource cache\n");
 	DebugPrintf(" list - Lists all the resources of a given type\n");
 	DebugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	DebugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -373,6 +388,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" segment_table / segtable - Lists all segments\n");
 	DebugPrintf(" segment_info / seginfo - Provides information on the specified segment\n");
 	DebugPrintf(" segment_kill / segkill - Deletes the specified segment\n");
+	DebugPrintf(" selector_cache - Shows statistics of the selector lookup cache\n");
 	DebugPrintf("\n");
 	DebugPrintf("Garbage collection:\n");
 	DebugPrintf(" gc - Invokes the garbage collector\n");
@@ -380,6 +396,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" gc_reachable - Lists all addresses directly reachable from a given memory object\n");
 	DebugPrintf(" gc_freeable - Lists all addresses freeable in a given segment\n");
 	DebugPrintf(" gc_normalize - Prints the \"normal\" address of a given address\n");
+	DebugPrintf(" gc_stats - Shows statistics of the garbage collector\n");
 	DebugPrintf("\n");
 	DebugPrintf("Music/SFX:\n");
 	DebugPrintf(" songlib - Shows the song library\n");
@@ -421,6 +438,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf("\n");
 	DebugPrintf("VM:\n");
 	DebugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	DebugPrintf(" vm_profile - Counts the executed opcodes and shows the most frequent ones\n");
 	DebugPrintf(" vm_varlist / vmvarlist / vl - Shows the addresses of variables in the VM\n");
 	DebugPrintf(" vm_vars / vmvars / vv - Displays or changes variables in the VM\n");
 	DebugPrintf(" stack - Lists the specified number of stack elements\n");
@@ -785,6 +803,33 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceStats(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows statistics of the resource cache\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		resMan->resetStats();
+		DebugPrintf("Resource statistics have been reset\n");
+		return true;
+	}
+
+	const ResourceStats &stats = resMan->getStats();
+	const uint32 lookups = stats.hits + stats.misses;
+
+	DebugPrintf("Unlocked resources: %d of %d KB\n", resMan->getLRUMemory() / 1024, resMan->getMaxMemory() / 1024);
+	DebugPrintf("Locked resources: %d KB\n", resMan->getLockedMemory() / 1024);
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate)\n", stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0);
+	DebugPrintf("Evictions: %d (%d KB)\n", stats.evictions, stats.evictedBytes / 1024);
+	DebugPrintf("Loading and decompression time: %d ms\n", stats.loadTime);
+
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		DebugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
@@ -2009,6 +2054,34 @@ bool Console::cmdKillSegment(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	SelectorLookupCache &cache = _engine->_gamestate->_segMan->getLookupCache();
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows statistics of the selector lookup cache\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		cache.resetStats();
+		DebugPrintf("Selector cache statistics have been reset\n");
+		return true;
+	}
+
+	const SelectorLookupStats &stats = cache.getStats();
+	const uint32 lookups = stats.siteHits + stats.tableHits + stats.misses;
+
+	DebugPrintf("Lookups: %d\n", lookups);
+	DebugPrintf("Inline cache hits: %d (%.1f%%)\n", stats.siteHits, lookups ? stats.siteHits * 100.0 / lookups : 0.0);
+	DebugPrintf("Selector table hits: %d (%.1f%%)\n", stats.tableHits, lookups ? stats.tableHits * 100.0 / lookups : 0.0);
+	DebugPrintf("Misses: %d (%.1f%%)\n", stats.misses, lookups ? stats.misses * 100.0 / lookups : 0.0);
+	DebugPrintf("Objects with selector tables: %d\n", cache.getTableCount());
+	DebugPrintf("Invalidations: %d\n", stats.invalidations);
+
+	return true;
+}
+
 bool Console::cmdShowMap(int argc, const char **argv) {
 	if (argc != 2) {
 		DebugPrintf("Switches to one of the following screen maps\n");
@@ -2176,6 +2249,36 @@ bool Console::cmdGCObjects(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdGCStats(int argc, const char **argv) {
+	SegManager *segMan = _engine->_gamestate->_segMan;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Shows statistics of the garbage collector\n");
+		DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		return true;
+	}
+
+	GCStats &stats = segMan->getGCStats();
+
+	if (argc == 2) {
+		memset(&stats, 0, sizeof(stats));
+		DebugPrintf("Garbage collector statistics have been reset\n");
+		return true;
+	}
+
+	DebugPrintf("Mode: %s", _engine->_gamestate->incrementalGC ? "incremental" : "stop-the-world");
+	if (segMan->isGCInProgress())
+		DebugPrintf(" (marking, %d gray objects)", segMan->getGCWorklist()->_worklist.size());
+	DebugPrintf("\n");
+	DebugPrintf("Collections: %d, aborted: %d, incremental steps: %d\n", stats.collections, stats.aborted, stats.steps);
+	DebugPrintf("Objects freed: %d, by the last collection: %d\n", stats.freed, stats.lastFreed);
+	DebugPrintf("References marked by the last collection: %d\n", stats.lastMarked);
+	DebugPrintf("Pause time: last %d ms, max %d ms, average %.1f ms\n", stats.lastPause, stats.maxPause,
+				stats.collections ? (double)stats.totalPause / stats.collections : 0.0);
+
+	return true;
+}
+
 bool Console::cmdGCShowReachable(int argc, const char **argv) {
 	if (argc != 2) {
 		DebugPrintf("Prints all addresses directly reachable from the memory object specified as parameter.\n");
@@ -2637,6 +2740,62 @@ bool Console::cmdScriptSteps(int argc, const char **argv) {
 	return true;
 }
 
+namespace {
+struct OpcodeCountGreater {
+	const uint32 *_counts;
+	OpcodeCountGreater(const uint32 *counts) : _counts(counts) {}
+	bool operator()(int a, int b) const { return _counts[a] > _counts[b]; }
+};
+} // End of anonymous namespace
+
+bool Console::cmdVMProfile(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "on") && strcmp(argv[1], "off") && strcmp(argv[1], "reset"))) {
+		DebugPrintf("Counts the executed opcodes and shows the most frequent ones\n");
+		DebugPrintf("Usage: %s [on | off | reset]\n", argv[0]);
+		return true;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "reset"))
+			memset(_debugState.opcodeCounts, 0, sizeof(_debugState.opcodeCounts));
+		else
+			_debugState.profiling = !strcmp(argv[1], "on");
+
+		DebugPrintf("Opcode profiling is %s\n", _debugState.profiling ? "on" : "off");
+		return true;
+	}
+
+	uint32 total = 0;
+	int opcodes[128];
+	for (int i = 0; i < 128; i++) {
+		total += _debugState.opcodeCounts[i];
+		opcodes[i] = i;
+	}
+
+	Common::sort(opcodes, opcodes + 128, OpcodeCountGreater(_debugState.opcodeCounts));
+
+	DebugPrintf("Opcode profiling is %s, %d opcodes counted\n", _debugState.profiling ? "on" : "off", total);
+	for (int i = 0; i < 20 && _debugState.opcodeCounts[opcodes[i]]; i++) {
+		const uint32 count = _debugState.opcodeCounts[opcodes[i]];
+		DebugPrintf("%-10s %10d (%.1f%%)\n", opcodeNames[opcodes[i]], count, count * 100.0 / total);
+	}
+
+	// Show how much the instruction cache of the scripts holds
+	const Common::Array<SegmentObj *> &segments = _engine->_gamestate->_segMan->getSegments();
+	uint scriptCount = 0, instructionCount = 0;
+	for (uint i = 0; i < segments.size(); i++) {
+		if (segments[i] && segments[i]->getType() == SEG_TYPE_SCRIPT) {
+			scriptCount++;
+			instructionCount += ((Script *)segments[i])->getPredecodedCount();
+		}
+	}
+
+	DebugPrintf("Predecoded instructions: %d in %d scripts (%s)\n", instructionCount, scriptCount,
+				g_debug_predecode_scripts ? "enabled" : "disabled, see the predecode_scripts variable");
+
+	return true;
+}
+
 bool Console::cmdBacktrace(int argc, const char **argv) {
 	DebugPrintf("Call stack (current base: 0x%x):\n", _engine->_gamestate->executionStackBase);
 	Common::List<ExecStack>::const_iterator iter;
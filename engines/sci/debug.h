@@ -72,12 +72,15 @@ struct DebugState {
 	StackPtr old_sp;
 	Common::List<Breakpoint> _breakpoints;   //< List of breakpoints
 	int _activeBreakpointTypes;  //< Bit mask specifying which types of breakpoints are active
+	bool profiling;				// Count the executed opcodes, see the vm_profile console command
+	uint32 opcodeCounts[128];	// Number of times each opcode was executed while profiling
 };
 
 // Various global variables used for debugging are declared here
 extern int g_debug_sleeptime_factor;
 extern int g_debug_simulated_key;
 extern bool g_debug_track_mouse_clicks;
+extern bool g_debug_predecode_scripts;
 
 } // End of namespace Sci
 
@@ -22,12 +22,21 @@
 
 #include "sci/engine/gc.h"
 #include "common/array.h"
+#include "common/system.h"
 #include "sci/graphics/ports.h"
 
 namespace Sci {
 
 //#define GC_DEBUG_CODE
 
+enum {
+	/**
+	 * Number of gray objects scanned by each step of an incremental
+	 * collection, i.e. on each kernel call while the collection is marking.
+	 */
+	kGCStepSize = 64
+};
+
 #ifdef GC_DEBUG_CODE
 const char *segmentTypeNames[] = {
 	"invalid",   // 0
@@ -80,26 +89,33 @@ static AddrSet *normalizeAddresses(SegManager *segMan, const AddrSet &nonnormal_
 	return normal_map;
 }
 
-static void processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap) {
+/**
+ * Scans the gray objects on the worklist for their outgoing references.
+ * @param maxObjects	Number of objects to scan at most, or 0 to empty the worklist
+ */
+static void processWorkList(SegManager *segMan, WorklistManager &wm, const Common::Array<SegmentObj *> &heap, uint maxObjects = 0) {
 	SegmentId stackSegment = segMan->findSegmentByType(SEG_TYPE_STACK);
-	while (!wm._worklist.empty()) {
+	uint scanned = 0;
+	while (!wm._worklist.empty() && (!maxObjects || scanned < maxObjects)) {
 		reg_t reg = wm._worklist.back();
 		wm._worklist.pop_back();
 		if (reg.segment != stackSegment) { // No need to repeat this one
 			debugC(kDebugLevelGC, "[GC] Checking %04x:%04x", PRINT_REG(reg));
-			if (reg.segment < heap.size() && heap[reg.segment]) {
+			// Objects can be freed while an incremental collection is
+			// still marking, skip them
+			if (reg.segment < heap.size() && heap[reg.segment] && heap[reg.segment]->isValidOffset(reg.offset)) {
 				// Valid heap object? Find its outgoing references!
 				wm.pushArray(heap[reg.segment]->listAllOutgoingReferences(reg));
+				scanned++;
 			}
 		}
 	}
 }
 
-AddrSet *findAllActiveReferences(EngineState *s) {
+/** Pushes the root set: the registers, the stacks and the explicitly loaded scripts. */
+static void pushRoots(EngineState *s, WorklistManager &wm) {
 	assert(!s->_executionStack.empty());
 
-	WorklistManager wm;
-
 	// Initialize registers
 	wm.push(s->r_acc);
 	wm.push(s->r_prev);
@@ -151,8 +167,13 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	}
 
 	debugC(kDebugLevelGC, "[GC] -- Finished explicitly loaded scripts, done with root set");
+}
 
-	processWorkList(s->_segMan, wm, heap);
+AddrSet *findAllActiveReferences(EngineState *s) {
+	WorklistManager wm;
+
+	pushRoots(s, wm);
+	processWorkList(s->_segMan, wm, s->_segMan->getSegments());
 
 	if (g_sci->_gfxPorts)
 		g_sci->_gfxPorts->processEngineHunkList(wm);
@@ -160,11 +181,12 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	return normalizeAddresses(s->_segMan, wm._map);
 }
 
-void run_gc(EngineState *s) {
-	SegManager *segMan = s->_segMan;
-
-	// Some debug stuff
-	debugC(kDebugLevelGC, "[GC] Running...");
+/**
+ * Frees everything which is not in the given set of active references.
+ * @return the number of freed objects
+ */
+static uint sweep(SegManager *segMan, const AddrSet &activeRefs) {
+	uint freed = 0;
 #ifdef GC_DEBUG_CODE
 	const char *segnames[SEG_TYPE_MAX + 1];
 	int segcount[SEG_TYPE_MAX + 1];
@@ -172,9 +194,6 @@ void run_gc(EngineState *s) {
 	memset(segcount, 0, sizeof(segcount));
 #endif
 
-	// Compute the set of all segments references currently in use.
-	AddrSet *activeRefs = findAllActiveReferences(s);
-
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
 	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
@@ -192,10 +211,11 @@ void run_gc(EngineState *s) {
 			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
 			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
 				const reg_t addr = *it;
-				if (!activeRefs->contains(addr)) {
+				if (!activeRefs.contains(addr)) {
 					// Not found -> we can free it
 					mobj->freeAtAddress(segMan, addr);
 					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+					freed++;
 #ifdef GC_DEBUG_CODE
 					segcount[type]++;
 #endif
@@ -205,8 +225,6 @@ void run_gc(EngineState *s) {
 		}
 	}
 
-	delete activeRefs;
-
 #ifdef GC_DEBUG_CODE
 	// Output debug summary of garbage collection
 	debugC(kDebugLevelGC, "[GC] Summary:");
@@ -214,6 +232,73 @@ void run_gc(EngineState *s) {
 		if (segcount[i])
 			debugC(kDebugLevelGC, "\t%d\t* %s", segcount[i], segnames[i]);
 #endif
+
+	return freed;
+}
+
+void run_gc(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	const uint32 startTime = g_system->getMillis();
+
+	debugC(kDebugLevelGC, "[GC] Running...");
+
+	// Finish an incremental collection right away, if one is marking
+	WorklistManager *wm = segMan->getGCWorklist();
+	segMan->setGCWorklist(NULL);
+	if (!wm)
+		wm = new WorklistManager();
+
+	// Compute the set of all segments references currently in use. The
+	// registers and the stacks are written without the write barrier, and
+	// scripts may have been locked, since an incremental collection
+	// started, so the roots are always pushed (again) here.
+	pushRoots(s, *wm);
+	processWorkList(segMan, *wm, segMan->getSegments());
+
+	if (g_sci->_gfxPorts)
+		g_sci->_gfxPorts->processEngineHunkList(*wm);
+
+	AddrSet *activeRefs = normalizeAddresses(segMan, wm->_map);
+	const uint marked = wm->_map.size();
+	delete wm;
+
+	const uint freed = sweep(segMan, *activeRefs);
+	delete activeRefs;
+
+	const uint32 pause = g_system->getMillis() - startTime;
+	GCStats &stats = segMan->getGCStats();
+	stats.collections++;
+	stats.freed += freed;
+	stats.lastFreed = freed;
+	stats.lastMarked = marked;
+	stats.lastPause = pause;
+	stats.maxPause = MAX(stats.maxPause, pause);
+	stats.totalPause += pause;
+}
+
+void run_gc_step(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	WorklistManager *wm = segMan->getGCWorklist();
+
+	if (!wm) {
+		// Start a new collection. Everything allocated or stored into
+		// the heap from now on is shaded by the SegManager.
+		debugC(kDebugLevelGC, "[GC] Starting incremental collection");
+		wm = new WorklistManager();
+		pushRoots(s, *wm);
+		segMan->setGCWorklist(wm);
+		return;
+	}
+
+	segMan->getGCStats().steps++;
+
+	if (!wm->_worklist.empty()) {
+		processWorkList(segMan, *wm, segMan->getSegments(), kGCStepSize);
+		return;
+	}
+
+	// No gray objects are left, rescan the roots and sweep
+	run_gc(s);
 }
 
 } // End of namespace Sci
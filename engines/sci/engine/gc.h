@@ -30,12 +30,6 @@
 
 namespace Sci {
 
-struct reg_t_Hash {
-	uint operator()(const reg_t& x) const {
-		return (x.segment << 3) ^ x.offset ^ (x.offset << 16);
-	}
-};
-
 /*
  * The AddrSet is a "set" of reg_t values.
  * We don't have a HashSet type, so we abuse a HashMap for this.
@@ -50,11 +44,22 @@ typedef Common::HashMap<reg_t, bool, reg_t_Hash> AddrSet;
 AddrSet *findAllActiveReferences(EngineState *s);
 
 /**
- * Runs garbage collection on the current system state
+ * Runs garbage collection on the current system state. If an incremental
+ * collection is in progress, it is finished.
  * @param s The state in which we should gc
  */
 void run_gc(EngineState *s);
 
+/**
+ * Does a bounded amount of work of an incremental garbage collection:
+ * starts a new collection by shading the roots, scans some of the gray
+ * objects, or finishes the collection once all reachable objects have been
+ * marked. The SegManager shades new objects and, through its write barrier,
+ * all references stored into the heap, while the collection is marking.
+ * @param s The state in which we should gc
+ */
+void run_gc_step(EngineState *s);
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
 	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
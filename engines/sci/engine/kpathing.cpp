@@ -28,6 +28,7 @@
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
 
+#include "common/array.h"
 #include "common/debug-channels.h"
 #include "common/list.h"
 #include "common/system.h"
@@ -60,6 +61,21 @@ enum {
 
 #define VERTEX_HAS_EDGES(V) ((V) != CLIST_NEXT(V))
 
+// Size of the edge grid cells in pixels. The cells grow when the polygons
+// span more than EDGE_GRID_MAX_CELLS cells.
+#define EDGE_GRID_CELL_SIZE 32
+#define EDGE_GRID_MAX_CELLS 1024
+
+// Maximum number of vertices for which visibility is cached
+#define VISIBILITY_CACHE_MAX_VERTICES 1024
+
+// Visibility cache entries
+enum {
+	VIS_UNKNOWN = 0,
+	VIS_BLOCKED = 1,
+	VIS_VISIBLE = 2
+};
+
 // Error codes
 enum {
 	PF_OK = 0,
@@ -94,10 +110,18 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Position in the vertex index
+	int _index;
+
+	// Position in the visibility cache, -1 if not cached
+	int _cacheIndex;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		_index = 0;
+		_cacheIndex = -1;
 	}
 };
 
@@ -214,6 +238,45 @@ public:
 
 typedef Common::List<Polygon *> PolygonList;
 
+/**
+ * Uniform grid over the polygon edges. Every edge is stored in all cells
+ * overlapped by its bounding box, so that only the edges near a line segment
+ * have to be tested for intersections with it.
+ */
+class EdgeGrid {
+public:
+	EdgeGrid() : _left(0), _top(0), _cellSize(EDGE_GRID_CELL_SIZE), _columns(0), _rows(0), _queryStamp(0) {}
+
+	/**
+	 * Builds the grid from the edges in a vertex index. The _index
+	 * members of the vertices must be set up already.
+	 */
+	void build(Vertex **vertices, int count);
+
+	/**
+	 * Collects all edges that might intersect the segment (a, b), or
+	 * have their start vertex on it. Every edge is identified by its
+	 * start vertex and appears only once in the result.
+	 */
+	void query(const Common::Point &a, const Common::Point &b, Common::Array<Vertex *> &edges);
+
+private:
+	void getCells(Vertex *edge, int &column0, int &row0, int &column1, int &row1) const;
+
+	int _left, _top;
+	int _cellSize;
+	int _columns, _rows;
+
+	// The edges of cell i are _cellEdges[_cellStart[i]] up to
+	// _cellEdges[_cellStart[i + 1]]
+	Common::Array<uint> _cellStart;
+	Common::Array<Vertex *> _cellEdges;
+
+	// Last query that returned an edge, by vertex index
+	Common::Array<uint32> _stamps;
+	uint32 _queryStamp;
+};
+
 // Pathfinding state
 struct PathfindingState {
 	// List of all polygons
@@ -235,12 +298,22 @@ struct PathfindingState {
 	// Screen size
 	int _width, _height;
 
+	// Spatial index of the polygon edges
+	EdgeGrid _edgeGrid;
+
+	// Scratch space for edge grid queries
+	Common::Array<Vertex *> _nearbyEdges;
+
+	// Visibility between polygon vertices, shared across calls
+	AvoidPathCache *_cache;
+
 	PathfindingState(int width, int height) : _width(width), _height(height) {
 		vertex_start = NULL;
 		vertex_end = NULL;
 		vertex_index = NULL;
 		_prependPoint = NULL;
 		_appendPoint = NULL;
+		_cache = NULL;
 		vertices = 0;
 	}
 
@@ -614,6 +687,162 @@ static void fix_vertex_order(Polygon *polygon) {
  * Returns   : (int) 1 if the line (p, vertex->v) intersects the interior of
  *                   the polygon, locally at the vertex. 0 otherwise
  */
+static int inside(const Common::Point &p, Vertex *vertex);
+
+void EdgeGrid::getCells(Vertex *edge, int &column0, int &row0, int &column1, int &row1) const {
+	const Common::Point &p = edge->v;
+	const Common::Point &q = CLIST_NEXT(edge)->v;
+
+	column0 = (MIN(p.x, q.x) - _left) / _cellSize;
+	column1 = (MAX(p.x, q.x) - _left) / _cellSize;
+	row0 = (MIN(p.y, q.y) - _top) / _cellSize;
+	row1 = (MAX(p.y, q.y) - _top) / _cellSize;
+}
+
+void EdgeGrid::build(Vertex **vertices, int count) {
+	int right = 0, bottom = 0;
+	int edges = 0;
+
+	_cellStart.clear();
+	_cellEdges.clear();
+	_columns = _rows = 0;
+	_cellSize = EDGE_GRID_CELL_SIZE;
+
+	_stamps.clear();
+	_stamps.resize(count);
+	_queryStamp = 0;
+
+	// Every edge endpoint is the start of another edge, so the start
+	// vertices give the bounds of all edges
+	for (int i = 0; i < count; i++) {
+		Vertex *vertex = vertices[i];
+
+		if (!VERTEX_HAS_EDGES(vertex))
+			continue;
+
+		if (!edges) {
+			_left = right = vertex->v.x;
+			_top = bottom = vertex->v.y;
+		} else {
+			_left = MIN<int>(_left, vertex->v.x);
+			_top = MIN<int>(_top, vertex->v.y);
+			right = MAX<int>(right, vertex->v.x);
+			bottom = MAX<int>(bottom, vertex->v.y);
+		}
+
+		edges++;
+	}
+
+	if (!edges)
+		return;
+
+	while (((right - _left) / _cellSize + 1) * ((bottom - _top) / _cellSize + 1) > EDGE_GRID_MAX_CELLS)
+		_cellSize *= 2;
+
+	_columns = (right - _left) / _cellSize + 1;
+	_rows = (bottom - _top) / _cellSize + 1;
+
+	// Count the edges of each cell first, then fill them in
+	const int cells = _columns * _rows;
+	_cellStart.resize(cells + 1);
+
+	for (int i = 0; i < count; i++) {
+		int column0, row0, column1, row1;
+
+		if (!VERTEX_HAS_EDGES(vertices[i]))
+			continue;
+
+		getCells(vertices[i], column0, row0, column1, row1);
+
+		for (int row = row0; row <= row1; row++)
+			for (int column = column0; column <= column1; column++)
+				_cellStart[row * _columns + column + 1]++;
+	}
+
+	for (int cell = 0; cell < cells; cell++)
+		_cellStart[cell + 1] += _cellStart[cell];
+
+	_cellEdges.resize(_cellStart[cells]);
+	Common::Array<uint> fill(_cellStart);
+
+	for (int i = 0; i < count; i++) {
+		int column0, row0, column1, row1;
+
+		if (!VERTEX_HAS_EDGES(vertices[i]))
+			continue;
+
+		getCells(vertices[i], column0, row0, column1, row1);
+
+		for (int row = row0; row <= row1; row++)
+			for (int column = column0; column <= column1; column++)
+				_cellEdges[fill[row * _columns + column]++] = vertices[i];
+	}
+}
+
+void EdgeGrid::query(const Common::Point &a, const Common::Point &b, Common::Array<Vertex *> &edges) {
+	edges.clear();
+
+	if (!_columns)
+		return;
+
+	if (++_queryStamp == 0) {
+		for (uint i = 0; i < _stamps.size(); i++)
+			_stamps[i] = 0;
+		_queryStamp = 1;
+	}
+
+	const int right = _left + _columns * _cellSize - 1;
+	const int bottom = _top + _rows * _cellSize - 1;
+	const int minX = MIN(a.x, b.x), maxX = MAX(a.x, b.x);
+	const int minY = MIN(a.y, b.y), maxY = MAX(a.y, b.y);
+
+	if (maxY < _top || minY > bottom)
+		return;
+
+	const int row0 = (MAX(minY, _top) - _top) / _cellSize;
+	const int row1 = (MIN(maxY, bottom) - _top) / _cellSize;
+
+	for (int row = row0; row <= row1; row++) {
+		int x0 = minX, x1 = maxX;
+
+		if (a.y != b.y) {
+			// Horizontal extent of the segment within this row. The
+			// row is extended up to the next one, as intersections
+			// with edges may lie in between. Rounding is covered by
+			// adding a pixel on each side.
+			const int rowTop = _top + row * _cellSize;
+			const float slope = (float)(b.x - a.x) / (b.y - a.y);
+			const float fx0 = a.x + (MAX(rowTop, minY) - a.y) * slope;
+			const float fx1 = a.x + (MIN(rowTop + _cellSize, maxY) - a.y) * slope;
+
+			x0 = MAX<int>(x0, (int)floor(MIN(fx0, fx1)) - 1);
+			x1 = MIN<int>(x1, (int)ceil(MAX(fx0, fx1)) + 1);
+		}
+
+		x0 = MAX(x0, _left);
+		x1 = MIN(x1, right);
+
+		if (x0 > x1)
+			continue;
+
+		const int column0 = (x0 - _left) / _cellSize;
+		const int column1 = (x1 - _left) / _cellSize;
+
+		for (int column = column0; column <= column1; column++) {
+			const int cell = row * _columns + column;
+
+			for (uint i = _cellStart[cell]; i < _cellStart[cell + 1]; i++) {
+				Vertex *edge = _cellEdges[i];
+
+				if (_stamps[edge->_index] != _queryStamp) {
+					_stamps[edge->_index] = _queryStamp;
+					edges.push_back(edge);
+				}
+			}
+		}
+	}
+}
+
 static int inside(const Common::Point &p, Vertex *vertex) {
 	// Check that it's not a single-vertex polygon
 	if (VERTEX_HAS_EDGES(vertex)) {
@@ -638,12 +867,67 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 }
 
 /**
- * Returns a list of all vertices that are visible from a particular vertex.
+ * Determines whether an edge blocks the line between two vertices
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @param edge			the start vertex of the edge
+ * @return true if the line (vertex_cur, vertex) is blocked by the edge
+ */
+static bool edge_blocks(Vertex *vertex_cur, Vertex *vertex, Vertex *edge) {
+	if (between(vertex_cur->v, vertex->v, edge->v)) {
+		// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+		// Otherwise this edge won't properly intersect
+		return inside(vertex_cur->v, edge) || inside(vertex->v, edge);
+	}
+
+	return intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v);
+}
+
+/**
+ * Determines whether a vertex is visible from another vertex, testing only
+ * the edges near the line between them
+ * @param s				the pathfinding state
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @return true if the vertices are visible from each other
+ */
+static bool vertex_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// Coincident vertices of different polygons are checked against all
+	// edges, as between() matches a whole line for such a segment
+	if (vertex_cur->v == vertex->v) {
+		for (int j = 0; j < s->vertices; j++) {
+			Vertex *edge = s->vertex_index[j];
+			if (VERTEX_HAS_EDGES(edge) && edge_blocks(vertex_cur, vertex, edge))
+				return false;
+		}
+
+		return true;
+	}
+
+	// Check for intersecting edges
+	s->_edgeGrid.query(vertex_cur->v, vertex->v, s->_nearbyEdges);
+
+	for (uint j = 0; j < s->_nearbyEdges.size(); j++) {
+		if (edge_blocks(vertex_cur, vertex, s->_nearbyEdges[j]))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Returns a list of all vertices that are visible from a particular vertex,
+ * testing every vertex against every edge. This is the reference for the
+ * edge grid and visibility cache used by visible_vertices().
  * @param s				the pathfinding state
  * @param vertex_cur	the vertex
  * @return list of vertices that are visible from vert
  */
-static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
+static VertexList *visible_vertices_reference(PathfindingState *s, Vertex *vertex_cur) {
 	VertexList *visVerts = new VertexList();
 
 	for (int i = 0; i < s->vertices; i++) {
@@ -657,25 +941,69 @@ static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 		int j;
 		for (j = 0; j < s->vertices; j++) {
 			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
+			if (VERTEX_HAS_EDGES(edge) && edge_blocks(vertex_cur, vertex, edge))
+				break;
+		}
 
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		if (j == s->vertices)
+			visVerts->push_front(vertex);
+	}
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
+	return visVerts;
+}
+
+/**
+ * Returns a list of all vertices that are visible from a particular vertex.
+ * @param s				the pathfinding state
+ * @param vertex_cur	the vertex
+ * @return list of vertices that are visible from vert
+ */
+static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
+	VertexList *visVerts = new VertexList();
+	AvoidPathCache *cache = s->_cache;
+	byte *cacheRow = NULL;
+
+	if (cache && vertex_cur->_cacheIndex >= 0)
+		cacheRow = &cache->visibility[vertex_cur->_cacheIndex * cache->vertices];
+
+	for (int i = 0; i < s->vertices; i++) {
+		Vertex *vertex = s->vertex_index[i];
+		bool visible;
+
+		if (cacheRow && vertex->_cacheIndex >= 0) {
+			byte &entry = cacheRow[vertex->_cacheIndex];
+
+			if (entry == VIS_UNKNOWN) {
+				// Visibility is symmetric, so fill in both entries
+				entry = vertex_visible(s, vertex_cur, vertex) ? VIS_VISIBLE : VIS_BLOCKED;
+				cache->visibility[vertex->_cacheIndex * cache->vertices + vertex_cur->_cacheIndex] = entry;
 			}
+
+			visible = (entry == VIS_VISIBLE);
+		} else {
+			visible = vertex_visible(s, vertex_cur, vertex);
 		}
 
-		if (j == s->vertices)
+		if (visible)
 			visVerts->push_front(vertex);
 	}
 
+	if (DebugMan.isDebugChannelEnabled(kDebugLevelAvoidPath)) {
+		// Validate against the brute force approach
+		VertexList *reference = visible_vertices_reference(s, vertex_cur);
+		VertexList::iterator it = visVerts->begin(), refIt = reference->begin();
+
+		while (it != visVerts->end() && refIt != reference->end() && *it == *refIt) {
+			++it;
+			++refIt;
+		}
+
+		if (it != visVerts->end() || refIt != reference->end())
+			warning("AvoidPath: Visible vertices of (%i, %i) differ from the reference", vertex_cur->v.x, vertex_cur->v.y);
+
+		delete reference;
+	}
+
 	return visVerts;
 }
 
@@ -1075,6 +1403,56 @@ static Vertex *merge_point(PathfindingState *s, const Common::Point &v) {
 	return v_new;
 }
 
+/**
+ * Assigns visibility cache positions to the vertices of all polygons with
+ * edges. The cache is cleared when the polygons differ from the ones it was
+ * filled for.
+ * Parameters: (PathfindingState *) s: The pathfinding state
+ *             (AvoidPathCache *) cache: The visibility cache
+ */
+static void setup_visibility_cache(PathfindingState *s, AvoidPathCache *cache) {
+	Common::Array<int16> polygons;
+	uint count = 0;
+
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+		Polygon *polygon = *it;
+		Vertex *vertex;
+
+		if (!VERTEX_HAS_EDGES(polygon->vertices.first()))
+			continue;
+
+		polygons.push_back(polygon->vertices.size());
+
+		CLIST_FOREACH(vertex, &polygon->vertices) {
+			polygons.push_back(vertex->v.x);
+			polygons.push_back(vertex->v.y);
+			vertex->_cacheIndex = count++;
+		}
+	}
+
+	if (count > VISIBILITY_CACHE_MAX_VERTICES) {
+		for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
+			Vertex *vertex;
+
+			CLIST_FOREACH(vertex, &(*it)->vertices) {
+				vertex->_cacheIndex = -1;
+			}
+		}
+
+		return;
+	}
+
+	if (!(polygons == cache->polygons)) {
+		debugC(kDebugLevelAvoidPath, "AvoidPath: Polygons changed, clearing visibility cache");
+		cache->polygons = polygons;
+		cache->vertices = count;
+		cache->visibility.clear();
+		cache->visibility.resize(count * count);
+	}
+
+	s->_cache = cache;
+}
+
 /**
  * Converts an SCI polygon into a Polygon
  * Parameters: (EngineState *) s: The game state
@@ -1254,6 +1632,12 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		}
 	}
 
+	// Set up the visibility cache before the start and end points are
+	// added, as visibility between the polygon vertices doesn't depend on
+	// them. Splitting an edge at one of these points doesn't change it
+	// either.
+	setup_visibility_cache(pf_s, &s->_avoidPathCache);
+
 	// Merge start and end points into polygon set
 	pf_s->vertex_start = merge_point(pf_s, *new_start);
 	pf_s->vertex_end = merge_point(pf_s, *new_end);
@@ -1271,11 +1655,13 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		Vertex *vertex;
 
 		CLIST_FOREACH(vertex, &polygon->vertices) {
+			vertex->_index = count;
 			pf_s->vertex_index[count++] = vertex;
 		}
 	}
 
 	pf_s->vertices = count;
+	pf_s->_edgeGrid.build(pf_s->vertex_index, count);
 
 	return pf_s;
 }
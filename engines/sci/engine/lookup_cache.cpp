@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "sci/engine/lookup_cache.h"
+
+namespace Sci {
+
+SelectorLookupCache::SelectorLookupCache() {
+	clearSites();
+	resetStats();
+}
+
+SelectorLookupCache::~SelectorLookupCache() {
+}
+
+const SelectorLookupCache::Entry *SelectorLookupCache::findInTable(reg_t site, reg_t base, Selector selector) {
+	TableMap::iterator table = _tables.find(base);
+	if (table == _tables.end())
+		return 0;
+
+	SelectorTable::const_iterator entry = table->_value.find(selector);
+	if (entry == table->_value.end())
+		return 0;
+
+	_stats.tableHits++;
+
+	if (site.isNull())
+		return &entry->_value;
+
+	// Let the send use this object from now on
+	SiteEntry &siteEntry = _sites[getSiteIndex(site, selector)];
+	siteEntry.site = site;
+	siteEntry.base = base;
+	siteEntry.selector = selector;
+	siteEntry.entry = entry->_value;
+	return &siteEntry.entry;
+}
+
+void SelectorLookupCache::insert(reg_t site, reg_t base, Selector selector, const Entry &entry) {
+	_stats.misses++;
+	_tables[base][selector] = entry;
+
+	if (!site.isNull()) {
+		SiteEntry &siteEntry = _sites[getSiteIndex(site, selector)];
+		siteEntry.site = site;
+		siteEntry.base = base;
+		siteEntry.selector = selector;
+		siteEntry.entry = entry;
+	}
+}
+
+void SelectorLookupCache::invalidate() {
+	if (_tables.empty())
+		return;
+
+	_tables.clear();
+	clearSites();
+	_stats.invalidations++;
+}
+
+void SelectorLookupCache::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
+void SelectorLookupCache::clearSites() {
+	// A null site never matches, as find() only looks at the inline cache
+	// for actual sends
+	for (uint i = 0; i < kSiteCount; i++) {
+		_sites[i].site = NULL_REG;
+		_sites[i].base = NULL_REG;
+		_sites[i].selector = NULL_SELECTOR;
+	}
+}
+
+} // End of namespace Sci
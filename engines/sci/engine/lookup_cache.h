@@ -0,0 +1,132 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef SCI_ENGINE_LOOKUP_CACHE_H
+#define SCI_ENGINE_LOOKUP_CACHE_H
+
+#include "common/hashmap.h"
+
+#include "sci/engine/vm.h"
+#include "sci/engine/vm_types.h"
+
+namespace Sci {
+
+/** Statistics of the selector lookup cache, see the selector_cache console command. */
+struct SelectorLookupStats {
+	uint32 siteHits;      ///< Lookups answered by the inline cache of the send
+	uint32 tableHits;     ///< Lookups answered by the selector table of the object
+	uint32 misses;        ///< Lookups which had to search the class chain
+	uint32 invalidations; ///< Number of times the caches were flushed
+};
+
+/**
+ * Caches the results of lookupSelector().
+ *
+ * Looking up a selector searches the variable selectors of the object's
+ * class and then the method selectors of the object and all its
+ * superclasses, which happens for every selector of every send. The result
+ * only depends on the object's base object in its script (clones share the
+ * base object of their parent) and the selector, so it is kept in a table
+ * for each base object, which is filled as selectors are looked up.
+ *
+ * In front of the tables, sends from the VM go through a small direct
+ * mapped inline cache, indexed by the address of the send and the
+ * selector. Most sends always go to objects with the same base object, so
+ * these are answered without any hashing.
+ *
+ * Method addresses point into the scripts defining them, so everything is
+ * thrown away as soon as any script is unloaded.
+ */
+class SelectorLookupCache {
+public:
+	/** The result of a lookup. */
+	struct Entry {
+		SelectorType type;
+		uint16 varIndex; ///< The index of the variable, for kSelectorVariable
+		reg_t func;      ///< The address of the method, for kSelectorMethod
+	};
+
+	SelectorLookupCache();
+	~SelectorLookupCache();
+
+	/**
+	 * Find a cached lookup.
+	 * @param site		The address of the send, or NULL_REG if the lookup
+	 * 					does not come from a send of the VM
+	 * @param base		The position of the base object of the object
+	 * @param selector	The selector to look up
+	 * @return the entry, or 0 if the selector was not looked up yet
+	 */
+	const Entry *find(reg_t site, reg_t base, Selector selector) {
+		if (!site.isNull()) {
+			const SiteEntry &siteEntry = _sites[getSiteIndex(site, selector)];
+			if (siteEntry.site == site && siteEntry.base == base && siteEntry.selector == selector) {
+				_stats.siteHits++;
+				return &siteEntry.entry;
+			}
+		}
+
+		return findInTable(site, base, selector);
+	}
+
+	/** Add the result of a lookup which was not found in the cache. */
+	void insert(reg_t site, reg_t base, Selector selector, const Entry &entry);
+
+	/** Throw away all cached lookups. */
+	void invalidate();
+
+	const SelectorLookupStats &getStats() const { return _stats; }
+	void resetStats();
+
+	/** Number of base objects with a selector table. */
+	uint getTableCount() const { return _tables.size(); }
+
+private:
+	enum {
+		kSiteCount = 1024 ///< Number of inline cache entries, must be a power of 2
+	};
+
+	struct SiteEntry {
+		reg_t site;
+		reg_t base;
+		Selector selector;
+		Entry entry;
+	};
+
+	typedef Common::HashMap<Selector, Entry> SelectorTable;
+	typedef Common::HashMap<reg_t, SelectorTable, reg_t_Hash> TableMap;
+
+	static uint getSiteIndex(reg_t site, Selector selector) {
+		return (site.offset ^ (site.segment << 7) ^ (selector << 3)) & (kSiteCount - 1);
+	}
+
+	const Entry *findInTable(reg_t site, reg_t base, Selector selector);
+	void clearSites();
+
+	SiteEntry _sites[kSiteCount];
+	TableMap _tables;
+	SelectorLookupStats _stats;
+};
+
+} // End of namespace Sci
+
+#endif // SCI_ENGINE_LOOKUP_CACHE_H
@@ -61,6 +61,29 @@ void Script::freeScript() {
 	_bufSize = 0;
 
 	_objects.clear();
+	clearPredecoded();
+}
+
+void Script::clearPredecoded() {
+	_instructionIndex.clear();
+	_instructions.clear();
+}
+
+const PredecodedInstruction &Script::decodeInstruction(uint16 offset) {
+	PredecodedInstruction instruction;
+	instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.opparams);
+
+	// The indices have to fit into 16 bits. There can't be more instructions
+	// than bytes in the buffer, unless code was changed and decoded again.
+	if (_instructions.size() >= 0xFFFF)
+		clearPredecoded();
+
+	if (_instructionIndex.empty())
+		_instructionIndex.resize(_bufSize);
+
+	_instructions.push_back(instruction);
+	_instructionIndex[offset] = _instructions.size();
+	return _instructions.back();
 }
 
 void Script::init(int script_nr, ResourceManager *resMan) {
@@ -139,6 +162,7 @@ void Script::load(ResourceManager *resMan) {
 
 	_buf = (byte *)malloc(_bufSize);
 	assert(_buf);
+	clearPredecoded();
 
 	assert(_bufSize >= script->size);
 	memcpy(_buf, script->data, script->size);
@@ -48,6 +48,13 @@ enum ScriptObjectTypes {
 
 typedef Common::HashMap<uint16, Object> ObjMap;
 
+/** An instruction of a script, as decoded by readPMachineInstruction(). */
+struct PredecodedInstruction {
+	int16 opparams[4];
+	uint16 size;    ///< Length of the instruction in bytes
+	byte extOpcode;
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -74,6 +81,16 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	/**
+	 * For every offset in the script buffer, the index of the instruction
+	 * decoded there plus 1, or 0 if no instruction was decoded there yet.
+	 * Only allocated once the script's code gets executed.
+	 */
+	Common::Array<uint16> _instructionIndex;
+	Common::Array<PredecodedInstruction> _instructions;
+
+	const PredecodedInstruction &decodeInstruction(uint16 offset);
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -119,6 +136,32 @@ public:
 
 	virtual void saveLoadWithSerializer(Common::Serializer &ser);
 
+	/**
+	 * Get the decoded instruction at the given offset. Every instruction
+	 * is only decoded the first time it is executed, so that the VM does
+	 * not need to parse the operands again each time.
+	 * @param offset	The offset of the instruction, which has to be
+	 * 					within the script buffer
+	 * @return			The instruction, which stays valid until the next
+	 * 					instruction of this script is decoded
+	 */
+	const PredecodedInstruction &getInstruction(uint16 offset) {
+		if (offset < _instructionIndex.size() && _instructionIndex[offset]) {
+			const PredecodedInstruction &instruction = _instructions[_instructionIndex[offset] - 1];
+			// Make sure the code has not been changed in the meantime
+			if (instruction.extOpcode == _buf[offset])
+				return instruction;
+		}
+
+		return decodeInstruction(offset);
+	}
+
+	/** Number of instructions which have been decoded so far. */
+	uint getPredecodedCount() const { return _instructions.size(); }
+
+	/** Forget all decoded instructions. */
+	void clearPredecoded();
+
 	Object *getObject(uint16 offset);
 	const Object *getObject(uint16 offset) const;
 
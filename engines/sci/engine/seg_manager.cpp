@@ -22,6 +22,7 @@
 
 #include "sci/sci.h"
 #include "sci/engine/seg_manager.h"
+#include "sci/engine/gc.h"
 #include "sci/engine/state.h"
 #include "sci/engine/script.h"
 
@@ -43,6 +44,9 @@ SegManager::SegManager(ResourceManager *resMan) {
 
 	_resMan = resMan;
 
+	_gcWorklist = NULL;
+	memset(&_gcStats, 0, sizeof(_gcStats));
+
 	createClassTable();
 }
 
@@ -51,6 +55,9 @@ SegManager::~SegManager() {
 }
 
 void SegManager::resetSegMan() {
+	// The marked references of a running collection are meaningless now
+	abortGC();
+
 	// Free memory
 	for (uint i = 0; i < _heap.size(); i++) {
 		if (_heap[i])
@@ -151,6 +158,8 @@ void SegManager::deallocate(SegmentId seg) {
 	if (mobj->getType() == SEG_TYPE_SCRIPT) {
 		Script *scr = (Script *)mobj;
 		_scriptSegMap.erase(scr->getScriptNumber());
+		// Cached lookups might refer to the script's objects and methods
+		_lookupCache.invalidate();
 		if (scr->getLocalsSegment())
 			deallocate(scr->getLocalsSegment());
 	}
@@ -159,6 +168,27 @@ void SegManager::deallocate(SegmentId seg) {
 	_heap[seg] = NULL;
 }
 
+void SegManager::shade(reg_t value) {
+	_gcWorklist->push(value);
+}
+
+void SegManager::shadeNew(reg_t addr) {
+	// Objects allocated while marking survive the collection. The address
+	// may have been marked already, if it belonged to an object which got
+	// freed in the meantime, so the new object is always scanned.
+	_gcWorklist->_map.setVal(addr, true);
+	_gcWorklist->_worklist.push_back(addr);
+}
+
+void SegManager::abortGC() {
+	if (!_gcWorklist)
+		return;
+
+	delete _gcWorklist;
+	_gcWorklist = NULL;
+	_gcStats.aborted++;
+}
+
 bool SegManager::isHeapObject(reg_t pos) const {
 	const Object *obj = getObject(pos);
 	if (obj == NULL || (obj && obj->isFreed()))
@@ -394,6 +424,9 @@ reg_t SegManager::allocateHunkEntry(const char *hunk_type, int size) {
 	h->size = size;
 	h->type = hunk_type;
 
+	if (_gcWorklist)
+		shadeNew(addr);
+
 	return addr;
 }
 
@@ -420,6 +453,8 @@ Clone *SegManager::allocateClone(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_clonesSegId, offset);
+	if (_gcWorklist)
+		shadeNew(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -434,6 +469,8 @@ List *SegManager::allocateList(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_listsSegId, offset);
+	if (_gcWorklist)
+		shadeNew(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -448,6 +485,8 @@ Node *SegManager::allocateNode(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_nodesSegId, offset);
+	if (_gcWorklist)
+		shadeNew(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -825,6 +864,9 @@ byte *SegManager::allocDynmem(int size, const char *descr, reg_t *addr) {
 
 	d._description = descr;
 
+	if (_gcWorklist)
+		shadeNew(*addr);
+
 	return (byte *)(d._buf);
 }
 
@@ -850,6 +892,8 @@ SciArray<reg_t> *SegManager::allocateArray(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_arraysSegId, offset);
+	if (_gcWorklist)
+		shadeNew(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -890,6 +934,8 @@ SciString *SegManager::allocateString(reg_t *addr) {
 	offset = table->allocEntry();
 
 	*addr = make_reg(_stringSegId, offset);
+	if (_gcWorklist)
+		shadeNew(*addr);
 	return &(table->_table[offset]);
 }
 
@@ -972,6 +1018,7 @@ int SegManager::instantiateScript(int scriptNum) {
 			return segmentId;
 		} else {
 			scr->freeScript();
+			_lookupCache.invalidate();
 		}
 	} else {
 		scr = allocateScript(scriptNum, &segmentId);
@@ -983,6 +1030,14 @@ int SegManager::instantiateScript(int scriptNum) {
 	scr->initializeClasses(this);
 	scr->initializeObjects(this, segmentId);
 
+	// The objects and locals of the script have been written without the
+	// write barrier
+	if (_gcWorklist) {
+		const Common::Array<reg_t> objects = scr->listObjectReferences();
+		for (uint i = 0; i < objects.size(); i++)
+			shadeNew(objects[i]);
+	}
+
 	return segmentId;
 }
 
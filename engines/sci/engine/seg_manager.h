@@ -25,6 +25,7 @@
 
 #include "common/scummsys.h"
 #include "common/serializer.h"
+#include "sci/engine/lookup_cache.h"
 #include "sci/engine/script.h"
 #include "sci/engine/vm.h"
 #include "sci/engine/vm_types.h"
@@ -42,6 +43,20 @@ enum ScriptLoadType {
 };
 
 class Script;
+struct WorklistManager;
+
+/** Statistics of the garbage collector, see the gc_stats console command. */
+struct GCStats {
+	uint32 collections;  ///< Number of finished collections
+	uint32 steps;        ///< Number of marking steps of incremental collections
+	uint32 aborted;      ///< Incremental collections thrown away because the heap was reset
+	uint32 freed;        ///< Number of objects freed by all collections
+	uint32 lastFreed;    ///< Number of objects freed by the last collection
+	uint32 lastMarked;   ///< Number of references marked by the last collection
+	uint32 lastPause;    ///< Duration of the last collection (without its marking steps), in ms
+	uint32 maxPause;     ///< Longest duration of a collection, in ms
+	uint32 totalPause;   ///< Total duration of all collections, in ms
+};
 
 class SegManager : public Common::Serializable {
 	friend class Console;
@@ -441,6 +456,35 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/** The cache of lookupSelector(), which is flushed whenever a script is unloaded. */
+	SelectorLookupCache &getLookupCache() { return _lookupCache; }
+
+	// 10. Incremental garbage collection
+
+	/**
+	 * The write barrier of the incremental garbage collector, which has to be
+	 * called with every reference that is stored into a heap object (object
+	 * properties, locals, list nodes, arrays...). While a collection is
+	 * marking, the referenced object is shaded gray, so that storing a
+	 * reference to an object which has not been reached yet into an object
+	 * which has already been scanned does not hide it from the collector.
+	 * Registers and the stacks are scanned again when the collection is
+	 * finished, so stores to them do not need the barrier.
+	 */
+	void writeBarrier(reg_t value) {
+		if (_gcWorklist && value.segment)
+			shade(value);
+	}
+
+	/** Returns true while an incremental collection is marking. */
+	bool isGCInProgress() const { return _gcWorklist != NULL; }
+
+	/** The gray objects and the marked references of the incremental collection, or NULL. */
+	WorklistManager *getGCWorklist() { return _gcWorklist; }
+	void setGCWorklist(WorklistManager *worklist) { _gcWorklist = worklist; }
+
+	GCStats &getGCStats() { return _gcStats; }
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -449,6 +493,11 @@ private:
 
 	ResourceManager *_resMan;
 
+	SelectorLookupCache _lookupCache;
+
+	WorklistManager *_gcWorklist;
+	GCStats _gcStats;
+
 	SegmentId _clonesSegId; ///< ID of the (a) clones segment
 	SegmentId _listsSegId; ///< ID of the (a) list segment
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
@@ -468,6 +517,9 @@ public:
 
 private:
 	void deallocate(SegmentId seg);
+	void shade(reg_t value);
+	void shadeNew(reg_t addr);
+	void abortGC();
 	void createClassTable();
 
 	SegmentId findFreeSegment() const;
@@ -210,8 +210,10 @@ void writeSelector(SegManager *segMan, reg_t object, Selector selectorId, reg_t
 	if (lookupSelector(segMan, object, selectorId, &address, NULL) != kSelectorVariable)
 		error("Selector '%s' of object at %04x:%04x could not be"
 		         " written to", g_sci->getKernel()->getSelectorName(selectorId).c_str(), PRINT_REG(object));
-	else
+	else {
 		*address.getPointer(segMan) = value;
+		segMan->writeBarrier(value);
+	}
 }
 
 void invokeSelector(EngineState *s, reg_t object, int selectorId,
@@ -249,9 +251,39 @@ void invokeSelector(EngineState *s, reg_t object, int selectorId,
 	run_vm(s); // Start a new vm
 }
 
-SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr) {
+/** Search the object and its class chain for the selector. */
+static SelectorLookupCache::Entry resolveSelector(SegManager *segMan, const Object *obj, Selector selectorId) {
+	SelectorLookupCache::Entry entry;
+	entry.type = kSelectorNone;
+	entry.varIndex = 0;
+	entry.func = NULL_REG;
+
+	int index = obj->locateVarSelector(segMan, selectorId);
+
+	if (index >= 0) {
+		// Found it as a variable
+		entry.type = kSelectorVariable;
+		entry.varIndex = index;
+		return entry;
+	}
+
+	// Check if it's a method, with recursive lookup in superclasses
+	while (obj) {
+		index = obj->funcSelectorPosition(selectorId);
+		if (index >= 0) {
+			entry.type = kSelectorMethod;
+			entry.func = obj->getFunction(index);
+			return entry;
+		}
+
+		obj = segMan->getObject(obj->getSuperClassSelector());
+	}
+
+	return entry;
+}
+
+SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr, reg_t site) {
 	const Object *obj = segMan->getObject(obj_location);
-	int index;
 	bool oldScriptHeader = (getSciVersion() == SCI_VERSION_0_EARLY);
 
 	// Early SCI versions used the LSB in the selector ID as a read/write
@@ -264,34 +296,26 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				PRINT_REG(obj_location));
 	}
 
-	index = obj->locateVarSelector(segMan, selectorId);
-
-	if (index >= 0) {
-		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
-		}
-		return kSelectorVariable;
-	} else {
-		// Check if it's a method, with recursive lookup in superclasses
-		while (obj) {
-			index = obj->funcSelectorPosition(selectorId);
-			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
-
-				return kSelectorMethod;
-			} else {
-				obj = segMan->getObject(obj->getSuperClassSelector());
-			}
-		}
+	// Clones share the selectors of the object they were cloned from, so
+	// the lookup is cached for the position of the base object
+	SelectorLookupCache &cache = segMan->getLookupCache();
+	const SelectorLookupCache::Entry *entry = cache.find(site, obj->getPos(), selectorId);
+	SelectorLookupCache::Entry resolved;
 
-		return kSelectorNone;
+	if (!entry) {
+		resolved = resolveSelector(segMan, obj, selectorId);
+		cache.insert(site, obj->getPos(), selectorId, resolved);
+		entry = &resolved;
 	}
 
+	if (entry->type == kSelectorVariable && varp) {
+		varp->obj = obj_location;
+		varp->varindex = entry->varIndex;
+	} else if (entry->type == kSelectorMethod && fptr) {
+		*fptr = entry->func;
+	}
 
-//	return _lookupSelector_function(segMan, obj, selectorId, fptr);
+	return entry->type;
 }
 
 } // End of namespace Sci
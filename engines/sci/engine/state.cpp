@@ -84,6 +84,8 @@ void EngineState::reset(bool isRestoring) {
 		_fileHandles.resize(5);
 
 		abortScriptProcessing = kAbortNone;
+
+		incrementalGC = false;
 	}
 
 	executionStackBase = 0;
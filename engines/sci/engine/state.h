@@ -131,6 +131,19 @@ struct VideoState {
 	}
 };
 
+/**
+ * Visibility between the polygon vertices of the last kAvoidPath call. It
+ * only depends on the polygons, so it is reused for as long as the game
+ * keeps passing the same ones (e.g. while actors walk around in a room).
+ */
+struct AvoidPathCache {
+	Common::Array<int16> polygons; ///< Size and points of each polygon with edges
+	Common::Array<byte> visibility; ///< Per vertex pair: 0 = unknown, 1 = blocked, 2 = visible
+	uint vertices;
+
+	AvoidPathCache() : vertices(0) {}
+};
+
 struct EngineState : public Common::Serializable {
 public:
 	EngineState(SegManager *segMan);
@@ -200,6 +213,7 @@ public:
 
 	int scriptStepCounter; // Counts the number of steps executed
 	int scriptGCInterval; // Number of steps in between gcs
+	bool incrementalGC; // Spread the marking of gcs over the following kernel calls
 
 	uint16 currentRoomNumber() const;
 	void setRoomNumber(uint16 roomNumber);
@@ -228,6 +242,7 @@ public:
 	byte _memorySegment[kMemorySegmentMax];
 
 	VideoState _videoState;
+	AvoidPathCache _avoidPathCache;
 	bool _syncedAudioOptions;
 
 	/**
@@ -187,6 +187,7 @@ static void write_var(EngineState *s, int type, int index, reg_t value) {
 				if (lookupSelector(s->_segMan, stopGroopPos, SELECTOR(client), &varp, NULL) == kSelectorVariable) {
 					reg_t *clientVar = varp.getPointer(s->_segMan);
 					*clientVar = value;
+					s->_segMan->writeBarrier(value);
 				}
 			}
 		}
@@ -200,6 +201,11 @@ static void write_var(EngineState *s, int type, int index, reg_t value) {
 
 		s->variables[type][index] = value;
 
+		// Globals and locals live in the heap, only temps and parameters
+		// live on the stack
+		if (type == VAR_GLOBAL || type == VAR_LOCAL)
+			s->_segMan->writeBarrier(value);
+
 		// If the game is trying to change its speech/subtitle settings, apply the ScummVM audio
 		// options first, if they haven't been applied yet
 		if (type == VAR_GLOBAL && index == 90 && !g_sci->getEngineState()->_syncedAudioOptions) {
@@ -265,6 +271,7 @@ static void _exec_varselectors(EngineState *s) {
 			// varselector access?
 			if (xs.argc) { // write?
 				*var = xs.variables_argp[1];
+				s->_segMan->writeBarrier(*var);
 
 			} else // No, read
 				s->r_acc = *var;
@@ -276,7 +283,7 @@ static void _exec_varselectors(EngineState *s) {
 // from scriptdebug.cpp
 extern void debugSelectorCall(reg_t send_obj, Selector selector, int argc, StackPtr argp, ObjVarRef &varp, reg_t funcp, SegManager *segMan, SelectorType selectorType);
 
-ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj, StackPtr sp, int framesize, StackPtr argp) {
+ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj, StackPtr sp, int framesize, StackPtr argp, reg_t site) {
 	// send_obj and work_obj are equal for anything but 'super'
 	// Returns a pointer to the TOS exec_stack element
 	assert(s);
@@ -298,7 +305,7 @@ ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj, StackPt
 		if (argc > 0x800)	// More arguments than the stack could possibly accomodate for
 			error("send_selector(): More than 0x800 arguments to function call");
 
-		SelectorType selectorType = lookupSelector(s->_segMan, send_obj, selector, &varp, &funcp);
+		SelectorType selectorType = lookupSelector(s->_segMan, send_obj, selector, &varp, &funcp, site);
 		if (selectorType == kSelectorNone)
 			error("Send to invalid selector 0x%x of object at %04x:%04x", 0xffff & selector, PRINT_REG(send_obj));
 
@@ -570,6 +577,8 @@ void run_vm(EngineState *s) {
 
 	s->_executionStackPosChanged = true; // Force initialization
 
+	Console *con = g_sci->getSciDebugger();
+
 #ifdef ABORT_ON_INFINITE_LOOP
 	byte prevOpcode = 0xFF;
 #endif
@@ -609,14 +618,17 @@ void run_vm(EngineState *s) {
 		if (s->abortScriptProcessing != kAbortNone)
 			return; // Stop processing
 
-		// Debug if this has been requested:
-		// TODO: re-implement sci_debug_flags
-		if (g_sci->_debugState.debugging /* sci_debug_flags*/) {
-			g_sci->scriptDebug();
-			g_sci->_debugState.breakpointWasHit = false;
+		// Debugger hooks, only checked with a single test unless the
+		// debugger is actually in use
+		if (g_sci->_debugState.debugging || con->isAttached()) {
+			// Debug if this has been requested:
+			// TODO: re-implement sci_debug_flags
+			if (g_sci->_debugState.debugging /* sci_debug_flags*/) {
+				g_sci->scriptDebug();
+				g_sci->_debugState.breakpointWasHit = false;
+			}
+			con->onFrame();
 		}
-		Console *con = g_sci->getSciDebugger();
-		con->onFrame();
 
 		if (s->xs->sp < s->xs->fp)
 			error("run_vm(): stack underflow, sp: %04x:%04x, fp: %04x:%04x",
@@ -630,8 +642,20 @@ void run_vm(EngineState *s) {
 
 		// Get opcode
 		byte extOpcode;
-		s->xs->addr.pc.offset += readPMachineInstruction(scr->getBuf() + s->xs->addr.pc.offset, extOpcode, opparams);
+		if (g_debug_predecode_scripts) {
+			// The parameters are copied, as the instruction might go away if
+			// the script gets executed recursively, e.g. by a kernel call
+			const PredecodedInstruction &instruction = scr->getInstruction(s->xs->addr.pc.offset);
+			extOpcode = instruction.extOpcode;
+			memcpy(opparams, instruction.opparams, sizeof(opparams));
+			s->xs->addr.pc.offset += instruction.size;
+		} else {
+			s->xs->addr.pc.offset += readPMachineInstruction(scr->getBuf() + s->xs->addr.pc.offset, extOpcode, opparams);
+		}
 		const byte opcode = extOpcode >> 1;
+
+		if (g_sci->_debugState.profiling)
+			g_sci->_debugState.opcodeCounts[opcode]++;
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
 #ifdef ABORT_ON_INFINITE_LOOP
@@ -852,10 +876,17 @@ void run_vm(EngineState *s) {
 		}
 
 		case op_callk: { // 0x21 (33)
-			// Run the garbage collector, if needed
-			if (s->gcCountDown-- <= 0) {
+			// Run the garbage collector, if needed. Once an incremental
+			// collection has been started, it does some work on every
+			// kernel call until it is finished.
+			if (s->_segMan->isGCInProgress()) {
+				run_gc_step(s);
+			} else if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
-				run_gc(s);
+				if (s->incrementalGC)
+					run_gc_step(s);
+				else
+					run_gc(s);
 			}
 
 			// Call kernel function
@@ -936,9 +967,10 @@ void run_vm(EngineState *s) {
 				if (old_xs->type == EXEC_STACK_TYPE_VARSELECTOR) {
 					// varselector access?
 					reg_t *var = old_xs->getVarPointer(s->_segMan);
-					if (old_xs->argc) // write?
+					if (old_xs->argc) { // write?
 						*var = old_xs->variables_argp[1];
-					else // No, read
+						s->_segMan->writeBarrier(*var);
+					} else // No, read
 						s->r_acc = *var;
 				}
 
@@ -967,7 +999,8 @@ void run_vm(EngineState *s) {
 
 			s->xs->sp[1].offset += s->r_rest;
 			xs_new = send_selector(s, s->r_acc, s->r_acc, s_temp,
-									(int)(opparams[0] >> 1) + (uint16)s->r_rest, s->xs->sp);
+									(int)(opparams[0] >> 1) + (uint16)s->r_rest, s->xs->sp,
+									s->xs->addr.pc);
 
 			if (xs_new && xs_new != s->xs)
 				s->_executionStackPosChanged = true;
@@ -1011,7 +1044,7 @@ void run_vm(EngineState *s) {
 			s->xs->sp[1].offset += s->r_rest;
 			xs_new = send_selector(s, s->xs->objp, s->xs->objp,
 									s_temp, (int)(opparams[0] >> 1) + (uint16)s->r_rest,
-									s->xs->sp);
+									s->xs->sp, s->xs->addr.pc);
 
 			if (xs_new && xs_new != s->xs)
 				s->_executionStackPosChanged = true;
@@ -1032,7 +1065,7 @@ void run_vm(EngineState *s) {
 				s->xs->sp[1].offset += s->r_rest;
 				xs_new = send_selector(s, r_temp, s->xs->objp, s_temp,
 										(int)(opparams[1] >> 1) + (uint16)s->r_rest,
-										s->xs->sp);
+										s->xs->sp, s->xs->addr.pc);
 
 				if (xs_new && xs_new != s->xs)
 					s->_executionStackPosChanged = true;
@@ -1094,6 +1127,7 @@ void run_vm(EngineState *s) {
 		case op_aTop: // 0x32 (50)
 			// Accumulator To Property
 			validate_property(s, obj, opparams[0]) = s->r_acc;
+			s->_segMan->writeBarrier(s->r_acc);
 			break;
 
 		case op_pTos: // 0x33 (51)
@@ -1103,7 +1137,9 @@ void run_vm(EngineState *s) {
 
 		case op_sTop: // 0x34 (52)
 			// Stack To Property
-			validate_property(s, obj, opparams[0]) = POP32();
+			r_temp = POP32();
+			validate_property(s, obj, opparams[0]) = r_temp;
+			s->_segMan->writeBarrier(r_temp);
 			break;
 
 		case op_ipToa: // 0x35 (53)
@@ -1118,6 +1154,7 @@ void run_vm(EngineState *s) {
 				opProperty += 1;
 			else
 				opProperty -= 1;
+			s->_segMan->writeBarrier(opProperty);
 
 			if (opcode == op_ipToa || opcode == op_dpToa)
 				s->r_acc = opProperty;
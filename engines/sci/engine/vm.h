@@ -303,10 +303,12 @@ ExecStack *execute_method(EngineState *s, uint16 script, uint16 pubfunct,
  * 						[selector_number][argument_counter] and then
  * 						"argument_counter" word entries with the
  * 						parameter values.
+ * @param[in] site		Address of the send instruction, to look the
+ * 						selectors up in its inline cache, or NULL_REG
  * @return				A pointer to the new execution stack TOS entry
  */
 ExecStack *send_selector(EngineState *s, reg_t send_obj, reg_t work_obj,
-	StackPtr sp, int framesize, StackPtr argp);
+	StackPtr sp, int framesize, StackPtr argp, reg_t site = NULL_REG);
 
 
 /**
@@ -336,6 +338,10 @@ void script_debug(EngineState *s);
  * 							fptr is written to iff it is non-NULL and the
  * 							selector indicates a member function of that
  * 							object.
+ * @param[in] site			Address of the send doing the lookup, which
+ * 							is used as key of the inline cache, or
+ * 							NULL_REG for lookups which are not part of a
+ * 							send of the VM
  * @return					kSelectorNone if the selector was not found in
  * 							the object or its superclasses.
  * 							kSelectorVariable if the selector represents an
@@ -344,7 +350,7 @@ void script_debug(EngineState *s);
  * 							method
  */
 SelectorType lookupSelector(SegManager *segMan, reg_t obj, Selector selectorid,
-		ObjVarRef *varp, reg_t *fptr);
+		ObjVarRef *varp, reg_t *fptr, reg_t site = NULL_REG);
 
 /**
  * Read a PMachine instruction from a memory buffer and return its length.
@@ -146,6 +146,12 @@ static inline reg_t make_reg(SegmentId segment, uint16 offset) {
 	return r;
 }
 
+struct reg_t_Hash {
+	uint operator()(const reg_t& x) const {
+		return (x.segment << 3) ^ x.offset ^ (x.offset << 16);
+	}
+};
+
 #define PRINT_REG(r) (0xffff) & (unsigned) (r).segment, (unsigned) (r).offset
 
 // Stack pointer type
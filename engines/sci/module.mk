@@ -26,6 +26,7 @@ MODULE_OBJS := \
 	engine/ksound.o \
 	engine/kstring.o \
 	engine/kvideo.o \
+	engine/lookup_cache.o \
 	engine/message.o \
 	engine/object.o \
 	engine/savegame.o \
@@ -22,9 +22,11 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 
 #include "sci/resource.h"
@@ -190,6 +192,8 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_fileOffset = 0;
 	_status = kResStatusNoMalloc;
 	_lockers = 0;
+	_lruPrev = NULL;
+	_lruNext = NULL;
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
@@ -891,7 +895,10 @@ ResourceManager::ResourceManager() {
 void ResourceManager::init(bool initFromFallbackDetector) {
 	_memoryLocked = 0;
 	_memoryLRU = 0;
-	_LRU.clear();
+	_maxMemoryLRU = kMaxMemory;
+	_lruFirst = NULL;
+	_lruLast = NULL;
+	_stats.reset();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
 
@@ -943,6 +950,15 @@ void ResourceManager::init(bool initFromFallbackDetector) {
 
 	debugC(1, kDebugLevelResMan, "resMan: Detected %s", getSciVersionDesc(getSciVersion()));
 
+	// The memory budget can be set per game (or per platform, through the
+	// global settings of a port), in KB
+	if (getSciVersion() >= SCI_VERSION_2)
+		_maxMemoryLRU = kMaxMemorySci32;
+	if (!initFromFallbackDetector && ConfMan.hasKey("sci_resource_cache_size") && ConfMan.getInt("sci_resource_cache_size") > 0)
+		_maxMemoryLRU = ConfMan.getInt("sci_resource_cache_size") * 1024;
+
+	debugC(1, kDebugLevelResMan, "resMan: Keeping up to %d KB of unlocked resources", _maxMemoryLRU / 1024);
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -994,7 +1010,19 @@ void ResourceManager::removeFromLRU(Resource *res) {
 		warning("resMan: trying to remove resource that isn't enqueued");
 		return;
 	}
-	_LRU.remove(res);
+
+	if (res->_lruPrev)
+		res->_lruPrev->_lruNext = res->_lruNext;
+	else
+		_lruFirst = res->_lruNext;
+
+	if (res->_lruNext)
+		res->_lruNext->_lruPrev = res->_lruPrev;
+	else
+		_lruLast = res->_lruPrev;
+
+	res->_lruPrev = NULL;
+	res->_lruNext = NULL;
 	_memoryLRU -= res->size;
 	res->_status = kResStatusAllocated;
 }
@@ -1004,7 +1032,15 @@ void ResourceManager::addToLRU(Resource *res) {
 		warning("resMan: trying to enqueue resource with state %d", res->_status);
 		return;
 	}
-	_LRU.push_front(res);
+
+	res->_lruPrev = NULL;
+	res->_lruNext = _lruFirst;
+	if (_lruFirst)
+		_lruFirst->_lruPrev = res;
+	else
+		_lruLast = res;
+	_lruFirst = res;
+
 	_memoryLRU += res->size;
 #if SCI_VERBOSE_RESMAN
 	debug("Adding %s.%03d (%d bytes) to lru control: %d bytes total",
@@ -1017,26 +1053,24 @@ void ResourceManager::addToLRU(Resource *res) {
 void ResourceManager::printLRU() {
 	int mem = 0;
 	int entries = 0;
-	Common::List<Resource *>::iterator it = _LRU.begin();
-	Resource *res;
 
-	while (it != _LRU.end()) {
-		res = *it;
+	for (Resource *res = _lruFirst; res; res = res->_lruNext) {
 		debug("\t%s: %d bytes", res->_id.toString().c_str(), res->size);
 		mem += res->size;
 		++entries;
-		++it;
 	}
 
 	debug("Total: %d entries, %d bytes (mgr says %d)", entries, mem, _memoryLRU);
 }
 
 void ResourceManager::freeOldResources() {
-	while (MAX_MEMORY < _memoryLRU) {
-		assert(!_LRU.empty());
-		Resource *goner = *_LRU.reverse_begin();
+	while (_maxMemoryLRU < _memoryLRU) {
+		assert(_lruLast);
+		Resource *goner = _lruLast;
 		removeFromLRU(goner);
 		goner->unalloc();
+		_stats.evictions++;
+		_stats.evictedBytes += goner->size;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s.%03d (%d bytes)", getResourceTypeName(goner->type), goner->number, goner->size);
 #endif
@@ -1062,10 +1096,16 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
+	if (retval->_status == kResStatusNoMalloc) {
+		const uint32 loadStart = g_system->getMillis();
 		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
-		removeFromLRU(retval);
+		_stats.loadTime += g_system->getMillis() - loadStart;
+		_stats.misses++;
+	} else {
+		if (retval->_status == kResStatusEnqueued)
+			removeFromLRU(retval);
+		_stats.hits++;
+	}
 	// Unless an error occurred, the resource is now either
 	// locked or allocated, but never queued or freed.
 
@@ -1853,6 +1893,10 @@ Resource *ResourceManager::updateResource(ResourceId resId, ResourceSource *src,
 
 	if (_resMap.contains(resId)) {
 		res = _resMap.getVal(resId);
+
+		// The resource is reset to its unloaded state below
+		if (res->_status == kResStatusEnqueued)
+			removeFromLRU(res);
 	} else {
 		res = new Resource(this, resId);
 		_resMap.setVal(resId, res);
@@ -54,6 +54,26 @@ enum ResourceStatus {
 	kResStatusLocked /**< Allocated and in use */
 };
 
+/**
+ * Statistics of the resource cache, shown by the resource_stats console
+ * command.
+ */
+struct ResourceStats {
+	uint32 hits;		///< Lookups of resources which were still loaded
+	uint32 misses;		///< Lookups which had to load the resource
+	uint32 evictions;	///< Resources freed to stay within the memory budget
+	uint32 evictedBytes;	///< Total size of the freed resources
+	uint32 loadTime;	///< Time spent reading and decompressing resources, in ms
+
+	ResourceStats() { reset(); }
+
+	void reset() {
+		hits = misses = 0;
+		evictions = evictedBytes = 0;
+		loadTime = 0;
+	}
+};
+
 /** Initialization result types */
 enum {
 	SCI_ERROR_IO_ERROR = 1,
@@ -240,6 +260,8 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	Resource *_lruPrev; /**< Next more recently used resource in the LRU queue */
+	Resource *_lruNext; /**< Next less recently used resource in the LRU queue */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -378,20 +400,34 @@ public:
 	 */
 	ResourceType convertResType(byte type);
 
+	/**
+	 * Returns the statistics of the resource cache.
+	 */
+	const ResourceStats &getStats() const { return _stats; }
+	void resetStats() { _stats.reset(); }
+
+	int getMaxMemory() const { return _maxMemoryLRU; }
+	int getLRUMemory() const { return _memoryLRU; }
+	int getLockedMemory() const { return _memoryLocked; }
+
 protected:
-	// Maximum number of bytes to allow being allocated for resources
-	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
-	// for resources which are not explicitly locked. However, a warning will be
-	// issued whenever this limit is exceeded.
+	// Default number of bytes to allow being allocated for resources. The
+	// budget can be overridden with the sci_resource_cache_size setting.
+	// Note: it will not be interpreted as a hard limit, only as a restriction
+	// for resources which are not explicitly locked.
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+		kMaxMemory = 256 * 1024,		// 256KB, like the original interpreters
+		kMaxMemorySci32 = 8 * 1024 * 1024	// 8MB, SCI32 resources are a lot bigger
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _maxMemoryLRU;	///< Maximum amount of resource bytes under LRU control
+	Resource *_lruFirst;	///< Most recently used resource in the LRU queue
+	Resource *_lruLast;	///< Least recently used resource in the LRU queue
+	ResourceStats _stats;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -346,6 +346,7 @@ void AkosRenderer::setCostume(int costume, int shadow) {
 	akcd = _vm->findResourceData(MKTAG('A','K','C','D'), akos);
 	akpl = _vm->findResourceData(MKTAG('A','K','P','L'), akos);
 	_codec = READ_LE_UINT16(&akhd->codec);
+	setCostumeData(costume, akos);
 	akct = _vm->findResourceData(MKTAG('A','K','C','T'), akos);
 	rgbs = _vm->findResourceData(MKTAG('R','G','B','S'), akos);
 
@@ -539,12 +540,40 @@ byte AkosRenderer::drawLimb(const Actor *a, int limb) {
 	return result;
 }
 
+inline void AkosRenderer::codec1_drawPixel(byte *dst, uint16 color) {
+	uint16 pcolor = _palette[color];
+
+	if (_shadow_mode == 1) {
+		if (pcolor == 13)
+			pcolor = _shadow_table[*dst];
+	} else if (_shadow_mode == 2) {
+		error("codec1_spec2"); // TODO
+	} else if (_shadow_mode == 3) {
+		if (_vm->_game.features & GF_16BIT_COLOR) {
+			uint16 srcColor = (pcolor >> 1) & 0x7DEF;
+			uint16 dstColor = (READ_UINT16(dst) >> 1) & 0x7DEF;
+			pcolor = srcColor + dstColor;
+		} else if (_vm->_game.heversion >= 90) {
+			pcolor = (pcolor << 8) + *dst;
+			pcolor = xmap[pcolor];
+		} else if (pcolor < 8) {
+			pcolor = (pcolor << 8) + *dst;
+			pcolor = _shadow_table[pcolor];
+		}
+	}
+	if (_vm->_bytesPerPixel == 2) {
+		WRITE_UINT16(dst, pcolor);
+	} else {
+		*dst = pcolor;
+	}
+}
+
 void AkosRenderer::codec1_genericDecode(Codec1 &v1) {
 	const byte *mask, *src;
 	byte *dst;
 	byte len, maskbit;
 	int y;
-	uint16 color, height, pcolor;
+	uint16 color, height;
 	const byte *scaleytab;
 	bool masked;
 	bool skip_column = false;
@@ -580,32 +609,8 @@ void AkosRenderer::codec1_genericDecode(Codec1 &v1) {
 				} else {
 					masked = (y < v1.boundsRect.top || y >= v1.boundsRect.bottom) || (v1.x < 0 || v1.x >= v1.boundsRect.right) || (*mask & maskbit);
 
-					if (color && !masked && !skip_column) {
-						pcolor = _palette[color];
-						if (_shadow_mode == 1) {
-							if (pcolor == 13)
-								pcolor = _shadow_table[*dst];
-						} else if (_shadow_mode == 2) {
-							error("codec1_spec2"); // TODO
-						} else if (_shadow_mode == 3) {
-							if (_vm->_game.features & GF_16BIT_COLOR) {
-								uint16 srcColor = (pcolor >> 1) & 0x7DEF;
-								uint16 dstColor = (READ_UINT16(dst) >> 1) & 0x7DEF;
-								pcolor = srcColor + dstColor;
-							} else if (_vm->_game.heversion >= 90) {
-								pcolor = (pcolor << 8) + *dst;
-								pcolor = xmap[pcolor];
-							} else if (pcolor < 8) {
-								pcolor = (pcolor << 8) + *dst;
-								pcolor = _shadow_table[pcolor];
-							}
-						}
-						if (_vm->_bytesPerPixel == 2) {
-							WRITE_UINT16(dst, pcolor);
-						} else {
-							*dst = pcolor;
-						}
-					}
+					if (color && !masked && !skip_column)
+						codec1_drawPixel(dst, color);
 				}
 				dst += _out.pitch;
 				mask += _numStrips;
@@ -637,6 +642,75 @@ void AkosRenderer::codec1_genericDecode(Codec1 &v1) {
 	} while (1);
 }
 
+// Draws a cel from the limb cache, starting at the given column, exactly
+// like codec1_genericDecode() does. Unscaled cels only visit their
+// non-transparent pixels.
+void AkosRenderer::codec1_cachedDecode(Codec1 &v1, const DecodedLimb &limb, int column) {
+	const byte *mask, *src, *scaleytab;
+	byte *dst;
+	byte maskbit;
+	int y, row;
+	bool skip_column = false;
+
+	// Rows inside of the bounds, for the unscaled case
+	const int firstRow = MAX(0, v1.boundsRect.top - v1.y);
+	const int lastRow = MIN(limb.height, v1.boundsRect.bottom - v1.y);
+
+	maskbit = revBitMask(v1.x & 7);
+
+	for (; column < limb.width; column++) {
+		src = limb.getColumn(column);
+		dst = v1.destptr;
+		mask = _vm->getMaskBuffer(v1.x - (_vm->_virtscr[kMainVirtScreen].xstart & 7), v1.y, _zbuf);
+
+		if (_actorHitMode || _scaleY != 255) {
+			y = v1.y;
+			scaleytab = &v1.scaletable[v1.scaleYindex];
+
+			for (row = 0; row < limb.height; row++) {
+				if (_scaleY == 255 || *scaleytab++ < _scaleY) {
+					if (_actorHitMode) {
+						if (src[row] && y == _actorHitY && v1.x == _actorHitX) {
+							_actorHitResult = true;
+							return;
+						}
+					} else if (src[row] && !skip_column && y >= v1.boundsRect.top && y < v1.boundsRect.bottom &&
+								v1.x >= 0 && v1.x < v1.boundsRect.right && !(*mask & maskbit)) {
+						codec1_drawPixel(dst, src[row]);
+					}
+					dst += _out.pitch;
+					mask += _numStrips;
+					y++;
+				}
+			}
+		} else if (!skip_column && v1.x >= 0 && v1.x < v1.boundsRect.right) {
+			for (const DecodedLimb::Span *span = limb.getSpans(column); span != limb.getSpansEnd(column); span++) {
+				const int start = MAX<int>(span->start, firstRow);
+				const int end = MIN<int>(span->start + span->length, lastRow);
+
+				for (row = start; row < end; row++) {
+					if (!(mask[row * _numStrips] & maskbit))
+						codec1_drawPixel(dst + row * _out.pitch, src[row]);
+				}
+			}
+		}
+
+		if (!--v1.skip_width)
+			return;
+
+		if (_scaleX == 255 || v1.scaletable[v1.scaleXindex] < _scaleX) {
+			v1.x += v1.scaleXstep;
+			if (v1.x < 0 || v1.x >= v1.boundsRect.right)
+				return;
+			maskbit = revBitMask(v1.x & 7);
+			v1.destptr += v1.scaleXstep * _vm->_bytesPerPixel;
+			skip_column = false;
+		} else
+			skip_column = true;
+		v1.scaleXindex += v1.scaleXstep;
+	}
+}
+
 // This is exact duplicate of smallCostumeScaleTable[] in costume.cpp
 // See FIXME below for explanation
 const byte smallCostumeScaleTableAKOS[256] = {
@@ -941,13 +1015,19 @@ byte AkosRenderer::codec1(int xmoveCur, int ymoveCur) {
 
 	v1.replen = 0;
 
+	const DecodedLimb *limb = lookupLimb(v1);
+	int firstColumn = 0;
+
 	if (_mirror) {
 		if (!use_scaling)
 			skip = v1.boundsRect.left - v1.x;
 
 		if (skip > 0) {
 			v1.skip_width -= skip;
-			codec1_ignorePakCols(v1, skip);
+			if (limb)
+				firstColumn = skip;
+			else
+				codec1_ignorePakCols(v1, skip);
 			v1.x = v1.boundsRect.left;
 		} else {
 			skip = rect.right - v1.boundsRect.right;
@@ -962,7 +1042,10 @@ byte AkosRenderer::codec1(int xmoveCur, int ymoveCur) {
 			skip = rect.right - v1.boundsRect.right + 1;
 		if (skip > 0) {
 			v1.skip_width -= skip;
-			codec1_ignorePakCols(v1, skip)	;
+			if (limb)
+				firstColumn = skip;
+			else
+				codec1_ignorePakCols(v1, skip);
 			v1.x = v1.boundsRect.right - 1;
 		} else {
 			skip = (v1.boundsRect.left -1) - rect.left;
@@ -996,7 +1079,10 @@ byte AkosRenderer::codec1(int xmoveCur, int ymoveCur) {
 
 	v1.destptr = (byte *)_out.pixels + v1.y * _out.pitch + v1.x * _vm->_bytesPerPixel;
 
-	codec1_genericDecode(v1);
+	if (limb)
+		codec1_cachedDecode(v1, *limb, firstColumn);
+	else
+		codec1_genericDecode(v1);
 
 	return drawFlag;
 }
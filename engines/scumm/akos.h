@@ -113,6 +113,8 @@ protected:
 
 	byte codec1(int xmoveCur, int ymoveCur);
 	void codec1_genericDecode(Codec1 &v1);
+	void codec1_cachedDecode(Codec1 &v1, const DecodedLimb &limb, int column);
+	void codec1_drawPixel(byte *dst, uint16 color);
 	byte codec5(int xmoveCur, int ymoveCur);
 	byte codec16(int xmoveCur, int ymoveCur);
 	byte codec32(int xmoveCur, int ymoveCur);
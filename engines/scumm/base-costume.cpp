@@ -23,6 +23,7 @@
 
 #include "scumm/base-costume.h"
 #include "scumm/costume.h"
+#include "scumm/resource.h"
 
 namespace Scumm {
 
@@ -74,6 +75,194 @@ void BaseCostumeRenderer::codec1_ignorePakCols(Codec1 &v1, int num) {
 	} while (1);
 }
 
+void BaseCostumeRenderer::setCostumeData(int costume, const byte *data) {
+	_costume = costume;
+	_costumeData = data;
+	_costumeSize = data ? _vm->_res->_types[rtCostume][costume]._size : 0;
+}
+
+CostumeLimbCache::CostumeLimbCache() : _head(0), _tail(0), _size(0), _maxSize(kDefaultMaxSize) {
+	resetStats();
+}
+
+CostumeLimbCache::~CostumeLimbCache() {
+	clear();
+}
+
+const DecodedLimb *CostumeLimbCache::lookup(int costume, const byte *data, uint32 dataSize, const byte *src, int width, int height, byte shr, byte mask) {
+	if (!_maxSize || !data || src < data || src >= data + dataSize || width <= 0 || height <= 0)
+		return 0;
+
+	// Huge limbs would push everything else out of the cache
+	if ((uint32)(width * height) > _maxSize / 4)
+		return 0;
+
+	DecodedLimb::Key key;
+	key.costume = costume;
+	key.offset = src - data;
+	key.shr = shr;
+
+	LimbMap::iterator i = _limbs.find(key);
+	if (i != _limbs.end()) {
+		DecodedLimb *limb = i->_value;
+		if (limb->width == width && limb->height == height) {
+			_stats.hits++;
+			if (limb != _head) {
+				unlinkLimb(limb);
+				link(limb);
+			}
+			return limb;
+		}
+		remove(limb);
+	}
+
+	_stats.misses++;
+
+	DecodedLimb *limb = decode(src, data + dataSize, width, height, shr, mask);
+	if (!limb) {
+		_stats.failures++;
+		return 0;
+	}
+
+	limb->_key = key;
+	_limbs[key] = limb;
+	link(limb);
+	_size += limb->size;
+
+	while (_size > _maxSize && _tail != limb) {
+		remove(_tail);
+		_stats.evictions++;
+	}
+
+	return limb;
+}
+
+DecodedLimb *CostumeLimbCache::decode(const byte *src, const byte *end, int width, int height, byte shr, byte mask) {
+	const uint32 count = width * height;
+	byte *pixels = new byte[count];
+	uint32 pos = 0;
+
+	// Same decoding as codec1_ignorePakCols() and the codec 1 decoders, but
+	// checking that the data stays inside the costume resource
+	while (pos < count) {
+		if (src >= end) {
+			delete[] pixels;
+			return 0;
+		}
+
+		byte len = *src++;
+		const byte color = len >> shr;
+		len &= mask;
+		if (!len) {
+			if (src >= end) {
+				delete[] pixels;
+				return 0;
+			}
+			len = *src++;
+		}
+
+		// The decoders count the length down before checking it, so a
+		// length of 0 is a run of 256 pixels
+		uint32 run = len ? len : 256;
+		if (run > count - pos)
+			run = count - pos;
+		memset(pixels + pos, color, run);
+		pos += run;
+	}
+
+	uint32 numSpans = 0;
+	for (int x = 0; x < width; x++) {
+		const byte *column = pixels + x * height;
+		for (int y = 0; y < height; y++) {
+			if (column[y] && (y == 0 || !column[y - 1]))
+				numSpans++;
+		}
+	}
+
+	DecodedLimb *limb = new DecodedLimb;
+	limb->width = width;
+	limb->height = height;
+	limb->pixels = pixels;
+	limb->spans = new DecodedLimb::Span[numSpans ? numSpans : 1];
+	limb->columns = new uint32[width + 1];
+	limb->size = sizeof(DecodedLimb) + count + numSpans * sizeof(DecodedLimb::Span) + (width + 1) * sizeof(uint32);
+	limb->_prev = limb->_next = 0;
+
+	DecodedLimb::Span *span = limb->spans;
+	for (int x = 0; x < width; x++) {
+		const byte *column = pixels + x * height;
+		limb->columns[x] = span - limb->spans;
+
+		int y = 0;
+		while (y < height) {
+			if (!column[y]) {
+				y++;
+				continue;
+			}
+
+			span->start = y;
+			while (y < height && column[y])
+				y++;
+			span->length = y - span->start;
+			span++;
+		}
+	}
+	limb->columns[width] = span - limb->spans;
+
+	return limb;
+}
+
+void CostumeLimbCache::link(DecodedLimb *limb) {
+	limb->_prev = 0;
+	limb->_next = _head;
+	if (_head)
+		_head->_prev = limb;
+	else
+		_tail = limb;
+	_head = limb;
+}
+
+void CostumeLimbCache::unlinkLimb(DecodedLimb *limb) {
+	if (limb->_prev)
+		limb->_prev->_next = limb->_next;
+	else
+		_head = limb->_next;
+
+	if (limb->_next)
+		limb->_next->_prev = limb->_prev;
+	else
+		_tail = limb->_prev;
+}
+
+void CostumeLimbCache::remove(DecodedLimb *limb) {
+	unlinkLimb(limb);
+	_limbs.erase(limb->_key);
+	_size -= limb->size;
+
+	delete[] limb->pixels;
+	delete[] limb->spans;
+	delete[] limb->columns;
+	delete limb;
+}
+
+void CostumeLimbCache::clear() {
+	while (_head)
+		remove(_head);
+}
+
+void CostumeLimbCache::setMaxSize(uint32 maxSize) {
+	_maxSize = maxSize;
+
+	while (_tail && _size > _maxSize) {
+		remove(_tail);
+		_stats.evictions++;
+	}
+}
+
+void CostumeLimbCache::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+}
+
 bool ScummEngine::isCostumeInUse(int cost) const {
 	int i;
 	Actor *a;
@@ -24,6 +24,7 @@
 #define SCUMM_BASE_COSTUME_H
 
 #include "common/scummsys.h"
+#include "common/hashmap.h"
 #include "scumm/actor.h"		// for CostumeData
 
 namespace Scumm {
@@ -63,6 +64,117 @@ public:
 };
 
 
+/**
+ * A costume limb, decoded from the run length encoded data of the classic
+ * costumes and of AKOS codec 1.
+ */
+struct DecodedLimb {
+	/** A run of non-transparent pixels in a column. */
+	struct Span {
+		uint16 start, length;
+	};
+
+	int width, height;
+	byte *pixels;		///< Color indices, one column after the other
+	Span *spans;		///< Spans of all columns, top to bottom
+	uint32 *columns;	///< Index of the first span of each column, plus the end of the last one
+	uint32 size;		///< Memory used by the limb
+
+	const byte *getColumn(int column) const { return pixels + column * height; }
+	const Span *getSpans(int column) const { return spans + columns[column]; }
+	const Span *getSpansEnd(int column) const { return spans + columns[column + 1]; }
+
+private:
+	friend class CostumeLimbCache;
+
+	struct Key {
+		int costume;
+		uint32 offset;	///< Offset of the limb data in the costume resource
+		byte shr;
+
+		bool operator==(const Key &k) const { return costume == k.costume && offset == k.offset && shr == k.shr; }
+	};
+
+	struct Key_Hash {
+		uint operator()(const Key &k) const { return (k.offset * 31) ^ (k.costume << 3) ^ k.shr; }
+	};
+
+	Key _key;
+	DecodedLimb *_prev, *_next;
+};
+
+/** Statistics of the limb cache, see the limbcache debugger command. */
+struct CostumeLimbCacheStats {
+	uint32 hits;
+	uint32 misses;
+	uint32 evictions;
+	uint32 failures;	///< Limbs whose data runs past the end of the costume
+};
+
+/**
+ * Keeps the decoded limbs of the most recently drawn costume frames.
+ *
+ * Actors redraw the same few frames over and over, and decoding the run
+ * length encoded data is most of the work of drawing them. The limbs are
+ * kept as color indices, so the palette, shadow, scale and mirroring of
+ * the actor are applied when drawing them, and one entry serves every
+ * actor using the costume. The spans of each column let unscaled limbs
+ * skip their transparent pixels.
+ *
+ * Costume resources are never modified, so a limb is identified by its
+ * costume and its offset in the costume resource. The least recently used
+ * limbs are thrown away when the cache grows larger than its maximum size.
+ */
+class CostumeLimbCache {
+public:
+	enum {
+		kDefaultMaxSize = 1024 * 1024
+	};
+
+	CostumeLimbCache();
+	~CostumeLimbCache();
+
+	/**
+	 * Find a limb, decoding it if it is not in the cache yet.
+	 * @param costume	the costume the limb belongs to
+	 * @param data		the costume resource
+	 * @param dataSize	the size of the costume resource
+	 * @param src		the encoded data of the limb
+	 * @param width		the width of the limb
+	 * @param height	the height of the limb
+	 * @param shr		the shift giving the color of a run
+	 * @param mask		the mask giving the length of a run
+	 * @return the limb, or 0 if it cannot be cached
+	 */
+	const DecodedLimb *lookup(int costume, const byte *data, uint32 dataSize, const byte *src, int width, int height, byte shr, byte mask);
+
+	/** Throw away all limbs. */
+	void clear();
+
+	/** Set the maximum memory used by the limbs, 0 disables the cache. */
+	void setMaxSize(uint32 maxSize);
+	uint32 getMaxSize() const { return _maxSize; }
+	uint32 getSize() const { return _size; }
+	uint getLimbCount() const { return _limbs.size(); }
+
+	const CostumeLimbCacheStats &getStats() const { return _stats; }
+	void resetStats();
+
+private:
+	typedef Common::HashMap<DecodedLimb::Key, DecodedLimb *, DecodedLimb::Key_Hash> LimbMap;
+
+	DecodedLimb *decode(const byte *src, const byte *end, int width, int height, byte shr, byte mask);
+	void link(DecodedLimb *limb);
+	void unlinkLimb(DecodedLimb *limb);
+	void remove(DecodedLimb *limb);
+
+	LimbMap _limbs;
+	DecodedLimb *_head, *_tail;	///< Most and least recently used limb
+	uint32 _size, _maxSize;
+	CostumeLimbCacheStats _stats;
+};
+
+
 /**
  * Base class for both ClassicCostumeRenderer and AkosRenderer.
  */
@@ -105,6 +217,13 @@ protected:
 	// width and height of cel to decode
 	int _width, _height;
 
+	// costume resource the cels are decoded from
+	int _costume;
+	const byte *_costumeData;
+	uint32 _costumeSize;
+
+	CostumeLimbCache _limbCache;
+
 public:
 	struct Codec1 {
 		// Parameters for the original ("V1") costume codec.
@@ -139,6 +258,9 @@ public:
 		_xmove = _ymove = 0;
 		_mirror = false;
 		_width = _height = 0;
+		_costume = -1;
+		_costumeData = 0;
+		_costumeSize = 0;
 		_skipLimbs = 0;
 		_paletteNum = 0;
 	}
@@ -151,10 +273,20 @@ public:
 
 	byte drawCostume(const VirtScreen &vs, int numStrips, const Actor *a, bool drawToBackBuf);
 
+	CostumeLimbCache &getLimbCache() { return _limbCache; }
+
 protected:
 	virtual byte drawLimb(const Actor *a, int limb) = 0;
 
 	void codec1_ignorePakCols(Codec1 &v1, int num);
+
+	/** Remember the costume resource, for looking up its limbs in the limb cache. */
+	void setCostumeData(int costume, const byte *data);
+
+	/** Find the cel at _srcptr in the limb cache, or return 0 if it cannot be cached. */
+	const DecodedLimb *lookupLimb(const Codec1 &v1) {
+		return _limbCache.lookup(_costume, _costumeData, _costumeSize, _srcptr, _width, _height, v1.shr, v1.mask);
+	}
 };
 
 } // End of namespace Scumm
@@ -89,6 +89,8 @@ byte ClassicCostumeRenderer::mainRoutine(int xmoveCur, int ymoveCur) {
 	Common::Rect rect;
 	int step;
 	Codec1 v1;
+	const DecodedLimb *limb = 0;
+	int firstColumn = 0;
 
 	const int scaletableSize = 128;
 	const bool newAmiCost = (_vm->_game.version == 5) && (_vm->_game.platform == Common::kPlatformAmiga);
@@ -238,13 +240,22 @@ byte ClassicCostumeRenderer::mainRoutine(int xmoveCur, int ymoveCur) {
 
 	v1.replen = 0;
 
+#ifndef USE_ARM_COSTUME_ASM
+	// The ARM version of proc3() does its own decoding
+	if (!newAmiCost && !pcEngCost && _loaded._format != 0x57)
+		limb = lookupLimb(v1);
+#endif
+
 	if (_mirror) {
 		if (!use_scaling)
 			skip = -v1.x;
 		if (skip > 0) {
 			if (!newAmiCost && !pcEngCost && _loaded._format != 0x57) {
 				v1.skip_width -= skip;
-				codec1_ignorePakCols(v1, skip);
+				if (limb)
+					firstColumn = skip;
+				else
+					codec1_ignorePakCols(v1, skip);
 				v1.x = 0;
 			}
 		} else {
@@ -261,7 +272,10 @@ byte ClassicCostumeRenderer::mainRoutine(int xmoveCur, int ymoveCur) {
 		if (skip > 0) {
 			if (!newAmiCost && !pcEngCost && _loaded._format != 0x57) {
 				v1.skip_width -= skip;
-				codec1_ignorePakCols(v1, skip);
+				if (limb)
+					firstColumn = skip;
+				else
+					codec1_ignorePakCols(v1, skip);
 				v1.x = _out.w - 1;
 			}
 		} else {
@@ -313,6 +327,8 @@ byte ClassicCostumeRenderer::mainRoutine(int xmoveCur, int ymoveCur) {
 		proc3_ami(v1);
 	else if (pcEngCost)
 		procPCEngine(v1);
+	else if (limb)
+		proc3_cached(v1, *limb, firstColumn);
 	else
 		proc3(v1);
 
@@ -434,12 +450,25 @@ extern "C" int ClassicProc3RendererShadowARM(int _scaleY,
                                         int _scaleIndexY);
 #endif
 
+inline byte ClassicCostumeRenderer::proc3_color(uint color, byte dst) {
+	uint pcolor;
+
+	if (_shadow_mode & 0x20) {
+		pcolor = _shadow_table[dst];
+	} else {
+		pcolor = _palette[color];
+		if (pcolor == 13 && _shadow_table)
+			pcolor = _shadow_table[dst];
+	}
+	return pcolor;
+}
+
 void ClassicCostumeRenderer::proc3(Codec1 &v1) {
 	const byte *mask, *src;
 	byte *dst;
 	byte len, maskbit;
 	int y;
-	uint color, height, pcolor;
+	uint color, height;
 	byte scaleIndexY;
 	bool masked;
 
@@ -488,16 +517,8 @@ void ClassicCostumeRenderer::proc3(Codec1 &v1) {
 			if (_scaleY == 255 || v1.scaletable[scaleIndexY++] < _scaleY) {
 				masked = (y < 0 || y >= _out.h) || (v1.x < 0 || v1.x >= _out.w) || (v1.mask_ptr && (mask[0] & maskbit));
 
-				if (color && !masked) {
-					if (_shadow_mode & 0x20) {
-						pcolor = _shadow_table[*dst];
-					} else {
-						pcolor = _palette[color];
-						if (pcolor == 13 && _shadow_table)
-							pcolor = _shadow_table[*dst];
-					}
-					*dst = pcolor;
-				}
+				if (color && !masked)
+					*dst = proc3_color(color, *dst);
 				dst += _out.pitch;
 				mask += _numStrips;
 				y++;
@@ -526,6 +547,69 @@ void ClassicCostumeRenderer::proc3(Codec1 &v1) {
 	} while (1);
 }
 
+// Draws a cel from the limb cache, starting at the given column, exactly
+// like proc3() does. Unscaled cels only visit their non-transparent pixels.
+void ClassicCostumeRenderer::proc3_cached(Codec1 &v1, const DecodedLimb &limb, int column) {
+	const byte *mask, *src;
+	byte *dst;
+	byte maskbit;
+	int y, row;
+	byte scaleIndexY;
+
+	// Rows outside of the screen, for the unscaled case
+	const int firstRow = MAX(0, -v1.y);
+	const int lastRow = MIN(limb.height, _out.h - v1.y);
+
+	maskbit = revBitMask(v1.x & 7);
+
+	for (; column < limb.width; column++) {
+		src = limb.getColumn(column);
+		dst = v1.destptr;
+		mask = v1.mask_ptr + v1.x / 8;
+
+		if (v1.x >= 0 && v1.x < _out.w) {
+			if (_scaleY == 255) {
+				for (const DecodedLimb::Span *span = limb.getSpans(column); span != limb.getSpansEnd(column); span++) {
+					const int start = MAX<int>(span->start, firstRow);
+					const int end = MIN<int>(span->start + span->length, lastRow);
+
+					for (row = start; row < end; row++) {
+						if (v1.mask_ptr && (mask[row * _numStrips] & maskbit))
+							continue;
+						byte *pixel = dst + row * _out.pitch;
+						*pixel = proc3_color(src[row], *pixel);
+					}
+				}
+			} else {
+				y = v1.y;
+				scaleIndexY = _scaleIndexY;
+
+				for (row = 0; row < limb.height; row++) {
+					if (v1.scaletable[scaleIndexY++] < _scaleY) {
+						if (src[row] && y >= 0 && y < _out.h && !(v1.mask_ptr && (mask[0] & maskbit)))
+							*dst = proc3_color(src[row], *dst);
+						dst += _out.pitch;
+						mask += _numStrips;
+						y++;
+					}
+				}
+			}
+		}
+
+		if (!--v1.skip_width)
+			return;
+
+		if (_scaleX == 255 || v1.scaletable[_scaleIndexX] < _scaleX) {
+			v1.x += v1.scaleXstep;
+			if (v1.x < 0 || v1.x >= _out.w)
+				return;
+			maskbit = revBitMask(v1.x & 7);
+			v1.destptr += v1.scaleXstep;
+		}
+		_scaleIndexX += v1.scaleXstep;
+	}
+}
+
 void ClassicCostumeRenderer::proc3_ami(Codec1 &v1) {
 	const byte *mask, *src;
 	byte *dst;
@@ -1059,6 +1143,7 @@ void ClassicCostumeRenderer::setFacing(const Actor *a) {
 
 void ClassicCostumeRenderer::setCostume(int costume, int shadow) {
 	_loaded.loadCostume(costume);
+	setCostumeData(costume, _vm->getResourceAddress(rtCostume, costume));
 }
 
 byte ClassicCostumeLoader::increaseAnims(Actor *a) {
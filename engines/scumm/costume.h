@@ -102,7 +102,9 @@ protected:
 	byte drawLimb(const Actor *a, int limb);
 
 	void proc3(Codec1 &v1);
+	void proc3_cached(Codec1 &v1, const DecodedLimb &limb, int column);
 	void proc3_ami(Codec1 &v1);
+	byte proc3_color(uint color, byte dst);
 
 	void procC64(Codec1 &v1, int actor);
 
@@ -27,6 +27,7 @@
 #include "common/util.h"
 
 #include "scumm/actor.h"
+#include "scumm/base-costume.h"
 #include "scumm/boxes.h"
 #include "scumm/debugger.h"
 #include "scumm/imuse/imuse.h"
@@ -37,6 +38,8 @@
 
 namespace Scumm {
 
+extern const char *nameOfResType(ResType type);
+
 void debugC(int channel, const char *s, ...) {
 	char buf[STRINGBUFLEN];
 	va_list va;
@@ -79,6 +82,8 @@ ScummDebugger::ScummDebugger(ScummEngine *s)
 	DCmd_Register("scr",       WRAP_METHOD(ScummDebugger, Cmd_Script));
 	DCmd_Register("scripts",   WRAP_METHOD(ScummDebugger, Cmd_PrintScript));
 	DCmd_Register("importres", WRAP_METHOD(ScummDebugger, Cmd_ImportRes));
+	DCmd_Register("resources", WRAP_METHOD(ScummDebugger, Cmd_Resources));
+	DCmd_Register("limbcache", WRAP_METHOD(ScummDebugger, Cmd_LimbCache));
 
 	if (_vm->_game.id == GID_LOOM)
 		DCmd_Register("drafts",  WRAP_METHOD(ScummDebugger, Cmd_PrintDraft));
@@ -311,6 +316,82 @@ bool ScummDebugger::Cmd_ImportRes(int argc, const char** argv) {
 	return true;
 }
 
+bool ScummDebugger::Cmd_Resources(int argc, const char **argv) {
+	ResourceManager *res = _vm->_res;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		res->resetResourceStats();
+		DebugPrintf("Resource statistics have been reset\n");
+		return true;
+	}
+
+	if (argc == 4 && !strcmp(argv[1], "budget")) {
+		for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
+			if (!scumm_stricmp(argv[2], nameOfResType(type))) {
+				res->setHeapBudget(type, atoi(argv[3]) * 1024);
+				return true;
+			}
+		}
+		DebugPrintf("Unknown resource type '%s'\n", argv[2]);
+		return true;
+	}
+
+	if (argc != 1) {
+		DebugPrintf("Syntax: resources [reset | budget <restype> <KB>]\n");
+		return true;
+	}
+
+	DebugPrintf("+-----------------------------------------------------------------+\n");
+	DebugPrintf("|     Type    |  Size KB | Budget KB |  Loads | Evicted | Reloads |\n");
+	DebugPrintf("+-------------+----------+-----------+--------+---------+---------+\n");
+	for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
+		const ResourceManager::ResTypeData &resType = res->_types[type];
+		if (!resType.getLoads() && !resType.getAllocatedSize())
+			continue;
+
+		DebugPrintf("| %11s | %8d | %9d | %6d | %7d | %7d |\n", nameOfResType(type),
+			resType.getAllocatedSize() / 1024, resType.getBudget() / 1024,
+			resType.getLoads(), resType.getEvictions(), resType.getReloads());
+	}
+	DebugPrintf("+-----------------------------------------------------------------+\n");
+
+	return true;
+}
+
+bool ScummDebugger::Cmd_LimbCache(int argc, const char **argv) {
+	CostumeLimbCache &cache = _vm->_costumeRenderer->getLimbCache();
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		cache.resetStats();
+		DebugPrintf("Limb cache statistics have been reset\n");
+		return true;
+	}
+
+	if (argc == 2 && !strcmp(argv[1], "clear")) {
+		cache.clear();
+		return true;
+	}
+
+	if (argc == 3 && !strcmp(argv[1], "size")) {
+		cache.setMaxSize(atoi(argv[2]) * 1024);
+		return true;
+	}
+
+	if (argc != 1) {
+		DebugPrintf("Syntax: limbcache [reset | clear | size <KB>]\n");
+		return true;
+	}
+
+	const CostumeLimbCacheStats &stats = cache.getStats();
+	const uint32 lookups = stats.hits + stats.misses;
+
+	DebugPrintf("Limbs: %d (%d KB of %d KB)\n", cache.getLimbCount(), cache.getSize() / 1024, cache.getMaxSize() / 1024);
+	DebugPrintf("Hits: %d, misses: %d (%d%% hits)\n", stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0);
+	DebugPrintf("Evictions: %d, undecodable limbs: %d\n", stats.evictions, stats.failures);
+
+	return true;
+}
+
 bool ScummDebugger::Cmd_PrintScript(int argc, const char **argv) {
 	int i;
 	ScriptSlot *ss = _vm->vm.slot;
@@ -47,7 +47,9 @@ enum {
 	RF_USAGE = 0x7F,
 	RF_USAGE_MAX = RF_USAGE,
 
+	RS_LISTED = 0x01,
 	RS_MODIFIED = 0x10,
+	RS_EXPIRED = 0x20,
 	RF_OFFHEAP = 0x40
 };
 
@@ -543,6 +545,10 @@ void ResourceManager::allocResTypeData(ResType type, uint32 tag, int num, ResTyp
 	_types[type].clear();
 	_types[type].resize(num);
 
+	_allocatedSize -= _types[type]._allocatedSize;
+	_types[type]._allocatedSize = 0;
+	_types[type]._lruHead = _types[type]._lruTail = RES_INVALID_ID;
+
 /*
 	TODO: Use multiple Resource subclasses, one for each res mode; then,
 	given them serializability.
@@ -777,28 +783,97 @@ void ResourceManager::increaseExpireCounter() {
 }
 
 void ResourceManager::increaseResourceCounters() {
-	for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
-		ResId idx = _types[type].size();
-		while (idx-- > 0) {
-			byte counter = _types[type][idx].getResourceCounter();
-			if (counter && counter < RF_USAGE_MAX) {
-				setResourceCounter(type, idx, counter + 1);
-			}
-		}
-	}
+	// The counters are relative to the usage epoch, so this ages all
+	// resources at once, without changing the order of the LRU lists
+	++_usageEpoch;
 }
 
 void ResourceManager::setResourceCounter(ResType type, ResId idx, byte counter) {
-	_types[type][idx].setResourceCounter(counter);
+	Resource &res = _types[type][idx];
+	const uint32 lastUsed = _usageEpoch - (CLIP<byte>(counter, 1, RF_USAGE_MAX) - 1);
+
+	// This is called whenever a resource is accessed, so return early if the
+	// resource has been used in the current epoch already
+	if (res._lastUsed == lastUsed)
+		return;
+
+	res._lastUsed = lastUsed;
+	if (res._status & RS_LISTED) {
+		lruRemove(type, idx);
+		lruInsert(type, idx);
+	}
 }
 
-void ResourceManager::Resource::setResourceCounter(byte counter) {
-	_flags &= RF_LOCK;	// Clear lower 7 bits, preserve the lock bit.
-	_flags |= counter;	// Update the usage counter
+byte ResourceManager::getResourceCounter(ResType type, ResId idx) const {
+	const Resource &res = _types[type][idx];
+	if (!res._address)
+		return 0;
+	return MIN<uint32>(_usageEpoch - res._lastUsed + 1, RF_USAGE_MAX);
+}
+
+void ResourceManager::updateLruList(ResType type, ResId idx) {
+	const Resource &res = _types[type][idx];
+
+	// Only resources which can be expired are listed
+	const bool expirable = _types[type]._mode != kDynamicResTypeMode && res._address && !res.isLocked() && !res.isOffHeap();
+	const bool listed = (res._status & RS_LISTED) != 0;
+
+	if (expirable && !listed)
+		lruInsert(type, idx);
+	else if (!expirable && listed)
+		lruRemove(type, idx);
+}
+
+void ResourceManager::lruInsert(ResType type, ResId idx) {
+	ResTypeData &resType = _types[type];
+	Resource &res = resType[idx];
+	const byte counter = getResourceCounter(type, idx);
+
+	// Find the first resource which is at least as old, as the list is
+	// ordered from the most recently used resource to the oldest one. Most
+	// resources are inserted at either end of the list.
+	ResId next;
+	if (resType._lruHead == RES_INVALID_ID || getResourceCounter(type, resType._lruHead) >= counter)
+		next = resType._lruHead;
+	else if (getResourceCounter(type, resType._lruTail) <= counter)
+		next = RES_INVALID_ID;
+	else {
+		next = resType._lruHead;
+		while (getResourceCounter(type, next) < counter)
+			next = resType[next]._lruNext;
+	}
+
+	const ResId prev = (next == RES_INVALID_ID) ? resType._lruTail : resType[next]._lruPrev;
+
+	res._lruPrev = prev;
+	res._lruNext = next;
+	if (prev == RES_INVALID_ID)
+		resType._lruHead = idx;
+	else
+		resType[prev]._lruNext = idx;
+	if (next == RES_INVALID_ID)
+		resType._lruTail = idx;
+	else
+		resType[next]._lruPrev = idx;
+
+	res._status |= RS_LISTED;
 }
 
-byte ResourceManager::Resource::getResourceCounter() const {
-	return _flags & RF_USAGE;
+void ResourceManager::lruRemove(ResType type, ResId idx) {
+	ResTypeData &resType = _types[type];
+	Resource &res = resType[idx];
+
+	if (res._lruPrev == RES_INVALID_ID)
+		resType._lruHead = res._lruNext;
+	else
+		resType[res._lruPrev]._lruNext = res._lruNext;
+	if (res._lruNext == RES_INVALID_ID)
+		resType._lruTail = res._lruPrev;
+	else
+		resType[res._lruNext]._lruPrev = res._lruPrev;
+
+	res._lruPrev = res._lruNext = RES_INVALID_ID;
+	res._status &= ~RS_LISTED;
 }
 
 /* 2 bytes safety area to make "precaching" of bytes in the gdi drawer easier */
@@ -821,7 +896,7 @@ byte *ResourceManager::createResource(ResType type, ResId idx, uint32 size) {
 
 	nukeResource(type, idx);
 
-	expireResources(size);
+	expireResources(type, size);
 
 	byte *ptr = new byte[size + SAFETY_AREA];
 	if (ptr == NULL) {
@@ -831,9 +906,20 @@ byte *ResourceManager::createResource(ResType type, ResId idx, uint32 size) {
 	memset(ptr, 0, size + SAFETY_AREA);
 	_allocatedSize += size;
 
-	_types[type][idx]._address = ptr;
-	_types[type][idx]._size = size;
+	ResTypeData &resType = _types[type];
+	Resource &res = resType[idx];
+
+	resType._allocatedSize += size;
+	resType._loads++;
+	if (res._status & RS_EXPIRED) {
+		resType._reloads++;
+		res._status &= ~RS_EXPIRED;
+	}
+
+	res._address = ptr;
+	res._size = size;
 	setResourceCounter(type, idx, 1);
+	updateLruList(type, idx);
 	return ptr;
 }
 
@@ -844,6 +930,8 @@ ResourceManager::Resource::Resource() {
 	_status = 0;
 	_roomno = 0;
 	_roomoffs = 0;
+	_lastUsed = 0;
+	_lruPrev = _lruNext = RES_INVALID_ID;
 }
 
 ResourceManager::Resource::~Resource() {
@@ -862,6 +950,12 @@ void ResourceManager::Resource::nuke() {
 ResourceManager::ResTypeData::ResTypeData() {
 	_mode = kDynamicResTypeMode;
 	_tag = 0;
+	_lruHead = _lruTail = RES_INVALID_ID;
+	_allocatedSize = 0;
+	_budget = 0;
+	_loads = 0;
+	_evictions = 0;
+	_reloads = 0;
 }
 
 ResourceManager::ResTypeData::~ResTypeData() {
@@ -872,6 +966,7 @@ ResourceManager::ResourceManager(ScummEngine *vm) : _vm(vm) {
 	_maxHeapThreshold = 0;
 	_minHeapThreshold = 0;
 	_expireCounter = 0;
+	_usageEpoch = 0;
 }
 
 ResourceManager::~ResourceManager() {
@@ -885,6 +980,19 @@ void ResourceManager::setHeapThreshold(int min, int max) {
 	_minHeapThreshold = min;
 }
 
+void ResourceManager::setHeapBudget(ResType type, uint32 budget) {
+	assert(type >= rtFirst && type <= rtLast);
+	_types[type]._budget = budget;
+}
+
+void ResourceManager::resetResourceStats() {
+	for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
+		_types[type]._loads = 0;
+		_types[type]._evictions = 0;
+		_types[type]._reloads = 0;
+	}
+}
+
 bool ResourceManager::validateResource(const char *str, ResType type, ResId idx) const {
 	if (type < rtFirst || type > rtLast || (uint)idx >= (uint)_types[type].size()) {
 		error("%s Illegal Glob type %s (%d) num %d", str, nameOfResType(type), type, idx);
@@ -897,7 +1005,10 @@ void ResourceManager::nukeResource(ResType type, ResId idx) {
 	byte *ptr = _types[type][idx]._address;
 	if (ptr != NULL) {
 		debugC(DEBUG_RESOURCE, "nukeResource(%s,%d)", nameOfResType(type), idx);
+		if (_types[type][idx]._status & RS_LISTED)
+			lruRemove(type, idx);
 		_allocatedSize -= _types[type][idx]._size;
+		_types[type]._allocatedSize -= _types[type][idx]._size;
 		_types[type][idx].nuke();
 	}
 }
@@ -931,12 +1042,14 @@ void ResourceManager::lock(ResType type, ResId idx) {
 	if (!validateResource("Locking", type, idx))
 		return;
 	_types[type][idx].lock();
+	updateLruList(type, idx);
 }
 
 void ResourceManager::unlock(ResType type, ResId idx) {
 	if (!validateResource("Unlocking", type, idx))
 		return;
 	_types[type][idx].unlock();
+	updateLruList(type, idx);
 }
 
 bool ResourceManager::isLocked(ResType type, ResId idx) const {
@@ -998,12 +1111,14 @@ void ResourceManager::setOffHeap(ResType type, ResId idx) {
 	if (!validateResource("setOffHeap", type, idx))
 		return;
 	_types[type][idx].setOffHeap();
+	updateLruList(type, idx);
 }
 
 void ResourceManager::setOnHeap(ResType type, ResId idx) {
 	if (!validateResource("setOnHeap", type, idx))
 		return;
 	_types[type][idx].setOnHeap();
+	updateLruList(type, idx);
 }
 
 bool ResourceManager::isModified(ResType type, ResId idx) const {
@@ -1032,10 +1147,28 @@ void ResourceManager::Resource::setOnHeap() {
 	_status &= ~RF_OFFHEAP;
 }
 
-void ResourceManager::expireResources(uint32 size) {
-	byte best_counter;
-	ResType best_type;
-	int best_res = 0;
+ResId ResourceManager::findExpirableResource(ResType type) const {
+	// Walk from the oldest resource, skipping the ones in use. Resources
+	// which have been used since the counters were last increased are
+	// never expired.
+	ResId idx = _types[type]._lruTail;
+	while (idx != RES_INVALID_ID && getResourceCounter(type, idx) >= 2) {
+		if (!_vm->isResourceInUse(type, idx))
+			return idx;
+		idx = _types[type][idx]._lruPrev;
+	}
+
+	return RES_INVALID_ID;
+}
+
+void ResourceManager::expireResource(ResType type, ResId idx) {
+	debugC(DEBUG_RESOURCE, "expireResource(%s,%d)", nameOfResType(type), idx);
+	_types[type]._evictions++;
+	nukeResource(type, idx);
+	_types[type][idx]._status |= RS_EXPIRED;
+}
+
+void ResourceManager::expireResources(ResType type, uint32 size) {
 	uint32 oldAllocatedSize;
 
 	if (_expireCounter != 0xFF) {
@@ -1043,35 +1176,41 @@ void ResourceManager::expireResources(uint32 size) {
 		increaseResourceCounters();
 	}
 
+	// Keep the resources of the new resource's type within their budget
+	ResTypeData &resType = _types[type];
+	while (resType._budget && size + resType._allocatedSize > resType._budget) {
+		const ResId idx = findExpirableResource(type);
+		if (idx == RES_INVALID_ID)
+			break;
+		expireResource(type, idx);
+	}
+
 	if (size + _allocatedSize < _maxHeapThreshold)
 		return;
 
 	oldAllocatedSize = _allocatedSize;
 
 	do {
-		best_type = rtInvalid;
-		best_counter = 2;
-
-		for (ResType type = rtFirst; type <= rtLast; type = ResType(type + 1)) {
-			if (_types[type]._mode != kDynamicResTypeMode) {
-				// Resources of this type can be reloaded from the data files,
-				// so we can potentially unload them to free memory.
-				ResId idx = _types[type].size();
-				while (idx-- > 0) {
-					Resource &tmp = _types[type][idx];
-					byte counter = tmp.getResourceCounter();
-					if (!tmp.isLocked() && counter >= best_counter && tmp._address && !_vm->isResourceInUse(type, idx) && !tmp.isOffHeap()) {
-						best_counter = counter;
-						best_type = type;
-						best_res = idx;
-					}
+		// Expire the oldest resource of all types
+		byte best_counter = 2;
+		ResType best_type = rtInvalid;
+		ResId best_res = 0;
+
+		for (ResType t = rtFirst; t <= rtLast; t = ResType(t + 1)) {
+			const ResId idx = findExpirableResource(t);
+			if (idx != RES_INVALID_ID) {
+				const byte counter = getResourceCounter(t, idx);
+				if (counter >= best_counter) {
+					best_counter = counter;
+					best_type = t;
+					best_res = idx;
 				}
 			}
 		}
 
 		if (!best_type)
 			break;
-		nukeResource(best_type, best_res);
+		expireResource(best_type, best_res);
 	} while (size + _allocatedSize > _minHeapThreshold);
 
 	increaseResourceCounters();
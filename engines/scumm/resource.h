@@ -48,6 +48,11 @@ enum {
 	RES_INVALID_OFFSET = 0xFFFFFFFF
 };
 
+enum {
+	/** Marks the end of the LRU list of a resource type. */
+	RES_INVALID_ID = 0xFFFF
+};
+
 class ScummEngine;
 
 /**
@@ -80,6 +85,7 @@ protected:
 
 public:
 	class Resource {
+	friend class ResourceManager;
 	public:
 		/**
 		 * Pointer to the data contained in this resource
@@ -94,21 +100,34 @@ public:
 	protected:
 		/**
 		 * The uppermost bit indicates whether the resources is locked.
-		 * The lower 7 bits contain a counter. This counter measures roughly
-		 * how old the resource is; it starts out with a count of 1 and can go
-		 * as high as 127. When memory falls low resp. when the engine decides
-		 * that it should throw out some unused stuff, then it begins by
-		 * removing the resources with the highest counter (excluding locked
-		 * resources and resources that are known to be in use).
 		 */
 		byte _flags;
 
 		/**
-		 * The status of the resource. Currently only one bit is used, which
-		 * indicates whether the resource is modified.
+		 * The status of the resource: whether the resource is modified,
+		 * off heap, in the LRU list of its type, or was expired the last
+		 * time it was unloaded.
 		 */
 		byte _status;
 
+		/**
+		 * The usage epoch of the resource manager when the resource was last
+		 * used. The difference to the current epoch gives the resource
+		 * counter, which measures roughly how old the resource is; it starts
+		 * out with a count of 1 and can go as high as 127. When memory falls
+		 * low resp. when the engine decides that it should throw out some
+		 * unused stuff, then it begins by removing the resources with the
+		 * highest counter (excluding locked resources and resources that are
+		 * known to be in use).
+		 */
+		uint32 _lastUsed;
+
+		/**
+		 * The neighbours of the resource in the LRU list of its type, which
+		 * is ordered by the resource counter, or RES_INVALID_ID.
+		 */
+		ResId _lruPrev, _lruNext;
+
 	public:
 		/**
 		 * The id of the room (resp. the disk) the resource is contained in.
@@ -131,9 +150,6 @@ public:
 
 		void nuke();
 
-		inline void setResourceCounter(byte counter);
-		inline byte getResourceCounter() const;
-
 		void lock();
 		void unlock();
 		bool isLocked() const;
@@ -164,9 +180,39 @@ public:
 		 */
 		uint32 _tag;
 
+	protected:
+		/**
+		 * The loaded resources of this type which can be expired (i.e. which
+		 * are not locked and not off heap), ordered by their resource counter,
+		 * from the most recently used one to the oldest one. Only resources of
+		 * types which can be reloaded from the data files are listed.
+		 */
+		ResId _lruHead, _lruTail;
+
+		/**
+		 * Size of all loaded resources of this type.
+		 */
+		uint32 _allocatedSize;
+
+		/**
+		 * If not 0, resources of this type are expired when they would use
+		 * more memory than this.
+		 */
+		uint32 _budget;
+
+		uint32 _loads;     ///< Number of resources created
+		uint32 _evictions; ///< Number of resources expired to free memory
+		uint32 _reloads;   ///< Number of expired resources which had to be loaded again
+
 	public:
 		ResTypeData();
 		~ResTypeData();
+
+		uint32 getAllocatedSize() const { return _allocatedSize; }
+		uint32 getBudget() const { return _budget; }
+		uint32 getLoads() const { return _loads; }
+		uint32 getEvictions() const { return _evictions; }
+		uint32 getReloads() const { return _reloads; }
 	};
 	ResTypeData _types[rtLast + 1];
 
@@ -175,12 +221,29 @@ protected:
 	uint32 _maxHeapThreshold, _minHeapThreshold;
 	byte _expireCounter;
 
+	/**
+	 * Incremented by increaseResourceCounters(), which ages all resources.
+	 */
+	uint32 _usageEpoch;
+
 public:
 	ResourceManager(ScummEngine *vm);
 	~ResourceManager();
 
 	void setHeapThreshold(int min, int max);
 
+	/**
+	 * Limit the memory used by the resources of the given type. Once it would
+	 * be exceeded, the oldest resources of this type are expired first,
+	 * regardless of the global heap threshold. A budget of 0 means no limit.
+	 */
+	void setHeapBudget(ResType type, uint32 budget);
+
+	/**
+	 * Reset the load, eviction and reload counts of all resource types.
+	 */
+	void resetResourceStats();
+
 	void allocResTypeData(ResType type, uint32 tag, int num, ResTypeMode mode);
 	void freeResources();
 
@@ -215,8 +278,13 @@ public:
 	void setResourceCounter(ResType type, ResId idx, byte counter);
 
 	/**
-	 * Increment the counter of all unlocked loaded resources.
-	 * The maximal count is 255.
+	 * Get the specified resource's counter, or 0 if it is not loaded.
+	 */
+	byte getResourceCounter(ResType type, ResId idx) const;
+
+	/**
+	 * Increment the counter of all loaded resources, by starting a new usage
+	 * epoch. The maximal count is 127.
 	 * This is called by increaseExpireCounter and expireResources,
 	 * but also by ScummEngine::startScene.
 	 */
@@ -227,7 +295,13 @@ public:
 //protected:
 	bool validateResource(const char *str, ResType type, ResId idx) const;
 protected:
-	void expireResources(uint32 size);
+	void expireResources(ResType type, uint32 size);
+	void expireResource(ResType type, ResId idx);
+	ResId findExpirableResource(ResType type) const;
+
+	void updateLruList(ResType type, ResId idx);
+	void lruInsert(ResType type, ResId idx);
+	void lruRemove(ResType type, ResId idx);
 };
 
 } // End of namespace Scumm
@@ -1320,6 +1320,24 @@ void ScummEngine::setupScumm() {
 
 	_res->setHeapThreshold(400000, maxHeapThreshold);
 
+	// Optional budgets for the memory used by some resource types, in KB.
+	// These help tuning games which keep reloading resources, e.g. HE games
+	// with large rooms.
+	static const struct {
+		ResType type;
+		const char *key;
+	} heapBudgets[] = {
+		{ rtCostume, "heap_budget_costumes" },
+		{ rtRoom, "heap_budget_rooms" },
+		{ rtSound, "heap_budget_sounds" },
+		{ rtScript, "heap_budget_scripts" }
+	};
+
+	for (int i = 0; i < ARRAYSIZE(heapBudgets); i++) {
+		if (ConfMan.hasKey(heapBudgets[i].key))
+			_res->setHeapBudget(heapBudgets[i].type, MAX(ConfMan.getInt(heapBudgets[i].key), 0) * 1024);
+	}
+
 	free(_compositeBuf);
 	_compositeBuf = (byte *)malloc(_screenWidth * _textSurfaceMultiplier * _screenHeight * _textSurfaceMultiplier * _outputPixelFormat.bytesPerPixel);
 }
@@ -203,10 +203,6 @@ static StringResource *getStrings(ScummEngine *vm, const char *file, bool is_enc
 	return sr;
 }
 
-void SmushPlayer::timerCallback() {
-	parseNextFrame();
-}
-
 SmushPlayer::SmushPlayer(ScummEngine_v7 *scumm) {
 	_vm = scumm;
 	_nbframes = 0;
@@ -241,9 +237,19 @@ SmushPlayer::SmushPlayer(ScummEngine_v7 *scumm) {
 	_paused = false;
 	_pauseStartTime = 0;
 	_pauseTime = 0;
+
+	for (int i = 0; i < kMaxFramesAhead; i++) {
+		_frames[i].pixels = NULL;
+		_frames[i].size = 0;
+	}
+	_firstFrame = 0;
+	_numFrames = 0;
+	_maxFrames = 1;
+	memset(&_stats, 0, sizeof(_stats));
 }
 
 SmushPlayer::~SmushPlayer() {
+	clearFrames();
 }
 
 void SmushPlayer::init(int32 speed) {
@@ -310,6 +316,22 @@ void SmushPlayer::release() {
 	_codec37 = 0;
 	delete _codec47;
 	_codec47 = 0;
+
+	clearFrames();
+
+	debugC(DEBUG_SMUSH, "Smush stats: %d frames decoded (%d ahead of time) in %d ms, slowest %d ms, %d shown, %d dropped",
+		_stats.framesDecoded, _stats.framesAhead, _stats.decodeTime, _stats.maxDecodeTime,
+		_stats.framesShown, _stats.framesDropped);
+}
+
+void SmushPlayer::clearFrames() {
+	for (int i = 0; i < kMaxFramesAhead; i++) {
+		free(_frames[i].pixels);
+		_frames[i].pixels = NULL;
+		_frames[i].size = 0;
+	}
+	_firstFrame = 0;
+	_numFrames = 0;
 }
 
 void SmushPlayer::handleSoundBuffer(int32 track_id, int32 index, int32 max_frames, int32 flags, int32 vol, int32 pan, Common::SeekableReadStream &b, int32 size) {
@@ -1005,6 +1027,11 @@ void SmushPlayer::parseNextFrame() {
 		}
 
 		_base->seek(_seekPos + 8, SEEK_SET);
+
+		// The frames decoded so far belong to the old position
+		_firstFrame = 0;
+		_numFrames = 0;
+
 		_frame = _seekFrame;
 		_startFrame = _frame;
 		_startTime = _vm->_system->getMillis();
@@ -1019,7 +1046,8 @@ void SmushPlayer::parseNextFrame() {
 	const int32 subOffset = _base->pos();
 
 	if (_base->pos() >= (int32)_baseSize) {
-		_vm->_smushVideoShouldFinish = true;
+		// Don't set _smushVideoShouldFinish yet, the frames decoded ahead
+		// of time still have to be shown
 		_endOfFile = true;
 		return;
 	}
@@ -1072,10 +1100,59 @@ void SmushPlayer::warpMouse(int x, int y, int buttons) {
 }
 
 void SmushPlayer::updateScreen() {
-	uint32 end_time, start_time = _vm->_system->getMillis();
-	_updateNeeded = true;
-	end_time = _vm->_system->getMillis();
-	debugC(DEBUG_SMUSH, "Smush stats: updateScreen( %03d )", end_time - start_time);
+	// Keep a copy of the frame until it is due, as the following frames
+	// may be decoded into _dst before that
+	assert(_numFrames < kMaxFramesAhead);
+	DecodedFrame &frame = _frames[(_firstFrame + _numFrames) % kMaxFramesAhead];
+	const uint32 size = _width * _height;
+
+	if (frame.size < size) {
+		free(frame.pixels);
+		frame.pixels = (byte *)malloc(size);
+		assert(frame.pixels);
+		frame.size = size;
+	}
+	memcpy(frame.pixels, _dst, size);
+	frame.width = _width;
+	frame.height = _height;
+	frame.frame = _frame;
+
+	// Palette changes take effect when the frame is shown
+	frame.palDirtyMin = _palDirtyMin;
+	frame.palDirtyMax = _palDirtyMax;
+	if (_palDirtyMax >= _palDirtyMin) {
+		memcpy(frame.pal, _pal, 0x300);
+		_palDirtyMax = -1;
+		_palDirtyMin = 256;
+	}
+
+	_numFrames++;
+	_stats.framesDecoded++;
+}
+
+void SmushPlayer::decodeNextFrame() {
+	const uint32 startTime = _vm->_system->getMillis();
+
+	parseNextFrame();
+
+	const uint32 decodeTime = _vm->_system->getMillis() - startTime;
+	_stats.decodeTime += decodeTime;
+	if (_stats.maxDecodeTime < decodeTime)
+		_stats.maxDecodeTime = decodeTime;
+}
+
+void SmushPlayer::showFrame(const DecodedFrame &frame) {
+	if (frame.palDirtyMax >= frame.palDirtyMin)
+		_vm->_system->getPaletteManager()->setPalette(frame.pal + frame.palDirtyMin * 3, frame.palDirtyMin, frame.palDirtyMax - frame.palDirtyMin + 1);
+
+	// Workaround for bug #1386333: "FT DEMO: assertion triggered
+	// when playing movie". Some frames there are 384 x 224
+	int w = MIN(frame.width, _vm->_screenWidth);
+	int h = MIN(frame.height, _vm->_screenHeight);
+
+	_vm->_system->copyRectToScreen(frame.pixels, frame.width, 0, 0, w, h);
+	_vm->_system->updateScreen();
+	_stats.framesShown++;
 }
 
 void SmushPlayer::insanity(bool flag) {
@@ -1150,7 +1227,6 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 	}
 	f.close();
 
-	_updateNeeded = false;
 	_warpNeeded = false;
 	_palDirtyMin = 256;
 	_palDirtyMax = -1;
@@ -1173,11 +1249,17 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 
 	_pauseTime = 0;
 
+	// Insane reacts to the input while the video plays, so it cannot be
+	// decoded ahead of time. Two frames are still needed to drop the
+	// late ones.
+	_maxFrames = _insanity ? 2 : kMaxFramesAhead;
+	memset(&_stats, 0, sizeof(_stats));
+
 	int skipped = 0;
 
 	for (;;) {
 		uint32 now, elapsed;
-		bool skipFrame = false;
+		bool decodedAhead = false;
 
 		if (_insanity) {
 			// Seeking makes a mess of trying to sync the audio to
@@ -1198,12 +1280,17 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 			elapsed = now - _startTime;
 		}
 
-		if (elapsed >= ((_frame - _startFrame) * 1000) / _speed) {
-			if (elapsed >= ((_frame + 1) * 1000) / _speed)
-				skipFrame = true;
-			else
-				skipFrame = false;
-			timerCallback();
+		// Decode the frames which are due, and one more frame ahead of
+		// time if there is room for it. This way, the time left over by
+		// simple frames goes to decoding the complex ones.
+		while (!_endOfFile && _numFrames < _maxFrames) {
+			if (elapsed < getFrameTime(_frame)) {
+				if (_insanity || decodedAhead)
+					break;
+				decodedAhead = true;
+				_stats.framesAhead++;
+			}
+			decodeNextFrame();
 		}
 
 		_vm->scummLoop_handleSound();
@@ -1214,33 +1301,40 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 		}
 		_vm->parseEvents();
 		_vm->processInput();
+		// Palette changes made outside of a frame
 		if (_palDirtyMax >= _palDirtyMin) {
 			_vm->_system->getPaletteManager()->setPalette(_pal + _palDirtyMin * 3, _palDirtyMin, _palDirtyMax - _palDirtyMin + 1);
 
 			_palDirtyMax = -1;
 			_palDirtyMin = 256;
-			skipFrame = false;
 		}
-		if (skipFrame) {
-			if (++skipped > 10) {
-				skipFrame = false;
+
+		// Show the oldest frame once it is due. A frame which is already
+		// late is dropped if the next one is decoded, unless it changes
+		// the palette or ten frames in a row were dropped.
+		while (_numFrames) {
+			const DecodedFrame &frame = _frames[_firstFrame];
+			if (elapsed < getFrameTime(frame.frame))
+				break;
+
+			const bool late = _numFrames > 1 && elapsed >= getFrameTime(frame.frame + 1);
+			const bool drop = late && frame.palDirtyMax < frame.palDirtyMin && ++skipped <= 10;
+
+			if (drop) {
+				_stats.framesDropped++;
+			} else {
+				showFrame(frame);
 				skipped = 0;
 			}
-		} else
-			skipped = 0;
-		if (_updateNeeded) {
-			if (!skipFrame) {
-				// Workaround for bug #1386333: "FT DEMO: assertion triggered
-				// when playing movie". Some frames there are 384 x 224
-				int w = MIN(_width, _vm->_screenWidth);
-				int h = MIN(_height, _vm->_screenHeight);
-
-				_vm->_system->copyRectToScreen(_dst, _width, 0, 0, w, h);
-				_vm->_system->updateScreen();
-				_updateNeeded = false;
-			}
+
+			_firstFrame = (_firstFrame + 1) % kMaxFramesAhead;
+			_numFrames--;
+
+			if (!drop)
+				break;
 		}
-		if (_endOfFile)
+
+		if (_endOfFile && !_numFrames)
 			break;
 		if (_vm->shouldQuit() || _vm->_saveLoadFlag || _vm->_smushVideoShouldFinish) {
 			_smixer->stop();
@@ -1249,7 +1343,8 @@ void SmushPlayer::play(const char *filename, int32 speed, int32 offset, int32 st
 			_IACTpos = 0;
 			break;
 		}
-		_vm->_system->delayMillis(10);
+		if (!decodedAhead)
+			_vm->_system->delayMillis(10);
 	}
 
 	release();
@@ -35,9 +35,33 @@ class StringResource;
 class Codec37Decoder;
 class Codec47Decoder;
 
+/** Statistics of the last SMUSH video, see the DEBUG_SMUSH debug channel. */
+struct SmushStats {
+	uint32 framesDecoded;
+	uint32 framesShown;
+	uint32 framesDropped;	///< Frames which were decoded too late to be shown
+	uint32 framesAhead;		///< Frames which were decoded before they were due
+	uint32 decodeTime;		///< Milliseconds spent decoding frames
+	uint32 maxDecodeTime;	///< Milliseconds spent on the slowest frame
+};
+
 class SmushPlayer {
 	friend class Insane;
 private:
+	enum {
+		kMaxFramesAhead = 4	///< Size of the ring of decoded frames
+	};
+
+	/** A decoded frame, waiting to be shown. */
+	struct DecodedFrame {
+		byte *pixels;
+		uint32 size;		///< Size of the pixels buffer
+		int width, height;
+		uint32 frame;
+		byte pal[0x300];
+		int palDirtyMin, palDirtyMax;
+	};
+
 	ScummEngine_v7 *_vm;
 	int32 _nbframes;
 	SmushMixer *_smixer;
@@ -73,7 +97,6 @@ private:
 	bool _endOfFile;
 
 	byte *_dst;
-	bool _updateNeeded;
 	bool _warpNeeded;
 	int _palDirtyMin, _palDirtyMax;
 	int _warpX, _warpY;
@@ -82,6 +105,11 @@ private:
 	bool _middleAudio;
 	bool _skipPalette;
 
+	DecodedFrame _frames[kMaxFramesAhead];
+	int _firstFrame, _numFrames;
+	int _maxFrames;		///< Number of frames which may be decoded ahead
+	SmushStats _stats;
+
 public:
 	SmushPlayer(ScummEngine_v7 *scumm);
 	~SmushPlayer();
@@ -93,6 +121,8 @@ public:
 	void release();
 	void warpMouse(int x, int y, int buttons);
 
+	const SmushStats &getStats() const { return _stats; }
+
 protected:
 	int _width, _height;
 
@@ -116,6 +146,11 @@ private:
 	void updateScreen();
 	void tryCmpFile(const char *filename);
 
+	uint32 getFrameTime(uint32 frame) const { return ((frame - _startFrame) * 1000) / _speed; }
+	void decodeNextFrame();
+	void showFrame(const DecodedFrame &frame);
+	void clearFrames();
+
 	bool readString(const char *file);
 	void decodeFrameObject(int codec, const uint8 *src, int left, int top, int width, int height);
 	void handleAnimHeader(int32 subSize, Common::SeekableReadStream &);
@@ -134,7 +169,6 @@ private:
 	void handleDeltaPalette(int32 subSize, Common::SeekableReadStream &);
 	void readPalette(byte *, Common::SeekableReadStream &);
 
-	void timerCallback();
 };
 
 } // End of namespace Scumm
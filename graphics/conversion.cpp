@@ -22,17 +22,321 @@
 #include "graphics/conversion.h"
 #include "graphics/pixelformat.h"
 
+#include "common/sse2.h"
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
 
+namespace {
+
+template<int bytesPerPixel>
+inline uint32 readPixel(const byte *src);
+
+template<>
+inline uint32 readPixel<2>(const byte *src) {
+	return *(const uint16 *)src;
+}
+
+template<>
+inline uint32 readPixel<3>(const byte *src) {
+	uint32 color = 0;
+	byte *col = (byte *)&color;
+#ifdef SCUMM_BIG_ENDIAN
+	col++;
+#endif
+	memcpy(col, src, 3);
+	return color;
+}
+
+template<>
+inline uint32 readPixel<4>(const byte *src) {
+	return *(const uint32 *)src;
+}
+
+template<int bytesPerPixel>
+inline void writePixel(byte *dst, uint32 color);
+
+template<>
+inline void writePixel<1>(byte *dst, uint32 color) {
+	*dst = color;
+}
+
+template<>
+inline void writePixel<2>(byte *dst, uint32 color) {
+	*(uint16 *)dst = color;
+}
+
+template<>
+inline void writePixel<3>(byte *dst, uint32 color) {
+	const byte *col = (const byte *)&color;
+#ifdef SCUMM_BIG_ENDIAN
+	col++;
+#endif
+	memcpy(dst, col, 3);
+}
+
+template<>
+inline void writePixel<4>(byte *dst, uint32 color) {
+	*(uint32 *)dst = color;
+}
+
+template<int srcBytesPerPixel, int dstBytesPerPixel>
+void crossBlitLogic(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	uint8 r, g, b, a;
+	for (int y = 0; y < h; y++) {
+		const byte *s = src;
+		byte *d = dst;
+		for (int x = 0; x < w; x++, s += srcBytesPerPixel, d += dstBytesPerPixel) {
+			srcFmt.colorToARGB(readPixel<srcBytesPerPixel>(s), a, r, g, b);
+			writePixel<dstBytesPerPixel>(d, dstFmt.ARGBToColor(a, r, g, b));
+		}
+		src += srcpitch;
+		dst += dstpitch;
+	}
+}
+
+template<int srcBytesPerPixel>
+void crossBlitFrom(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	switch (dstFmt.bytesPerPixel) {
+	case 2:
+		crossBlitLogic<srcBytesPerPixel, 2>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	case 3:
+		crossBlitLogic<srcBytesPerPixel, 3>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	default:
+		crossBlitLogic<srcBytesPerPixel, 4>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	}
+}
+
+template<int bytesPerPixel>
+struct PixelType;
+
+template<>
+struct PixelType<2> {
+	typedef uint16 Type;
+};
+
+template<>
+struct PixelType<4> {
+	typedef uint32 Type;
+};
+
+/**
+ * A pixel format which is known at compile time. It converts colors with
+ * the same formulas as PixelFormat, so that the fast paths give exactly
+ * the same results as the generic code.
+ */
+template<int BytesPerPixel, int RBits, int GBits, int BBits, int ABits, int RShift, int GShift, int BShift, int AShift>
+struct StaticPixelFormat {
+	typedef typename PixelType<BytesPerPixel>::Type Pixel;
+
+	static PixelFormat getFormat() {
+		return PixelFormat(BytesPerPixel, RBits, GBits, BBits, ABits, RShift, GShift, BShift, AShift);
+	}
+
+	static inline void colorToARGB(uint32 color, uint8 &a, uint8 &r, uint8 &g, uint8 &b) {
+		a = ((color >> AShift) << (8 - ABits)) & 0xFF;
+		r = ((color >> RShift) << (8 - RBits)) & 0xFF;
+		g = ((color >> GShift) << (8 - GBits)) & 0xFF;
+		b = ((color >> BShift) << (8 - BBits)) & 0xFF;
+	}
+
+	static inline uint32 ARGBToColor(uint8 a, uint8 r, uint8 g, uint8 b) {
+		return
+			((uint32)(a >> (8 - ABits)) << AShift) |
+			((uint32)(r >> (8 - RBits)) << RShift) |
+			((uint32)(g >> (8 - GBits)) << GShift) |
+			((uint32)(b >> (8 - BBits)) << BShift);
+	}
+};
+
+typedef StaticPixelFormat<2, 5, 6, 5, 0, 11, 5, 0, 0> FormatRGB565;
+typedef StaticPixelFormat<2, 5, 5, 5, 1, 10, 5, 0, 15> FormatARGB1555;
+typedef StaticPixelFormat<4, 8, 8, 8, 0, 16, 8, 0, 0> FormatXRGB8888;
+typedef StaticPixelFormat<4, 8, 8, 8, 8, 16, 8, 0, 24> FormatARGB8888;
+typedef StaticPixelFormat<4, 8, 8, 8, 8, 24, 16, 8, 0> FormatRGBA8888;
+
+typedef void (*ConvertRowProc)(byte *dst, const byte *src, int w);
+
+template<class SrcFormat, class DstFormat>
+void convertRowLogic(byte *dst, const byte *src, int w) {
+	const typename SrcFormat::Pixel *s = (const typename SrcFormat::Pixel *)src;
+	typename DstFormat::Pixel *d = (typename DstFormat::Pixel *)dst;
+
+	uint8 r, g, b, a;
+	for (int x = 0; x < w; x++) {
+		SrcFormat::colorToARGB(s[x], a, r, g, b);
+		d[x] = DstFormat::ARGBToColor(a, r, g, b);
+	}
+}
+
+/**
+ * Convert one row of pixels. This is specialized with SIMD code for some
+ * conversions, which leave the remaining pixels to convertRowLogic().
+ */
+template<class SrcFormat, class DstFormat>
+void convertRow(byte *dst, const byte *src, int w) {
+	convertRowLogic<SrcFormat, DstFormat>(dst, src, w);
+}
+
+#ifdef USE_SSE2
+
+// All of these only shift and mask the color components, exactly like
+// StaticPixelFormat does. They convert 8 pixels per iteration.
+
+template<>
+void convertRow<FormatRGB565, FormatXRGB8888>(byte *dst, const byte *src, int w) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i redMask = _mm_set1_epi32(0xF800);
+	const __m128i greenMask = _mm_set1_epi32(0x07E0);
+	const __m128i blueMask = _mm_set1_epi32(0x001F);
+
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 16, dst += 32) {
+		const __m128i color = _mm_loadu_si128((const __m128i *)src);
+		__m128i half[2];
+		half[0] = _mm_unpacklo_epi16(color, zero);
+		half[1] = _mm_unpackhi_epi16(color, zero);
+
+		for (int i = 0; i < 2; i++) {
+			const __m128i r = _mm_slli_epi32(_mm_and_si128(half[i], redMask), 8);
+			const __m128i g = _mm_slli_epi32(_mm_and_si128(half[i], greenMask), 5);
+			const __m128i b = _mm_slli_epi32(_mm_and_si128(half[i], blueMask), 3);
+			_mm_storeu_si128((__m128i *)dst + i, _mm_or_si128(_mm_or_si128(r, g), b));
+		}
+	}
+
+	convertRowLogic<FormatRGB565, FormatXRGB8888>(dst, src, w - x);
+}
+
+template<>
+void convertRow<FormatXRGB8888, FormatRGB565>(byte *dst, const byte *src, int w) {
+	const __m128i redMask = _mm_set1_epi32(0xF80000);
+	const __m128i greenMask = _mm_set1_epi32(0x00FC00);
+	const __m128i blueMask = _mm_set1_epi32(0x0000F8);
+
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 32, dst += 16) {
+		__m128i half[2];
+		for (int i = 0; i < 2; i++) {
+			const __m128i color = _mm_loadu_si128((const __m128i *)src + i);
+			const __m128i r = _mm_srli_epi32(_mm_and_si128(color, redMask), 8);
+			const __m128i g = _mm_srli_epi32(_mm_and_si128(color, greenMask), 5);
+			const __m128i b = _mm_srli_epi32(_mm_and_si128(color, blueMask), 3);
+
+			// Sign extend, so that the saturating pack keeps all 16 bits
+			half[i] = _mm_srai_epi32(_mm_slli_epi32(_mm_or_si128(_mm_or_si128(r, g), b), 16), 16);
+		}
+		_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(half[0], half[1]));
+	}
+
+	convertRowLogic<FormatXRGB8888, FormatRGB565>(dst, src, w - x);
+}
+
+template<>
+void convertRow<FormatARGB1555, FormatRGB565>(byte *dst, const byte *src, int w) {
+	const __m128i redGreenMask = _mm_set1_epi16(0x7FE0);
+	const __m128i blueMask = _mm_set1_epi16(0x001F);
+
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 16, dst += 16) {
+		const __m128i color = _mm_loadu_si128((const __m128i *)src);
+		const __m128i redGreen = _mm_slli_epi16(_mm_and_si128(color, redGreenMask), 1);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(redGreen, _mm_and_si128(color, blueMask)));
+	}
+
+	convertRowLogic<FormatARGB1555, FormatRGB565>(dst, src, w - x);
+}
+
+template<>
+void convertRow<FormatRGB565, FormatARGB1555>(byte *dst, const byte *src, int w) {
+	const __m128i redGreenMask = _mm_set1_epi16(0x7FE0);
+	const __m128i blueMask = _mm_set1_epi16(0x001F);
+
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 16, dst += 16) {
+		const __m128i color = _mm_loadu_si128((const __m128i *)src);
+		const __m128i redGreen = _mm_and_si128(_mm_srli_epi16(color, 1), redGreenMask);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(redGreen, _mm_and_si128(color, blueMask)));
+	}
+
+	convertRowLogic<FormatRGB565, FormatARGB1555>(dst, src, w - x);
+}
+
+template<>
+void convertRow<FormatRGBA8888, FormatARGB8888>(byte *dst, const byte *src, int w) {
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 32, dst += 32) {
+		for (int i = 0; i < 2; i++) {
+			const __m128i color = _mm_loadu_si128((const __m128i *)src + i);
+			_mm_storeu_si128((__m128i *)dst + i, _mm_or_si128(_mm_srli_epi32(color, 8), _mm_slli_epi32(color, 24)));
+		}
+	}
+
+	convertRowLogic<FormatRGBA8888, FormatARGB8888>(dst, src, w - x);
+}
+
+template<>
+void convertRow<FormatARGB8888, FormatRGBA8888>(byte *dst, const byte *src, int w) {
+	int x = 0;
+	for (; x + 8 <= w; x += 8, src += 32, dst += 32) {
+		for (int i = 0; i < 2; i++) {
+			const __m128i color = _mm_loadu_si128((const __m128i *)src + i);
+			_mm_storeu_si128((__m128i *)dst + i, _mm_or_si128(_mm_slli_epi32(color, 8), _mm_srli_epi32(color, 24)));
+		}
+	}
+
+	convertRowLogic<FormatARGB8888, FormatRGBA8888>(dst, src, w - x);
+}
+
+#endif // USE_SSE2
+
+template<class SrcFormat, class DstFormat>
+inline bool isConversion(const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	return srcFmt == SrcFormat::getFormat() && dstFmt == DstFormat::getFormat();
+}
+
+ConvertRowProc findConvertRow(const PixelFormat &dstFmt, const PixelFormat &srcFmt) {
+	if (isConversion<FormatRGB565, FormatXRGB8888>(dstFmt, srcFmt))
+		return convertRow<FormatRGB565, FormatXRGB8888>;
+	if (isConversion<FormatXRGB8888, FormatRGB565>(dstFmt, srcFmt))
+		return convertRow<FormatXRGB8888, FormatRGB565>;
+	if (isConversion<FormatARGB1555, FormatRGB565>(dstFmt, srcFmt))
+		return convertRow<FormatARGB1555, FormatRGB565>;
+	if (isConversion<FormatRGB565, FormatARGB1555>(dstFmt, srcFmt))
+		return convertRow<FormatRGB565, FormatARGB1555>;
+	if (isConversion<FormatRGBA8888, FormatARGB8888>(dstFmt, srcFmt))
+		return convertRow<FormatRGBA8888, FormatARGB8888>;
+	if (isConversion<FormatARGB8888, FormatRGBA8888>(dstFmt, srcFmt))
+		return convertRow<FormatARGB8888, FormatRGBA8888>;
+	return 0;
+}
+
+template<int bytesPerPixel>
+void crossBlitMapLogic(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, const uint32 *map) {
+	for (int y = 0; y < h; y++) {
+		byte *d = dst;
+		for (int x = 0; x < w; x++, d += bytesPerPixel)
+			writePixel<bytesPerPixel>(d, map[src[x]]);
+		src += srcpitch;
+		dst += dstpitch;
+	}
+}
+
+} // End of anonymous namespace
+
 // Function to blit a rect from one color format to another
 bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
 	// Error out if conversion is impossible
-	if ((srcFmt.bytesPerPixel == 1) || (dstFmt.bytesPerPixel == 1)
-			 || (!srcFmt.bytesPerPixel) || (!dstFmt.bytesPerPixel)
-			 || (srcFmt.bytesPerPixel > dstFmt.bytesPerPixel))
+	if ((srcFmt.bytesPerPixel < 2) || (srcFmt.bytesPerPixel > 4)
+			 || (dstFmt.bytesPerPixel < 2) || (dstFmt.bytesPerPixel > 4))
 		return false;
 
 	// Don't perform unnecessary conversion
@@ -52,95 +356,52 @@ bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 		}
 	}
 
-	// Faster, but larger, to provide optimized handling for each case.
-	int srcDelta, dstDelta;
-	srcDelta = (srcpitch - w * srcFmt.bytesPerPixel);
-	dstDelta = (dstpitch - w * dstFmt.bytesPerPixel);
+	const ConvertRowProc convertRow = findConvertRow(dstFmt, srcFmt);
+	if (convertRow) {
+		// Convert rects without padding as one long row
+		if (srcpitch == w * srcFmt.bytesPerPixel && dstpitch == w * dstFmt.bytesPerPixel) {
+			w *= h;
+			h = 1;
+		}
 
-	// TODO: optimized cases for dstDelta of 0
-	uint8 r, g, b, a;
-	if (dstFmt.bytesPerPixel == 2) {
-		uint16 color;
 		for (int y = 0; y < h; y++) {
-			for (int x = 0; x < w; x++, src += 2, dst += 2) {
-				color = *(const uint16 *)src;
-				srcFmt.colorToARGB(color, a, r, g, b);
-				color = dstFmt.ARGBToColor(a, r, g, b);
-				*(uint16 *)dst = color;
-			}
-			src += srcDelta;
-			dst += dstDelta;
+			convertRow(dst, src, w);
+			src += srcpitch;
+			dst += dstpitch;
 		}
-	} else if (dstFmt.bytesPerPixel == 3) {
-		uint32 color;
-		uint8 *col = (uint8 *) &color;
-#ifdef SCUMM_BIG_ENDIAN
-		col++;
-#endif
-		if (srcFmt.bytesPerPixel == 2) {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 3) {
-					color = *(const uint16 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					memcpy(dst, col, 3);
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 3, dst += 3) {
-					memcpy(col, src, 3);
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					memcpy(dst, col, 3);
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		}
-	} else if (dstFmt.bytesPerPixel == 4) {
-		uint32 color;
-		if (srcFmt.bytesPerPixel == 2) {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 4) {
-					color = *(const uint16 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else if (srcFmt.bytesPerPixel == 3) {
-			uint8 *col = (uint8 *)&color;
-#ifdef SCUMM_BIG_ENDIAN
-			col++;
-#endif
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 2, dst += 4) {
-					memcpy(col, src, 3);
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		} else {
-			for (int y = 0; y < h; y++) {
-				for (int x = 0; x < w; x++, src += 4, dst += 4) {
-					color = *(const uint32 *)src;
-					srcFmt.colorToARGB(color, a, r, g, b);
-					color = dstFmt.ARGBToColor(a, r, g, b);
-					*(uint32 *)dst = color;
-				}
-				src += srcDelta;
-				dst += dstDelta;
-			}
-		}
-	} else {
+		return true;
+	}
+
+	switch (srcFmt.bytesPerPixel) {
+	case 2:
+		crossBlitFrom<2>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	case 3:
+		crossBlitFrom<3>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	default:
+		crossBlitFrom<4>(dst, src, dstpitch, srcpitch, w, h, dstFmt, srcFmt);
+		break;
+	}
+	return true;
+}
+
+bool crossBlitMap(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, uint bytesPerPixel, const uint32 *map) {
+	switch (bytesPerPixel) {
+	case 1:
+		crossBlitMapLogic<1>(dst, src, dstpitch, srcpitch, w, h, map);
+		break;
+	case 2:
+		crossBlitMapLogic<2>(dst, src, dstpitch, srcpitch, w, h, map);
+		break;
+	case 3:
+		crossBlitMapLogic<3>(dst, src, dstpitch, srcpitch, w, h, map);
+		break;
+	case 4:
+		crossBlitMapLogic<4>(dst, src, dstpitch, srcpitch, w, h, map);
+		break;
+	default:
 		return false;
 	}
 	return true;
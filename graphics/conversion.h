@@ -48,6 +48,10 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
 /**
  * Blits a rectangle from one graphical format to another.
  *
+ * Conversions between RGB565, ARGB1555, XRGB8888, ARGB8888 and RGBA8888
+ * which are used for videos and overlays have specialized fast paths. They
+ * give exactly the same results as the generic conversion.
+ *
  * @param dstbuf	the buffer which will recieve the converted graphics data
  * @param srcbuf	the buffer containing the original graphics data
  * @param dstpitch	width in bytes of one full line of the dest buffer
@@ -59,9 +63,8 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
  * @return			true if conversion completes successfully,
  *					false if there is an error.
  *
- * @note This implementation currently arbitrarily requires that the
- *		 destination's format have at least as high a bytedepth as
- *		 the source's.
+ * @note Paletted graphics can not be converted with this function, use
+ *		 crossBlitMap() for them.
  * @note This can convert a rectangle in place, if the source and
  *		 destination format have the same bytedepth.
  *
@@ -69,6 +72,27 @@ inline static void RGB2YUV(byte r, byte g, byte b, byte &y, byte &u, byte &v) {
 bool crossBlit(byte *dst, const byte *src, int dstpitch, int srcpitch,
 						int w, int h, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Blits a rectangle of paletted graphics, looking up the color of each
+ * pixel in a map.
+ *
+ * The map is usually filled once per palette change, with
+ * PixelFormat::RGBToColor() for each palette entry.
+ *
+ * @param dstbuf	the buffer which will recieve the converted graphics data
+ * @param srcbuf	the buffer containing the paletted graphics data
+ * @param dstpitch	width in bytes of one full line of the dest buffer
+ * @param srcpitch	width in bytes of one full line of the source buffer
+ * @param w			the width of the graphics data
+ * @param h			the height of the graphics data
+ * @param bytesPerPixel	the bytedepth of the destination
+ * @param map		the colors of all 256 palette entries
+ * @return			true if conversion completes successfully,
+ *					false if there is an error.
+ */
+bool crossBlitMap(byte *dst, const byte *src, int dstpitch, int srcpitch,
+						int w, int h, uint bytesPerPixel, const uint32 *map);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
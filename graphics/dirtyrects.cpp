@@ -0,0 +1,175 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/dirtyrects.h"
+
+namespace Graphics {
+
+DirtyRectSet::DirtyRectSet(uint maxRects, uint pixelCost, uint rectCost)
+	: _maxRects(maxRects), _pixelCost(pixelCost), _rectCost(rectCost), _pixels(0) {
+	assert(maxRects > 0);
+}
+
+void DirtyRectSet::setCosts(uint pixelCost, uint rectCost) {
+	_pixelCost = pixelCost;
+	_rectCost = rectCost;
+}
+
+void DirtyRectSet::add(const Common::Rect &r) {
+	if (r.isEmpty())
+		return;
+
+	_pending.push_back(r);
+
+	// Only the rect itself is merged with others. The pieces it is split
+	// into are not, as they could just be merged back together.
+	bool isPiece = false;
+
+	for (; !_pending.empty(); isPiece = true) {
+		Common::Rect rect = _pending.back();
+		_pending.pop_back();
+
+		bool covered = false;
+		uint i = 0;
+		while (i < _rects.size()) {
+			const Common::Rect &other = _rects[i];
+
+			if (other.contains(rect)) {
+				covered = true;
+				break;
+			}
+
+			if (rect.contains(other)) {
+				removeRect(i);
+				continue;
+			}
+
+			if (!isPiece) {
+				Common::Rect merged(rect);
+				merged.extend(other);
+
+				if (getCost(merged) <= getCost(rect) + getCost(other)) {
+					// The merged rect may now overlap rects which were
+					// checked before, so start over
+					removeRect(i);
+					rect = merged;
+					i = 0;
+					continue;
+				}
+			}
+
+			if (rect.intersects(other)) {
+				// Only add the parts which are not covered yet
+				splitRect(rect, other);
+				covered = true;
+				break;
+			}
+
+			i++;
+		}
+
+		if (covered)
+			continue;
+
+		if (_rects.size() == _maxRects) {
+			// No room left, so grow one of the rects instead, together
+			// with all the rects it overlaps then
+			const uint index = findCheapestMerge(rect);
+			rect.extend(_rects[index]);
+			removeRect(index);
+
+			i = 0;
+			while (i < _rects.size()) {
+				if (rect.intersects(_rects[i])) {
+					rect.extend(_rects[i]);
+					removeRect(i);
+					i = 0;
+				} else {
+					i++;
+				}
+			}
+		}
+
+		_rects.push_back(rect);
+		_pixels += getArea(rect);
+	}
+}
+
+Common::Rect DirtyRectSet::getBoundingBox() const {
+	if (_rects.empty())
+		return Common::Rect();
+
+	Common::Rect box(_rects[0]);
+	for (uint i = 1; i < _rects.size(); i++)
+		box.extend(_rects[i]);
+
+	return box;
+}
+
+bool DirtyRectSet::isBoundingBoxCheaper() const {
+	if (_rects.size() < 2)
+		return false;
+
+	return getCost(getBoundingBox()) <= _pixels * _pixelCost + _rects.size() * _rectCost;
+}
+
+void DirtyRectSet::removeRect(uint index) {
+	_pixels -= getArea(_rects[index]);
+	_rects[index] = _rects.back();
+	_rects.pop_back();
+}
+
+void DirtyRectSet::splitRect(const Common::Rect &r, const Common::Rect &covered) {
+	Common::Rect inner(r);
+	inner.clip(covered);
+
+	// Full width pieces above and below the covered part, and the parts
+	// left and right of it
+	if (r.top < inner.top)
+		_pending.push_back(Common::Rect(r.left, r.top, r.right, inner.top));
+	if (inner.bottom < r.bottom)
+		_pending.push_back(Common::Rect(r.left, inner.bottom, r.right, r.bottom));
+	if (r.left < inner.left)
+		_pending.push_back(Common::Rect(r.left, inner.top, inner.left, inner.bottom));
+	if (inner.right < r.right)
+		_pending.push_back(Common::Rect(inner.right, inner.top, r.right, inner.bottom));
+}
+
+uint DirtyRectSet::findCheapestMerge(const Common::Rect &r) const {
+	uint best = 0;
+	uint bestCost = 0xFFFFFFFF;
+
+	for (uint i = 0; i < _rects.size(); i++) {
+		Common::Rect merged(r);
+		merged.extend(_rects[i]);
+
+		const uint cost = getCost(merged) - getCost(_rects[i]);
+		if (cost < bestCost) {
+			best = i;
+			bestCost = cost;
+		}
+	}
+
+	return best;
+}
+
+} // End of namespace Graphics
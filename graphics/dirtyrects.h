@@ -0,0 +1,105 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_DIRTYRECTS_H
+#define GRAPHICS_DIRTYRECTS_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Graphics {
+
+/**
+ * A set of dirty rectangles, which are kept free of overlaps.
+ *
+ * Each rectangle which is added is merged with the rectangles already in
+ * the set whenever redrawing their bounding box is cheaper than redrawing
+ * them separately. This is decided with a simple cost model: redrawing a
+ * rectangle costs a fixed overhead plus a cost for each of its pixels.
+ * Adjacent strips of the same height, or rectangles which mostly overlap,
+ * are always merged. When the bounding box would be too expensive, the
+ * parts which are already covered by the set are cut away instead, so that
+ * no pixel has to be redrawn twice.
+ *
+ * The number of rectangles is limited: when the set is full, a new
+ * rectangle is merged with the one which makes that the cheapest.
+ */
+class DirtyRectSet {
+public:
+	typedef Common::Array<Common::Rect>::const_iterator const_iterator;
+
+	/**
+	 * @param maxRects	the maximum number of rectangles in the set
+	 * @param pixelCost	the cost of redrawing one pixel
+	 * @param rectCost	the overhead of redrawing a rectangle
+	 */
+	DirtyRectSet(uint maxRects, uint pixelCost = 1, uint rectCost = 256);
+
+	/**
+	 * Change the cost model, e.g. when another scaler is selected.
+	 * This only affects rectangles added afterwards.
+	 */
+	void setCosts(uint pixelCost, uint rectCost);
+
+	/** Add a rectangle to the set. Empty rectangles are ignored. */
+	void add(const Common::Rect &r);
+
+	/** Remove all rectangles from the set. */
+	void clear() { _rects.resize(0); _pixels = 0; }
+
+	bool empty() const { return _rects.empty(); }
+	uint size() const { return _rects.size(); }
+
+	const_iterator begin() const { return _rects.begin(); }
+	const_iterator end() const { return _rects.end(); }
+
+	/** Return the number of pixels covered by the set. */
+	uint getPixelCount() const { return _pixels; }
+
+	/** Return the bounding box of all rectangles in the set. */
+	Common::Rect getBoundingBox() const;
+
+	/**
+	 * Return whether redrawing the bounding box of the set is cheaper than
+	 * redrawing all of its rectangles one by one.
+	 */
+	bool isBoundingBoxCheaper() const;
+
+private:
+	static uint getArea(const Common::Rect &r) { return r.width() * r.height(); }
+	uint getCost(const Common::Rect &r) const { return getArea(r) * _pixelCost + _rectCost; }
+
+	void removeRect(uint index);
+	void splitRect(const Common::Rect &r, const Common::Rect &covered);
+	uint findCheapestMerge(const Common::Rect &r) const;
+
+	Common::Array<Common::Rect> _rects;
+	Common::Array<Common::Rect> _pending; ///< Rectangles which still have to be added
+	uint _maxRects;
+	uint _pixelCost;
+	uint _rectCost;
+	uint _pixels;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -43,23 +43,10 @@ static const uint8 _zigZagOrder[64] = {
 	53, 60, 61, 54, 47, 55, 62, 63
 };
 
-// IDCT table built with :
-// _idct8x8[x][y] = cos(((2 * x + 1) * y) * (M_PI / 16.0)) * 0.5;
-// _idct8x8[x][y] /= sqrt(2.0) if y == 0
-static const double _idct8x8[8][8] = {
-	{ 0.353553390593274,  0.490392640201615,  0.461939766255643,  0.415734806151273,  0.353553390593274,  0.277785116509801,  0.191341716182545,  0.097545161008064 },
-	{ 0.353553390593274,  0.415734806151273,  0.191341716182545, -0.097545161008064, -0.353553390593274, -0.490392640201615, -0.461939766255643, -0.277785116509801 },
-	{ 0.353553390593274,  0.277785116509801, -0.191341716182545, -0.490392640201615, -0.353553390593274,  0.097545161008064,  0.461939766255643,  0.415734806151273 },
-	{ 0.353553390593274,  0.097545161008064, -0.461939766255643, -0.277785116509801,  0.353553390593274,  0.415734806151273, -0.191341716182545, -0.490392640201615 },
-	{ 0.353553390593274, -0.097545161008064, -0.461939766255643,  0.277785116509801,  0.353553390593274, -0.415734806151273, -0.191341716182545,  0.490392640201615 },
-	{ 0.353553390593274, -0.277785116509801, -0.191341716182545,  0.490392640201615, -0.353553390593273, -0.097545161008064,  0.461939766255643, -0.415734806151273 },
-	{ 0.353553390593274, -0.415734806151273,  0.191341716182545,  0.097545161008064, -0.353553390593274,  0.490392640201615, -0.461939766255643,  0.277785116509801 },
-	{ 0.353553390593274, -0.490392640201615,  0.461939766255643, -0.415734806151273,  0.353553390593273, -0.277785116509801,  0.191341716182545, -0.097545161008064 }
-};
-
 JPEG::JPEG() :
-	_stream(NULL), _w(0), _h(0), _numComp(0), _components(NULL), _numScanComp(0),
-	_scanComp(NULL), _currentComp(NULL) {
+	_stream(NULL), _w(0), _h(0), _restartInterval(0), _numComp(0), _components(NULL),
+	_componentsDecoded(false), _numScanComp(0), _scanComp(NULL), _currentComp(NULL),
+	_scanData(NULL), _scanSize(0), _scanPos(0) {
 
 	// Initialize the quantization tables
 	for (int i = 0; i < JPEG_MAX_QUANT_TABLES; i++)
@@ -78,7 +65,7 @@ JPEG::~JPEG() {
 	reset();
 }
 
-Surface *JPEG::getSurface(const PixelFormat &format) {
+Surface *JPEG::getSurface(const PixelFormat &format, uint scale) {
 	// Make sure we have loaded data
 	if (!isLoaded())
 		return 0;
@@ -87,23 +74,30 @@ Surface *JPEG::getSurface(const PixelFormat &format) {
 	if (format.bytesPerPixel == 1)
 		return 0;
 
-	// Get our component surfaces
-	Graphics::Surface *yComponent = getComponent(1);
-	Graphics::Surface *uComponent = getComponent(2);
-	Graphics::Surface *vComponent = getComponent(3);
+	if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+		warning("JPEG: Unsupported scale factor %d", scale);
+		return 0;
+	}
+
+	// Only YUV and grayscale images are converted
+	if (_numComp != 3 && _numComp != 1) {
+		warning("JPEG: Can't convert %d components to RGB", _numComp);
+		return 0;
+	}
 
 	Graphics::Surface *output = new Graphics::Surface();
-	output->create(yComponent->w, yComponent->h, format);
-
-	for (uint16 i = 0; i < output->h; i++) {
-		for (uint16 j = 0; j < output->w; j++) {
-			byte r = 0, g = 0, b = 0;
-			YUV2RGB(*((byte *)yComponent->getBasePtr(j, i)), *((byte *)uComponent->getBasePtr(j, i)), *((byte *)vComponent->getBasePtr(j, i)), r, g, b);
-			if (format.bytesPerPixel == 2)
-				*((uint16 *)output->getBasePtr(j, i)) = format.RGBToColor(r, g, b);
-			else
-				*((uint32 *)output->getBasePtr(j, i)) = format.RGBToColor(r, g, b);
-		}
+	output->create((_w + scale - 1) / scale, (_h + scale - 1) / scale, format);
+
+	// Images made of several scans were already decoded while reading
+	if (_componentsDecoded && !_scanData) {
+		convertComponents(scale, output);
+		return output;
+	}
+
+	if (!decodeScan(scale, output)) {
+		output->free();
+		delete output;
+		return 0;
 	}
 
 	return output;
@@ -113,18 +107,24 @@ void JPEG::reset() {
 	// Reset member variables
 	_stream = NULL;
 	_w = _h = 0;
+	_restartInterval = 0;
 
 	// Free the components
 	for (int c = 0; c < _numComp; c++)
 		_components[c].surface.free();
 	delete[] _components; _components = NULL;
 	_numComp = 0;
+	_componentsDecoded = false;
 
 	// Free the scan components
 	delete[] _scanComp; _scanComp = NULL;
 	_numScanComp = 0;
 	_currentComp = NULL;
 
+	// Free the scan data
+	free(_scanData); _scanData = NULL;
+	_scanSize = 0;
+
 	// Free the quantization tables
 	for (int i = 0; i < JPEG_MAX_QUANT_TABLES; i++) {
 		delete[] _quant[i];
@@ -205,6 +205,9 @@ bool JPEG::read(Common::SeekableReadStream *stream) {
 		case 0xDB: // Define Quantization Tables
 			ok = readDQT();
 			break;
+		case 0xDD: // Define Restart Interval
+			ok = readDRI();
+			break;
 		case 0xE0: // JFIF/JFXX segment
 			ok = readJFIF();
 			break;
@@ -218,6 +221,8 @@ bool JPEG::read(Common::SeekableReadStream *stream) {
 		}
 		}
 	}
+
+	_stream = NULL;
 	return ok;
 }
 
@@ -283,6 +288,14 @@ bool JPEG::readSOF0() {
 		_components[c].factorV = _components[c].factorH & 0xF;
 		_components[c].factorH >>= 4;
 		_components[c].quantTableSelector = _stream->readByte();
+		_components[c].mcu = NULL;
+
+		if (_components[c].factorH < 1 || _components[c].factorH > 4 ||
+		    _components[c].factorV < 1 || _components[c].factorV > 4 ||
+		    _components[c].quantTableSelector >= JPEG_MAX_QUANT_TABLES) {
+			warning("JPEG: Invalid component");
+			return false;
+		}
 	}
 
 	return true;
@@ -299,52 +312,93 @@ bool JPEG::readDHT() {
 		uint8 tableId = _stream->readByte();
 		uint8 tableType = tableId >> 4; // type 0: DC, 1: AC
 		tableId &= 0xF;
+
+		if (tableType > 1 || tableId >= JPEG_MAX_HUFF_TABLES) {
+			warning("JPEG: Invalid Huffman table");
+			return false;
+		}
+
 		uint8 tableNum = (tableId << 1) + tableType;
+		HuffmanTable &table = _huff[tableNum];
 
 		// Free the Huffman table
-		delete[] _huff[tableNum].values; _huff[tableNum].values = NULL;
-		delete[] _huff[tableNum].sizes; _huff[tableNum].sizes = NULL;
-		delete[] _huff[tableNum].codes; _huff[tableNum].codes = NULL;
+		delete[] table.values; table.values = NULL;
+		delete[] table.sizes; table.sizes = NULL;
+		delete[] table.codes; table.codes = NULL;
 
 		// Read the number of values for each length
 		uint8 numValues[16];
-		_huff[tableNum].count = 0;
+		table.count = 0;
 		for (int len = 0; len < 16; len++) {
 			numValues[len] = _stream->readByte();
-			_huff[tableNum].count += numValues[len];
+			table.count += numValues[len];
+		}
+
+		if (table.count == 0 || table.count > 256) {
+			warning("JPEG: Invalid Huffman table");
+			return false;
 		}
 
 		// Allocate memory for the current table
-		_huff[tableNum].values = new uint8[_huff[tableNum].count];
-		_huff[tableNum].sizes = new uint8[_huff[tableNum].count];
-		_huff[tableNum].codes = new uint16[_huff[tableNum].count];
+		table.values = new uint8[table.count];
+		table.sizes = new uint8[table.count];
+		table.codes = new uint16[table.count];
 
 		// Read the table contents
 		int cur = 0;
 		for (int len = 0; len < 16; len++) {
 			for (int i = 0; i < numValues[len]; i++) {
-				_huff[tableNum].values[cur] = _stream->readByte();
-				_huff[tableNum].sizes[cur] = len + 1;
+				table.values[cur] = _stream->readByte();
+				table.sizes[cur] = len + 1;
 				cur++;
 			}
 		}
 
 		// Fill the table of Huffman codes
 		cur = 0;
-		uint16 curCode = 0;
-		uint8 curCodeSize = _huff[tableNum].sizes[0];
-		while (cur < _huff[tableNum].count) {
+		uint32 curCode = 0;
+		uint8 curCodeSize = table.sizes[0];
+		while (cur < table.count) {
 			// Increase the code size to fit the request
-			while (_huff[tableNum].sizes[cur] != curCodeSize) {
+			while (table.sizes[cur] != curCodeSize) {
 				curCode <<= 1;
 				curCodeSize++;
 			}
 
+			// Too many codes for their sizes would overflow the lookup table
+			if (curCode >= (1U << curCodeSize)) {
+				warning("JPEG: Invalid Huffman table");
+				return false;
+			}
+
 			// Assign the current code
-			_huff[tableNum].codes[cur] = curCode;
+			table.codes[cur] = curCode;
 			curCode++;
 			cur++;
 		}
+
+		// Build the decoding tables. The short codes take all lookup
+		// entries starting with them, the longer ones are found by
+		// comparing against the largest code of each size.
+		memset(table.lookup, 0, sizeof(table.lookup));
+		for (int len = 0; len <= 16; len++) {
+			table.maxCode[len] = -1;
+			table.valueOffset[len] = 0;
+		}
+
+		for (int i = 0; i < table.count; i++) {
+			const uint8 codeSize = table.sizes[i];
+
+			if (table.maxCode[codeSize] == -1)
+				table.valueOffset[codeSize] = i - table.codes[i];
+			table.maxCode[codeSize] = table.codes[i];
+
+			if (codeSize <= JPEG_HUFF_LOOKUP_BITS) {
+				const uint8 fill = JPEG_HUFF_LOOKUP_BITS - codeSize;
+				for (uint32 j = 0; j < (1U << fill); j++)
+					table.lookup[(table.codes[i] << fill) | j] = (codeSize << 8) | table.values[i];
+			}
+		}
 	}
 
 	return true;
@@ -357,19 +411,33 @@ bool JPEG::readSOS() {
 
 	// Number of scan components
 	_numScanComp = _stream->readByte();
-	if (size != 6 + 2 * _numScanComp) {
+	if (size != 6 + 2 * _numScanComp || _numScanComp == 0 || _numScanComp > _numComp) {
 		warning("JPEG: Invalid number of components");
 		return false;
 	}
 
+	// A buffered scan has to be decoded before its components are replaced
+	if (_scanData) {
+		if (!decodeComponents())
+			return false;
+
+		free(_scanData); _scanData = NULL;
+		_scanSize = 0;
+	}
+
 	// Allocate the new scan components
 	delete[] _scanComp;
 	_scanComp = new Component *[_numScanComp];
 
-	// Reset the maximum sampling factors
+	// The maximum sampling factors of the frame give the MCU size
 	_maxFactorV = 0;
 	_maxFactorH = 0;
 
+	for (int c = 0; c < _numComp; c++) {
+		_maxFactorV = MAX(_maxFactorV, _components[c].factorV);
+		_maxFactorH = MAX(_maxFactorH, _components[c].factorH);
+	}
+
 	// Component-specification parameters
 	for (int c = 0; c < _numScanComp; c++) {
 		// Read the desired component id
@@ -397,15 +465,11 @@ bool JPEG::readSOS() {
 		_scanComp[c]->ACentropyTableSelector = _scanComp[c]->DCentropyTableSelector & 0xF;
 		_scanComp[c]->DCentropyTableSelector >>= 4;
 
-		// Calculate the maximum sampling factors
-		if (_scanComp[c]->factorV > _maxFactorV)
-			_maxFactorV = _scanComp[c]->factorV;
-
-		if (_scanComp[c]->factorH > _maxFactorH)
-			_maxFactorH = _scanComp[c]->factorH;
-
-		// Initialize the DC predictor
-		_scanComp[c]->DCpredictor = 0;
+		if (_scanComp[c]->DCentropyTableSelector >= JPEG_MAX_HUFF_TABLES ||
+		    _scanComp[c]->ACentropyTableSelector >= JPEG_MAX_HUFF_TABLES) {
+			warning("JPEG: Invalid Huffman table");
+			return false;
+		}
 	}
 
 	// Start of spectral selection
@@ -426,37 +490,71 @@ bool JPEG::readSOS() {
 		return false;
 	}
 
-	// Entropy coded sequence starts, initialize Huffman decoder
-	_bitsNumber = 0;
+	if (!readScanData())
+		return false;
 
-	// Read all the scan MCUs
-	uint16 xMCU = _w / (_maxFactorH * 8);
-	uint16 yMCU = _h / (_maxFactorV * 8);
+	// A single scan of all components is decoded when the image is
+	// requested, in the desired form
+	if (_numScanComp == _numComp && !_componentsDecoded)
+		return true;
 
-	// Check for non- multiple-of-8 dimensions
-	if (_w % (_maxFactorH * 8) != 0)
-		xMCU++;
-	if (_h % (_maxFactorV * 8) != 0)
-		yMCU++;
+	// Otherwise the image is split into several scans, which are decoded
+	// one by one into the component surfaces
+	bool ok = decodeComponents();
 
-	// Initialize the scan surfaces
-	for (uint16 c = 0; c < _numScanComp; c++) {
-		_scanComp[c]->surface.create(xMCU * _maxFactorH * 8, yMCU * _maxFactorV * 8, PixelFormat::createFormatCLUT8());
-	}
+	free(_scanData); _scanData = NULL;
+	_scanSize = 0;
 
-	bool ok = true;
-	for (int y = 0; ok && (y < yMCU); y++)
-		for (int x = 0; ok && (x < xMCU); x++)
-			ok = readMCU(x, y);
+	return ok;
+}
+
+bool JPEG::readScanData() {
+	// Copy the entropy coded data up to the next marker, keeping the
+	// stuffed bytes and the restart markers in it
+	uint32 capacity = 0;
+	byte buffer[4096];
+	bool prevFF = false;
+
+	for (;;) {
+		const uint32 chunkStart = _stream->pos();
+		const uint32 chunkSize = _stream->read(buffer, sizeof(buffer));
+
+		uint32 end = chunkSize;
+		bool found = false;
+		for (uint32 i = 0; i < chunkSize; i++) {
+			if (prevFF && buffer[i] != 0 && (buffer[i] < 0xD0 || buffer[i] > 0xD7)) {
+				// A marker, starting with the previous byte
+				end = i;
+				found = true;
+				break;
+			}
+
+			prevFF = (buffer[i] == 0xFF);
+		}
+
+		if (_scanSize + end > capacity) {
+			capacity = MAX<uint32>(capacity * 2, _scanSize + end);
+			_scanData = (byte *)realloc(_scanData, capacity);
+		}
+
+		memcpy(_scanData + _scanSize, buffer, end);
+		_scanSize += end;
+
+		if (found) {
+			// Leave the stream at the marker, and its 0xFF out of the data
+			_scanSize--;
+			_stream->seek(chunkStart + end - 1);
+			break;
+		}
 
-	// Trim Component surfaces back to image height and width
-	// Note: Code using jpeg must use surface.pitch correctly...
-	for (uint16 c = 0; c < _numScanComp; c++) {
-		_scanComp[c]->surface.w = _w;
-		_scanComp[c]->surface.h = _h;
+		if (chunkSize < sizeof(buffer))
+			break;
 	}
 
-	return ok;
+	if (!_scanData)
+		_scanData = (byte *)malloc(1);
+
+	return true;
 }
 
 // Marker 0xDB (Define Quantization Tables)
@@ -472,7 +570,7 @@ bool JPEG::readDQT() {
 
 		// Validate the table id
 		tableId &= 0xF;
-		if (tableId > JPEG_MAX_QUANT_TABLES) {
+		if (tableId >= JPEG_MAX_QUANT_TABLES) {
 			warning("JPEG: Invalid number of components");
 			return false;
 		}
@@ -489,119 +587,267 @@ bool JPEG::readDQT() {
 	return true;
 }
 
-bool JPEG::readMCU(uint16 xMCU, uint16 yMCU) {
-	bool ok = true;
-	for (int c = 0; ok && (c < _numComp); c++) {
-		// Set the current component
-		_currentComp = _scanComp[c];
-
-		// Read the data units of the current component
-		for (int y = 0; ok && (y < _scanComp[c]->factorV); y++)
-			for (int x = 0; ok && (x < _scanComp[c]->factorH); x++)
-				ok = readDataUnit(xMCU * _scanComp[c]->factorH + x, yMCU * _scanComp[c]->factorV + y);
+// Marker 0xDD (Define Restart Interval)
+bool JPEG::readDRI() {
+	debug(5, "JPEG: readDRI");
+	if (_stream->readUint16BE() != 4) {
+		warning("JPEG: Invalid restart interval");
+		return false;
 	}
 
-	return ok;
+	_restartInterval = _stream->readUint16BE();
+	return true;
 }
 
-void JPEG::idct8x8(float result[64], const int16 dct[64]) {
-	float tmp[64];
-
-	// Apply 1D IDCT to rows
-	for (int y = 0; y < 8; y++) {
-		for (int x = 0; x < 8; x++) {
-			tmp[y + x * 8] = dct[0] * _idct8x8[x][0]
-			                 + dct[1] * _idct8x8[x][1]
-			                 + dct[2] * _idct8x8[x][2]
-			                 + dct[3] * _idct8x8[x][3]
-			                 + dct[4] * _idct8x8[x][4]
-			                 + dct[5] * _idct8x8[x][5]
-			                 + dct[6] * _idct8x8[x][6]
-			                 + dct[7] * _idct8x8[x][7];
+bool JPEG::decodeScan(uint scale, Surface *output) {
+	if (!_scanData) {
+		warning("JPEG: No scan to decode");
+		return false;
+	}
+
+	// Fold the AAN scale factors of the IDCT into the dequantization,
+	// scaling the coefficients up by 4 for precision
+	for (int t = 0; t < JPEG_MAX_QUANT_TABLES; t++) {
+		if (!_quant[t])
+			continue;
+
+		for (int i = 0; i < 64; i++)
+			_dequant[t][i] = (_quant[t][i] * idctAANScales[_zigZagOrder[i]] + (1 << 11)) >> 12;
+	}
+
+	for (int c = 0; c < _numScanComp; c++) {
+		if (!_quant[_scanComp[c]->quantTableSelector] ||
+		    !_huff[_scanComp[c]->DCentropyTableSelector << 1].values ||
+		    !_huff[(_scanComp[c]->ACentropyTableSelector << 1) + 1].values) {
+			warning("JPEG: Missing tables for the scan");
+			return false;
 		}
+	}
 
-		dct += 8;
-	}
-
-	// Apply 1D IDCT to columns
-	for (int x = 0; x < 8; x++) {
-		const float *u = tmp + x * 8;
-		for (int y = 0; y < 8; y++) {
-			result[y * 8 + x] = u[0] * _idct8x8[y][0]
-			                    + u[1] * _idct8x8[y][1]
-			                    + u[2] * _idct8x8[y][2]
-			                    + u[3] * _idct8x8[y][3]
-			                    + u[4] * _idct8x8[y][4]
-			                    + u[5] * _idct8x8[y][5]
-			                    + u[6] * _idct8x8[y][6]
-			                    + u[7] * _idct8x8[y][7];
+	// The MCUs of scans with a single component are made of a single
+	// block, otherwise of the blocks given by the sampling factors
+	for (int c = 0; c < _numScanComp; c++) {
+		_scanComp[c]->blocksH = (_numScanComp == 1) ? 1 : _scanComp[c]->factorH;
+		_scanComp[c]->blocksV = (_numScanComp == 1) ? 1 : _scanComp[c]->factorV;
+	}
+
+	// Allocate the MCU buffers of the components
+	for (int c = 0; c < _numScanComp; c++) {
+		_scanComp[c]->mcuPitch = _scanComp[c]->blocksH * 8 / scale;
+		_scanComp[c]->mcu = new byte[_scanComp[c]->mcuPitch * _scanComp[c]->blocksV * 8 / scale];
+		_scanComp[c]->DCpredictor = 0;
+	}
+
+	// Entropy coded sequence starts, initialize Huffman decoder
+	_scanPos = 0;
+	_bitsData = 0;
+	_bitsNumber = 0;
+
+	// Read all the scan MCUs, including the partial ones at the right
+	// and bottom edges
+	uint16 xMCU, yMCU;
+	if (_numScanComp == 1) {
+		const Component *comp = _scanComp[0];
+		const uint16 compW = (_w * comp->factorH + _maxFactorH - 1) / _maxFactorH;
+		const uint16 compH = (_h * comp->factorV + _maxFactorV - 1) / _maxFactorV;
+		xMCU = (compW + 7) / 8;
+		yMCU = (compH + 7) / 8;
+	} else {
+		xMCU = (_w + _maxFactorH * 8 - 1) / (_maxFactorH * 8);
+		yMCU = (_h + _maxFactorV * 8 - 1) / (_maxFactorV * 8);
+	}
+
+	uint16 restartsLeft = _restartInterval;
+	for (int y = 0; y < yMCU; y++) {
+		for (int x = 0; x < xMCU; x++) {
+			if (_restartInterval) {
+				if (restartsLeft == 0) {
+					restart();
+					restartsLeft = _restartInterval;
+				}
+				restartsLeft--;
+			}
+
+			decodeMCU(scale);
+
+			if (output)
+				writeRGB(x, y, scale, output);
+			else
+				writeComponents(x, y);
 		}
 	}
+
+	for (int c = 0; c < _numScanComp; c++) {
+		delete[] _scanComp[c]->mcu;
+		_scanComp[c]->mcu = NULL;
+	}
+
+	return true;
 }
 
-bool JPEG::readDataUnit(uint16 x, uint16 y) {
-	// Prepare an empty data array
-	int16 readData[64];
-	for (int i = 1; i < 64; i++)
-		readData[i] = 0;
+void JPEG::restart() {
+	// Drop the bits left before the restart marker, and the marker itself
+	_bitsData = 0;
+	_bitsNumber = 0;
 
-	// Read the DC component
-	readData[0] = _currentComp->DCpredictor + readDC();
-	_currentComp->DCpredictor = readData[0];
+	if (_scanPos + 1 < _scanSize && _scanData[_scanPos] == 0xFF &&
+	    _scanData[_scanPos + 1] >= 0xD0 && _scanData[_scanPos + 1] <= 0xD7)
+		_scanPos += 2;
+	else
+		warning("JPEG: Restart marker missing");
 
-	// Read the AC components (stored in Zig-Zag)
-	readAC(readData);
+	for (int c = 0; c < _numScanComp; c++)
+		_scanComp[c]->DCpredictor = 0;
+}
 
-	// Calculate the DCT coefficients from the input sequence
-	int16 DCT[64];
-	for (uint8 i = 0; i < 64; i++) {
-		// Dequantize
-		int16 val = readData[i];
-		int16 quant = _quant[_currentComp->quantTableSelector][i];
-		val *= quant;
+void JPEG::decodeMCU(uint scale) {
+	for (int c = 0; c < _numScanComp; c++) {
+		// Set the current component
+		_currentComp = _scanComp[c];
 
-		// Store the normalized coefficients, undoing the Zig-Zag
-		DCT[_zigZagOrder[i]] = val;
+		// Read the data units of the current component
+		const uint16 blockSize = 8 / scale;
+		for (int y = 0; y < _currentComp->blocksV; y++)
+			for (int x = 0; x < _currentComp->blocksH; x++)
+				decodeBlock(_currentComp->mcu + y * blockSize * _currentComp->mcuPitch + x * blockSize, _currentComp->mcuPitch, scale);
 	}
+}
 
-	// Apply the IDCT
-	float result[64];
-	idct8x8(result, DCT);
+void JPEG::decodeBlock(byte *dst, uint16 pitch, uint scale) {
+	// Read the DC component
+	_currentComp->DCpredictor += readDC();
 
-	// Level shift to make the values unsigned
-	for (int i = 0; i < 64; i++) {
-		result[i] = result[i] + 128;
+	const int32 *dequant = _dequant[_currentComp->quantTableSelector];
 
-		if (result[i] < 0)
-			result[i] = 0;
+	// Prepare the coefficients, in natural order
+	int16 coeffs[64];
+	memset(coeffs, 0, sizeof(coeffs));
+	coeffs[0] = CLIP<int32>(_currentComp->DCpredictor * dequant[0], -32768, 32767);
 
-		if (result[i] > 255)
-			result[i] = 255;
+	// Read the AC components (stored in Zig-Zag)
+	int16 acValues[64];
+	const uint8 last = readAC(acValues);
+
+	// A block of just the DC component has the same value everywhere, which is
+	// also the value of the reduced blocks. The IDCT would give the same.
+	if (last == 0 || scale == 8) {
+		const byte value = CLIP<int>(((coeffs[0] + 16) >> 5) + 128, 0, 255);
+		for (uint y = 0; y < 8 / scale; y++)
+			memset(dst + y * pitch, value, 8 / scale);
+		return;
 	}
 
-	// Paint the component surface
-	uint8 scalingV = _maxFactorV / _currentComp->factorV;
-	uint8 scalingH = _maxFactorH / _currentComp->factorH;
+	// Dequantize, undoing the Zig-Zag
+	for (uint8 i = 1; i <= last; i++) {
+		if (acValues[i])
+			coeffs[_zigZagOrder[i]] = CLIP<int32>(acValues[i] * dequant[i], -32768, 32767);
+	}
 
-	// Convert coordinates from MCU blocks to pixels
-	x <<= 3;
-	y <<= 3;
+	if (scale == 1) {
+		idctAAN8x8(dst, pitch, coeffs);
+		return;
+	}
+
+	// Reduce the block by averaging the samples
+	byte samples[64];
+	idctAAN8x8(samples, 8, coeffs);
+
+	const uint shift = (scale == 2) ? 2 : 4;
+	for (uint y = 0; y < 8; y += scale) {
+		for (uint x = 0; x < 8; x += scale) {
+			uint sum = 0;
+			for (uint j = 0; j < scale; j++)
+				for (uint i = 0; i < scale; i++)
+					sum += samples[(y + j) * 8 + x + i];
 
-	for (uint8 j = 0; j < 8; j++) {
-		for (uint16 sV = 0; sV < scalingV; sV++) {
-			// Get the beginning of the block line
-			byte *ptr = (byte *)_currentComp->surface.getBasePtr(x * scalingH, (y + j) * scalingV + sV);
+			dst[(y / scale) * pitch + x / scale] = (sum + (1 << (shift - 1))) >> shift;
+		}
+	}
+}
 
-			for (uint8 i = 0; i < 8; i++) {
-				for (uint16 sH = 0; sH < scalingH; sH++) {
-					*ptr = (byte)(result[j * 8 + i]);
-					ptr++;
+void JPEG::writeComponents(uint16 xMCU, uint16 yMCU) {
+	// Paint the component surfaces, upsampling the components to the
+	// maximum sampling factors
+	for (int c = 0; c < _numScanComp; c++) {
+		Component *comp = _scanComp[c];
+		const uint8 scalingV = _maxFactorV / comp->factorV;
+		const uint8 scalingH = _maxFactorH / comp->factorH;
+		const uint16 w = comp->blocksH * 8;
+		const uint16 h = comp->blocksV * 8;
+
+		for (uint16 j = 0; j < h; j++) {
+			const byte *src = comp->mcu + j * comp->mcuPitch;
+
+			for (uint16 sV = 0; sV < scalingV; sV++) {
+				// Get the beginning of the block line
+				byte *ptr = (byte *)comp->surface.getBasePtr(xMCU * w * scalingH, (yMCU * h + j) * scalingV + sV);
+
+				if (scalingH == 1) {
+					memcpy(ptr, src, w);
+					continue;
 				}
+
+				for (uint16 i = 0; i < w; i++)
+					for (uint16 sH = 0; sH < scalingH; sH++)
+						*ptr++ = src[i];
 			}
 		}
 	}
+}
 
-	return true;
+/** Convert a row of samples to RGB, the indices mapping the pixels to the samples of each component. */
+template<typename PixelInt>
+static void convertRow(PixelInt *dst, uint16 w, const PixelFormat &format, const byte *y, const byte *u, const byte *v,
+                       const uint8 *yIndex, const uint8 *uIndex, const uint8 *vIndex) {
+	for (uint16 i = 0; i < w; i++) {
+		byte r, g, b;
+		if (u)
+			YUV2RGB(y[yIndex[i]], u[uIndex[i]], v[vIndex[i]], r, g, b);
+		else
+			r = g = b = y[yIndex[i]];
+
+		*dst++ = format.RGBToColor(r, g, b);
+	}
+}
+
+void JPEG::writeRGB(uint16 xMCU, uint16 yMCU, uint scale, Surface *output) {
+	const Component &first = _components[0];
+	const uint16 mcuW = first.blocksH * (_maxFactorH / first.factorH) * 8 / scale;
+	const uint16 mcuH = first.blocksV * (_maxFactorV / first.factorV) * 8 / scale;
+	const uint16 x0 = xMCU * mcuW;
+	const uint16 y0 = yMCU * mcuH;
+
+	// Clip the MCU to the image
+	const uint16 w = MIN<uint16>(mcuW, output->w - x0);
+	const uint16 h = MIN<uint16>(mcuH, output->h - y0);
+
+	// Components might be subsampled, so map the pixels of the MCU to their
+	// samples. Grayscale images only have the Y component.
+	const bool grayscale = (_numComp == 1);
+	const int numComp = grayscale ? 1 : 3;
+	uint8 colIndex[3][32];
+	uint8 divV[3];
+
+	for (int c = 0; c < numComp; c++) {
+		const uint8 divH = _maxFactorH / _components[c].factorH;
+		divV[c] = _maxFactorV / _components[c].factorV;
+
+		for (uint16 i = 0; i < w; i++)
+			colIndex[c][i] = i / divH;
+	}
+
+	for (uint16 j = 0; j < h; j++) {
+		const byte *rows[3] = { 0, 0, 0 };
+		for (int c = 0; c < numComp; c++)
+			rows[c] = _components[c].mcu + (j / divV[c]) * _components[c].mcuPitch;
+
+		void *dst = output->getBasePtr(x0, y0 + j);
+
+		if (output->format.bytesPerPixel == 2)
+			convertRow<uint16>((uint16 *)dst, w, output->format, rows[0], rows[1], rows[2], colIndex[0], colIndex[1], colIndex[2]);
+		else
+			convertRow<uint32>((uint32 *)dst, w, output->format, rows[0], rows[1], rows[2], colIndex[0], colIndex[1], colIndex[2]);
+	}
 }
 
 int16 JPEG::readDC() {
@@ -615,12 +861,13 @@ int16 JPEG::readDC() {
 	return readSignedBits(numBits);
 }
 
-void JPEG::readAC(int16 *out) {
+uint8 JPEG::readAC(int16 *out) {
 	// AC is type 1
 	uint8 tableNum = (_currentComp->ACentropyTableSelector << 1) + 1;
 
-	// Start reading AC element 1
+	// Start reading AC element 1, and remember the last one read
 	uint8 cur = 1;
+	uint8 last = 0;
 	while (cur < 64) {
 		uint8 s = readHuff(tableNum);
 		uint8 r = s >> 4;
@@ -632,26 +879,66 @@ void JPEG::readAC(int16 *out) {
 				cur += 16;
 			} else {
 				// EOB: end of block
-				cur = 64;
+				break;
 			}
 		} else {
 			// Skip r values
 			cur += r;
+			if (cur >= 64) {
+				warning("JPEG: Too many AC coefficients");
+				break;
+			}
 
 			// Read the next value
+			for (uint8 i = last + 1; i < cur; i++)
+				out[i] = 0;
 			out[cur] = readSignedBits(s);
+			last = cur;
 			cur++;
 		}
 	}
+
+	return last;
+}
+
+void JPEG::fillBits() {
+	// Keep at least 25 bits in the buffer, feeding zeros after the
+	// end of the data, or when running into a marker
+	while (_bitsNumber <= 24) {
+		byte data = 0;
+
+		if (_scanPos < _scanSize) {
+			data = _scanData[_scanPos];
+
+			if (data != 0xFF) {
+				_scanPos++;
+			} else if (_scanPos + 1 < _scanSize && _scanData[_scanPos + 1] == 0) {
+				// A stuffed 0 validates the previous byte
+				_scanPos += 2;
+			} else {
+				// Restart marker, or the end of the data
+				data = 0;
+			}
+		}
+
+		_bitsData |= (uint32)data << (24 - _bitsNumber);
+		_bitsNumber += 8;
+	}
 }
 
 int16 JPEG::readSignedBits(uint8 numBits) {
-	uint16 ret = 0;
-	if (numBits > 16) error("requested %d bits", numBits); //XXX
+	if (numBits == 0)
+		return 0;
+
+	if (numBits > 16)
+		error("requested %d bits", numBits); //XXX
+
+	fillBits();
 
 	// MSB=0 for negatives, 1 for positives
-	for (int i = 0; i < numBits; i++)
-		ret = (ret << 1) + readBit();
+	uint16 ret = _bitsData >> (32 - numBits);
+	_bitsData <<= numBits;
+	_bitsNumber -= numBits;
 
 	// Extend sign bits (PAG109)
 	if (!(ret >> (numBits - 1))) {
@@ -661,65 +948,98 @@ int16 JPEG::readSignedBits(uint8 numBits) {
 	return ret;
 }
 
-// TODO: optimize?
 uint8 JPEG::readHuff(uint8 table) {
-	bool foundCode = false;
-	uint8 val = 0;
-
-	uint8 cur = 0;
-	uint8 codeSize = 1;
-	uint16 code = readBit();
-	while (!foundCode) {
-		// Prepare a code of the current size
-		while (codeSize < _huff[table].sizes[cur]) {
-			code = (code << 1) + readBit();
-			codeSize++;
+	const HuffmanTable &huff = _huff[table];
+
+	fillBits();
+
+	// Short codes are looked up directly
+	const uint16 entry = huff.lookup[_bitsData >> (32 - JPEG_HUFF_LOOKUP_BITS)];
+	if (entry) {
+		const uint8 size = entry >> 8;
+		_bitsData <<= size;
+		_bitsNumber -= size;
+		return entry & 0xFF;
+	}
+
+	// Longer codes are compared against the largest code of each size
+	for (uint8 size = JPEG_HUFF_LOOKUP_BITS + 1; size <= 16; size++) {
+		const int32 code = _bitsData >> (32 - size);
+
+		if (code <= huff.maxCode[size]) {
+			const int32 index = code + huff.valueOffset[size];
+			if (index < 0 || index >= huff.count)
+				break;
+
+			_bitsData <<= size;
+			_bitsNumber -= size;
+			return huff.values[index];
 		}
+	}
 
-		// Compare the codes of the current size
-		while (!foundCode && (codeSize == _huff[table].sizes[cur])) {
-			if (code == _huff[table].codes[cur]) {
-				// Found the code
-				val = _huff[table].values[cur];
-				foundCode = true;
-			} else {
-				// Continue reading
-				cur++;
-			}
+	warning("JPEG: Invalid Huffman code");
+	_bitsData <<= 16;
+	_bitsNumber -= 16;
+	return 0;
+}
+
+bool JPEG::decodeComponents() {
+	if (!_componentsDecoded) {
+		uint16 xMCU = (_w + _maxFactorH * 8 - 1) / (_maxFactorH * 8);
+		uint16 yMCU = (_h + _maxFactorV * 8 - 1) / (_maxFactorV * 8);
+
+		for (uint16 i = 0; i < _numComp; i++) {
+			_components[i].surface.create(xMCU * _maxFactorH * 8, yMCU * _maxFactorV * 8, PixelFormat::createFormatCLUT8());
+
+			// Trim Component surfaces back to image height and width
+			// Note: Code using jpeg must use surface.pitch correctly...
+			_components[i].surface.w = _w;
+			_components[i].surface.h = _h;
 		}
+
+		_componentsDecoded = true;
 	}
 
-	return val;
+	return decodeScan(1, 0);
 }
 
-uint8 JPEG::readBit() {
-	// Read a whole byte if necessary
-	if (_bitsNumber == 0) {
-		_bitsData = _stream->readByte();
-		_bitsNumber = 8;
-
-		// Detect markers
-		if (_bitsData == 0xFF) {
-			uint8 byte2 = _stream->readByte();
-
-			// A stuffed 0 validates the previous byte
-			if (byte2 != 0) {
-				if (byte2 == 0xDC) {
-					// DNL marker: Define Number of Lines
-					// TODO: terminate scan
-					warning("DNL marker detected: terminate scan");
-				} else {
-					warning("Error: marker 0x%02X read in entropy data", byte2);
-				}
+void JPEG::convertComponents(uint scale, Surface *output) {
+	// Average the samples of each component covered by the output pixels
+	const bool grayscale = (_numComp == 1);
+	const uint shift = (scale == 8) ? 6 : (scale == 4) ? 4 : (scale == 2) ? 2 : 0;
+
+	for (uint16 y = 0; y < output->h; y++) {
+		for (uint16 x = 0; x < output->w; x++) {
+			byte values[3] = { 0, 0, 0 };
+
+			for (int c = 0; c < (grayscale ? 1 : 3); c++) {
+				uint sum = 0;
+				for (uint j = 0; j < scale; j++)
+					for (uint i = 0; i < scale; i++)
+						sum += *(const byte *)_components[c].surface.getBasePtr(MIN<uint>(x * scale + i, _w - 1), MIN<uint>(y * scale + j, _h - 1));
+
+				values[c] = (sum + ((1 << shift) >> 1)) >> shift;
 			}
+
+			byte r, g, b;
+			if (grayscale)
+				r = g = b = values[0];
+			else
+				YUV2RGB(values[0], values[1], values[2], r, g, b);
+
+			if (output->format.bytesPerPixel == 2)
+				*(uint16 *)output->getBasePtr(x, y) = output->format.RGBToColor(r, g, b);
+			else
+				*(uint32 *)output->getBasePtr(x, y) = output->format.RGBToColor(r, g, b);
 		}
 	}
-	_bitsNumber--;
-
-	return (_bitsData & (1 << _bitsNumber)) ? 1 : 0;
 }
 
 Surface *JPEG::getComponent(uint c) {
+	// Decode the scan into the component surfaces on first use
+	if (!_componentsDecoded && isLoaded() && _scanData)
+		decodeComponents();
+
 	for (int i = 0; i < _numComp; i++)
 		if (_components[i].id == c) // We found the desired component
 			return &_components[i].surface;
@@ -36,6 +36,9 @@ struct PixelFormat;
 #define JPEG_MAX_QUANT_TABLES 4
 #define JPEG_MAX_HUFF_TABLES 2
 
+// Number of bits looked up at once when decoding Huffman codes
+#define JPEG_HUFF_LOOKUP_BITS 9
+
 class JPEG {
 public:
 	JPEG();
@@ -47,13 +50,24 @@ public:
 	uint16 getHeight() const { return _h; }
 
 	Surface *getComponent(uint c);
-	Surface *getSurface(const PixelFormat &format);
+
+	/**
+	 * Decode the image into a new surface of the given format. The image
+	 * data is converted to RGB right after decoding each MCU, without
+	 * building the component surfaces first.
+	 *
+	 * @param format the pixel format of the surface, with 2 or 4 bytes per pixel
+	 * @param scale  reduce the image size by this factor: 1, 2, 4 or 8
+	 * @return the new surface, which the caller has to free, or 0 on failure
+	 */
+	Surface *getSurface(const PixelFormat &format, uint scale = 1);
 
 private:
 	void reset();
 
 	Common::SeekableReadStream *_stream;
 	uint16 _w, _h;
+	uint16 _restartInterval;
 
 	// Image components
 	uint8 _numComp;
@@ -68,6 +82,12 @@ private:
 		uint8 DCentropyTableSelector;
 		uint8 ACentropyTableSelector;
 		int16 DCpredictor;
+		uint8 blocksH;
+		uint8 blocksV;
+
+		// Samples of the MCU being decoded
+		byte *mcu;
+		uint16 mcuPitch;
 
 		// Result image for this component
 		Surface surface;
@@ -75,6 +95,10 @@ private:
 
 	Component *_components;
 
+	// Whether the component surfaces hold the image. Scans which do not
+	// interleave all components are decoded into them right away.
+	bool _componentsDecoded;
+
 	// Scan components
 	uint8 _numScanComp;
 	Component **_scanComp;
@@ -87,38 +111,83 @@ private:
 	// Quantization tables
 	uint16 *_quant[JPEG_MAX_QUANT_TABLES];
 
+	// Dequantization multipliers of the current scan, scaled for the IDCT
+	int32 _dequant[JPEG_MAX_QUANT_TABLES][64];
+
 	// Huffman tables
 	struct HuffmanTable {
-		uint8 count;
+		uint16 count;
 		uint8 *values;
 		uint8 *sizes;
 		uint16 *codes;
+
+		// Size and value of the codes starting with the looked up bits, 0 for longer codes
+		uint16 lookup[1 << JPEG_HUFF_LOOKUP_BITS];
+		// Largest code of each size, -1 if there's none
+		int32 maxCode[17];
+		// Offset from the codes of each size to their values
+		int32 valueOffset[17];
 	} _huff[2 * JPEG_MAX_HUFF_TABLES];
 
+	// Entropy coded data of the scan
+	byte *_scanData;
+	uint32 _scanSize;
+	uint32 _scanPos;
+
 	// Marker read functions
 	bool readJFIF();
 	bool readSOF0();
 	bool readDHT();
 	bool readSOS();
 	bool readDQT();
+	bool readDRI();
+	bool readScanData();
 
 	// Helper functions
-	bool readMCU(uint16 xMCU, uint16 yMCU);
-	bool readDataUnit(uint16 x, uint16 y);
+	bool decodeScan(uint scale, Surface *output);
+	bool decodeComponents();
+	void convertComponents(uint scale, Surface *output);
+	void decodeMCU(uint scale);
+	void decodeBlock(byte *dst, uint16 pitch, uint scale);
 	int16 readDC();
-	void readAC(int16 *out);
+	uint8 readAC(int16 *out);
 	int16 readSignedBits(uint8 numBits);
+	void restart();
+	void writeComponents(uint16 xMCU, uint16 yMCU);
+	void writeRGB(uint16 xMCU, uint16 yMCU, uint scale, Surface *output);
 
 	// Huffman decoding
 	uint8 readHuff(uint8 table);
-	uint8 readBit();
-	uint8 _bitsData;
+	void fillBits();
+	uint32 _bitsData;
 	uint8 _bitsNumber;
-
-	// Inverse Discrete Cosine Transformation
-	void idct8x8(float dst[64], const int16 src[64]);
 };
 
+/**
+ * Apply the inverse DCT to an 8x8 block of coefficients and store the
+ * level shifted, clipped samples.
+ *
+ * This is the integer AAN algorithm, which expects the coefficients in
+ * natural order, dequantized with the AAN scale factors folded in and
+ * scaled up by 4. On hosts with SSE2 it is vectorized; the result is
+ * always bit-identical to idctAAN8x8Scalar(), as long as the intermediate
+ * values fit into 16 bits, which they do for valid 8 bit JPEG data.
+ *
+ * @param dst   the top left sample of the block
+ * @param pitch the distance between two rows of samples
+ * @param src   the 64 coefficients
+ */
+void idctAAN8x8(byte *dst, int pitch, const int16 src[64]);
+
+/**
+ * Plain C implementation of idctAAN8x8(). Serves as reference for the
+ * optimized variants and as fallback on hosts without SIMD support.
+ */
+void idctAAN8x8Scalar(byte *dst, int pitch, const int16 src[64]);
+
+/** The AAN scale factors of the coefficients in natural order, scaled by 2^14. */
+extern const uint16 idctAANScales[64];
+
 } // End of Graphics namespace
 
 #endif // GRAPHICS_JPEG_H
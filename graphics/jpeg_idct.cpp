@@ -0,0 +1,237 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The integer AAN (Arai, Agui, Nakajima) IDCT, following the structure of
+// the one in the Independent JPEG Group's libjpeg.
+
+#include "graphics/jpeg.h"
+
+#include "common/sse2.h"
+#include "common/util.h"
+
+namespace Graphics {
+
+const uint16 idctAANScales[64] = {
+	16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+	22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+	21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+	19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+	16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+	12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+	 8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+	 4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+};
+
+// The multiplications by the AAN constants are done with 16 bit fractions,
+// plus an integer part, so that the SSE2 version can use the high half of
+// a 16 bit multiplication and still produce the same results.
+enum {
+	kFrac1_414213562 = 27146,  // 1.414213562 - 1
+	kFrac1_847759065 = -9977,  // 1.847759065 - 2
+	kFrac1_082392200 = 5400,   // 1.082392200 - 1
+	kFrac2_613125930 = 25354   // 3 - 2.613125930
+};
+
+static inline int multiply1_414(int v) { return ((v * kFrac1_414213562) >> 16) + v; }
+static inline int multiply1_847(int v) { return ((v * kFrac1_847759065) >> 16) + 2 * v; }
+static inline int multiply1_082(int v) { return ((v * kFrac1_082392200) >> 16) + v; }
+static inline int multiplyMinus2_613(int v) { return ((v * kFrac2_613125930) >> 16) - 3 * v; }
+
+/** One-dimensional IDCT of the 8 values at v[0], v[stride], ... v[7 * stride]. */
+static inline void idctAAN1D(int *v, int stride) {
+	// Even part
+	const int tmp10 = v[0] + v[4 * stride];
+	const int tmp11 = v[0] - v[4 * stride];
+	const int tmp13 = v[2 * stride] + v[6 * stride];
+	const int tmp12 = multiply1_414(v[2 * stride] - v[6 * stride]) - tmp13;
+
+	const int even0 = tmp10 + tmp13;
+	const int even3 = tmp10 - tmp13;
+	const int even1 = tmp11 + tmp12;
+	const int even2 = tmp11 - tmp12;
+
+	// Odd part
+	const int z13 = v[5 * stride] + v[3 * stride];
+	const int z10 = v[5 * stride] - v[3 * stride];
+	const int z11 = v[1 * stride] + v[7 * stride];
+	const int z12 = v[1 * stride] - v[7 * stride];
+
+	const int odd7 = z11 + z13;
+	const int z5 = multiply1_847(z10 + z12);
+	const int odd6 = multiplyMinus2_613(z10) + z5 - odd7;
+	const int odd5 = multiply1_414(z11 - z13) - odd6;
+	const int odd4 = multiply1_082(z12) - z5 + odd5;
+
+	v[0 * stride] = even0 + odd7;
+	v[7 * stride] = even0 - odd7;
+	v[1 * stride] = even1 + odd6;
+	v[6 * stride] = even1 - odd6;
+	v[2 * stride] = even2 + odd5;
+	v[5 * stride] = even2 - odd5;
+	v[4 * stride] = even3 + odd4;
+	v[3 * stride] = even3 - odd4;
+}
+
+void idctAAN8x8Scalar(byte *dst, int pitch, const int16 src[64]) {
+	int workspace[64];
+	for (int i = 0; i < 64; i++)
+		workspace[i] = src[i];
+
+	// Pass 1: process the columns
+	for (int x = 0; x < 8; x++)
+		idctAAN1D(workspace + x, 8);
+
+	// Pass 2: process the rows, and remove the scaling of the coefficients
+	// and the factor 8 of the two passes
+	for (int y = 0; y < 8; y++) {
+		int *row = workspace + y * 8;
+		idctAAN1D(row, 1);
+
+		for (int x = 0; x < 8; x++)
+			dst[x] = CLIP<int>(((row[x] + 16) >> 5) + 128, 0, 255);
+
+		dst += pitch;
+	}
+}
+
+#ifdef USE_SSE2
+
+/** Multiply by a 16 bit fraction, plus the given integer part, like the scalar code does. */
+static inline __m128i multiplySSE2(__m128i v, short fraction, int integer) {
+	__m128i result = _mm_mulhi_epi16(v, _mm_set1_epi16(fraction));
+
+	if (integer < 0) {
+		for (int i = 0; i < -integer; i++)
+			result = _mm_sub_epi16(result, v);
+	} else {
+		for (int i = 0; i < integer; i++)
+			result = _mm_add_epi16(result, v);
+	}
+
+	return result;
+}
+
+/** One-dimensional IDCT of each lane of the 8 rows. */
+static inline void idctAAN1DSSE2(__m128i *v) {
+	// Even part
+	const __m128i tmp10 = _mm_add_epi16(v[0], v[4]);
+	const __m128i tmp11 = _mm_sub_epi16(v[0], v[4]);
+	const __m128i tmp13 = _mm_add_epi16(v[2], v[6]);
+	const __m128i tmp12 = _mm_sub_epi16(multiplySSE2(_mm_sub_epi16(v[2], v[6]), kFrac1_414213562, 1), tmp13);
+
+	const __m128i even0 = _mm_add_epi16(tmp10, tmp13);
+	const __m128i even3 = _mm_sub_epi16(tmp10, tmp13);
+	const __m128i even1 = _mm_add_epi16(tmp11, tmp12);
+	const __m128i even2 = _mm_sub_epi16(tmp11, tmp12);
+
+	// Odd part
+	const __m128i z13 = _mm_add_epi16(v[5], v[3]);
+	const __m128i z10 = _mm_sub_epi16(v[5], v[3]);
+	const __m128i z11 = _mm_add_epi16(v[1], v[7]);
+	const __m128i z12 = _mm_sub_epi16(v[1], v[7]);
+
+	const __m128i odd7 = _mm_add_epi16(z11, z13);
+	const __m128i z5 = multiplySSE2(_mm_add_epi16(z10, z12), kFrac1_847759065, 2);
+	const __m128i odd6 = _mm_sub_epi16(_mm_add_epi16(multiplySSE2(z10, kFrac2_613125930, -3), z5), odd7);
+	const __m128i odd5 = _mm_sub_epi16(multiplySSE2(_mm_sub_epi16(z11, z13), kFrac1_414213562, 1), odd6);
+	const __m128i odd4 = _mm_add_epi16(_mm_sub_epi16(multiplySSE2(z12, kFrac1_082392200, 1), z5), odd5);
+
+	v[0] = _mm_add_epi16(even0, odd7);
+	v[7] = _mm_sub_epi16(even0, odd7);
+	v[1] = _mm_add_epi16(even1, odd6);
+	v[6] = _mm_sub_epi16(even1, odd6);
+	v[2] = _mm_add_epi16(even2, odd5);
+	v[5] = _mm_sub_epi16(even2, odd5);
+	v[4] = _mm_add_epi16(even3, odd4);
+	v[3] = _mm_sub_epi16(even3, odd4);
+}
+
+/** Transpose the 8x8 block of 16 bit values. */
+static inline void transposeSSE2(__m128i *v) {
+	const __m128i a0 = _mm_unpacklo_epi16(v[0], v[1]);
+	const __m128i a1 = _mm_unpackhi_epi16(v[0], v[1]);
+	const __m128i a2 = _mm_unpacklo_epi16(v[2], v[3]);
+	const __m128i a3 = _mm_unpackhi_epi16(v[2], v[3]);
+	const __m128i a4 = _mm_unpacklo_epi16(v[4], v[5]);
+	const __m128i a5 = _mm_unpackhi_epi16(v[4], v[5]);
+	const __m128i a6 = _mm_unpacklo_epi16(v[6], v[7]);
+	const __m128i a7 = _mm_unpackhi_epi16(v[6], v[7]);
+
+	const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+	const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+	const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+	const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+	const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+	const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+	const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+	const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+	v[0] = _mm_unpacklo_epi64(b0, b4);
+	v[1] = _mm_unpackhi_epi64(b0, b4);
+	v[2] = _mm_unpacklo_epi64(b1, b5);
+	v[3] = _mm_unpackhi_epi64(b1, b5);
+	v[4] = _mm_unpacklo_epi64(b2, b6);
+	v[5] = _mm_unpackhi_epi64(b2, b6);
+	v[6] = _mm_unpacklo_epi64(b3, b7);
+	v[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+static void idctAAN8x8SSE2(byte *dst, int pitch, const int16 src[64]) {
+	__m128i v[8];
+	for (int i = 0; i < 8; i++)
+		v[i] = _mm_loadu_si128((const __m128i *)(src + i * 8));
+
+	// Pass 1 works on the columns, as each lane holds one
+	idctAAN1DSSE2(v);
+
+	// Pass 2 works on the rows, after transposing them into the lanes
+	transposeSSE2(v);
+	idctAAN1DSSE2(v);
+	transposeSSE2(v);
+
+	// Descale and level shift: the saturating pack to signed 8 bit values
+	// clips them, and flipping the sign bit adds 128
+	const __m128i rounding = _mm_set1_epi16(16);
+	const __m128i signBit = _mm_set1_epi8((char)0x80);
+
+	for (int i = 0; i < 8; i += 2) {
+		const __m128i row0 = _mm_srai_epi16(_mm_add_epi16(v[i], rounding), 5);
+		const __m128i row1 = _mm_srai_epi16(_mm_add_epi16(v[i + 1], rounding), 5);
+		const __m128i samples = _mm_xor_si128(_mm_packs_epi16(row0, row1), signBit);
+
+		_mm_storel_epi64((__m128i *)dst, samples);
+		_mm_storel_epi64((__m128i *)(dst + pitch), _mm_srli_si128(samples, 8));
+		dst += 2 * pitch;
+	}
+}
+
+#endif
+
+void idctAAN8x8(byte *dst, int pitch, const int16 src[64]) {
+#ifdef USE_SSE2
+	idctAAN8x8SSE2(dst, pitch, src);
+#else
+	idctAAN8x8Scalar(dst, pitch, src);
+#endif
+}
+
+} // End of namespace Graphics
@@ -318,6 +318,18 @@ void AdvMame3x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPi
 	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 2, width, height);
 }
 
+/** AdvMame2x for 32 bit pixels. */
+void AdvMame2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							 int width, int height) {
+	scale(2, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 4, width, height);
+}
+
+/** AdvMame3x for 32 bit pixels. */
+void AdvMame3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+							 int width, int height) {
+	scale(3, dstPtr, dstPitch, srcPtr - srcPitch, srcPitch, 4, width, height);
+}
+
 template<typename ColorMask>
 void TV2xTemplate(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 					int width, int height) {
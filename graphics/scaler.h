@@ -50,6 +50,8 @@ DECLARE_SCALER(SuperEagle);
 
 DECLARE_SCALER(AdvMame2x);
 DECLARE_SCALER(AdvMame3x);
+DECLARE_SCALER(AdvMame2x32);
+DECLARE_SCALER(AdvMame3x32);
 
 DECLARE_SCALER(TV2x);
 DECLARE_SCALER(DotMatrix);
@@ -57,6 +59,11 @@ DECLARE_SCALER(DotMatrix);
 #ifdef USE_HQ_SCALERS
 DECLARE_SCALER(HQ2x);
 DECLARE_SCALER(HQ3x);
+
+// Versions of the HQ scalers for ARGB8888 pixels. These do not need the
+// lookup table set up by InitScalers().
+DECLARE_SCALER(HQ2x32);
+DECLARE_SCALER(HQ3x32);
 #endif
 
 #endif // #ifdef USE_SCALERS
@@ -20,7 +20,7 @@
  *
  */
 
-#include "graphics/scaler/intern.h"
+#include "graphics/scaler/hqx.h"
 
 #ifdef USE_NASM
 // Assembly version of HQ2x
@@ -39,77 +39,80 @@ void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
 	hq2x_16(srcPtr, dstPtr, width, height, srcPitch, dstPitch);
 }
 
-#else
+#endif
 
 #define PIXEL00_0	*(q) = w5;
-#define PIXEL00_10	*(q) = interpolate16_3_1<ColorMask >(w5, w1);
-#define PIXEL00_11	*(q) = interpolate16_3_1<ColorMask >(w5, w4);
-#define PIXEL00_12	*(q) = interpolate16_3_1<ColorMask >(w5, w2);
-#define PIXEL00_20	*(q) = interpolate16_2_1_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_21	*(q) = interpolate16_2_1_1<ColorMask >(w5, w1, w2);
-#define PIXEL00_22	*(q) = interpolate16_2_1_1<ColorMask >(w5, w1, w4);
-#define PIXEL00_60	*(q) = interpolate16_5_2_1<ColorMask >(w5, w2, w4);
-#define PIXEL00_61	*(q) = interpolate16_5_2_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_70	*(q) = interpolate16_6_1_1<ColorMask >(w5, w4, w2);
-#define PIXEL00_90	*(q) = interpolate16_2_3_3<ColorMask >(w5, w4, w2);
-#define PIXEL00_100	*(q) = interpolate16_14_1_1<ColorMask >(w5, w4, w2);
+#define PIXEL00_10	*(q) = Pixels::interpolate_3_1(w5, w1);
+#define PIXEL00_11	*(q) = Pixels::interpolate_3_1(w5, w4);
+#define PIXEL00_12	*(q) = Pixels::interpolate_3_1(w5, w2);
+#define PIXEL00_20	*(q) = Pixels::interpolate_2_1_1(w5, w4, w2);
+#define PIXEL00_21	*(q) = Pixels::interpolate_2_1_1(w5, w1, w2);
+#define PIXEL00_22	*(q) = Pixels::interpolate_2_1_1(w5, w1, w4);
+#define PIXEL00_60	*(q) = Pixels::interpolate_5_2_1(w5, w2, w4);
+#define PIXEL00_61	*(q) = Pixels::interpolate_5_2_1(w5, w4, w2);
+#define PIXEL00_70	*(q) = Pixels::interpolate_6_1_1(w5, w4, w2);
+#define PIXEL00_90	*(q) = Pixels::interpolate_2_3_3(w5, w4, w2);
+#define PIXEL00_100	*(q) = Pixels::interpolate_14_1_1(w5, w4, w2);
 
 #define PIXEL01_0	*(q+1) = w5;
-#define PIXEL01_10	*(q+1) = interpolate16_3_1<ColorMask >(w5, w3);
-#define PIXEL01_11	*(q+1) = interpolate16_3_1<ColorMask >(w5, w2);
-#define PIXEL01_12	*(q+1) = interpolate16_3_1<ColorMask >(w5, w6);
-#define PIXEL01_20	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_21	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w3, w6);
-#define PIXEL01_22	*(q+1) = interpolate16_2_1_1<ColorMask >(w5, w3, w2);
-#define PIXEL01_60	*(q+1) = interpolate16_5_2_1<ColorMask >(w5, w6, w2);
-#define PIXEL01_61	*(q+1) = interpolate16_5_2_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_70	*(q+1) = interpolate16_6_1_1<ColorMask >(w5, w2, w6);
-#define PIXEL01_90	*(q+1) = interpolate16_2_3_3<ColorMask >(w5, w2, w6);
-#define PIXEL01_100	*(q+1) = interpolate16_14_1_1<ColorMask >(w5, w2, w6);
+#define PIXEL01_10	*(q+1) = Pixels::interpolate_3_1(w5, w3);
+#define PIXEL01_11	*(q+1) = Pixels::interpolate_3_1(w5, w2);
+#define PIXEL01_12	*(q+1) = Pixels::interpolate_3_1(w5, w6);
+#define PIXEL01_20	*(q+1) = Pixels::interpolate_2_1_1(w5, w2, w6);
+#define PIXEL01_21	*(q+1) = Pixels::interpolate_2_1_1(w5, w3, w6);
+#define PIXEL01_22	*(q+1) = Pixels::interpolate_2_1_1(w5, w3, w2);
+#define PIXEL01_60	*(q+1) = Pixels::interpolate_5_2_1(w5, w6, w2);
+#define PIXEL01_61	*(q+1) = Pixels::interpolate_5_2_1(w5, w2, w6);
+#define PIXEL01_70	*(q+1) = Pixels::interpolate_6_1_1(w5, w2, w6);
+#define PIXEL01_90	*(q+1) = Pixels::interpolate_2_3_3(w5, w2, w6);
+#define PIXEL01_100	*(q+1) = Pixels::interpolate_14_1_1(w5, w2, w6);
 
 #define PIXEL10_0	*(q+nextlineDst) = w5;
-#define PIXEL10_10	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w7);
-#define PIXEL10_11	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w8);
-#define PIXEL10_12	*(q+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w4);
-#define PIXEL10_20	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_21	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w7, w4);
-#define PIXEL10_22	*(q+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w7, w8);
-#define PIXEL10_60	*(q+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w4, w8);
-#define PIXEL10_61	*(q+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_70	*(q+nextlineDst) = interpolate16_6_1_1<ColorMask >(w5, w8, w4);
-#define PIXEL10_90	*(q+nextlineDst) = interpolate16_2_3_3<ColorMask >(w5, w8, w4);
-#define PIXEL10_100	*(q+nextlineDst) = interpolate16_14_1_1<ColorMask >(w5, w8, w4);
+#define PIXEL10_10	*(q+nextlineDst) = Pixels::interpolate_3_1(w5, w7);
+#define PIXEL10_11	*(q+nextlineDst) = Pixels::interpolate_3_1(w5, w8);
+#define PIXEL10_12	*(q+nextlineDst) = Pixels::interpolate_3_1(w5, w4);
+#define PIXEL10_20	*(q+nextlineDst) = Pixels::interpolate_2_1_1(w5, w8, w4);
+#define PIXEL10_21	*(q+nextlineDst) = Pixels::interpolate_2_1_1(w5, w7, w4);
+#define PIXEL10_22	*(q+nextlineDst) = Pixels::interpolate_2_1_1(w5, w7, w8);
+#define PIXEL10_60	*(q+nextlineDst) = Pixels::interpolate_5_2_1(w5, w4, w8);
+#define PIXEL10_61	*(q+nextlineDst) = Pixels::interpolate_5_2_1(w5, w8, w4);
+#define PIXEL10_70	*(q+nextlineDst) = Pixels::interpolate_6_1_1(w5, w8, w4);
+#define PIXEL10_90	*(q+nextlineDst) = Pixels::interpolate_2_3_3(w5, w8, w4);
+#define PIXEL10_100	*(q+nextlineDst) = Pixels::interpolate_14_1_1(w5, w8, w4);
 
 #define PIXEL11_0	*(q+1+nextlineDst) = w5;
-#define PIXEL11_10	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w9);
-#define PIXEL11_11	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w6);
-#define PIXEL11_12	*(q+1+nextlineDst) = interpolate16_3_1<ColorMask >(w5, w8);
-#define PIXEL11_20	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_21	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w9, w8);
-#define PIXEL11_22	*(q+1+nextlineDst) = interpolate16_2_1_1<ColorMask >(w5, w9, w6);
-#define PIXEL11_60	*(q+1+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w8, w6);
-#define PIXEL11_61	*(q+1+nextlineDst) = interpolate16_5_2_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_70	*(q+1+nextlineDst) = interpolate16_6_1_1<ColorMask >(w5, w6, w8);
-#define PIXEL11_90	*(q+1+nextlineDst) = interpolate16_2_3_3<ColorMask >(w5, w6, w8);
-#define PIXEL11_100	*(q+1+nextlineDst) = interpolate16_14_1_1<ColorMask >(w5, w6, w8);
+#define PIXEL11_10	*(q+1+nextlineDst) = Pixels::interpolate_3_1(w5, w9);
+#define PIXEL11_11	*(q+1+nextlineDst) = Pixels::interpolate_3_1(w5, w6);
+#define PIXEL11_12	*(q+1+nextlineDst) = Pixels::interpolate_3_1(w5, w8);
+#define PIXEL11_20	*(q+1+nextlineDst) = Pixels::interpolate_2_1_1(w5, w6, w8);
+#define PIXEL11_21	*(q+1+nextlineDst) = Pixels::interpolate_2_1_1(w5, w9, w8);
+#define PIXEL11_22	*(q+1+nextlineDst) = Pixels::interpolate_2_1_1(w5, w9, w6);
+#define PIXEL11_60	*(q+1+nextlineDst) = Pixels::interpolate_5_2_1(w5, w8, w6);
+#define PIXEL11_61	*(q+1+nextlineDst) = Pixels::interpolate_5_2_1(w5, w6, w8);
+#define PIXEL11_70	*(q+1+nextlineDst) = Pixels::interpolate_6_1_1(w5, w6, w8);
+#define PIXEL11_90	*(q+1+nextlineDst) = Pixels::interpolate_2_3_3(w5, w6, w8);
+#define PIXEL11_100	*(q+1+nextlineDst) = Pixels::interpolate_14_1_1(w5, w6, w8);
 
-extern "C" uint32   *RGBtoYUV;
-#define YUV(x)	RGBtoYUV[w ## x]
+#define YUV(x)	yuv ## x
 
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (see http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
+ * Pixels provides the pixel format, see hqx.h.
  */
-template<typename ColorMask>
+template<typename Pixels>
 static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
-	register int w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	typedef typename Pixels::Pixel Pixel;
+
+	uint32 w1, w2, w3, w4, w5, w6, w7, w8, w9;
+	int yuv1, yuv2, yuv3, yuv4, yuv5, yuv6, yuv7, yuv8, yuv9;
 
-	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
-	const uint16 *p = (const uint16 *)srcPtr;
+	const uint32 nextlineSrc = srcPitch / sizeof(Pixel);
+	const Pixel *p = (const Pixel *)srcPtr;
 
-	const uint32 nextlineDst = dstPitch / sizeof(uint16);
-	uint16 *q = (uint16 *)dstPtr;
+	const uint32 nextlineDst = dstPitch / sizeof(Pixel);
+	Pixel *q = (Pixel *)dstPtr;
 
 	//	 +----+----+----+
 	//	 |    |    |    |
@@ -131,6 +134,9 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
+		Pixels::yuv(w1, w4, w7, yuv1, yuv4, yuv7);
+		Pixels::yuv(w2, w5, w8, yuv2, yuv5, yuv8);
+
 		int tmpWidth = width;
 		while (tmpWidth--) {
 			p++;
@@ -139,16 +145,9 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			Pixels::yuv(w3, w6, w9, yuv3, yuv6, yuv9);
+
+			const int pattern = hqPattern(yuv5, yuv1, yuv2, yuv3, yuv4, yuv6, yuv7, yuv8, yuv9);
 
 			switch (pattern) {
 			case 0:
@@ -1950,6 +1949,14 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 			w5 = w6;
 			w8 = w9;
 
+			yuv1 = yuv2;
+			yuv4 = yuv5;
+			yuv7 = yuv8;
+
+			yuv2 = yuv3;
+			yuv5 = yuv6;
+			yuv8 = yuv9;
+
 			q += 2;
 		}
 		p += nextlineSrc - width;
@@ -1957,12 +1964,16 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	}
 }
 
+#ifndef USE_NASM
 void HQ2x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	extern int gBitFormat;
 	if (gBitFormat == 565)
-		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		HQ2x_implementation<HQPixel16<Graphics::ColorMasks<565> > >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 	else
-		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		HQ2x_implementation<HQPixel16<Graphics::ColorMasks<555> > >(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 }
+#endif
 
-#endif // Assembly version
+void HQ2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
+	HQ2x_implementation<HQPixel8888>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+}
@@ -0,0 +1,170 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SCALER_HQX_H
+#define GRAPHICS_SCALER_HQX_H
+
+#include "common/sse2.h"
+#include "graphics/scaler/intern.h"
+
+/*
+ * Code shared by the HQ2x and HQ3x scalers.
+ *
+ * The scalers are templates over a pixel class, which provides the pixel
+ * type, the YUV values used for the comparisons of the pixels, for a column
+ * of three pixels at a time, and the interpolation functions.
+ */
+
+#ifndef USE_NASM
+
+extern "C" uint32 *RGBtoYUV;
+
+/** The pixels of the 16 bit formats, with the YUV values from the lookup table. */
+template<typename ColorMask>
+struct HQPixel16 {
+	typedef uint16 Pixel;
+
+	static inline void yuv(uint32 p1, uint32 p2, uint32 p3, int &yuv1, int &yuv2, int &yuv3) {
+		yuv1 = RGBtoYUV[p1];
+		yuv2 = RGBtoYUV[p2];
+		yuv3 = RGBtoYUV[p3];
+	}
+
+	static inline uint32 interpolate_1_1(uint32 p1, uint32 p2) { return interpolate16_1_1<ColorMask>(p1, p2); }
+	static inline uint32 interpolate_3_1(uint32 p1, uint32 p2) { return interpolate16_3_1<ColorMask>(p1, p2); }
+	static inline uint32 interpolate_7_1(uint32 p1, uint32 p2) { return interpolate16_7_1<ColorMask>(p1, p2); }
+	static inline uint32 interpolate_2_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_2_1_1<ColorMask>(p1, p2, p3); }
+	static inline uint32 interpolate_5_2_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_5_2_1<ColorMask>(p1, p2, p3); }
+	static inline uint32 interpolate_6_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_6_1_1<ColorMask>(p1, p2, p3); }
+	static inline uint32 interpolate_2_3_3(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_2_3_3<ColorMask>(p1, p2, p3); }
+	static inline uint32 interpolate_2_7_7(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_2_7_7<ColorMask>(p1, p2, p3); }
+	static inline uint32 interpolate_14_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate16_14_1_1<ColorMask>(p1, p2, p3); }
+};
+
+#endif
+
+/**
+ * Interpolate three ARGB8888 pixels with the given weights, which add up
+ * to 1 << shift, at most 16. The red and blue channels, and the alpha and
+ * green channels, are handled together, with enough room between them for
+ * the weighted sums.
+ */
+template<int w1, int w2, int w3, int shift>
+static inline uint32 interpolate8888(uint32 p1, uint32 p2, uint32 p3) {
+	const uint32 rb = ((p1 & 0x00FF00FF) * w1 + (p2 & 0x00FF00FF) * w2 + (p3 & 0x00FF00FF) * w3) >> shift;
+	const uint32 ag = (((p1 >> 8) & 0x00FF00FF) * w1 + ((p2 >> 8) & 0x00FF00FF) * w2 + ((p3 >> 8) & 0x00FF00FF) * w3) >> shift;
+	return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+}
+
+/**
+ * The ARGB8888 pixels. The YUV values use the same formula as the 256 KB
+ * lookup table of the 16 bit formats, but are computed on the fly, as a
+ * table covering all 24 bit colors would need 64 MB.
+ */
+struct HQPixel8888 {
+	typedef uint32 Pixel;
+
+	static inline int yuv(uint32 p) {
+		const int r = (p >> 16) & 0xFF;
+		const int g = (p >> 8) & 0xFF;
+		const int b = p & 0xFF;
+
+		const int y = (r + g + b) >> 2;
+		const int u = 128 + ((r - b) >> 2);
+		const int v = 128 + ((-r + 2 * g - b) >> 3);
+		return (y << 16) | (u << 8) | v;
+	}
+
+	static inline void yuv(uint32 p1, uint32 p2, uint32 p3, int &yuv1, int &yuv2, int &yuv3) {
+#ifdef USE_SSE2
+		const __m128i p = _mm_set_epi32(0, p3, p2, p1);
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), byteMask);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(p, 8), byteMask);
+		const __m128i b = _mm_and_si128(p, byteMask);
+		const __m128i offset = _mm_set1_epi32(128);
+
+		const __m128i y = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(r, g), b), 2);
+		const __m128i u = _mm_add_epi32(offset, _mm_srai_epi32(_mm_sub_epi32(r, b), 2));
+		const __m128i v = _mm_add_epi32(offset, _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(_mm_add_epi32(g, g), r), b), 3));
+		const __m128i result = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(y, 16), _mm_slli_epi32(u, 8)), v);
+
+		yuv1 = _mm_cvtsi128_si32(result);
+		yuv2 = _mm_cvtsi128_si32(_mm_srli_si128(result, 4));
+		yuv3 = _mm_cvtsi128_si32(_mm_srli_si128(result, 8));
+#else
+		yuv1 = yuv(p1);
+		yuv2 = yuv(p2);
+		yuv3 = yuv(p3);
+#endif
+	}
+
+	static inline uint32 interpolate_1_1(uint32 p1, uint32 p2) { return interpolate8888<1, 1, 0, 1>(p1, p2, 0); }
+	static inline uint32 interpolate_3_1(uint32 p1, uint32 p2) { return interpolate8888<3, 1, 0, 2>(p1, p2, 0); }
+	static inline uint32 interpolate_7_1(uint32 p1, uint32 p2) { return interpolate8888<7, 1, 0, 3>(p1, p2, 0); }
+	static inline uint32 interpolate_2_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<2, 1, 1, 2>(p1, p2, p3); }
+	static inline uint32 interpolate_5_2_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<5, 2, 1, 3>(p1, p2, p3); }
+	static inline uint32 interpolate_6_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<6, 1, 1, 3>(p1, p2, p3); }
+	static inline uint32 interpolate_2_3_3(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<2, 3, 3, 3>(p1, p2, p3); }
+	static inline uint32 interpolate_2_7_7(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<2, 7, 7, 4>(p1, p2, p3); }
+	static inline uint32 interpolate_14_1_1(uint32 p1, uint32 p2, uint32 p3) { return interpolate8888<14, 1, 1, 4>(p1, p2, p3); }
+};
+
+/**
+ * Compare the center pixel of the 3x3 block with its neighbors. Bit 0 to 7
+ * of the result are set for the neighbors 1 to 4 and 6 to 9 which differ
+ * from it, according to diffYUV().
+ */
+static inline int hqPattern(int yuv5, int yuv1, int yuv2, int yuv3, int yuv4,
+                            int yuv6, int yuv7, int yuv8, int yuv9) {
+#ifdef USE_SSE2
+	// The Y, U and V values each fit in a byte, so the absolute differences
+	// of all eight neighbors are computed in two registers, and compared
+	// with the thresholds with a saturating subtraction.
+	const __m128i center = _mm_set1_epi32(yuv5);
+	const __m128i thresholds = _mm_set1_epi32(0x00300706);
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i lo = _mm_set_epi32(yuv4, yuv3, yuv2, yuv1);
+	__m128i hi = _mm_set_epi32(yuv9, yuv8, yuv7, yuv6);
+	lo = _mm_or_si128(_mm_subs_epu8(lo, center), _mm_subs_epu8(center, lo));
+	hi = _mm_or_si128(_mm_subs_epu8(hi, center), _mm_subs_epu8(center, hi));
+	lo = _mm_cmpeq_epi32(_mm_subs_epu8(lo, thresholds), zero);
+	hi = _mm_cmpeq_epi32(_mm_subs_epu8(hi, thresholds), zero);
+
+	const int same = _mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+	return same ^ 0xFF;
+#else
+	int pattern = 0;
+	if (yuv5 != yuv1 && diffYUV(yuv5, yuv1)) pattern |= 0x0001;
+	if (yuv5 != yuv2 && diffYUV(yuv5, yuv2)) pattern |= 0x0002;
+	if (yuv5 != yuv3 && diffYUV(yuv5, yuv3)) pattern |= 0x0004;
+	if (yuv5 != yuv4 && diffYUV(yuv5, yuv4)) pattern |= 0x0008;
+	if (yuv5 != yuv6 && diffYUV(yuv5, yuv6)) pattern |= 0x0010;
+	if (yuv5 != yuv7 && diffYUV(yuv5, yuv7)) pattern |= 0x0020;
+	if (yuv5 != yuv8 && diffYUV(yuv5, yuv8)) pattern |= 0x0040;
+	if (yuv5 != yuv9 && diffYUV(yuv5, yuv9)) pattern |= 0x0080;
+	return pattern;
+#endif
+}
+
+#endif
@@ -28,6 +28,8 @@
 
 #include "engines/engine.h"
 
+#include "audio/mixer.h"
+
 #include "gui/debugger.h"
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 	#include "gui/console.h"
@@ -64,6 +66,8 @@ Debugger::Debugger() {
 	DCmd_Register("debugflag_list",		WRAP_METHOD(Debugger, Cmd_DebugFlagsList));
 	DCmd_Register("debugflag_enable",	WRAP_METHOD(Debugger, Cmd_DebugFlagEnable));
 	DCmd_Register("debugflag_disable",	WRAP_METHOD(Debugger, Cmd_DebugFlagDisable));
+
+	DCmd_Register("mixer_stats",		WRAP_METHOD(Debugger, Cmd_MixerStats));
 }
 
 Debugger::~Debugger() {
@@ -538,6 +542,46 @@ bool Debugger::Cmd_DebugFlagDisable(int argc, const char **argv) {
 	return true;
 }
 
+bool Debugger::Cmd_MixerStats(int argc, const char **argv) {
+	static const char *const soundTypes[] = { "plain", "music", "sfx", "speech" };
+
+	Audio::Mixer *mixer = g_system->getMixer();
+	Audio::Mixer::Stats stats;
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "reset")) {
+			mixer->resetStats();
+			DebugPrintf("Mixer statistics reset\n");
+		} else {
+			DebugPrintf("Usage: %s [reset]\n", argv[0]);
+		}
+		return true;
+	}
+
+	if (!mixer->getStats(stats)) {
+		DebugPrintf("The mixer does not provide statistics\n");
+		return true;
+	}
+
+	const uint32 duration = (uint32)((uint64)stats.samplesMixed * 1000 / mixer->getOutputRate());
+
+	DebugPrintf("Mixer: %u buffers (%u ms each), %u ms of audio\n", stats.callbacks, stats.bufferPeriod, duration);
+	DebugPrintf("Mix time: %u ms total, %u ms max, load %.1f%%\n", stats.mixTime, stats.maxMixTime,
+	            duration ? 100.0 * stats.mixTime / duration : 0.0);
+	DebugPrintf("Underruns: %u, overruns: %u\n", stats.underruns, stats.overruns);
+
+	DebugPrintf("\nSlot  Id     Type    Rate   Ch  Samples     Time (ms)\n");
+	DebugPrintf("------------------------------------------------------\n");
+	for (uint i = 0; i < stats.channels.size(); i++) {
+		const Audio::Mixer::ChannelStats &channel = stats.channels[i];
+		DebugPrintf("%-4d  %-5d  %-6s  %-5u  %-2d  %-10u  %u%s\n", channel.slot, channel.id,
+		            soundTypes[channel.type], channel.rate, channel.stereo ? 2 : 1,
+		            channel.samplesMixed, channel.mixTime, channel.paused ? " (paused)" : "");
+	}
+
+	return true;
+}
+
 // Console handler
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 bool Debugger::debuggerInputCallback(GUI::ConsoleDialog *console, const char *input, void *refCon) {
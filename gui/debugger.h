@@ -66,6 +66,13 @@ public:
 	 */
 	bool isActive() const { return _isActive; }
 
+	/**
+	 * Return true if the debugger is attached, i.e. one of the next calls
+	 * of onFrame() is going to open it. Engines calling onFrame() very
+	 * often can use this to skip the calls.
+	 */
+	bool isAttached() const { return _frameCountdown > 0; }
+
 protected:
 	typedef Common::Functor2<int, const char **, bool> Debuglet;
 
@@ -195,6 +202,7 @@ protected:
 	bool Cmd_DebugFlagsList(int argc, const char **argv);
 	bool Cmd_DebugFlagEnable(int argc, const char **argv);
 	bool Cmd_DebugFlagDisable(int argc, const char **argv);
+	bool Cmd_MixerStats(int argc, const char **argv);
 
 #ifndef USE_TEXT_CONSOLE_FOR_DEBUGGER
 private:
@@ -0,0 +1,209 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+#include "audio/decoders/raw.h"
+
+#include "common/endian.h"
+#include "test/common/random_helper.h"
+
+#include <math.h>
+
+class RateTestSuite : public CxxTest::TestSuite
+{
+private:
+	TestRandom _random;
+
+	int16 getRandomSample() {
+		return (int16)_random.getRandom();
+	}
+
+	void mixBufferTestTemplate(const int frames, const bool stereo, const bool reverseStereo, const Audio::st_volume_t vol_l, const Audio::st_volume_t vol_r, const int offset) {
+		_random.setSeed(frames);
+
+		const int inSamples = frames * (stereo ? 2 : 1);
+		// Allocate some extra room to test unaligned buffers
+		int16 *in = new int16[inSamples + offset];
+		int16 *outRef = new int16[frames * 2];
+		int16 *out = new int16[frames * 2 + offset];
+
+		for (int i = 0; i < inSamples; ++i)
+			in[i + offset] = getRandomSample();
+
+		// Use loud output samples, so saturation is exercised as well
+		for (int i = 0; i < frames * 2; ++i)
+			outRef[i] = out[i + offset] = getRandomSample();
+
+		Audio::mixBufferScalar(outRef, in + offset, frames, stereo, reverseStereo, vol_l, vol_r);
+		Audio::mixBuffer(out + offset, in + offset, frames, stereo, reverseStereo, vol_l, vol_r);
+
+		TS_ASSERT_EQUALS(memcmp(outRef, out + offset, sizeof(int16) * frames * 2), 0);
+
+		delete[] in;
+		delete[] outRef;
+		delete[] out;
+	}
+
+	void mixBufferVolumeTemplate(const bool stereo, const bool reverseStereo) {
+		static const Audio::st_volume_t volumes[] = { 0, 1, 127, 128, 255, Audio::Mixer::kMaxMixerVolume };
+
+		for (int l = 0; l < ARRAYSIZE(volumes); ++l) {
+			for (int r = 0; r < ARRAYSIZE(volumes); ++r) {
+				mixBufferTestTemplate(1031, stereo, reverseStereo, volumes[l], volumes[r], 0);
+				mixBufferTestTemplate(1031, stereo, reverseStereo, volumes[l], volumes[r], 1);
+			}
+		}
+	}
+
+	/**
+	 * Convert a mono 16 bit stream with the given samples and return the
+	 * number of frames written to 'out'. With 'drain', the samples held
+	 * back by the converter at the end of the stream are written as well.
+	 */
+	int convert(const int16 *samples, int count, int inRate, int outRate, Audio::RateConverterQuality quality, int16 *out, int outFrames, bool drain = false) {
+		int16 *buffer = (int16 *)malloc(count * sizeof(int16));
+		for (int i = 0; i < count; ++i)
+			WRITE_LE_UINT16(&buffer[i], samples[i]);
+
+		Audio::AudioStream *stream = Audio::makeRawStream((const byte *)buffer, count * sizeof(int16), inRate,
+		                                                  Audio::FLAG_16BITS | Audio::FLAG_LITTLE_ENDIAN);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, false, false, quality);
+
+		memset(out, 0, outFrames * 2 * sizeof(int16));
+		int frames = converter->flow(*stream, out, outFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		if (drain)
+			frames += converter->drain(out + frames * 2, outFrames - frames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+		delete converter;
+		delete stream;
+		return frames;
+	}
+
+	void polyphaseDCTestTemplate(Audio::RateConverterQuality quality) {
+		int16 in[2000];
+		for (int i = 0; i < ARRAYSIZE(in); ++i)
+			in[i] = 10000;
+
+		int16 out[4000 * 2];
+		const int frames = convert(in, ARRAYSIZE(in), 22050, 44100, quality, out, 4000);
+		TS_ASSERT(frames > 3800);
+
+		// Skip the filter's ramp up at the start of the stream
+		for (int i = 64; i < frames; ++i) {
+			TS_ASSERT_EQUALS(out[i * 2 + 0], 10000);
+			TS_ASSERT_EQUALS(out[i * 2 + 1], 10000);
+		}
+	}
+
+	void polyphaseSineTestTemplate(Audio::RateConverterQuality quality) {
+		// A 441 Hz sine wave, well below the cutoff of the filter
+		int16 in[2000];
+		for (int i = 0; i < ARRAYSIZE(in); ++i)
+			in[i] = (int16)(sin(i * 441.0 / 11025 * 2 * M_PI) * 16384);
+
+		int16 out[8000 * 2];
+		const int frames = convert(in, ARRAYSIZE(in), 11025, 44100, quality, out, 8000);
+		TS_ASSERT(frames > 7800);
+
+		int maxError = 0;
+		for (int i = 64; i < frames; ++i) {
+			const double expected = sin(i / 4.0 * 441.0 / 11025 * 2 * M_PI) * 16384;
+			maxError = MAX<int>(maxError, (int)fabs(out[i * 2] - expected));
+		}
+		TS_ASSERT_LESS_THAN(maxError, 16);
+	}
+
+	void polyphaseAliasTestTemplate(Audio::RateConverterQuality quality) {
+		// Downsampling a 20 kHz tone to 22050 Hz has to remove it
+		int16 in[8000];
+		for (int i = 0; i < ARRAYSIZE(in); ++i)
+			in[i] = (int16)(sin(i * 20000.0 / 44100 * 2 * M_PI) * 16384);
+
+		int16 out[4000 * 2];
+		const int frames = convert(in, ARRAYSIZE(in), 44100, 22050, quality, out, 4000);
+		TS_ASSERT(frames > 3900);
+
+		int peak = 0;
+		for (int i = 64; i < frames; ++i)
+			peak = MAX<int>(peak, ABS<int>(out[i * 2]));
+		TS_ASSERT_LESS_THAN(peak, 300);
+	}
+
+	void polyphaseImpulseTestTemplate(Audio::RateConverterQuality quality, int pos) {
+		// The output has to be centered on the input, also for the very
+		// first and last samples of the stream
+		int16 in[200];
+		memset(in, 0, sizeof(in));
+		in[pos] = 16384;
+
+		int16 out[1000 * 2];
+		const int frames = convert(in, ARRAYSIZE(in), 11025, 44100, quality, out, 1000, true);
+		TS_ASSERT_EQUALS(frames, 800);
+
+		int peak = 0;
+		for (int i = 1; i < frames; ++i) {
+			if (out[i * 2] > out[peak * 2])
+				peak = i;
+		}
+		TS_ASSERT_EQUALS(peak, pos * 4);
+	}
+
+public:
+	void test_polyphase_dc() {
+		polyphaseDCTestTemplate(Audio::kRateQualityHigh);
+		polyphaseDCTestTemplate(Audio::kRateQualityBest);
+	}
+
+	void test_polyphase_sine() {
+		polyphaseSineTestTemplate(Audio::kRateQualityHigh);
+		polyphaseSineTestTemplate(Audio::kRateQualityBest);
+	}
+
+	void test_polyphase_impulse() {
+		polyphaseImpulseTestTemplate(Audio::kRateQualityHigh, 0);
+		polyphaseImpulseTestTemplate(Audio::kRateQualityHigh, 100);
+		polyphaseImpulseTestTemplate(Audio::kRateQualityHigh, 199);
+		polyphaseImpulseTestTemplate(Audio::kRateQualityBest, 0);
+		polyphaseImpulseTestTemplate(Audio::kRateQualityBest, 100);
+		polyphaseImpulseTestTemplate(Audio::kRateQualityBest, 199);
+	}
+
+	void test_polyphase_alias() {
+		polyphaseAliasTestTemplate(Audio::kRateQualityHigh);
+		polyphaseAliasTestTemplate(Audio::kRateQualityBest);
+	}
+
+	void test_mix_buffer_mono() {
+		mixBufferVolumeTemplate(false, false);
+	}
+
+	void test_mix_buffer_stereo() {
+		mixBufferVolumeTemplate(true, false);
+	}
+
+	void test_mix_buffer_stereo_reversed() {
+		mixBufferVolumeTemplate(true, true);
+	}
+
+	void test_mix_buffer_short() {
+		for (int frames = 0; frames < 20; ++frames) {
+			mixBufferTestTemplate(frames, false, false, 200, 100, 0);
+			mixBufferTestTemplate(frames, true, false, 200, 100, 0);
+			mixBufferTestTemplate(frames, true, true, 200, 100, 0);
+		}
+	}
+
+	void test_mix_buffer_extremes() {
+		int16 in[16], out[16], outRef[16];
+
+		for (int i = 0; i < 16; ++i) {
+			in[i] = (i & 1) ? -32768 : 32767;
+			out[i] = outRef[i] = (i & 2) ? -32768 : 32767;
+		}
+
+		Audio::mixBufferScalar(outRef, in, 8, true, false, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+		Audio::mixBuffer(out, in, 8, true, false, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume);
+
+		TS_ASSERT_EQUALS(memcmp(outRef, out, sizeof(out)), 0);
+	}
+};
@@ -0,0 +1,138 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/memstream.h"
+
+class BitStreamTestSuite : public CxxTest::TestSuite
+{
+private:
+	/**
+	 * Read the data in chunks of varying sizes, checking that peeking
+	 * returns the same bits as reading, and that skipping and reading
+	 * end up at the same positions.
+	 */
+	template<class Stream>
+	void peekSkipTemplate() {
+		byte data[64];
+		for (int i = 0; i < ARRAYSIZE(data); i++)
+			data[i] = (byte)(i * 37 + 11);
+
+		Common::MemoryReadStream stream1(data, sizeof(data));
+		Common::MemoryReadStream stream2(data, sizeof(data));
+		Stream bits(stream1), skipBits(stream2);
+
+		uint8 n = 1;
+		while (bits.size() - bits.pos() >= 32) {
+			const uint32 peeked = bits.peekBits(n);
+			TS_ASSERT_EQUALS(bits.peekBit(), peeked >> (bits.isMSBFirst() ? n - 1 : 0) & 1);
+			TS_ASSERT_EQUALS(bits.getBits(n), peeked);
+
+			skipBits.skip(n);
+			TS_ASSERT_EQUALS(skipBits.pos(), bits.pos());
+			TS_ASSERT_EQUALS(skipBits.peekBits(7), bits.peekBits(7));
+
+			n = n % 17 + 1;
+		}
+	}
+
+	/**
+	 * Read the data in chunks of 1 to 32 bits, comparing the values with
+	 * the bits taken one at a time straight from the data.
+	 */
+	template<class Stream, int valueBits, bool isLE, bool isMSB2LSB>
+	void layoutTemplate() {
+		byte data[66];
+		for (int i = 0; i < ARRAYSIZE(data); i++)
+			data[i] = (byte)(i * 73 + 5);
+
+		// The last, partial value of the 16 and 32 bit layouts is ignored
+		const uint32 size = (sizeof(data) / (valueBits / 8)) * valueBits;
+		byte expected[sizeof(data) * 8];
+
+		for (uint32 i = 0; i < size / valueBits; i++) {
+			const byte *ptr = data + i * (valueBits / 8);
+			uint32 value = *ptr;
+			if (valueBits == 16)
+				value = isLE ? READ_LE_UINT16(ptr) : READ_BE_UINT16(ptr);
+			else if (valueBits == 32)
+				value = isLE ? READ_LE_UINT32(ptr) : READ_BE_UINT32(ptr);
+
+			for (int j = 0; j < valueBits; j++)
+				expected[i * valueBits + j] = (value >> (isMSB2LSB ? valueBits - 1 - j : j)) & 1;
+		}
+
+		Common::BitStreamMemoryStream stream(data, sizeof(data));
+		Stream bits(stream);
+		TS_ASSERT_EQUALS(bits.size(), size);
+		TS_ASSERT_EQUALS(bits.isMSBFirst(), isMSB2LSB);
+
+		uint32 pos = 0;
+		uint8 n = 1;
+		while (size - pos >= n) {
+			uint32 value = 0;
+			for (uint8 j = 0; j < n; j++) {
+				if (isMSB2LSB)
+					value = (value << 1) | expected[pos + j];
+				else
+					value |= (uint32)expected[pos + j] << j;
+			}
+
+			TS_ASSERT_EQUALS(bits.peekBits(n), value);
+			TS_ASSERT_EQUALS(bits.getBits(n), value);
+
+			pos += n;
+			TS_ASSERT_EQUALS(bits.pos(), pos);
+
+			n = n % 32 + 1;
+		}
+
+		bits.skip(size - pos);
+		TS_ASSERT(bits.eos());
+
+		bits.rewind();
+		TS_ASSERT_EQUALS(bits.pos(), 0U);
+		bits.skip(valueBits + 3);
+		TS_ASSERT_EQUALS(bits.getBit(), (uint32)expected[valueBits + 3]);
+	}
+
+public:
+	void test_peek_skip() {
+		peekSkipTemplate<Common::BitStream8MSB>();
+		peekSkipTemplate<Common::BitStream8LSB>();
+		peekSkipTemplate<Common::BitStream16LEMSB>();
+		peekSkipTemplate<Common::BitStream16BELSB>();
+		peekSkipTemplate<Common::BitStream32LELSB>();
+		peekSkipTemplate<Common::BitStream32BEMSB>();
+	}
+
+	void test_memory_layouts() {
+		layoutTemplate<Common::BitStreamMemory8MSB, 8, false, true>();
+		layoutTemplate<Common::BitStreamMemory8LSB, 8, false, false>();
+		layoutTemplate<Common::BitStreamMemory16LEMSB, 16, true, true>();
+		layoutTemplate<Common::BitStreamMemory16LELSB, 16, true, false>();
+		layoutTemplate<Common::BitStreamMemory16BEMSB, 16, false, true>();
+		layoutTemplate<Common::BitStreamMemory16BELSB, 16, false, false>();
+		layoutTemplate<Common::BitStreamMemory32LEMSB, 32, true, true>();
+		layoutTemplate<Common::BitStreamMemory32LELSB, 32, true, false>();
+		layoutTemplate<Common::BitStreamMemory32BEMSB, 32, false, true>();
+		layoutTemplate<Common::BitStreamMemory32BELSB, 32, false, false>();
+	}
+
+	void test_bit_order() {
+		static const byte data[] = { 0x35, 0xA0 };
+		Common::MemoryReadStream stream1(data, sizeof(data));
+		Common::MemoryReadStream stream2(data, sizeof(data));
+
+		Common::BitStream8MSB msb(stream1);
+		TS_ASSERT(msb.isMSBFirst());
+		TS_ASSERT_EQUALS(msb.getBits(4), 0x3U);
+		TS_ASSERT_EQUALS(msb.peekBits(4), 0x5U);
+		TS_ASSERT_EQUALS(msb.peekBits(8), 0x5AU);
+
+		Common::BitStream8LSB lsb(stream2);
+		TS_ASSERT(!lsb.isMSBFirst());
+		TS_ASSERT_EQUALS(lsb.getBits(4), 0x5U);
+		TS_ASSERT_EQUALS(lsb.peekBits(4), 0x3U);
+		TS_ASSERT_EQUALS(lsb.peekBits(8), 0x03U);
+	}
+};
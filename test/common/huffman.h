@@ -0,0 +1,141 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/huffman.h"
+#include "common/bitstream.h"
+#include "common/memstream.h"
+#include "test/common/random_helper.h"
+
+class HuffmanTestSuite : public CxxTest::TestSuite
+{
+private:
+	TestRandom _random;
+
+	/** Assign canonical codes to the lengths, with the first bit as the MSB. */
+	static void makeCanonicalCodes(const uint8 *lengths, uint32 count, uint32 *codes) {
+		uint32 code = 0;
+
+		for (uint8 length = 1; length <= 32; length++) {
+			for (uint32 i = 0; i < count; i++) {
+				if (lengths[i] == length)
+					codes[i] = code++;
+			}
+			code <<= 1;
+		}
+	}
+
+	static uint32 reverseBits(uint32 v, uint8 n) {
+		uint32 result = 0;
+		for (uint8 i = 0; i < n; i++, v >>= 1)
+			result = (result << 1) | (v & 1);
+		return result;
+	}
+
+	/** Append a code to a bit buffer, in reading order. */
+	static void putCode(byte *buffer, uint32 &bitPos, uint32 code, uint8 length, bool msbFirst) {
+		for (uint8 i = 0; i < length; i++, bitPos++) {
+			const uint32 bit = (code >> (length - 1 - i)) & 1;
+
+			if (msbFirst)
+				buffer[bitPos >> 3] |= bit << (7 - (bitPos & 7));
+			else
+				buffer[bitPos >> 3] |= bit << (bitPos & 7);
+		}
+	}
+
+	/**
+	 * Encode random symbols with canonical codes of the given lengths and
+	 * decode them again, with a stream of the given layout.
+	 */
+	template<class Stream, class DataStream>
+	void roundTripTemplate(const uint8 *lengths, uint32 count, bool msbFirst) {
+		uint32 codes[64], streamCodes[64], symbols[64];
+		makeCanonicalCodes(lengths, count, codes);
+
+		for (uint32 i = 0; i < count; i++) {
+			// A stream handing out the LSB first reads a code's LSB first
+			streamCodes[i] = msbFirst ? codes[i] : reverseBits(codes[i], lengths[i]);
+			symbols[i] = 1000 + i * 3;
+		}
+
+		Common::Huffman huffman(0, count, streamCodes, lengths, symbols);
+
+		const uint32 kSymbols = 5000;
+		uint32 input[kSymbols];
+		byte *buffer = new byte[kSymbols * 4 + 4];
+		memset(buffer, 0, kSymbols * 4 + 4);
+
+		uint32 bitPos = 0;
+		_random.setSeed(count);
+		for (uint32 i = 0; i < kSymbols; i++) {
+			input[i] = _random.getRandom() % count;
+			putCode(buffer, bitPos, codes[input[i]], lengths[input[i]], msbFirst);
+		}
+
+		// The stream ends right after the last code, rounded up to whole values
+		DataStream data(buffer, ((bitPos + 31) / 32) * 4);
+		Stream bits(data);
+
+		for (uint32 i = 0; i < kSymbols; i++)
+			TS_ASSERT_EQUALS(huffman.getSymbol(bits), symbols[input[i]]);
+
+		TS_ASSERT_EQUALS(bits.pos(), bitPos);
+
+		delete[] buffer;
+	}
+
+	template<class Stream, class DataStream>
+	void lengthsTemplate(bool msbFirst) {
+		// Short codes only, all found in the primary table
+		static const uint8 shortLengths[] = { 2, 3, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6, 6, 6 };
+		roundTripTemplate<Stream, DataStream>(shortLengths, ARRAYSIZE(shortLengths), msbFirst);
+
+		// Codes up to 20 bits long, needing two levels of secondary tables
+		uint8 longLengths[21];
+		for (uint8 i = 0; i < 20; i++)
+			longLengths[i] = i + 1;
+		longLengths[20] = 20;
+		roundTripTemplate<Stream, DataStream>(longLengths, ARRAYSIZE(longLengths), msbFirst);
+
+		// A mix of short codes and several long ones with a shared prefix
+		static const uint8 mixedLengths[] = { 1, 3, 4, 5, 6, 7, 9, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12 };
+		roundTripTemplate<Stream, DataStream>(mixedLengths, ARRAYSIZE(mixedLengths), msbFirst);
+	}
+
+public:
+	void test_msb_first() {
+		lengthsTemplate<Common::BitStream8MSB, Common::MemoryReadStream>(true);
+		lengthsTemplate<Common::BitStream32BEMSB, Common::MemoryReadStream>(true);
+	}
+
+	void test_lsb_first() {
+		lengthsTemplate<Common::BitStream8LSB, Common::MemoryReadStream>(false);
+		lengthsTemplate<Common::BitStream32LELSB, Common::MemoryReadStream>(false);
+	}
+
+	void test_memory_readers() {
+		lengthsTemplate<Common::BitStreamMemory8MSB, Common::BitStreamMemoryStream>(true);
+		lengthsTemplate<Common::BitStreamMemory16BEMSB, Common::BitStreamMemoryStream>(true);
+		lengthsTemplate<Common::BitStreamMemory8LSB, Common::BitStreamMemoryStream>(false);
+		lengthsTemplate<Common::BitStreamMemory32LELSB, Common::BitStreamMemoryStream>(false);
+	}
+
+	void test_set_symbols() {
+		static const uint8 lengths[] = { 1, 2, 3, 3 };
+		static const uint32 codes[] = { 0, 2, 6, 7 };
+		static const uint32 symbols[] = { 7, 5, 3, 1 };
+
+		Common::Huffman huffman(0, 4, codes, lengths);
+
+		// 0 10 110 111
+		static const byte data[] = { 0x5B, 0x80 };
+		Common::MemoryReadStream stream(data, sizeof(data));
+		Common::BitStream8MSB bits(stream);
+
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 0U);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 1U);
+
+		huffman.setSymbols(symbols);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 3U);
+		TS_ASSERT_EQUALS(huffman.getSymbol(bits), 1U);
+	}
+};
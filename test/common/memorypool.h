@@ -0,0 +1,171 @@
+#include <cxxtest/TestSuite.h>
+
+#if defined(__GNUC__) && defined(__linux__) && !defined(__ANDROID__)
+#include <pthread.h>
+#define TEST_SMALLOBJ_THREADS
+#endif
+
+#include "common/memorypool.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite
+{
+	struct Counted {
+		static int _count;
+		int _value;
+
+		Counted(int value) : _value(value) { ++_count; }
+		~Counted() { --_count; }
+	};
+
+	static void *allocAndFreeChunks(void *) {
+		void *chunks[20];
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			chunks[i] = Common::allocSmallObject(100);
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			Common::freeSmallObject(chunks[i], 100);
+		return 0;
+	}
+
+	public:
+	void test_memory_pool() {
+		Common::MemoryPool pool(sizeof(int));
+		int *chunks[100];
+
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i) {
+			chunks[i] = (int *)pool.allocChunk();
+			*chunks[i] = i;
+		}
+
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			TS_ASSERT_EQUALS(*chunks[i], i);
+
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			pool.freeChunk(chunks[i]);
+
+		pool.freeUnusedPages();
+	}
+
+	void test_small_object_sizes() {
+		// Fill every possible size, including ones passed on to malloc
+		for (size_t size = 0; size <= Common::kSmallObjectMaxSize + 16; ++size) {
+			byte *a = (byte *)Common::allocSmallObject(size);
+			byte *b = (byte *)Common::allocSmallObject(size);
+			TS_ASSERT(a != 0);
+			TS_ASSERT(b != 0);
+			TS_ASSERT_DIFFERS(a, b);
+
+			memset(a, 0xAA, size);
+			memset(b, 0x55, size);
+			for (size_t i = 0; i < size; ++i) {
+				TS_ASSERT_EQUALS(a[i], 0xAA);
+				TS_ASSERT_EQUALS(b[i], 0x55);
+			}
+
+			Common::freeSmallObject(a, size);
+			Common::freeSmallObject(b, size);
+		}
+	}
+
+	void test_small_object_alignment() {
+		for (size_t size = 1; size <= Common::kSmallObjectMaxSize; size += 7) {
+			void *ptr = Common::allocSmallObject(size);
+			TS_ASSERT_EQUALS((size_t)ptr % sizeof(void *), 0U);
+			Common::freeSmallObject(ptr, size);
+		}
+	}
+
+	void test_small_object_many() {
+		// Use more chunks than fit into a thread cache or a single page
+		const int count = 5000;
+		int **chunks = new int *[count];
+
+		for (int i = 0; i < count; ++i) {
+			chunks[i] = (int *)Common::allocSmallObject(sizeof(int) * (1 + i % 8));
+			chunks[i][0] = i;
+		}
+
+		// Free every second chunk and allocate them again
+		for (int i = 0; i < count; i += 2)
+			Common::freeSmallObject(chunks[i], sizeof(int) * (1 + i % 8));
+		for (int i = 0; i < count; i += 2) {
+			chunks[i] = (int *)Common::allocSmallObject(sizeof(int) * (1 + i % 8));
+			chunks[i][0] = i;
+		}
+
+		for (int i = 0; i < count; ++i)
+			TS_ASSERT_EQUALS(chunks[i][0], i);
+
+		for (int i = 0; i < count; ++i)
+			Common::freeSmallObject(chunks[i], sizeof(int) * (1 + i % 8));
+
+		delete[] chunks;
+	}
+
+	void test_small_object_stats() {
+		Common::SmallObjectStats before, during, after;
+		Common::getSmallObjectStats(before);
+
+		void *chunks[100];
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			chunks[i] = Common::allocSmallObject(100);
+
+		Common::getSmallObjectStats(during);
+
+		// 100 bytes go into the 112 byte class
+		const Common::SmallObjectStats::SizeClass &cls = during.sizeClasses[10];
+		TS_ASSERT_EQUALS(cls.chunkSize, 112U);
+		TS_ASSERT_EQUALS(cls.allocations - before.sizeClasses[10].allocations, 100U);
+		TS_ASSERT_EQUALS(cls.liveChunks - before.sizeClasses[10].liveChunks, 100U);
+		TS_ASSERT_EQUALS(during.liveBytes - before.liveBytes, 100U * 112);
+		TS_ASSERT(during.peakBytes >= during.liveBytes);
+		TS_ASSERT(cls.reservedBytes >= 100U * 112);
+		TS_ASSERT(during.reservedBytes >= during.liveBytes);
+
+		for (int i = 0; i < ARRAYSIZE(chunks); ++i)
+			Common::freeSmallObject(chunks[i], 100);
+
+		Common::flushSmallObjectCache();
+		Common::getSmallObjectStats(after);
+
+		TS_ASSERT_EQUALS(after.sizeClasses[10].frees - before.sizeClasses[10].frees, 100U);
+		TS_ASSERT_EQUALS(after.sizeClasses[10].liveChunks, before.sizeClasses[10].liveChunks);
+		TS_ASSERT_EQUALS(after.liveBytes, before.liveBytes);
+		TS_ASSERT(after.peakBytes >= during.liveBytes);
+	}
+
+	void test_small_object_thread_exit() {
+#ifdef TEST_SMALLOBJ_THREADS
+		Common::SmallObjectStats before, after;
+		Common::getSmallObjectStats(before);
+
+		// The thread never exchanges chunks with the shared pool after its
+		// first refill, so only its exit makes the counters visible
+		pthread_t thread;
+		TS_ASSERT_EQUALS(pthread_create(&thread, 0, allocAndFreeChunks, 0), 0);
+		TS_ASSERT_EQUALS(pthread_join(thread, 0), 0);
+
+		Common::getSmallObjectStats(after);
+		TS_ASSERT_EQUALS(after.sizeClasses[10].allocations - before.sizeClasses[10].allocations, 20U);
+		TS_ASSERT_EQUALS(after.sizeClasses[10].frees - before.sizeClasses[10].frees, 20U);
+		TS_ASSERT_EQUALS(after.liveBytes, before.liveBytes);
+		TS_ASSERT_EQUALS(after.reservedBytes, before.reservedBytes);
+#endif
+	}
+
+	void test_small_object_pool() {
+		Common::SmallObjectPool<Counted> pool;
+		Counted *objects[50];
+
+		for (int i = 0; i < ARRAYSIZE(objects); ++i)
+			objects[i] = new (pool) Counted(i);
+		TS_ASSERT_EQUALS(Counted::_count, ARRAYSIZE(objects));
+
+		for (int i = 0; i < ARRAYSIZE(objects); ++i) {
+			TS_ASSERT_EQUALS(objects[i]->_value, i);
+			pool.deleteChunk(objects[i]);
+		}
+		TS_ASSERT_EQUALS(Counted::_count, 0);
+	}
+};
+
+int MemoryPoolTestSuite::Counted::_count = 0;
@@ -0,0 +1,27 @@
+#ifndef TEST_COMMON_RANDOM_HELPER_H
+#define TEST_COMMON_RANDOM_HELPER_H
+
+#include "common/scummsys.h"
+
+/**
+ * Linear congruential generator for reproducible test and benchmark data.
+ * Unlike Common::RandomSource, it does not need g_system or the event
+ * recorder, and gives the same sequence on every run.
+ */
+class TestRandom {
+public:
+	explicit TestRandom(uint32 seed = 1) : _seed(seed) {}
+
+	void setSeed(uint32 seed) { _seed = seed; }
+
+	/** Return the next number of the sequence, between 0 and 65535. */
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+private:
+	uint32 _seed;
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/unzip.h"
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/zlib.h"
+#include "test/common/random_helper.h"
+
+class UnzipTestSuite : public CxxTest::TestSuite
+{
+	struct Member {
+		const char *name;
+		Common::Array<byte> data;
+		bool deflate;
+	};
+
+	Common::Array<Member> _members;
+
+	static uint32 crc32(const byte *data, uint32 size) {
+		uint32 crc = 0xFFFFFFFF;
+		for (uint32 i = 0; i < size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+		return ~crc;
+	}
+
+	static Common::Array<byte> deflate(const Common::Array<byte> &data) {
+		// Use the gzip writer and strip its 10 byte header and 8 byte trailer
+		// to obtain raw deflate data
+		Common::MemoryWriteStreamDynamic *memStream = new Common::MemoryWriteStreamDynamic();
+		Common::WriteStream *gzStream = Common::wrapCompressedWriteStream(memStream);
+		gzStream->write(data.begin(), data.size());
+		gzStream->finalize();
+
+		byte *gzData = memStream->getData();
+		Common::Array<byte> result;
+		result.resize(memStream->size() - 18);
+		memcpy(result.begin(), gzData + 10, result.size());
+
+		delete gzStream;
+		free(gzData);
+		return result;
+	}
+
+	void addMember(const char *name, const Common::Array<byte> &data, bool deflate) {
+		Member member;
+		member.name = name;
+		member.data = data;
+		member.deflate = deflate;
+		_members.push_back(member);
+	}
+
+	Common::Archive *makeArchive(bool corruptCrc = false) {
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		Common::Array<uint32> offsets;
+		Common::Array<Common::Array<byte> > compressed;
+
+		for (uint i = 0; i < _members.size(); ++i) {
+			const Member &m = _members[i];
+			offsets.push_back(zip.pos());
+			compressed.push_back(m.deflate ? deflate(m.data) : m.data);
+
+			zip.writeUint32LE(0x04034b50);
+			writeHeaderFields(zip, m, compressed[i], corruptCrc);
+			zip.writeUint16LE(0); // extra field length
+			zip.write(m.name, strlen(m.name));
+			zip.write(compressed[i].begin(), compressed[i].size());
+		}
+
+		const uint32 centralDir = zip.pos();
+		for (uint i = 0; i < _members.size(); ++i) {
+			const Member &m = _members[i];
+			zip.writeUint32LE(0x02014b50);
+			zip.writeUint16LE(20); // version made by
+			writeHeaderFields(zip, m, compressed[i], corruptCrc);
+			zip.writeUint16LE(0); // extra field length
+			zip.writeUint16LE(0); // comment length
+			zip.writeUint16LE(0); // disk number
+			zip.writeUint16LE(0); // internal attributes
+			zip.writeUint32LE(0); // external attributes
+			zip.writeUint32LE(offsets[i]);
+			zip.write(m.name, strlen(m.name));
+		}
+
+		const uint32 centralDirSize = zip.pos() - centralDir;
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(_members.size());
+		zip.writeUint16LE(_members.size());
+		zip.writeUint32LE(centralDirSize);
+		zip.writeUint32LE(centralDir);
+		zip.writeUint16LE(0); // comment length
+
+		return Common::makeZipArchive(new Common::MemoryReadStream(zip.getData(), zip.size(), DisposeAfterUse::YES));
+	}
+
+	static void writeHeaderFields(Common::WriteStream &zip, const Member &m, const Common::Array<byte> &compressed, bool corruptCrc) {
+		zip.writeUint16LE(20); // version needed
+		zip.writeUint16LE(0); // flags
+		zip.writeUint16LE(m.deflate ? 8 : 0);
+		zip.writeUint32LE(0x3C210000); // date and time
+		zip.writeUint32LE(crc32(m.data.begin(), m.data.size()) ^ (corruptCrc ? 1 : 0));
+		zip.writeUint32LE(compressed.size());
+		zip.writeUint32LE(m.data.size());
+		zip.writeUint16LE(strlen(m.name));
+	}
+
+	static Common::Array<byte> makeData(uint32 size, uint32 seed) {
+		Common::Array<byte> data;
+		data.resize(size);
+		TestRandom rnd(seed);
+		for (uint32 i = 0; i < size; ++i) {
+			// Compressible, but not trivially so
+			data[i] = (byte)((i / 64) + (rnd.getRandom() & 7));
+		}
+		return data;
+	}
+
+	static Common::Array<byte> makeText(const char *text) {
+		Common::Array<byte> data;
+		data.resize(strlen(text));
+		memcpy(data.begin(), text, data.size());
+		return data;
+	}
+
+	static bool checkContents(Common::SeekableReadStream *stream, const Common::Array<byte> &data) {
+		if (!stream || stream->size() != (int32)data.size())
+			return false;
+
+		// Read in odd sized chunks, so buffer boundaries are crossed
+		byte buf[1000];
+		uint32 pos = 0;
+		while (pos < data.size()) {
+			const uint32 n = stream->read(buf, 997);
+			if (n == 0 || memcmp(buf, data.begin() + pos, n))
+				return false;
+			pos += n;
+		}
+
+		return !stream->err() && stream->read(buf, 1) == 0 && stream->eos();
+	}
+
+public:
+	void setUp() {
+		_members.clear();
+		addMember("readme.txt", makeText("Old readme"), false);
+		addMember("data/Stored.bin", makeData(200000, 1), false);
+		addMember("data/deflated.bin", makeData(300000, 2), true);
+		addMember("small.bin", makeData(1000, 3), true);
+		addMember("README.TXT", makeText("New readme"), false);
+	}
+
+	void test_index() {
+		Common::Archive *archive = makeArchive();
+		TS_ASSERT(archive != 0);
+
+		TS_ASSERT(archive->hasFile("readme.txt"));
+		TS_ASSERT(archive->hasFile("DATA/stored.BIN"));
+		TS_ASSERT(archive->hasFile("data/deflated.bin"));
+		TS_ASSERT(archive->hasFile("small.bin"));
+		TS_ASSERT(!archive->hasFile("data"));
+		TS_ASSERT(!archive->hasFile("small.bin2"));
+		TS_ASSERT(!archive->hasFile("a"));
+		TS_ASSERT(!archive->hasFile("zzz"));
+
+		// The duplicate readme is only listed once
+		Common::ArchiveMemberList list;
+		TS_ASSERT_EQUALS(archive->listMembers(list), 4);
+		TS_ASSERT_EQUALS(list.size(), 4U);
+
+		delete archive;
+	}
+
+	void test_duplicate_names() {
+		Common::Archive *archive = makeArchive();
+
+		// The file stored last wins
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("readme.txt");
+		TS_ASSERT(checkContents(stream, _members[4].data));
+		delete stream;
+
+		delete archive;
+	}
+
+	void test_contents() {
+		Common::Archive *archive = makeArchive();
+
+		for (uint i = 1; i < 4; ++i) {
+			Common::SeekableReadStream *stream = archive->createReadStreamForMember(_members[i].name);
+			TS_ASSERT(checkContents(stream, _members[i].data));
+			delete stream;
+		}
+
+		delete archive;
+	}
+
+	void test_independent_streams() {
+		Common::Archive *archive = makeArchive();
+		Common::SeekableReadStream *stored = archive->createReadStreamForMember("data/stored.bin");
+		Common::SeekableReadStream *deflated = archive->createReadStreamForMember("data/deflated.bin");
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small.bin");
+
+		// Streams stay valid after the archive is gone
+		delete archive;
+
+		const Common::Array<byte> &storedData = _members[1].data;
+		const Common::Array<byte> &deflatedData = _members[2].data;
+
+		// Interleave reads and seeks on the streams
+		const int32 positions[] = { 0, 150000, 100, 199990, 70000, 5, 123456 };
+		for (int i = 0; i < ARRAYSIZE(positions); ++i) {
+			byte a[10], b[10];
+			TS_ASSERT(stored->seek(positions[i]));
+			TS_ASSERT(deflated->seek(positions[i] + 100000));
+			TS_ASSERT_EQUALS(stored->read(a, 10), 10U);
+			TS_ASSERT_EQUALS(deflated->read(b, 10), 10U);
+			TS_ASSERT(!memcmp(a, storedData.begin() + positions[i], 10));
+			TS_ASSERT(!memcmp(b, deflatedData.begin() + positions[i] + 100000, 10));
+			TS_ASSERT_EQUALS(small->readByte(), _members[3].data[i]);
+		}
+
+		TS_ASSERT(stored->seek(-10, SEEK_END));
+		TS_ASSERT_EQUALS(stored->pos(), 199990);
+
+		delete stored;
+		delete deflated;
+		delete small;
+	}
+
+	void test_crc_error() {
+		Common::Archive *archive = makeArchive(true);
+
+		// The archive stream can't be opened again, so even large members
+		// are extracted, and checked up front
+		TS_ASSERT(archive->createReadStreamForMember("small.bin") == 0);
+		TS_ASSERT(archive->createReadStreamForMember("data/deflated.bin") == 0);
+
+		delete archive;
+	}
+};
@@ -0,0 +1,176 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+#include "test/common/random_helper.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite {
+	enum {
+		kMaxWidth = 37,
+		kHeight = 5,
+		kPadding = 12,
+		kBufferSize = (kMaxWidth * 4 + kPadding) * kHeight
+	};
+
+	TestRandom _random;
+
+	void fillRandom(byte *buf, int size) {
+		for (int i = 0; i < size; i++)
+			buf[i] = _random.getRandom() & 0xFF;
+	}
+
+	static uint32 readPixel(const byte *p, int bytesPerPixel) {
+		switch (bytesPerPixel) {
+		case 2:
+			return *(const uint16 *)p;
+		case 4:
+			return *(const uint32 *)p;
+		default: {
+			uint32 color = 0;
+			byte *col = (byte *)&color;
+#ifdef SCUMM_BIG_ENDIAN
+			col++;
+#endif
+			memcpy(col, p, 3);
+			return color;
+			}
+		}
+	}
+
+	static void writePixel(byte *p, uint32 color, int bytesPerPixel) {
+		switch (bytesPerPixel) {
+		case 1:
+			*p = color;
+			break;
+		case 2:
+			*(uint16 *)p = color;
+			break;
+		case 4:
+			*(uint32 *)p = color;
+			break;
+		default: {
+			const byte *col = (const byte *)&color;
+#ifdef SCUMM_BIG_ENDIAN
+			col++;
+#endif
+			memcpy(p, col, 3);
+			}
+		}
+	}
+
+	/** Convert the rect with PixelFormat, one pixel at a time, and compare to crossBlit(). */
+	void checkCrossBlit(const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+		byte src[kBufferSize], dst[kBufferSize], expected[kBufferSize];
+
+		for (int w = 1; w <= kMaxWidth; w++) {
+			// With and without padding at the end of the rows
+			for (int padding = 0; padding <= kPadding; padding += kPadding) {
+				const int srcPitch = w * srcFmt.bytesPerPixel + padding;
+				const int dstPitch = w * dstFmt.bytesPerPixel + padding;
+
+				fillRandom(src, sizeof(src));
+				fillRandom(dst, sizeof(dst));
+				memcpy(expected, dst, sizeof(dst));
+
+				for (int y = 0; y < kHeight; y++) {
+					for (int x = 0; x < w; x++) {
+						uint8 a, r, g, b;
+						srcFmt.colorToARGB(readPixel(src + y * srcPitch + x * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), a, r, g, b);
+						writePixel(expected + y * dstPitch + x * dstFmt.bytesPerPixel, dstFmt.ARGBToColor(a, r, g, b), dstFmt.bytesPerPixel);
+					}
+				}
+
+				TS_ASSERT(Graphics::crossBlit(dst, src, dstPitch, srcPitch, w, kHeight, dstFmt, srcFmt));
+				TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+			}
+		}
+	}
+
+public:
+	void test_fast_paths() {
+		_random.setSeed(1);
+
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat argb1555(2, 5, 5, 5, 1, 10, 5, 0, 15);
+		const Graphics::PixelFormat xrgb8888(4, 8, 8, 8, 0, 16, 8, 0, 0);
+		const Graphics::PixelFormat argb8888(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+		checkCrossBlit(xrgb8888, rgb565);
+		checkCrossBlit(rgb565, xrgb8888);
+		checkCrossBlit(rgb565, argb1555);
+		checkCrossBlit(argb1555, rgb565);
+		checkCrossBlit(argb8888, rgba8888);
+		checkCrossBlit(rgba8888, argb8888);
+	}
+
+	void test_generic() {
+		_random.setSeed(2);
+
+		const Graphics::PixelFormat rgb555(2, 5, 5, 5, 0, 10, 5, 0, 0);
+		const Graphics::PixelFormat rgb888(3, 8, 8, 8, 0, 16, 8, 0, 0);
+		const Graphics::PixelFormat bgr888(3, 8, 8, 8, 0, 0, 8, 16, 0);
+		const Graphics::PixelFormat abgr8888(4, 8, 8, 8, 8, 0, 8, 16, 24);
+		const Graphics::PixelFormat rgba4444(2, 4, 4, 4, 4, 12, 8, 4, 0);
+
+		checkCrossBlit(abgr8888, rgb555);
+		checkCrossBlit(bgr888, rgb555);
+		checkCrossBlit(rgb888, bgr888);
+		checkCrossBlit(abgr8888, rgb888);
+		checkCrossBlit(rgb888, abgr8888);
+		checkCrossBlit(rgba4444, abgr8888);
+	}
+
+	void test_in_place() {
+		const Graphics::PixelFormat argb8888(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+		uint32 pixels[20];
+		for (int i = 0; i < 20; i++)
+			pixels[i] = 0x11223300 + i;
+
+		TS_ASSERT(Graphics::crossBlit((byte *)pixels, (const byte *)pixels, 40, 40, 10, 2, argb8888, rgba8888));
+
+		for (int i = 0; i < 20; i++)
+			TS_ASSERT_EQUALS(pixels[i], (uint32)(0x00112233 + (i << 24)));
+	}
+
+	void test_invalid() {
+		byte buf[16];
+		const Graphics::PixelFormat clut8 = Graphics::PixelFormat::createFormatCLUT8();
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+
+		TS_ASSERT(!Graphics::crossBlit(buf, buf, 8, 8, 4, 1, rgb565, clut8));
+		TS_ASSERT(!Graphics::crossBlit(buf, buf, 8, 8, 4, 1, clut8, rgb565));
+	}
+
+	void test_map() {
+		_random.setSeed(3);
+
+		uint32 map[256];
+		for (int i = 0; i < 256; i++)
+			map[i] = _random.getRandom() * 65536 + _random.getRandom();
+
+		byte src[kBufferSize], dst[kBufferSize];
+		fillRandom(src, sizeof(src));
+
+		const int srcPitch = kMaxWidth + 3;
+		const int width = kMaxWidth - 2;
+
+		for (int bytesPerPixel = 1; bytesPerPixel <= 4; bytesPerPixel++) {
+			const int dstPitch = kMaxWidth * bytesPerPixel;
+			byte expected[kBufferSize];
+			fillRandom(dst, sizeof(dst));
+			memcpy(expected, dst, sizeof(dst));
+
+			for (int y = 0; y < kHeight; y++)
+				for (int x = 0; x < width; x++)
+					writePixel(expected + y * dstPitch + x * bytesPerPixel, map[src[y * srcPitch + x]], bytesPerPixel);
+
+			TS_ASSERT(Graphics::crossBlitMap(dst, src, dstPitch, srcPitch, width, kHeight, bytesPerPixel, map));
+			TS_ASSERT_SAME_DATA(dst, expected, sizeof(dst));
+		}
+
+		TS_ASSERT(!Graphics::crossBlitMap(dst, src, 4, 4, 4, 1, 5, map));
+	}
+};
@@ -0,0 +1,162 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyrects.h"
+#include "test/common/random_helper.h"
+
+class DirtyRectSetTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 320,
+		kHeight = 200
+	};
+
+	byte _coverage[kWidth * kHeight];
+
+	/** Count how many rects of the set cover each pixel. */
+	void computeCoverage(const Graphics::DirtyRectSet &set) {
+		memset(_coverage, 0, sizeof(_coverage));
+
+		for (Graphics::DirtyRectSet::const_iterator r = set.begin(); r != set.end(); ++r)
+			for (int y = r->top; y < r->bottom; y++)
+				for (int x = r->left; x < r->right; x++)
+					_coverage[y * kWidth + x]++;
+	}
+
+	bool isCovered(const Common::Rect &r) const {
+		for (int y = r.top; y < r.bottom; y++)
+			for (int x = r.left; x < r.right; x++)
+				if (!_coverage[y * kWidth + x])
+					return false;
+
+		return true;
+	}
+
+	uint countPixels(int coverage) const {
+		uint count = 0;
+		for (uint i = 0; i < sizeof(_coverage); i++)
+			if (_coverage[i] == coverage)
+				count++;
+
+		return count;
+	}
+
+	static Common::Rect createRect(TestRandom &rnd, int maxSize) {
+		const int x = rnd.getRandom() % kWidth;
+		const int y = rnd.getRandom() % kHeight;
+		const int w = 1 + rnd.getRandom() % maxSize;
+		const int h = 1 + rnd.getRandom() % maxSize;
+
+		return Common::Rect(x, y, MIN<int>(x + w, kWidth), MIN<int>(y + h, kHeight));
+	}
+
+public:
+	void test_strips() {
+		// Strips as drawn by SCUMM, which overlap after being extended
+		// by one pixel on each side for the scalers
+		Graphics::DirtyRectSet set(100);
+
+		for (int x = 0; x < 160; x += 8)
+			set.add(Common::Rect(MAX(x - 1, 0), 15, x + 9, 145));
+
+		TS_ASSERT_EQUALS(set.size(), 1U);
+		TS_ASSERT(set.begin()->equals(Common::Rect(0, 15, 161, 145)));
+		TS_ASSERT_EQUALS(set.getPixelCount(), 161U * 130U);
+	}
+
+	void test_contained() {
+		Graphics::DirtyRectSet set(100);
+
+		set.add(Common::Rect(10, 10, 100, 100));
+		set.add(Common::Rect(20, 20, 30, 30));
+		set.add(Common::Rect());
+
+		TS_ASSERT_EQUALS(set.size(), 1U);
+		TS_ASSERT(set.begin()->equals(Common::Rect(10, 10, 100, 100)));
+
+		set.add(Common::Rect(0, 0, 200, 150));
+
+		TS_ASSERT_EQUALS(set.size(), 1U);
+		TS_ASSERT(set.begin()->equals(Common::Rect(0, 0, 200, 150)));
+	}
+
+	void test_overlap_is_not_redrawn() {
+		// A cross, where the bounding box would be much too expensive
+		Graphics::DirtyRectSet set(100, 1, 16);
+
+		set.add(Common::Rect(0, 90, 320, 110));
+		set.add(Common::Rect(150, 0, 170, 200));
+
+		computeCoverage(set);
+		TS_ASSERT_EQUALS(countPixels(2), 0U);
+		TS_ASSERT_EQUALS(countPixels(1), 320U * 20U + 20U * 180U);
+		TS_ASSERT_EQUALS(set.getPixelCount(), 320U * 20U + 20U * 180U);
+		TS_ASSERT(!set.isBoundingBoxCheaper());
+	}
+
+	void test_costs() {
+		// Two small rects with a small gap are merged, far apart ones are not
+		Graphics::DirtyRectSet set(100, 1, 256);
+
+		set.add(Common::Rect(0, 0, 10, 10));
+		set.add(Common::Rect(12, 0, 22, 10));
+		TS_ASSERT_EQUALS(set.size(), 1U);
+
+		set.add(Common::Rect(200, 150, 210, 160));
+		TS_ASSERT_EQUALS(set.size(), 2U);
+		TS_ASSERT(!set.isBoundingBoxCheaper());
+
+		// With a high overhead per rect, everything is merged
+		set.clear();
+		TS_ASSERT(set.empty());
+		TS_ASSERT_EQUALS(set.getPixelCount(), 0U);
+
+		set.setCosts(1, 100000);
+		set.add(Common::Rect(0, 0, 10, 10));
+		set.add(Common::Rect(200, 150, 210, 160));
+		TS_ASSERT_EQUALS(set.size(), 1U);
+		TS_ASSERT(set.begin()->equals(Common::Rect(0, 0, 210, 160)));
+	}
+
+	void test_bounding_box() {
+		// The border of a window: no two parts are worth merging, but
+		// together they cover enough of their bounding box
+		Graphics::DirtyRectSet set(100, 1, 2500);
+
+		set.add(Common::Rect(0, 0, 100, 10));
+		set.add(Common::Rect(0, 10, 10, 90));
+		set.add(Common::Rect(90, 10, 100, 90));
+		set.add(Common::Rect(0, 90, 100, 100));
+
+		TS_ASSERT_EQUALS(set.size(), 4U);
+		TS_ASSERT(set.getBoundingBox().equals(Common::Rect(0, 0, 100, 100)));
+		TS_ASSERT(set.isBoundingBoxCheaper());
+
+		set.setCosts(1, 1000);
+		TS_ASSERT(!set.isBoundingBoxCheaper());
+	}
+
+	void test_random() {
+		TestRandom rnd(0x1234);
+
+		for (int pass = 0; pass < 20; pass++) {
+			// Also check that running out of rects works
+			Graphics::DirtyRectSet set(pass < 10 ? 100 : 8, 1 + pass % 4, 64 * (pass % 5));
+			Common::Array<Common::Rect> added;
+
+			const int count = 1 + rnd.getRandom() % 60;
+			for (int i = 0; i < count; i++) {
+				const Common::Rect r = createRect(rnd, i % 3 ? 24 : 120);
+				added.push_back(r);
+				set.add(r);
+			}
+
+			TS_ASSERT_LESS_THAN_EQUALS(set.size(), pass < 10 ? 100U : 8U);
+
+			computeCoverage(set);
+			TS_ASSERT_EQUALS(countPixels(2) + countPixels(3) + countPixels(4), 0U);
+			TS_ASSERT_EQUALS(countPixels(1), set.getPixelCount());
+
+			for (uint i = 0; i < added.size(); i++)
+				TS_ASSERT(isCovered(added[i]));
+		}
+	}
+};
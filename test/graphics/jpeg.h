@@ -0,0 +1,309 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/jpeg.h"
+#include "graphics/conversion.h"
+#include "graphics/surface.h"
+#include "common/memstream.h"
+#include "test/common/random_helper.h"
+
+#include <math.h>
+
+/**
+ * A 16x16 baseline JPEG with 4:2:0 subsampling. Each 8x8 quadrant has a
+ * flat luma of 40, 120 (top) and 200, 240 (bottom), the chroma is a flat
+ * U = 96, V = 160.
+ */
+static const byte jpegQuadrants[] = {
+		0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+		0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x03, 0x02, 0x02, 0x03, 0x02, 0x02, 0x03,
+		0x03, 0x03, 0x03, 0x04, 0x03, 0x03, 0x04, 0x05, 0x08, 0x05, 0x05, 0x04, 0x04, 0x05, 0x0a, 0x07,
+		0x07, 0x06, 0x08, 0x0c, 0x0a, 0x0c, 0x0c, 0x0b, 0x0a, 0x0b, 0x0b, 0x0d, 0x0e, 0x12, 0x10, 0x0d,
+		0x0e, 0x11, 0x0e, 0x0b, 0x0b, 0x10, 0x16, 0x10, 0x11, 0x13, 0x14, 0x15, 0x15, 0x15, 0x0c, 0x0f,
+		0x17, 0x18, 0x16, 0x14, 0x18, 0x12, 0x14, 0x15, 0x14, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x03, 0x04,
+		0x04, 0x05, 0x04, 0x05, 0x09, 0x05, 0x05, 0x09, 0x14, 0x0d, 0x0b, 0x0d, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0xff, 0xc0,
+		0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x10, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+		0x01, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+		0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+		0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+		0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23,
+		0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17,
+		0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+		0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+		0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+		0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+		0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+		0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5,
+		0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1,
+		0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xc4, 0x00, 0x1f, 0x01, 0x00, 0x03,
+		0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+		0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x11, 0x00,
+		0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77, 0x00,
+		0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13,
+		0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15,
+		0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27,
+		0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+		0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6,
+		0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4,
+		0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9,
+		0xfa, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xf8,
+		0x52, 0xbe, 0xd6, 0xaf, 0xb5, 0x6b, 0xda, 0xeb, 0xf2, 0xa3, 0xf5, 0x53, 0xff, 0xd9
+};
+
+/**
+ * The same image as jpegQuadrants, with the same coefficients, but stored
+ * in three non-interleaved scans, one per component.
+ */
+static const byte jpegQuadrantsScans[] = {
+		0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01,
+		0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x03, 0x02, 0x02, 0x03, 0x02, 0x02, 0x03,
+		0x03, 0x03, 0x03, 0x04, 0x03, 0x03, 0x04, 0x05, 0x08, 0x05, 0x05, 0x04, 0x04, 0x05, 0x0a, 0x07,
+		0x07, 0x06, 0x08, 0x0c, 0x0a, 0x0c, 0x0c, 0x0b, 0x0a, 0x0b, 0x0b, 0x0d, 0x0e, 0x12, 0x10, 0x0d,
+		0x0e, 0x11, 0x0e, 0x0b, 0x0b, 0x10, 0x16, 0x10, 0x11, 0x13, 0x14, 0x15, 0x15, 0x15, 0x0c, 0x0f,
+		0x17, 0x18, 0x16, 0x14, 0x18, 0x12, 0x14, 0x15, 0x14, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x03, 0x04,
+		0x04, 0x05, 0x04, 0x05, 0x09, 0x05, 0x05, 0x09, 0x14, 0x0d, 0x0b, 0x0d, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14,
+		0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0x14, 0xff, 0xc0,
+		0x00, 0x11, 0x08, 0x00, 0x10, 0x00, 0x10, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11,
+		0x01, 0xff, 0xc4, 0x00, 0x1f, 0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+		0x0a, 0x0b, 0xff, 0xc4, 0x00, 0xb5, 0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05,
+		0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d, 0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21,
+		0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23,
+		0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17,
+		0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+		0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a,
+		0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a,
+		0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99,
+		0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+		0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5,
+		0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1,
+		0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00,
+		0x00, 0x3f, 0x00, 0xf8, 0x52, 0xbe, 0xd6, 0xaf, 0xb5, 0x6b, 0xda, 0xeb, 0xff, 0xc4, 0x00, 0x1f,
+		0x01, 0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00,
+		0xb5, 0x11, 0x00, 0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01,
+		0x02, 0x77, 0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07,
+		0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33,
+		0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19,
+		0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46,
+		0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66,
+		0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85,
+		0x86, 0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+		0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+		0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+		0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6,
+		0xf7, 0xf8, 0xf9, 0xfa, 0xff, 0xda, 0x00, 0x08, 0x01, 0x02, 0x11, 0x00, 0x3f, 0x00, 0xfc, 0xa8,
+		0xff, 0xda, 0x00, 0x08, 0x01, 0x03, 0x11, 0x00, 0x3f, 0x00, 0xfd, 0x54, 0xff, 0xd9
+};
+
+class JPEGTestSuite : public CxxTest::TestSuite
+{
+private:
+	TestRandom _random;
+
+	/** Random coefficients, in natural order, with the magnitudes decaying like in real images. */
+	void makeCoefficients(int *coeffs) {
+		for (int i = 0; i < 64; i++) {
+			const int range = (i == 0) ? 1024 : 256 / (1 + (i >> 3) + (i & 7));
+			coeffs[i] = (_random.getRandom() % 3 == 0) ? (int)(_random.getRandom() % (2 * range + 1)) - range : 0;
+		}
+	}
+
+	/** Fold the AAN scale factors into the coefficients, like the decoder does. */
+	static void scaleCoefficients(const int *coeffs, int16 *scaled) {
+		for (int i = 0; i < 64; i++)
+			scaled[i] = (coeffs[i] * Graphics::idctAANScales[i] + (1 << 11)) >> 12;
+	}
+
+	static void loadQuadrants(Graphics::JPEG &jpeg, bool scans = false) {
+		Common::MemoryReadStream stream(scans ? jpegQuadrantsScans : jpegQuadrants,
+		                                scans ? sizeof(jpegQuadrantsScans) : sizeof(jpegQuadrants));
+		TS_ASSERT(jpeg.read(&stream));
+		TS_ASSERT_EQUALS(jpeg.getWidth(), 16);
+		TS_ASSERT_EQUALS(jpeg.getHeight(), 16);
+	}
+
+	static void checkPixel(const Graphics::Surface *surface, int x, int y, byte lum) {
+		byte r, g, b, expR, expG, expB;
+		surface->format.colorToRGB(*(const uint32 *)surface->getBasePtr(x, y), r, g, b);
+		Graphics::YUV2RGB(lum, 96, 160, expR, expG, expB);
+
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(r - expR), 2);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(g - expG), 2);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(b - expB), 2);
+	}
+
+public:
+	void setUp() {
+		_random.setSeed(1);
+	}
+
+	void test_idct_accuracy() {
+		int coeffs[64];
+		int16 scaled[64];
+		byte samples[64];
+
+		for (int n = 0; n < 200; n++) {
+			makeCoefficients(coeffs);
+			scaleCoefficients(coeffs, scaled);
+			Graphics::idctAAN8x8(samples, 8, scaled);
+
+			for (int y = 0; y < 8; y++) {
+				for (int x = 0; x < 8; x++) {
+					double sum = 0;
+					for (int v = 0; v < 8; v++) {
+						for (int u = 0; u < 8; u++) {
+							const double cu = u ? 1.0 : sqrt(0.5);
+							const double cv = v ? 1.0 : sqrt(0.5);
+							sum += cu * cv * coeffs[v * 8 + u] * cos((2 * x + 1) * u * M_PI / 16) * cos((2 * y + 1) * v * M_PI / 16);
+						}
+					}
+
+					const int expected = CLIP<int>((int)floor(sum / 4 + 128.5), 0, 255);
+					TS_ASSERT_LESS_THAN_EQUALS(ABS(samples[y * 8 + x] - expected), 1);
+				}
+			}
+		}
+	}
+
+	void test_idct_matches_scalar() {
+		int coeffs[64];
+		int16 scaled[64];
+		byte samples[8 * 10], reference[8 * 10];
+
+		for (int n = 0; n < 1000; n++) {
+			makeCoefficients(coeffs);
+			scaleCoefficients(coeffs, scaled);
+
+			// Use a pitch larger than the block, to catch stray writes
+			memset(samples, 0xAA, sizeof(samples));
+			memset(reference, 0xAA, sizeof(reference));
+			Graphics::idctAAN8x8(samples, 10, scaled);
+			Graphics::idctAAN8x8Scalar(reference, 10, scaled);
+
+			TS_ASSERT_EQUALS(memcmp(samples, reference, sizeof(samples)), 0);
+		}
+	}
+
+	void test_components() {
+		Graphics::JPEG jpeg;
+		loadQuadrants(jpeg);
+
+		const Graphics::Surface *y = jpeg.getComponent(1);
+		const Graphics::Surface *u = jpeg.getComponent(2);
+		const Graphics::Surface *v = jpeg.getComponent(3);
+		TS_ASSERT(y && u && v);
+
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)y->getBasePtr(3, 3) - 40), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)y->getBasePtr(12, 3) - 120), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)y->getBasePtr(3, 12) - 200), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)y->getBasePtr(12, 12) - 240), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)u->getBasePtr(7, 7) - 96), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)v->getBasePtr(7, 7) - 160), 1);
+	}
+
+	void test_surface() {
+		Graphics::JPEG jpeg;
+		loadQuadrants(jpeg);
+
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+		Graphics::Surface *surface = jpeg.getSurface(format);
+		TS_ASSERT(surface);
+		TS_ASSERT_EQUALS(surface->w, 16);
+		TS_ASSERT_EQUALS(surface->h, 16);
+
+		checkPixel(surface, 0, 0, 40);
+		checkPixel(surface, 15, 0, 120);
+		checkPixel(surface, 0, 15, 200);
+		checkPixel(surface, 15, 15, 240);
+
+		surface->free();
+		delete surface;
+	}
+
+	void test_scaled_surface() {
+		Graphics::JPEG jpeg;
+		loadQuadrants(jpeg);
+
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+		for (uint scale = 2; scale <= 8; scale *= 2) {
+			Graphics::Surface *surface = jpeg.getSurface(format, scale);
+			TS_ASSERT(surface);
+
+			const int size = 16 / scale;
+			TS_ASSERT_EQUALS(surface->w, size);
+			TS_ASSERT_EQUALS(surface->h, size);
+
+			checkPixel(surface, 0, 0, 40);
+			checkPixel(surface, size - 1, 0, 120);
+			checkPixel(surface, 0, size - 1, 200);
+			checkPixel(surface, size - 1, size - 1, 240);
+
+			surface->free();
+			delete surface;
+		}
+	}
+
+	void test_non_interleaved_scans() {
+		Graphics::JPEG interleaved, scans;
+		loadQuadrants(interleaved);
+		loadQuadrants(scans, true);
+
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+
+		for (uint scale = 1; scale <= 8; scale *= 2) {
+			Graphics::Surface *expected = interleaved.getSurface(format, scale);
+			Graphics::Surface *surface = scans.getSurface(format, scale);
+			TS_ASSERT(expected && surface);
+			TS_ASSERT_EQUALS(surface->w, expected->w);
+			TS_ASSERT_EQUALS(surface->h, expected->h);
+
+			// The scaled images are reduced after the upsampling of the
+			// chroma, so they may differ a bit
+			for (int y = 0; y < surface->h; y++) {
+				for (int x = 0; x < surface->w; x++) {
+					byte r, g, b, expR, expG, expB;
+					format.colorToRGB(*(const uint32 *)surface->getBasePtr(x, y), r, g, b);
+					format.colorToRGB(*(const uint32 *)expected->getBasePtr(x, y), expR, expG, expB);
+
+					const int tolerance = (scale == 1) ? 0 : 2;
+					TS_ASSERT_LESS_THAN_EQUALS(ABS(r - expR), tolerance);
+					TS_ASSERT_LESS_THAN_EQUALS(ABS(g - expG), tolerance);
+					TS_ASSERT_LESS_THAN_EQUALS(ABS(b - expB), tolerance);
+				}
+			}
+
+			expected->free();
+			delete expected;
+			surface->free();
+			delete surface;
+		}
+
+		const Graphics::Surface *y = scans.getComponent(1);
+		const Graphics::Surface *u = scans.getComponent(2);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)y->getBasePtr(12, 12) - 240), 1);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(*(const byte *)u->getBasePtr(15, 15) - 96), 1);
+	}
+
+	void test_invalid_huffman_table() {
+		// Three codes of one bit, while there are only two such codes
+		static const byte invalidTable[] = {
+			0xff, 0xd8, 0xff, 0xc4, 0x00, 0x16, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0xff, 0xd9
+		};
+
+		Graphics::JPEG jpeg;
+		Common::MemoryReadStream stream(invalidTable, sizeof(invalidTable));
+		TS_ASSERT(!jpeg.read(&stream));
+	}
+};
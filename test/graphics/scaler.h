@@ -0,0 +1,157 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+
+#include "common/scummsys.h"
+#include "test/common/random_helper.h"
+
+/**
+ * Tests of the 32 bit scalers against the 16 bit ones. The 32 bit source
+ * image is the 16 bit one with each channel shifted up, which is how the
+ * RGB to YUV table of the 16 bit HQ scalers converts it too. So both see
+ * the same edges, and as the interpolations round down, the 32 bit output
+ * shifted back down is exactly the 16 bit output.
+ *
+ * The 16 bit output itself is checked against checksums recorded from the
+ * scalers before they were turned into templates.
+ */
+class ScalerTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kWidth = 64,
+		kHeight = 48,
+		kSrcWidth = kWidth + 2,
+		kSrcHeight = kHeight + 2
+	};
+
+	uint16 _src16[kSrcWidth * kSrcHeight];
+	uint32 _src32[kSrcWidth * kSrcHeight];
+
+	static uint32 to8888(uint16 color) {
+		return 0xFF000000 | ((color & 0xF800) << 8) | ((color & 0x07E0) << 5) | ((color & 0x001F) << 3);
+	}
+
+	static uint16 to565(uint32 color) {
+		return ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+	}
+
+	/** Patches of a few colors with noise, which covers most cases of the HQ scalers. */
+	void createImage(uint32 seed) {
+		TestRandom rnd(seed);
+
+		uint16 palette[8];
+		for (int i = 0; i < 8; i++)
+			palette[i] = rnd.getRandom();
+
+		for (int i = 0; i < kSrcWidth * kSrcHeight; i++) {
+			const int x = i % kSrcWidth;
+			const int y = i / kSrcWidth;
+
+			if (rnd.getRandom() % 4)
+				_src16[i] = palette[((x / 3) ^ (y / 5) ^ (x * y / 7)) & 7];
+			else
+				_src16[i] = rnd.getRandom();
+
+			_src32[i] = to8888(_src16[i]);
+		}
+	}
+
+	/** FNV-1a hash of the 16 bit output for all test images. */
+	uint32 checksum(ScalerProc *scaler, int factor) {
+		const int dstWidth = kWidth * factor;
+		const int dstHeight = kHeight * factor;
+		uint16 *dst = new uint16[dstWidth * dstHeight];
+		uint32 hash = 2166136261U;
+
+		for (uint32 seed = 1; seed <= 8; seed++) {
+			createImage(seed);
+
+			scaler((const uint8 *)(_src16 + kSrcWidth + 1), kSrcWidth * 2, (uint8 *)dst, dstWidth * 2, kWidth, kHeight);
+
+			for (int i = 0; i < dstWidth * dstHeight; i++)
+				hash = (hash ^ dst[i]) * 16777619U;
+		}
+
+		delete[] dst;
+		return hash;
+	}
+
+	void compare(ScalerProc *scaler16, ScalerProc *scaler32, int factor) {
+		const int dstWidth = kWidth * factor;
+		const int dstHeight = kHeight * factor;
+		uint16 *dst16 = new uint16[dstWidth * dstHeight];
+		uint32 *dst32 = new uint32[dstWidth * dstHeight];
+
+		for (uint32 seed = 1; seed <= 8; seed++) {
+			createImage(seed);
+
+			scaler16((const uint8 *)(_src16 + kSrcWidth + 1), kSrcWidth * 2, (uint8 *)dst16, dstWidth * 2, kWidth, kHeight);
+			scaler32((const uint8 *)(_src32 + kSrcWidth + 1), kSrcWidth * 4, (uint8 *)dst32, dstWidth * 4, kWidth, kHeight);
+
+			int mismatches = 0;
+			for (int i = 0; i < dstWidth * dstHeight; i++) {
+				if (to565(dst32[i]) != dst16[i] || (dst32[i] >> 24) != 0xFF)
+					mismatches++;
+			}
+			TS_ASSERT_EQUALS(mismatches, 0);
+		}
+
+		delete[] dst16;
+		delete[] dst32;
+	}
+
+public:
+	void setUp() {
+		InitScalers(565);
+	}
+
+	void tearDown() {
+		DestroyScalers();
+	}
+
+	void test_16bit_output() {
+		TS_ASSERT_EQUALS(checksum(AdvMame2x, 2), 0x83B20E90U);
+		TS_ASSERT_EQUALS(checksum(AdvMame3x, 3), 0xC92426FEU);
+#ifdef USE_HQ_SCALERS
+		TS_ASSERT_EQUALS(checksum(HQ2x, 2), 0x026623EEU);
+		TS_ASSERT_EQUALS(checksum(HQ3x, 3), 0xC266A5BEU);
+
+		DestroyScalers();
+		InitScalers(555);
+		TS_ASSERT_EQUALS(checksum(HQ2x, 2), 0x912F1AF1U);
+		TS_ASSERT_EQUALS(checksum(HQ3x, 3), 0x80302E89U);
+#endif
+	}
+
+	void test_advmame() {
+		compare(AdvMame2x, AdvMame2x32, 2);
+		compare(AdvMame3x, AdvMame3x32, 3);
+	}
+
+	void test_hq() {
+#ifdef USE_HQ_SCALERS
+		compare(HQ2x, HQ2x32, 2);
+		compare(HQ3x, HQ3x32, 3);
+#endif
+	}
+
+	void test_hq_keeps_flat_areas() {
+#ifdef USE_HQ_SCALERS
+		for (int i = 0; i < kSrcWidth * kSrcHeight; i++)
+			_src32[i] = 0x80123456;
+
+		uint32 *dst = new uint32[kWidth * 3 * kHeight * 3];
+		HQ3x32((const uint8 *)(_src32 + kSrcWidth + 1), kSrcWidth * 4, (uint8 *)dst, kWidth * 3 * 4, kWidth, kHeight);
+
+		for (int i = 0; i < kWidth * 3 * kHeight * 3; i++) {
+			if (dst[i] != 0x80123456) {
+				TS_ASSERT_EQUALS(dst[i], (uint32)0x80123456);
+				break;
+			}
+		}
+
+		delete[] dst;
+#endif
+	}
+};
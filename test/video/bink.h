@@ -0,0 +1,90 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/bink_decoder.h"
+#include "test/common/random_helper.h"
+
+class BinkTestSuite : public CxxTest::TestSuite
+{
+private:
+	TestRandom _random;
+
+	/** Random coefficients, mostly small and sparse like in real videos, sometimes huge. */
+	void makeBlock(int16 *block, bool huge) {
+		for (int i = 0; i < 64; i++) {
+			const int range = huge ? 32767 : ((i == 0) ? 2048 : 512 / (1 + (i >> 3) + (i & 7)));
+			block[i] = (huge || _random.getRandom() % 3 == 0) ? (int)(_random.getRandom() % (2 * range + 1)) - range : 0;
+		}
+	}
+
+	void makePixels(byte *pixels) {
+		for (int i = 0; i < 8 * 16; i++)
+			pixels[i] = _random.getRandom() & 0xFF;
+	}
+
+public:
+	void test_idct_matches_scalar() {
+		_random.setSeed(1);
+
+		for (int n = 0; n < 2000; n++) {
+			int16 block[64], expected[64];
+			makeBlock(block, n % 10 == 9);
+			memcpy(expected, block, sizeof(block));
+
+			Video::binkIDCT(block);
+			Video::binkIDCTScalar(expected);
+
+			for (int i = 0; i < 64; i++)
+				TS_ASSERT_EQUALS(block[i], expected[i]);
+		}
+	}
+
+	void test_idct_put_matches_scalar() {
+		_random.setSeed(2);
+
+		for (int n = 0; n < 2000; n++) {
+			int16 block[64];
+			byte pixels[8 * 16], expected[8 * 16];
+			makeBlock(block, n % 10 == 9);
+			makePixels(pixels);
+			memcpy(expected, pixels, sizeof(pixels));
+
+			// Use a pitch larger than the block, the pixels in between must stay
+			Video::binkIDCTPut(pixels, 16, block);
+			Video::binkIDCTPutScalar(expected, 16, block);
+
+			for (int i = 0; i < 8 * 16; i++)
+				TS_ASSERT_EQUALS(pixels[i], expected[i]);
+		}
+	}
+
+	void test_idct_add_matches_scalar() {
+		_random.setSeed(3);
+
+		for (int n = 0; n < 2000; n++) {
+			int16 block[64];
+			byte pixels[8 * 16], expected[8 * 16];
+			makeBlock(block, n % 10 == 9);
+			makePixels(pixels);
+			memcpy(expected, pixels, sizeof(pixels));
+
+			Video::binkIDCTAdd(pixels, 16, block);
+			Video::binkIDCTAddScalar(expected, 16, block);
+
+			for (int i = 0; i < 8 * 16; i++)
+				TS_ASSERT_EQUALS(pixels[i], expected[i]);
+		}
+	}
+
+	void test_idct_dc_only() {
+		// A lone DC coefficient gives a flat block
+		int16 block[64];
+		memset(block, 0, sizeof(block));
+		block[0] = 100 * 256;
+
+		byte pixels[64];
+		Video::binkIDCTPut(pixels, 8, block);
+
+		for (int i = 0; i < 64; i++)
+			TS_ASSERT_EQUALS(pixels[i], 100);
+	}
+};
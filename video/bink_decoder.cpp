@@ -30,7 +30,6 @@
 #include "common/textconsole.h"
 #include "common/math.h"
 #include "common/stream.h"
-#include "common/substream.h"
 #include "common/file.h"
 #include "common/str.h"
 #include "common/bitstream.h"
@@ -219,9 +218,7 @@ const Graphics::Surface *BinkDecoder::decodeNextFrame() {
 				//                  Number of samples in bytes
 				audio.sampleCount = _bink->readUint32LE() / (2 * audio.channels);
 
-				audio.bits =
-					new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-					    audioPacketStart + 4, audioPacketEnd), true);
+				audio.bits = readPacket(audioPacketEnd - (audioPacketStart + 4));
 
 				audioPacket(audio);
 
@@ -238,9 +235,7 @@ const Graphics::Surface *BinkDecoder::decodeNextFrame() {
 	uint32 videoPacketStart = _bink->pos();
 	uint32 videoPacketEnd   = _bink->pos() + frameSize;
 
-	frame.bits =
-		new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-		    videoPacketStart, videoPacketEnd), true);
+	frame.bits = readPacket(videoPacketEnd - videoPacketStart);
 
 	videoPacket(frame);
 
@@ -280,6 +275,14 @@ void BinkDecoder::audioPacket(AudioTrack &audio) {
 	}
 }
 
+Common::BitStreamMemory32LELSB *BinkDecoder::readPacket(uint32 size) {
+	byte *data = (byte *)malloc(size);
+	if (_bink->read(data, size) != size)
+		error("Bink packet truncated");
+
+	return new Common::BitStreamMemory32LELSB(new Common::BitStreamMemoryStream(data, size, DisposeAfterUse::YES), DisposeAfterUse::YES);
+}
+
 void BinkDecoder::videoPacket(VideoFrame &video) {
 	assert(video.bits);
 
@@ -828,7 +831,7 @@ void BinkDecoder::blockScaledIntra(DecodeContext &ctx) {
 
 	readDCTCoeffs(*ctx.video, block, true);
 
-	IDCT(block);
+	binkIDCT(block);
 
 	int16 *src   = block;
 	byte  *dest1 = ctx.dest;
@@ -978,7 +981,7 @@ void BinkDecoder::blockIntra(DecodeContext &ctx) {
 
 	readDCTCoeffs(*ctx.video, block, true);
 
-	IDCTPut(ctx, block);
+	binkIDCTPut(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::blockFill(DecodeContext &ctx) {
@@ -999,7 +1002,7 @@ void BinkDecoder::blockInter(DecodeContext &ctx) {
 
 	readDCTCoeffs(*ctx.video, block, false);
 
-	IDCTAdd(ctx, block);
+	binkIDCTAdd(ctx.dest, ctx.pitch, block);
 }
 
 void BinkDecoder::blockPattern(DecodeContext &ctx) {
@@ -1564,87 +1567,4 @@ void BinkDecoder::floatToInt16Interleave(int16 *dst, const float **src, uint32 l
 	}
 }
 
-#define A1  2896 /* (1/sqrt(2))<<12 */
-#define A2  2217
-#define A3  3784
-#define A4 -5352
-
-#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
-    const int a0 = (src)[s0] + (src)[s4]; \
-    const int a1 = (src)[s0] - (src)[s4]; \
-    const int a2 = (src)[s2] + (src)[s6]; \
-    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
-    const int a4 = (src)[s5] + (src)[s3]; \
-    const int a5 = (src)[s5] - (src)[s3]; \
-    const int a6 = (src)[s1] + (src)[s7]; \
-    const int a7 = (src)[s1] - (src)[s7]; \
-    const int b0 = a4 + a6; \
-    const int b1 = (A3*(a5 + a7)) >> 11; \
-    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
-    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
-    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
-    (dest)[d0] = munge(a0+a2   +b0); \
-    (dest)[d1] = munge(a1+a3-a2+b2); \
-    (dest)[d2] = munge(a1-a3+a2+b3); \
-    (dest)[d3] = munge(a0-a2   -b4); \
-    (dest)[d4] = munge(a0-a2   +b4); \
-    (dest)[d5] = munge(a1-a3+a2-b3); \
-    (dest)[d6] = munge(a1+a3-a2-b2); \
-    (dest)[d7] = munge(a0+a2   -b0); \
-}
-/* end IDCT_TRANSFORM macro */
-
-#define MUNGE_NONE(x) (x)
-#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
-
-#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
-#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
-
-static inline void IDCTCol(int16 *dest, const int16 *src)
-{
-	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
-		dest[ 0] =
-		dest[ 8] =
-		dest[16] =
-		dest[24] =
-		dest[32] =
-		dest[40] =
-		dest[48] =
-		dest[56] = src[0];
-	} else {
-		IDCT_COL(dest, src);
-	}
-}
-
-void BinkDecoder::IDCT(int16 *block) {
-	int i;
-	int16 temp[64];
-
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
-	}
-}
-
-void BinkDecoder::IDCTAdd(DecodeContext &ctx, int16 *block) {
-	int i, j;
-
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
-void BinkDecoder::IDCTPut(DecodeContext &ctx, int16 *block) {
-	int i;
-	int16 temp[64];
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
-	}
-}
-
 } // End of namespace Video
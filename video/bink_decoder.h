@@ -34,6 +34,7 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h"
 #include "common/array.h"
+#include "common/bitstream.h"
 #include "common/rational.h"
 
 #include "graphics/surface.h"
@@ -42,7 +43,6 @@
 
 namespace Common {
 	class SeekableReadStream;
-	class BitStream;
 	class Huffman;
 
 	class RDFT;
@@ -150,7 +150,7 @@ protected:
 
 		uint32 sampleCount;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		bool first;
 
@@ -183,7 +183,7 @@ protected:
 		uint32 offset;
 		uint32 size;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		VideoFrame();
 		~VideoFrame();
@@ -256,6 +256,9 @@ protected:
 	/** Initialize the Huffman decoders. */
 	void initHuffman();
 
+	/** Read a packet of the given size into memory and create a bit stream over it. */
+	Common::BitStreamMemory32LELSB *readPacket(uint32 size);
+
 	/** Decode an audio packet. */
 	void audioPacket(AudioTrack &audio);
 	/** Decode a video packet. */
@@ -323,17 +326,29 @@ protected:
 
 	void floatToInt16Interleave(int16 *dst, const float **src, uint32 length, uint8 channels);
 
-	// Bink video IDCT
-	void IDCT(int16 *block);
-	void IDCTPut(DecodeContext &ctx, int16 *block);
-	void IDCTAdd(DecodeContext &ctx, int16 *block);
-
 	/** Start playing the audio track */
 	void startAudio();
 	/** Stop playing the audio track */
 	void stopAudio();
 };
 
+/**
+ * The Bink video IDCT of an 8x8 block, in place. Uses SSE2 where available,
+ * which always gives the same results as binkIDCTScalar().
+ */
+void binkIDCT(int16 *block);
+
+/** Apply the IDCT to the block and store the result into the pixels. */
+void binkIDCTPut(byte *dest, int pitch, const int16 *block);
+
+/** Apply the IDCT to the block and add the result to the pixels. */
+void binkIDCTAdd(byte *dest, int pitch, const int16 *block);
+
+// Plain C implementations of the above, serving as reference for testing
+void binkIDCTScalar(int16 *block);
+void binkIDCTPutScalar(byte *dest, int pitch, const int16 *block);
+void binkIDCTAddScalar(byte *dest, int pitch, const int16 *block);
+
 } // End of namespace Video
 
 #endif // VIDEO_BINK_DECODER_H
@@ -0,0 +1,301 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The Bink video IDCT, based on the one in FFmpeg. The SSE2 version works
+// on four 32 bit lanes, so it computes exactly the same results as the C
+// version, including the truncation to 16 bits after the first pass.
+
+#include "common/scummsys.h"
+#include "common/sse2.h"
+
+#ifdef USE_BINK
+
+#include "video/bink_decoder.h"
+
+namespace Video {
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+static inline void IDCTCol(int16 *dest, const int16 *src)
+{
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+void binkIDCTScalar(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTPutScalar(byte *dest, int pitch, const int16 *block) {
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTAddScalar(byte *dest, int pitch, const int16 *block) {
+	int i, j;
+	int16 temp[64];
+
+	memcpy(temp, block, sizeof(temp));
+	binkIDCTScalar(temp);
+
+	for (i = 0; i < 8; i++, dest += pitch)
+		for (j = 0; j < 8; j++)
+			 dest[j] += temp[i * 8 + j];
+}
+
+#ifdef USE_SSE2
+
+/**
+ * The low 32 bits of the products of the lanes with a constant, like a 32
+ * bit multiplication in C. SSE2 only multiplies two of the lanes at a time.
+ */
+static inline __m128i multiplySSE2(__m128i v, int constant) {
+	const __m128i c = _mm_set1_epi32(constant);
+	const __m128i even = _mm_mul_epu32(v, c);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(v, 32), c);
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** IDCT_TRANSFORM on each lane of the 8 rows, without the munging. */
+static inline void idct1DSSE2(__m128i *v) {
+	const __m128i a0 = _mm_add_epi32(v[0], v[4]);
+	const __m128i a1 = _mm_sub_epi32(v[0], v[4]);
+	const __m128i a2 = _mm_add_epi32(v[2], v[6]);
+	const __m128i a3 = _mm_srai_epi32(multiplySSE2(_mm_sub_epi32(v[2], v[6]), A1), 11);
+	const __m128i a4 = _mm_add_epi32(v[5], v[3]);
+	const __m128i a5 = _mm_sub_epi32(v[5], v[3]);
+	const __m128i a6 = _mm_add_epi32(v[1], v[7]);
+	const __m128i a7 = _mm_sub_epi32(v[1], v[7]);
+
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(multiplySSE2(_mm_add_epi32(a5, a7), A3), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(multiplySSE2(a5, A4), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(multiplySSE2(_mm_sub_epi32(a6, a4), A1), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(multiplySSE2(a7, A2), 11), b3), b1);
+
+	const __m128i a0a2 = _mm_add_epi32(a0, a2);
+	const __m128i a0s2 = _mm_sub_epi32(a0, a2);
+	const __m128i a1a3 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i a1s3 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	v[0] = _mm_add_epi32(a0a2, b0);
+	v[1] = _mm_add_epi32(a1a3, b2);
+	v[2] = _mm_add_epi32(a1s3, b3);
+	v[3] = _mm_sub_epi32(a0s2, b4);
+	v[4] = _mm_add_epi32(a0s2, b4);
+	v[5] = _mm_sub_epi32(a1s3, b3);
+	v[6] = _mm_sub_epi32(a1a3, b2);
+	v[7] = _mm_sub_epi32(a0a2, b0);
+}
+
+static inline void transpose4x4SSE2(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3) {
+	const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+	r0 = _mm_unpacklo_epi64(t0, t1);
+	r1 = _mm_unpackhi_epi64(t0, t1);
+	r2 = _mm_unpacklo_epi64(t2, t3);
+	r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/**
+ * Transpose the 8x8 block of 32 bit values, with the left half of each row
+ * in left[] and the right half in right[].
+ */
+static inline void transposeSSE2(__m128i *left, __m128i *right) {
+	transpose4x4SSE2(left[0], left[1], left[2], left[3]);
+	transpose4x4SSE2(left[4], left[5], left[6], left[7]);
+	transpose4x4SSE2(right[0], right[1], right[2], right[3]);
+	transpose4x4SSE2(right[4], right[5], right[6], right[7]);
+
+	// Swap the top right and bottom left quarters
+	for (int i = 0; i < 4; i++) {
+		const __m128i t = left[i + 4];
+		left[i + 4] = right[i];
+		right[i] = t;
+	}
+}
+
+/** Sign extend the low 16 bits of each lane, like storing to an int16. */
+static inline __m128i truncateSSE2(__m128i v) {
+	return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+
+/**
+ * Both passes of the IDCT. Returns the rows of the result, as 32 bit
+ * values, in left[] and right[].
+ */
+static inline void idctSSE2(const int16 *block, __m128i *left, __m128i *right) {
+	for (int i = 0; i < 8; i++) {
+		const __m128i row = _mm_loadu_si128((const __m128i *)(block + i * 8));
+		left[i] = _mm_srai_epi32(_mm_unpacklo_epi16(row, row), 16);
+		right[i] = _mm_srai_epi32(_mm_unpackhi_epi16(row, row), 16);
+	}
+
+	// Pass 1 works on the columns, as each lane holds one. The results
+	// go through an int16 in the C version.
+	idct1DSSE2(left);
+	idct1DSSE2(right);
+	for (int i = 0; i < 8; i++) {
+		left[i] = truncateSSE2(left[i]);
+		right[i] = truncateSSE2(right[i]);
+	}
+
+	// Pass 2 works on the rows, after transposing them into the lanes
+	transposeSSE2(left, right);
+	idct1DSSE2(left);
+	idct1DSSE2(right);
+
+	const __m128i rounding = _mm_set1_epi32(0x7F);
+	for (int i = 0; i < 8; i++) {
+		left[i] = _mm_srai_epi32(_mm_add_epi32(left[i], rounding), 8);
+		right[i] = _mm_srai_epi32(_mm_add_epi32(right[i], rounding), 8);
+	}
+
+	transposeSSE2(left, right);
+}
+
+/** The low 8 bits of the 8 values of a row, like storing to a byte. */
+static inline __m128i packBytesSSE2(__m128i left, __m128i right) {
+	const __m128i lowByte = _mm_set1_epi32(0xFF);
+	const __m128i words = _mm_packs_epi32(_mm_and_si128(left, lowByte), _mm_and_si128(right, lowByte));
+	return _mm_packus_epi16(words, words);
+}
+
+static void binkIDCTSSE2(int16 *block) {
+	__m128i left[8], right[8];
+	idctSSE2(block, left, right);
+
+	for (int i = 0; i < 8; i++) {
+		const __m128i row = _mm_packs_epi32(truncateSSE2(left[i]), truncateSSE2(right[i]));
+		_mm_storeu_si128((__m128i *)(block + i * 8), row);
+	}
+}
+
+static void binkIDCTPutSSE2(byte *dest, int pitch, const int16 *block) {
+	__m128i left[8], right[8];
+	idctSSE2(block, left, right);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64((__m128i *)dest, packBytesSSE2(left[i], right[i]));
+}
+
+static void binkIDCTAddSSE2(byte *dest, int pitch, const int16 *block) {
+	__m128i left[8], right[8];
+	idctSSE2(block, left, right);
+
+	// Adding the low 8 bits wraps around like the byte addition in C
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i pixels = _mm_loadl_epi64((const __m128i *)dest);
+		_mm_storel_epi64((__m128i *)dest, _mm_add_epi8(pixels, packBytesSSE2(left[i], right[i])));
+	}
+}
+
+#endif
+
+void binkIDCT(int16 *block) {
+#ifdef USE_SSE2
+	binkIDCTSSE2(block);
+#else
+	binkIDCTScalar(block);
+#endif
+}
+
+void binkIDCTPut(byte *dest, int pitch, const int16 *block) {
+#ifdef USE_SSE2
+	binkIDCTPutSSE2(dest, pitch, block);
+#else
+	binkIDCTPutScalar(dest, pitch, block);
+#endif
+}
+
+void binkIDCTAdd(byte *dest, int pitch, const int16 *block) {
+#ifdef USE_SSE2
+	binkIDCTAddSSE2(dest, pitch, block);
+#else
+	binkIDCTAddScalar(dest, pitch, block);
+#endif
+}
+
+} // End of namespace Video
+
+#endif // USE_BINK
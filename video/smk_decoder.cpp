@@ -29,7 +29,6 @@
 #include "common/endian.h"
 #include "common/util.h"
 #include "common/stream.h"
-#include "common/memstream.h"
 #include "common/bitstream.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -54,9 +53,9 @@ enum SmkBlockTypes {
 
 class SmallHuffmanTree {
 public:
-	SmallHuffmanTree(Common::BitStream &bs);
+	SmallHuffmanTree(Common::BitStreamMemory8LSB &bs);
 
-	uint16 getCode(Common::BitStream &bs);
+	uint16 getCode(Common::BitStreamMemory8LSB &bs);
 private:
 	enum {
 		SMK_NODE = 0x8000
@@ -70,10 +69,10 @@ private:
 	uint16 _prefixtree[256];
 	byte _prefixlength[256];
 
-	Common::BitStream &_bs;
+	Common::BitStreamMemory8LSB &_bs;
 };
 
-SmallHuffmanTree::SmallHuffmanTree(Common::BitStream &bs)
+SmallHuffmanTree::SmallHuffmanTree(Common::BitStreamMemory8LSB &bs)
 	: _treeSize(0), _bs(bs) {
 	uint32 bit = _bs.getBit();
 	assert(bit);
@@ -118,7 +117,7 @@ uint16 SmallHuffmanTree::decodeTree(uint32 prefix, int length) {
 	return r1+r2+1;
 }
 
-uint16 SmallHuffmanTree::getCode(Common::BitStream &bs) {
+uint16 SmallHuffmanTree::getCode(Common::BitStreamMemory8LSB &bs) {
 	byte peek = bs.peekBits(8);
 	uint16 *p = &_tree[_prefixtree[peek]];
 	bs.skip(_prefixlength[peek]);
@@ -139,11 +138,11 @@ uint16 SmallHuffmanTree::getCode(Common::BitStream &bs) {
 
 class BigHuffmanTree {
 public:
-	BigHuffmanTree(Common::BitStream &bs, int allocSize);
+	BigHuffmanTree(Common::BitStreamMemory8LSB &bs, int allocSize);
 	~BigHuffmanTree();
 
 	void reset();
-	uint32 getCode(Common::BitStream &bs);
+	uint32 getCode(Common::BitStreamMemory8LSB &bs);
 private:
 	enum {
 		SMK_NODE = 0x80000000
@@ -159,13 +158,13 @@ private:
 	byte _prefixlength[256];
 
 	/* Used during construction */
-	Common::BitStream &_bs;
+	Common::BitStreamMemory8LSB &_bs;
 	uint32 _markers[3];
 	SmallHuffmanTree *_loBytes;
 	SmallHuffmanTree *_hiBytes;
 };
 
-BigHuffmanTree::BigHuffmanTree(Common::BitStream &bs, int allocSize)
+BigHuffmanTree::BigHuffmanTree(Common::BitStreamMemory8LSB &bs, int allocSize)
 	: _bs(bs) {
 	uint32 bit = _bs.getBit();
 	if (!bit) {
@@ -257,7 +256,7 @@ uint32 BigHuffmanTree::decodeTree(uint32 prefix, int length) {
 	return r1+r2+1;
 }
 
-uint32 BigHuffmanTree::getCode(Common::BitStream &bs) {
+uint32 BigHuffmanTree::getCode(Common::BitStreamMemory8LSB &bs) {
 	byte peek = bs.peekBits(8);
 	uint32 *p = &_tree[_prefixtree[peek]];
 	bs.skip(_prefixlength[peek]);
@@ -391,7 +390,7 @@ bool SmackerDecoder::loadStream(Common::SeekableReadStream *stream) {
 	byte *huffmanTrees = (byte *) malloc(_header.treesSize);
 	_fileStream->read(huffmanTrees, _header.treesSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(huffmanTrees, _header.treesSize, DisposeAfterUse::YES), true);
+	Common::BitStreamMemory8LSB bs(new Common::BitStreamMemoryStream(huffmanTrees, _header.treesSize, DisposeAfterUse::YES), DisposeAfterUse::YES);
 
 	_MMapTree = new BigHuffmanTree(bs, _header.mMapSize);
 	_MClrTree = new BigHuffmanTree(bs, _header.mClrSize);
@@ -489,7 +488,7 @@ const Graphics::Surface *SmackerDecoder::decodeNextFrame() {
 
 	_fileStream->read(_frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(_frameData, frameDataSize + 1, DisposeAfterUse::YES), true);
+	Common::BitStreamMemory8LSB bs(new Common::BitStreamMemoryStream(_frameData, frameDataSize + 1, DisposeAfterUse::YES), DisposeAfterUse::YES);
 
 	_MMapTree->reset();
 	_MClrTree->reset();
@@ -682,7 +681,7 @@ void SmackerDecoder::handleAudioTrack(byte track, uint32 chunkSize, uint32 unpac
 void SmackerDecoder::queueCompressedBuffer(byte *buffer, uint32 bufferSize,
 		uint32 unpackedSize, int streamNum) {
 
-	Common::BitStream8LSB audioBS(new Common::MemoryReadStream(buffer, bufferSize), true);
+	Common::BitStreamMemory8LSB audioBS(new Common::BitStreamMemoryStream(buffer, bufferSize), DisposeAfterUse::YES);
 	bool dataPresent = audioBS.getBit();
 
 	if (!dataPresent)